@@ -102,6 +102,18 @@ function(core_add_test_library name)
   endforeach()
 endfunction()
 
+# Add a benchmark library, its sources are built into the benchmark binary
+# Arguments:
+#   name name of the library to add
+# Implicit arguments:
+#   SOURCES the sources of the library
+function(core_add_bench_library name)
+  foreach(src IN LISTS SOURCES)
+    get_filename_component(src_path "${src}" ABSOLUTE)
+    set(bench_sources "${src_path}" ${bench_sources} CACHE STRING "" FORCE)
+  endforeach()
+endfunction()
+
 # Add an addon callback library
 # Arguments:
 #   name name of the library to add
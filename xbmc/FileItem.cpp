@@ -63,6 +63,8 @@
 #include "utils/Variant.h"
 #include "utils/Mime.h"
 #include "utils/Random.h"
+#include "utils/ParallelJobs.h"
+#include "utils/SortKeys.h"
 #include "events/IEvent.h"
 
 #include <assert.h>
@@ -2154,6 +2156,55 @@ void CFileItemList::Sort(SortDescription sortDescription)
     sortDescription.sortAttributes = (SortAttribute)((int)sortDescription.sortAttributes | SortAttributeIgnoreFolders);
 
   const Fields fields = SortUtils::GetFieldsForSorting(sortDescription.sortBy);
+
+  if (CSortKeys::IsSupported(sortDescription.sortBy))
+  {
+    // extract the typed sort keys of large lists in consecutive ranges in
+    // parallel, each through a single reused SortItem
+    const unsigned int threads = CParallelJobs::GetThreads(m_items.size());
+    std::vector<CSortKeys> ranges(CParallelJobs::GetRanges(m_items.size(), threads),
+                                  CSortKeys(sortDescription.sortBy, sortDescription.sortAttributes));
+    CParallelJobs::ForEach(m_items.size(), threads, [&](size_t range, size_t begin, size_t end)
+    {
+      CSortKeys &keys = ranges[range];
+      keys.Reserve(end - begin);
+      SortItem sortable;
+      for (size_t index = begin; index < end; index++)
+      {
+        sortable.clear();
+        m_items[index]->ToSortable(sortable, fields);
+        sortable[FieldId] = index;
+        if (!keys.Add(sortable))
+          break;
+      }
+    });
+
+    CSortKeys &keys = ranges.front();
+    for (size_t range = 1; range < ranges.size(); range++)
+    {
+      if (!keys.Append(std::move(ranges[range])))
+        break;
+    }
+
+    if (keys.Size() == m_items.size())
+    {
+      std::vector<size_t> order = keys.GetOrder(sortDescription.sortOrder, sortDescription.limitEnd, sortDescription.limitStart);
+
+      VECFILEITEMS sortedFileItems;
+      sortedFileItems.reserve(order.size());
+      for (std::vector<size_t>::const_iterator index = order.begin(); index != order.end(); ++index)
+      {
+        CFileItemPtr item = m_items[*index];
+        item->SetSortLabel(keys.GetSortLabel(*index));
+
+        sortedFileItems.push_back(item);
+      }
+
+      m_items = std::move(sortedFileItems);
+      return;
+    }
+  }
+
   SortItems sortItems((size_t)Size());
   for (int index = 0; index < Size(); index++)
   {
@@ -2163,7 +2214,8 @@ void CFileItemList::Sort(SortDescription sortDescription)
   }
 
   // do the sorting
-  SortUtils::Sort(sortDescription, sortItems);
+  SortUtils::SortByPreparator(sortDescription.sortBy, sortDescription.sortOrder, sortDescription.sortAttributes,
+                              sortItems, sortDescription.limitEnd, sortDescription.limitStart);
 
   // apply the new order to the existing CFileItems
   VECFILEITEMS sortedFileItems;
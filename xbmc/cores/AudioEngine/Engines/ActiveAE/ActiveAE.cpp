@@ -26,11 +26,13 @@ using namespace ActiveAE;
 #include "ServiceBroker.h"
 #include "cores/AudioEngine/Engines/ActiveAE/AudioDSPAddons/ActiveAEDSP.h"
 #include "cores/AudioEngine/Engines/ActiveAE/AudioDSPAddons/ActiveAEDSPProcess.h"
+#include "cores/AudioEngine/Utils/AEKernels.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
 #include "cores/AudioEngine/Utils/AEStreamInfo.h"
 #include "cores/AudioEngine/AEResampleFactory.h"
 #include "cores/AudioEngine/Encoders/AEEncoderFFmpeg.h"
 
+#include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "windowing/WindowingFactory.h"
 #include "utils/log.h"
@@ -286,6 +288,8 @@ CActiveAE::CActiveAE() :
   m_aeGUISoundForce = false;
   m_stats.Reset(44100, true);
   m_streamIdGen = 0;
+  m_sinkReturnedSample = NULL;
+  m_sinkMessageSamples = 0;
 }
 
 CActiveAE::~CActiveAE()
@@ -300,6 +304,8 @@ void CActiveAE::Dispose()
   m_bStop = true;
   m_outMsgEvent.Set();
   StopThread();
+  m_controlPort.LogStats();
+  m_dataPort.LogStats();
   m_controlPort.Purge();
   m_dataPort.Purge();
   m_sink.Dispose();
@@ -415,11 +421,11 @@ void CActiveAE::StateMachine(int signal, Protocol *port, Message *msg)
         switch (signal)
         {
         case CSinkDataProtocol::RETURNSAMPLE:
-          CSampleBuffer **buffer;
-          buffer = (CSampleBuffer**)msg->data;
+          CSampleBuffer *buffer;
+          buffer = msg ? *(CSampleBuffer**)msg->data : m_sinkReturnedSample;
           if (buffer)
           {
-            (*buffer)->Return();
+            buffer->Return();
           }
           return;
         default:
@@ -767,11 +773,11 @@ void CActiveAE::StateMachine(int signal, Protocol *port, Message *msg)
         switch (signal)
         {
         case CSinkDataProtocol::RETURNSAMPLE:
-          CSampleBuffer **buffer;
-          buffer = (CSampleBuffer**)msg->data;
+          CSampleBuffer *buffer;
+          buffer = msg ? *(CSampleBuffer**)msg->data : m_sinkReturnedSample;
           if (buffer)
           {
-            (*buffer)->Return();
+            buffer->Return();
           }
           m_extTimeout = 0;
           m_state = AE_TOP_CONFIGURED_PLAY;
@@ -826,11 +832,11 @@ void CActiveAE::StateMachine(int signal, Protocol *port, Message *msg)
         switch (signal)
         {
         case CSinkDataProtocol::RETURNSAMPLE:
-          CSampleBuffer **buffer;
-          buffer = (CSampleBuffer**)msg->data;
+          CSampleBuffer *buffer;
+          buffer = msg ? *(CSampleBuffer**)msg->data : m_sinkReturnedSample;
           if (buffer)
           {
-            (*buffer)->Return();
+            buffer->Return();
           }
           return;
         default:
@@ -988,11 +994,20 @@ void CActiveAE::Process()
       gotMsg = true;
       port = &m_controlPort;
     }
+    // check samples returned through the queue of the sink
+    else if (m_sink.ReceiveReturnedSample(m_sinkReturnedSample))
+    {
+      StateMachine(CSinkDataProtocol::RETURNSAMPLE, &m_sink.m_dataPort, NULL);
+      m_sinkReturnedSample = NULL;
+      continue;
+    }
     // check sink data port
     else if (m_sink.m_dataPort.ReceiveInMessage(&msg))
     {
       gotMsg = true;
       port = &m_sink.m_dataPort;
+      if (msg->signal == CSinkDataProtocol::RETURNSAMPLE)
+        m_sinkMessageSamples--;
     }
     else if (!m_extDeferData)
     {
@@ -1976,10 +1991,6 @@ bool CActiveAE::RunStages()
             out = (*it)->m_processingBuffers->m_outputSamples.front();
             (*it)->m_processingBuffers->m_outputSamples.pop_front();
 
-            int nb_floats = out->pkt->nb_samples * out->pkt->config.channels / out->pkt->planes;
-            int nb_loops = 1;
-            float fadingStep = 0.0f;
-
             // fading
             if ((*it)->m_fadingSamples == -1)
             {
@@ -1993,58 +2004,13 @@ bool CActiveAE::RunStages()
                 (*it)->m_streamFading = false;
               }
             }
-            if ((*it)->m_fadingSamples > 0)
-            {
-              nb_floats = out->pkt->config.channels / out->pkt->planes;
-              nb_loops = out->pkt->nb_samples;
-              float delta = (*it)->m_fadingTarget - (*it)->m_fadingBase;
-              int samples = m_internalFormat.m_sampleRate * (float)(*it)->m_fadingTime / 1000.0f;
-              fadingStep = delta / samples;
-            }
 
             // for stream amplification, 
             // turned off downmix normalization,
             // or if sink format is float (in order to prevent from clipping)
             // we need to run on a per sample basis
-            if ((*it)->m_amplify != 1.0 || !(*it)->m_processingBuffers->DoesNormalize() || (m_sinkFormat.m_dataFormat == AE_FMT_FLOAT))
-            {
-              nb_floats = out->pkt->config.channels / out->pkt->planes;
-              nb_loops = out->pkt->nb_samples;
-            }
-
-            for(int i=0; i<nb_loops; i++)
-            {
-              if ((*it)->m_fadingSamples > 0)
-              {
-                (*it)->m_volume += fadingStep;
-                (*it)->m_fadingSamples--;
-
-                if ((*it)->m_fadingSamples == 0)
-                {
-                  // set variables being polled via stream interface
-                  CSingleLock lock((*it)->m_streamLock);
-                  (*it)->m_streamFading = false;
-                }
-              }
-
-              // volume for stream
-              float volume = (*it)->m_volume * (*it)->m_rgain;
-              if(nb_loops > 1)
-                volume *= (*it)->m_limiter.Run((float**)out->pkt->data, out->pkt->config.channels, i*nb_floats, out->pkt->planes > 1);
-
-              for(int j=0; j<out->pkt->planes; j++)
-              {
-#if defined(HAVE_SSE) && defined(__SSE__)
-                CAEUtil::SSEMulArray((float*)out->pkt->data[j]+i*nb_floats, volume, nb_floats);
-#else
-                float* fbuffer = (float*) out->pkt->data[j]+i*nb_floats;
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  fbuffer[k] *= volume;
-                }
-#endif
-              }
-            }
+            bool perSample = (*it)->m_amplify != 1.0 || !(*it)->m_processingBuffers->DoesNormalize() || (m_sinkFormat.m_dataFormat == AE_FMT_FLOAT);
+            ApplyStreamVolume(*it, out, NULL, perSample);
           }
           else
           {
@@ -2052,76 +2018,23 @@ bool CActiveAE::RunStages()
             mix = (*it)->m_processingBuffers->m_outputSamples.front();
             (*it)->m_processingBuffers->m_outputSamples.pop_front();
 
-            int nb_floats = mix->pkt->nb_samples * mix->pkt->config.channels / mix->pkt->planes;
-            int nb_loops = 1;
-            float fadingStep = 0.0f;
-
             // fading
             if ((*it)->m_fadingSamples == -1)
             {
               (*it)->m_fadingSamples = m_internalFormat.m_sampleRate * (float)(*it)->m_fadingTime / 1000.0f;
               (*it)->m_volume = (*it)->m_fadingBase;
             }
-            if ((*it)->m_fadingSamples > 0)
-            {
-              nb_floats = mix->pkt->config.channels / mix->pkt->planes;
-              nb_loops = mix->pkt->nb_samples;
-              float delta = (*it)->m_fadingTarget - (*it)->m_fadingBase;
-              int samples = m_internalFormat.m_sampleRate * (float)(*it)->m_fadingTime / 1000.0f;
-              fadingStep = delta / samples;
-            }
 
             // for streams amplification of turned off downmix normalization
             // we need to run on a per sample basis
-            if ((*it)->m_amplify != 1.0 || !(*it)->m_processingBuffers->DoesNormalize())
-            {
-              nb_floats = out->pkt->config.channels / out->pkt->planes;
-              nb_loops = out->pkt->nb_samples;
-            }
+            bool perSample = (*it)->m_amplify != 1.0 || !(*it)->m_processingBuffers->DoesNormalize();
+            ApplyStreamVolume(*it, out, mix, perSample);
 
-            for(int i=0; i<nb_loops; i++)
+            if (!needClamp)
             {
-              if ((*it)->m_fadingSamples > 0)
-              {
-                (*it)->m_volume += fadingStep;
-                (*it)->m_fadingSamples--;
-
-                if ((*it)->m_fadingSamples == 0)
-                {
-                  // set variables being polled via stream interface
-                  CSingleLock lock((*it)->m_streamLock);
-                  (*it)->m_streamFading = false;
-                }
-              }
-
-              // volume for stream
-              float volume = (*it)->m_volume * (*it)->m_rgain;
-              if(nb_loops > 1)
-                volume *= (*it)->m_limiter.Run((float**)mix->pkt->data, mix->pkt->config.channels, i*nb_floats, mix->pkt->planes > 1);
-
-              for(int j=0; j<out->pkt->planes && j<mix->pkt->planes; j++)
-              {
-                float *dst = (float*)out->pkt->data[j]+i*nb_floats;
-                float *src = (float*)mix->pkt->data[j]+i*nb_floats;
-#if defined(HAVE_SSE) && defined(__SSE__)
-                CAEUtil::SSEMulAddArray(dst, src, volume, nb_floats);
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  if (fabs(dst[k]) > 1.0f)
-                  {
-                    needClamp = true;
-                    break;
-                  }
-                }
-#else
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  dst[k] += src[k] * volume;
-                  if (fabs(dst[k]) > 1.0f)
-                    needClamp = true;
-                }
-#endif
-              }
+              int nb_floats = out->pkt->nb_samples * out->pkt->config.channels / out->pkt->planes;
+              for (int j = 0; j < out->pkt->planes && !needClamp; j++)
+                needClamp = CAEKernels::Peak((float*)out->pkt->data[j], nb_floats) > 1.0f;
             }
             mix->Return();
           }
@@ -2135,7 +2048,7 @@ bool CActiveAE::RunStages()
         int nb_floats = out->pkt->nb_samples * out->pkt->config.channels / out->pkt->planes;
         for(int i=0; i<out->pkt->planes; i++)
         {
-          CAEUtil::ClampArray((float*)out->pkt->data[i], nb_floats);
+          CAEKernels::SoftClamp((float*)out->pkt->data[i], nb_floats);
         }
       }
 
@@ -2254,14 +2167,26 @@ bool CActiveAE::RunStages()
     CSampleBuffer *out = NULL;
     out = m_sinkBuffers->m_outputSamples.front();
     m_sinkBuffers->m_outputSamples.pop_front();
-    m_sink.m_dataPort.SendOutMessage(CSinkDataProtocol::SAMPLE,
-        &out, sizeof(CSampleBuffer*));
+    SendSinkSample(out);
     busy = true;
   }
 
   return busy;
 }
 
+void CActiveAE::SendSinkSample(CSampleBuffer *samples)
+{
+  // the sink outputs queued samples first, so switching from messages back
+  // to the queue has to wait until all samples sent by message are returned
+  if (g_advancedSettings.m_audioSinkQueue && m_sinkMessageSamples == 0 &&
+      m_sink.QueueSample(samples))
+    return;
+
+  m_sinkMessageSamples++;
+  m_sink.m_dataPort.SendOutMessage(CSinkDataProtocol::SAMPLE,
+      &samples, sizeof(CSampleBuffer*));
+}
+
 bool CActiveAE::HasWork()
 {
   if (!m_sounds_playing.empty())
@@ -2467,6 +2392,74 @@ CSampleBuffer* CActiveAE::SyncStream(CActiveAEStream *stream)
   return ret;
 }
 
+// applies the volume of the stream to dst, or mixes src into dst with it
+// if given. With perSample set or while fading, every frame passes the limiter.
+void CActiveAE::ApplyStreamVolume(CActiveAEStream *stream, CSampleBuffer *dst, CSampleBuffer *src, bool perSample)
+{
+  CSampleBuffer *buffer = src ? src : dst;
+  int planes = src ? std::min(dst->pkt->planes, src->pkt->planes) : dst->pkt->planes;
+  int channels = dst->pkt->config.channels / dst->pkt->planes;
+  int frames = dst->pkt->nb_samples;
+  int fadingFrames = 0;
+  float fadingStep = 0.0f;
+
+  if (stream->m_fadingSamples > 0)
+  {
+    float delta = stream->m_fadingTarget - stream->m_fadingBase;
+    int samples = m_internalFormat.m_sampleRate * (float)stream->m_fadingTime / 1000.0f;
+    fadingStep = delta / samples;
+    fadingFrames = std::min(frames, stream->m_fadingSamples);
+  }
+
+  if (perSample || fadingFrames > 0)
+  {
+    if ((int)m_streamGains.size() < frames)
+      m_streamGains.resize(frames);
+
+    for (int i = 0; i < frames; i++)
+    {
+      if (i < fadingFrames)
+        stream->m_volume += fadingStep;
+
+      // volume for stream
+      float volume = stream->m_volume * stream->m_rgain;
+      m_streamGains[i] = volume * stream->m_limiter.Run((float**)buffer->pkt->data, buffer->pkt->config.channels, i*channels, buffer->pkt->planes > 1);
+    }
+
+    for (int j = 0; j < planes; j++)
+    {
+      float *data = (float*)dst->pkt->data[j];
+      if (src)
+        CAEKernels::MulAddGains(data, (float*)src->pkt->data[j], m_streamGains.data(), frames, channels);
+      else
+        CAEKernels::MulGains(data, m_streamGains.data(), frames, channels);
+    }
+  }
+  else
+  {
+    float volume = stream->m_volume * stream->m_rgain;
+    for (int j = 0; j < planes; j++)
+    {
+      float *data = (float*)dst->pkt->data[j];
+      if (src)
+        CAEKernels::MulAdd(data, (float*)src->pkt->data[j], volume, frames * channels);
+      else
+        CAEKernels::Mul(data, volume, frames * channels);
+    }
+  }
+
+  if (fadingFrames > 0)
+  {
+    stream->m_fadingSamples -= fadingFrames;
+    if (stream->m_fadingSamples == 0)
+    {
+      // set variables being polled via stream interface
+      CSingleLock lock(stream->m_streamLock);
+      stream->m_streamFading = false;
+    }
+  }
+}
+
 void CActiveAE::MixSounds(CSoundPacket &dstSample)
 {
   if (m_sounds_playing.empty())
@@ -2495,12 +2488,7 @@ void CActiveAE::MixSounds(CSoundPacket &dstSample)
       out = (float*)dstSample.data[j];
       sample_buffer = (float*)(it->sound->GetSound(false)->data[j]+start);
       int nb_floats = mix_samples * dstSample.config.channels / dstSample.planes;
-#if defined(HAVE_SSE) && defined(__SSE__)
-      CAEUtil::SSEMulAddArray(out, sample_buffer, volume, nb_floats);
-#else
-      for (int k = 0; k < nb_floats; ++k)
-        *out++ += *sample_buffer++ * volume;
-#endif
+      CAEKernels::MulAdd(out, sample_buffer, volume, nb_floats);
     }
 
     it->samples_played += mix_samples;
@@ -2526,13 +2514,7 @@ void CActiveAE::Deamplify(CSoundPacket &dstSample)
     for(int j=0; j<dstSample.planes; j++)
     {
       buffer = (float*)dstSample.data[j];
-#if defined(HAVE_SSE) && defined(__SSE__)
-      CAEUtil::SSEMulArray(buffer, volume, nb_floats);
-#else
-      float *fbuffer = buffer;
-      for (int i = 0; i < nb_floats; i++)
-        *fbuffer++ *= volume;
-#endif
+      CAEKernels::Mul(buffer, volume, nb_floats);
     }
   }
 }
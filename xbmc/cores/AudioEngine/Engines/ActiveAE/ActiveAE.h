@@ -322,7 +322,9 @@ protected:
 
   bool RunStages();
   bool HasWork();
+  void SendSinkSample(CSampleBuffer *samples);
   CSampleBuffer* SyncStream(CActiveAEStream *stream);
+  void ApplyStreamVolume(CActiveAEStream *stream, CSampleBuffer *dst, CSampleBuffer *src, bool perSample);
 
   void ResampleSounds();
   bool ResampleSound(CActiveAESound *sound);
@@ -353,6 +355,8 @@ protected:
   }m_mode;
 
   CActiveAESink m_sink;
+  CSampleBuffer *m_sinkReturnedSample; // returned through the queue of the sink
+  unsigned int m_sinkMessageSamples;   // samples sent with messages and not yet returned
   AEAudioFormat m_sinkFormat;
   AEAudioFormat m_sinkRequestFormat;
   AEAudioFormat m_encoderFormat;
@@ -374,6 +378,7 @@ protected:
   std::list<CActiveAEStream*> m_streams;
   std::list<CActiveAEBufferPool*> m_discardBufferPools;
   unsigned int m_streamIdGen;
+  std::vector<float> m_streamGains; // per frame volume of a stream
 
   // gui sounds
   struct SoundState
@@ -0,0 +1,364 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ActiveAEResamplePolyphase.h"
+#include "cores/AudioEngine/Utils/AEKernels.h"
+#include "cores/AudioEngine/Utils/AEUtil.h"
+#include "utils/log.h"
+
+extern "C" {
+#include "libavutil/channel_layout.h"
+}
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+using namespace ActiveAE;
+
+CActiveAEResamplePolyphase::CActiveAEResamplePolyphase()
+{
+  m_useFFMPEG = true;
+  m_identity = true;
+  m_mixFirst = true;
+}
+
+const char *CActiveAEResamplePolyphase::GetName()
+{
+  if (m_useFFMPEG)
+    return CActiveAEResampleFFMPEG::GetName();
+  return "ActiveAEResamplePolyphase";
+}
+
+bool CActiveAEResamplePolyphase::Init(uint64_t dst_chan_layout, int dst_channels, int dst_rate, AVSampleFormat dst_fmt, int dst_bits, int dst_dither, uint64_t src_chan_layout, int src_channels, int src_rate, AVSampleFormat src_fmt, int src_bits, int src_dither, bool upmix, bool normalize, CAEChannelInfo *remapLayout, AEQuality quality, bool force_resample)
+{
+  m_dst_chan_layout = dst_chan_layout;
+  m_dst_channels = dst_channels;
+  m_dst_rate = dst_rate;
+  m_dst_fmt = dst_fmt;
+  m_dst_bits = dst_bits;
+  m_dst_dither_bits = dst_dither;
+  m_src_chan_layout = src_chan_layout;
+  m_src_channels = src_channels;
+  m_src_rate = src_rate;
+  m_src_fmt = src_fmt;
+  m_src_bits = src_bits;
+  m_src_dither_bits = src_dither;
+
+  if (m_dst_chan_layout == 0)
+    m_dst_chan_layout = av_get_default_channel_layout(m_dst_channels);
+  if (m_src_chan_layout == 0)
+    m_src_chan_layout = av_get_default_channel_layout(m_src_channels);
+
+  // ratio changes and forced resampling are handled by the filter as well,
+  // everything else goes to swresample
+  m_useFFMPEG = true;
+  if ((m_src_fmt == AV_SAMPLE_FMT_FLT || m_src_fmt == AV_SAMPLE_FMT_FLTP) &&
+      (m_dst_fmt == AV_SAMPLE_FMT_FLT || m_dst_fmt == AV_SAMPLE_FMT_FLTP) &&
+      m_src_channels > 0 && m_src_channels <= AE_CH_MAX &&
+      m_dst_channels > 0 && m_dst_channels <= AE_CH_MAX &&
+      CAEPolyphaseResampler::IsSupported(m_src_rate, m_dst_rate) &&
+      BuildMatrix(upmix, normalize, remapLayout))
+  {
+    m_mixFirst = m_dst_channels <= m_src_channels;
+    const int channels = m_mixFirst ? m_dst_channels : m_src_channels;
+    m_useFFMPEG = !m_resampler.Init(m_src_rate, m_dst_rate, channels, quality);
+  }
+
+  if (m_useFFMPEG)
+  {
+    CLog::Log(LOGDEBUG, "CActiveAEResamplePolyphase::Init - format not handled, using swresample");
+    return CActiveAEResampleFFMPEG::Init(dst_chan_layout, dst_channels, dst_rate, dst_fmt, dst_bits, dst_dither,
+                                         src_chan_layout, src_channels, src_rate, src_fmt, src_bits, src_dither,
+                                         upmix, normalize, remapLayout, quality, force_resample);
+  }
+
+  m_doesResample = m_src_rate != m_dst_rate;
+  return true;
+}
+
+bool CActiveAEResamplePolyphase::BuildMatrix(bool upmix, bool normalize, CAEChannelInfo *remapLayout)
+{
+  m_matrix.assign(m_dst_channels * m_src_channels, 0.0f);
+  m_identity = false;
+
+  if (remapLayout)
+  {
+    // one-to-one mapping of channels like CActiveAEResampleFFMPEG
+    if ((int)remapLayout->Count() != m_dst_channels)
+      return false;
+    for (int out = 0; out < m_dst_channels; out++)
+    {
+      int idx = CAEUtil::GetAVChannelIndex((*remapLayout)[out], m_src_chan_layout);
+      if (idx >= 0 && idx < m_src_channels)
+        m_matrix[out * m_src_channels + idx] = 1.0f;
+    }
+    m_dst_chan_layout = 0;
+    for (int out = 0; out < m_dst_channels; out++)
+      m_dst_chan_layout += ((uint64_t)1) << out;
+    return true;
+  }
+
+  if (m_src_chan_layout == m_dst_chan_layout && m_src_channels == m_dst_channels)
+  {
+    m_identity = true;
+    for (int ch = 0; ch < m_dst_channels; ch++)
+      m_matrix[ch * m_src_channels + ch] = 1.0f;
+    return true;
+  }
+
+  // stereo upmix
+  if (upmix && m_src_channels == 2 && m_dst_channels > 2)
+  {
+    for (int out = 0; out < m_dst_channels; out++)
+    {
+      float *row = &m_matrix[out * m_src_channels];
+      switch (av_channel_layout_extract_channel(m_dst_chan_layout, out))
+      {
+        case AV_CH_FRONT_LEFT:
+        case AV_CH_BACK_LEFT:
+        case AV_CH_SIDE_LEFT:
+          row[0] = 1.0f;
+          break;
+        case AV_CH_FRONT_RIGHT:
+        case AV_CH_BACK_RIGHT:
+        case AV_CH_SIDE_RIGHT:
+          row[1] = 1.0f;
+          break;
+        case AV_CH_FRONT_CENTER:
+        case AV_CH_LOW_FREQUENCY:
+          row[0] = 0.5f;
+          row[1] = 0.5f;
+          break;
+        default:
+          break;
+      }
+    }
+    return true;
+  }
+
+  // channels present on both sides are kept, the rest can only be folded
+  // into stereo with the coefficients of swresample
+  const bool stereo = m_dst_chan_layout == AV_CH_LAYOUT_STEREO;
+  for (int in = 0; in < m_src_channels; in++)
+  {
+    const uint64_t channel = av_channel_layout_extract_channel(m_src_chan_layout, in);
+    const int out = av_get_channel_layout_channel_index(m_dst_chan_layout, channel);
+    if (out >= 0 && out < m_dst_channels)
+    {
+      m_matrix[out * m_src_channels + in] = 1.0f;
+      continue;
+    }
+
+    float left = 0.0f, right = 0.0f;
+    switch (channel)
+    {
+      case AV_CH_LOW_FREQUENCY:
+        continue;
+      case AV_CH_FRONT_CENTER:
+        left = right = (float)M_SQRT1_2;
+        break;
+      case AV_CH_BACK_CENTER:
+        left = right = 0.5f;
+        break;
+      case AV_CH_FRONT_LEFT_OF_CENTER:
+        left = 1.0f;
+        break;
+      case AV_CH_FRONT_RIGHT_OF_CENTER:
+        right = 1.0f;
+        break;
+      case AV_CH_BACK_LEFT:
+      case AV_CH_SIDE_LEFT:
+        left = (float)M_SQRT1_2;
+        break;
+      case AV_CH_BACK_RIGHT:
+      case AV_CH_SIDE_RIGHT:
+        right = (float)M_SQRT1_2;
+        break;
+      default:
+        return false;
+    }
+    if (!stereo)
+      return false;
+    m_matrix[0 * m_src_channels + in] += left;
+    m_matrix[1 * m_src_channels + in] += right;
+  }
+
+  // keep the mix from clipping
+  if (normalize)
+  {
+    float maxSum = 0.0f;
+    for (int out = 0; out < m_dst_channels; out++)
+    {
+      float sum = 0.0f;
+      for (int in = 0; in < m_src_channels; in++)
+        sum += fabsf(m_matrix[out * m_src_channels + in]);
+      maxSum = std::max(maxSum, sum);
+    }
+    if (maxSum > 1.0f)
+    {
+      for (float &coef : m_matrix)
+        coef /= maxSum;
+    }
+  }
+  return true;
+}
+
+void CActiveAEResamplePolyphase::Mix(float **dst, const float * const *src, unsigned int frames)
+{
+  for (int out = 0; out < m_dst_channels; out++)
+  {
+    const float *row = &m_matrix[out * m_src_channels];
+    bool empty = true;
+    for (int in = 0; in < m_src_channels; in++)
+    {
+      if (row[in] == 0.0f)
+        continue;
+      if (empty)
+      {
+        memcpy(dst[out], src[in], frames * sizeof(float));
+        if (row[in] != 1.0f)
+          CAEKernels::Mul(dst[out], row[in], frames);
+        empty = false;
+      }
+      else
+        CAEKernels::MulAdd(dst[out], src[in], row[in], frames);
+    }
+    if (empty)
+      memset(dst[out], 0, frames * sizeof(float));
+  }
+}
+
+void CActiveAEResamplePolyphase::GetPlanes(std::vector<std::vector<float>> &planes, int channels, int frames, float **pointers)
+{
+  if ((int)planes.size() < channels)
+    planes.resize(channels);
+  for (int ch = 0; ch < channels; ch++)
+  {
+    if ((int)planes[ch].size() < frames)
+      planes[ch].resize(frames);
+    pointers[ch] = planes[ch].data();
+  }
+}
+
+int CActiveAEResamplePolyphase::Resample(uint8_t **dst_buffer, int dst_samples, uint8_t **src_buffer, int src_samples, double ratio)
+{
+  if (m_useFFMPEG)
+    return CActiveAEResampleFFMPEG::Resample(dst_buffer, dst_samples, src_buffer, src_samples, ratio);
+
+  if (ratio != 1.0)
+    m_doesResample = true;
+
+  const bool mixAfter = !m_mixFirst && !m_identity;
+  const int channels = m_mixFirst ? m_dst_channels : m_src_channels;
+
+  if (src_buffer && src_samples > 0)
+  {
+    float *src[AE_CH_MAX];
+    if (m_src_fmt == AV_SAMPLE_FMT_FLTP)
+    {
+      for (int ch = 0; ch < m_src_channels; ch++)
+        src[ch] = (float*)src_buffer[ch];
+    }
+    else
+    {
+      GetPlanes(m_srcPlanes, m_src_channels, src_samples, src);
+      const float *in = (const float*)src_buffer[0];
+      for (int i = 0; i < src_samples; i++)
+        for (int ch = 0; ch < m_src_channels; ch++)
+          src[ch][i] = *in++;
+    }
+
+    if (m_mixFirst && !m_identity)
+    {
+      float *mixed[AE_CH_MAX];
+      GetPlanes(m_mixPlanes, m_dst_channels, src_samples, mixed);
+      Mix(mixed, src, src_samples);
+      m_resampler.AddFrames(mixed, src_samples);
+    }
+    else
+      m_resampler.AddFrames(src, src_samples);
+  }
+
+  if (dst_samples <= 0)
+    return 0;
+
+  float *out[AE_CH_MAX];
+  if (m_dst_fmt == AV_SAMPLE_FMT_FLTP && !mixAfter)
+  {
+    for (int ch = 0; ch < channels; ch++)
+      out[ch] = (float*)dst_buffer[ch];
+  }
+  else
+    GetPlanes(m_outPlanes, channels, dst_samples, out);
+
+  int frames = m_resampler.GetFrames(out, dst_samples, ratio);
+
+  // no input means draining, let the look ahead of the filter through
+  if (!src_buffer && frames < dst_samples)
+  {
+    float *rest[AE_CH_MAX];
+    for (int ch = 0; ch < channels; ch++)
+      rest[ch] = out[ch] + frames;
+    m_resampler.Flush();
+    frames += m_resampler.GetFrames(rest, dst_samples - frames, ratio);
+  }
+
+  float *dst[AE_CH_MAX];
+  if (mixAfter)
+  {
+    if (m_dst_fmt == AV_SAMPLE_FMT_FLTP)
+    {
+      for (int ch = 0; ch < m_dst_channels; ch++)
+        dst[ch] = (float*)dst_buffer[ch];
+    }
+    else
+      GetPlanes(m_mixPlanes, m_dst_channels, frames, dst);
+    Mix(dst, out, frames);
+  }
+  else
+  {
+    for (int ch = 0; ch < m_dst_channels; ch++)
+      dst[ch] = out[ch];
+  }
+
+  if (m_dst_fmt == AV_SAMPLE_FMT_FLT)
+  {
+    float *packed = (float*)dst_buffer[0];
+    for (int i = 0; i < frames; i++)
+      for (int ch = 0; ch < m_dst_channels; ch++)
+        *packed++ = dst[ch][i];
+  }
+  return frames;
+}
+
+int64_t CActiveAEResamplePolyphase::GetDelay(int64_t base)
+{
+  if (m_useFFMPEG)
+    return CActiveAEResampleFFMPEG::GetDelay(base);
+  return (int64_t)llround(m_resampler.GetDelay() * base / m_src_rate);
+}
+
+int CActiveAEResamplePolyphase::GetBufferedSamples()
+{
+  if (m_useFFMPEG)
+    return CActiveAEResampleFFMPEG::GetBufferedSamples();
+  return (int)ceil(m_resampler.GetDelay() * m_dst_rate / m_src_rate);
+}
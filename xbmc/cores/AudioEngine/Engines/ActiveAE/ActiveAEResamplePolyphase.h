@@ -0,0 +1,62 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ActiveAEResampleFFMPEG.h"
+#include "cores/AudioEngine/Utils/AEPolyphaseResampler.h"
+
+#include <vector>
+
+namespace ActiveAE
+{
+
+/**
+ * @brief Resampler for float samples using CAEPolyphaseResampler.
+ *
+ * Channels are remapped, upmixed from stereo or downmixed to stereo with a
+ * fixed matrix built like the default one of swresample, before resampling
+ * if that leaves fewer channels to filter, after it otherwise. Formats,
+ * rates and layouts that are not handled are passed on to swresample.
+ */
+class CActiveAEResamplePolyphase : public CActiveAEResampleFFMPEG
+{
+public:
+  const char *GetName();
+  CActiveAEResamplePolyphase();
+  bool Init(uint64_t dst_chan_layout, int dst_channels, int dst_rate, AVSampleFormat dst_fmt, int dst_bits, int dst_dither, uint64_t src_chan_layout, int src_channels, int src_rate, AVSampleFormat src_fmt, int src_bits, int src_dither, bool upmix, bool normalize, CAEChannelInfo *remapLayout, AEQuality quality, bool force_resample);
+  int Resample(uint8_t **dst_buffer, int dst_samples, uint8_t **src_buffer, int src_samples, double ratio);
+  int64_t GetDelay(int64_t base);
+  int GetBufferedSamples();
+
+protected:
+  bool BuildMatrix(bool upmix, bool normalize, CAEChannelInfo *remapLayout);
+  void Mix(float **dst, const float * const *src, unsigned int frames);
+  static void GetPlanes(std::vector<std::vector<float>> &planes, int channels, int frames, float **pointers);
+
+  bool m_useFFMPEG;
+  bool m_identity;
+  bool m_mixFirst;
+  CAEPolyphaseResampler m_resampler;
+  // m_dst_channels rows of m_src_channels coefficients
+  std::vector<float> m_matrix;
+  std::vector<std::vector<float>> m_srcPlanes, m_mixPlanes, m_outPlanes;
+};
+
+}
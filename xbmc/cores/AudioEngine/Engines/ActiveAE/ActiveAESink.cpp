@@ -25,6 +25,7 @@
 #include "cores/AudioEngine/Utils/AEStreamInfo.h"
 #include "cores/AudioEngine/Utils/AEBitstreamPacker.h"
 #include "utils/EndianSwap.h"
+#include "utils/TimeUtils.h"
 #include "ActiveAE.h"
 #include "cores/AudioEngine/AEResampleFactory.h"
 #include "utils/log.h"
@@ -36,12 +37,17 @@
 #include "linux/XMemUtils.h"
 #endif
 
+// more than the sink buffers of the engine can hold
+#define SAMPLE_QUEUE_SIZE 512
+
 using namespace ActiveAE;
 
 CActiveAESink::CActiveAESink(CEvent *inMsgEvent) :
   CThread("AESink"),
   m_controlPort("SinkControlPort", inMsgEvent, &m_outMsgEvent),
-  m_dataPort("SinkDataPort", inMsgEvent, &m_outMsgEvent)
+  m_dataPort("SinkDataPort", inMsgEvent, &m_outMsgEvent),
+  m_sampleQueue(SAMPLE_QUEUE_SIZE),
+  m_returnQueue(SAMPLE_QUEUE_SIZE)
 {
   m_inMsgEvent = inMsgEvent;
   m_sink = nullptr;
@@ -49,6 +55,9 @@ CActiveAESink::CActiveAESink(CEvent *inMsgEvent) :
   m_volume = 0.0;
   m_packer = nullptr;
   m_streamNoise = true;
+  m_queuedSamples = 0;
+  m_queueSample = nullptr;
+  m_deferredMsg = nullptr;
 }
 
 void CActiveAESink::Start()
@@ -65,6 +74,13 @@ void CActiveAESink::Dispose()
   m_bStop = true;
   m_outMsgEvent.Set();
   StopThread();
+  if (m_deferredMsg)
+  {
+    m_deferredMsg->Release();
+    m_deferredMsg = nullptr;
+  }
+  m_controlPort.LogStats();
+  m_dataPort.LogStats();
   m_controlPort.Purge();
   m_dataPort.Purge();
 
@@ -264,6 +280,7 @@ void CActiveAESink::StateMachine(int signal, Protocol *port, Message *msg)
           m_extSilenceTimer = 0;
           m_extStreaming = false;
           ReturnBuffers();
+          LogLatency();
           OpenSink();
 
           if (!m_extError)
@@ -295,6 +312,7 @@ void CActiveAESink::StateMachine(int signal, Protocol *port, Message *msg)
 
         case CSinkControlProtocol::UNCONFIGURE:
           ReturnBuffers();
+          LogLatency();
           if (m_sink)
           {
             m_sink->Drain();
@@ -371,10 +389,10 @@ void CActiveAESink::StateMachine(int signal, Protocol *port, Message *msg)
         case CSinkDataProtocol::SAMPLE:
           CSampleBuffer *samples;
           int timeout;
-          samples = *((CSampleBuffer**)msg->data);
+          samples = GetSample(msg);
           timeout = 1000*samples->pkt->nb_samples/samples->pkt->config.sample_rate;
           Sleep(timeout);
-          msg->Reply(CSinkDataProtocol::RETURNSAMPLE, &samples, sizeof(CSampleBuffer*));
+          ReturnSample(msg, samples);
           m_extTimeout = 0;
           return;
         default:
@@ -429,9 +447,12 @@ void CActiveAESink::StateMachine(int signal, Protocol *port, Message *msg)
         case CSinkDataProtocol::SAMPLE:
           CSampleBuffer *samples;
           unsigned int delay;
-          samples = *((CSampleBuffer**)msg->data);
+          int64_t start;
+          samples = GetSample(msg);
+          start = CurrentHostCounter();
           delay = OutputSamples(samples);
-          msg->Reply(CSinkDataProtocol::RETURNSAMPLE, &samples, sizeof(CSampleBuffer*));
+          m_outputLatency.Add((CurrentHostCounter() - start) * 1000000 / CurrentHostFrequency());
+          ReturnSample(msg, samples);
           if (m_extError)
           {
             m_sink->Deinitialize();
@@ -596,8 +617,10 @@ void CActiveAESink::Process()
 {
   Message *msg = nullptr;
   Protocol *port = nullptr;
+  int signal = 0;
   bool gotMsg;
   XbmcThreads::EndTime timer;
+  QueuedSample queued;
 
   m_state = S_TOP_UNCONFIGURED;
   m_extTimeout = 1000;
@@ -613,8 +636,8 @@ void CActiveAESink::Process()
     {
       m_bStateMachineSelfTrigger = false;
       // self trigger state machine
-      StateMachine(msg->signal, port, msg);
-      if (!m_bStateMachineSelfTrigger)
+      StateMachine(signal, port, msg);
+      if (!m_bStateMachineSelfTrigger && msg)
       {
         msg->Release();
         msg = nullptr;
@@ -626,18 +649,41 @@ void CActiveAESink::Process()
     {
       gotMsg = true;
       port = &m_controlPort;
+      signal = msg->signal;
+    }
+    // check sample queue, queued samples go before later data messages
+    else if (m_sampleQueue.Pop(queued))
+    {
+      m_queueLatency.Add((CurrentHostCounter() - queued.queued) * 1000000 / CurrentHostFrequency());
+      m_queueSample = queued.samples;
+      gotMsg = true;
+      port = &m_dataPort;
+      signal = CSinkDataProtocol::SAMPLE;
     }
     // check data port
-    else if (m_dataPort.ReceiveOutMessage(&msg))
+    else if (m_deferredMsg || m_dataPort.ReceiveOutMessage(&msg))
     {
+      if (m_deferredMsg)
+      {
+        msg = m_deferredMsg;
+        m_deferredMsg = nullptr;
+      }
+      else if (!m_sampleQueue.Empty())
+      {
+        // samples were queued before the message was sent
+        m_deferredMsg = msg;
+        msg = nullptr;
+        continue;
+      }
       gotMsg = true;
       port = &m_dataPort;
+      signal = msg->signal;
     }
 
     if (gotMsg)
     {
-      StateMachine(msg->signal, port, msg);
-      if (!m_bStateMachineSelfTrigger)
+      StateMachine(signal, port, msg);
+      if (!m_bStateMachineSelfTrigger && msg)
       {
         msg->Release();
         msg = nullptr;
@@ -657,8 +703,9 @@ void CActiveAESink::Process()
       msg = m_controlPort.GetMessage();
       msg->signal = CSinkControlProtocol::TIMEOUT;
       port = 0;
+      signal = msg->signal;
       // signal timeout to state machine
-      StateMachine(msg->signal, port, msg);
+      StateMachine(signal, port, msg);
       if (!m_bStateMachineSelfTrigger)
       {
         msg->Release();
@@ -668,6 +715,64 @@ void CActiveAESink::Process()
   }
 }
 
+bool CActiveAESink::QueueSample(CSampleBuffer *samples)
+{
+  // the return queue has room for every sample that is not yet returned
+  if (m_queuedSamples >= m_returnQueue.Capacity())
+    return false;
+
+  QueuedSample queued;
+  queued.samples = samples;
+  queued.queued = CurrentHostCounter();
+  if (!m_sampleQueue.Push(queued))
+    return false;
+
+  m_queuedSamples++;
+  m_outMsgEvent.Set();
+  return true;
+}
+
+bool CActiveAESink::ReceiveReturnedSample(CSampleBuffer *&samples)
+{
+  if (!m_returnQueue.Pop(samples))
+    return false;
+
+  m_queuedSamples--;
+  return true;
+}
+
+CSampleBuffer* CActiveAESink::GetSample(Message *msg)
+{
+  if (msg)
+    return *((CSampleBuffer**)msg->data);
+  return m_queueSample;
+}
+
+void CActiveAESink::ReturnSample(Message *msg, CSampleBuffer *samples)
+{
+  if (msg)
+  {
+    msg->Reply(CSinkDataProtocol::RETURNSAMPLE, &samples, sizeof(CSampleBuffer*));
+    return;
+  }
+
+  // can't fail, the engine never has more samples queued than fit
+  m_returnQueue.Push(samples);
+  m_queueSample = nullptr;
+  m_inMsgEvent->Set();
+}
+
+void CActiveAESink::LogLatency()
+{
+  if (m_outputLatency.GetCount() == 0)
+    return;
+
+  CLog::Log(LOGDEBUG, "CActiveAESink::%s - queue: %s", __FUNCTION__, m_queueLatency.ToString().c_str());
+  CLog::Log(LOGDEBUG, "CActiveAESink::%s - output: %s", __FUNCTION__, m_outputLatency.ToString().c_str());
+  m_queueLatency.Reset();
+  m_outputLatency.Reset();
+}
+
 void CActiveAESink::EnumerateSinkList(bool force)
 {
   if (!m_sinkInfoList.empty() && !force)
@@ -903,6 +1008,22 @@ void CActiveAESink::ReturnBuffers()
 {
   Message *msg = nullptr;
   CSampleBuffer *samples;
+  QueuedSample queued;
+  while (m_sampleQueue.Pop(queued))
+    ReturnSample(nullptr, queued.samples);
+
+  if (m_deferredMsg)
+  {
+    msg = m_deferredMsg;
+    m_deferredMsg = nullptr;
+    if (msg->signal == CSinkDataProtocol::SAMPLE)
+    {
+      samples = *((CSampleBuffer**)msg->data);
+      msg->Reply(CSinkDataProtocol::RETURNSAMPLE, &samples, sizeof(CSampleBuffer*));
+    }
+    msg->Release();
+  }
+
   while (m_dataPort.ReceiveOutMessage(&msg))
   {
     if (msg->signal == CSinkDataProtocol::SAMPLE)
@@ -20,12 +20,14 @@
  */
 
 #include "threads/Event.h"
+#include "threads/SPSCQueue.h"
 #include "threads/Thread.h"
 #include "utils/ActorProtocol.h"
 #include "cores/AudioEngine/Interfaces/AE.h"
 #include "cores/AudioEngine/Interfaces/AESink.h"
 #include "cores/AudioEngine/AESinkFactory.h"
 #include "cores/AudioEngine/Engines/ActiveAE/ActiveAEBuffer.h"
+#include "cores/AudioEngine/Utils/AELatencyHistogram.h"
 
 class CAEBitstreamPacker;
 
@@ -102,6 +104,22 @@ public:
   AEDeviceType GetDeviceType(const std::string &device);
   bool HasPassthroughDevice();
   bool SupportsFormat(const std::string &device, AEAudioFormat &format);
+
+  /*!
+   \brief Pass samples to the sink without a message of m_dataPort
+   Only to be called by the engine thread. The samples are output before any
+   SAMPLE or DRAIN message sent afterwards and come back through
+   ReceiveReturnedSample().
+   \return false if the queue is full
+   */
+  bool QueueSample(CSampleBuffer *samples);
+
+  /*!
+   \brief Get samples that were passed with QueueSample() back
+   Only to be called by the engine thread.
+   */
+  bool ReceiveReturnedSample(CSampleBuffer *&samples);
+
   CSinkControlProtocol m_controlPort;
   CSinkDataProtocol m_dataPort;
 
@@ -112,6 +130,9 @@ protected:
   void GetDeviceFriendlyName(std::string &device);
   void OpenSink();
   void ReturnBuffers();
+  CSampleBuffer* GetSample(Message *msg);
+  void ReturnSample(Message *msg, CSampleBuffer *samples);
+  void LogLatency();
   void SetSilenceTimer();
   bool NeedIECPacking();
 
@@ -152,6 +173,20 @@ protected:
   CAEBitstreamPacker *m_packer;
   bool m_needIecPack;
   bool m_streamNoise;
+
+  // data path without messages, see QueueSample()
+  struct QueuedSample
+  {
+    CSampleBuffer *samples;
+    int64_t queued;
+  };
+  CSPSCQueue<QueuedSample> m_sampleQueue;
+  CSPSCQueue<CSampleBuffer*> m_returnQueue;
+  unsigned int m_queuedSamples; // samples not yet returned, engine thread only
+  CSampleBuffer *m_queueSample; // sample from the queue being processed
+  Message *m_deferredMsg;       // data message received while samples were queued
+  CAELatencyHistogram m_queueLatency;
+  CAELatencyHistogram m_outputLatency;
 };
 
 }
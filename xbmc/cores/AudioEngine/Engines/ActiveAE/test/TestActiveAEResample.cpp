@@ -0,0 +1,204 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Engines/ActiveAE/ActiveAEResampleFFMPEG.h"
+#include "cores/AudioEngine/Engines/ActiveAE/ActiveAEResamplePolyphase.h"
+
+extern "C" {
+#include "libavutil/channel_layout.h"
+}
+
+#include "gtest/gtest.h"
+
+#include <complex>
+#include <math.h>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace ActiveAE;
+
+namespace
+{
+const int PERIOD_FRAMES = 1024;
+const int TEST_FRAMES = 64 * PERIOD_FRAMES;
+
+// largest difference to swresample, relative to full scale
+const double TOLERANCE = 1e-3;
+
+struct ResampleScenario
+{
+  const char *label;
+  int srcRate;
+  int dstRate;
+  uint64_t srcLayout;
+  uint64_t dstLayout;
+};
+
+const ResampleScenario SCENARIOS[] =
+{
+  { "44.1k to 48k",         44100, 48000, AV_CH_LAYOUT_STEREO,  AV_CH_LAYOUT_STEREO },
+  { "48k to 44.1k",         48000, 44100, AV_CH_LAYOUT_STEREO,  AV_CH_LAYOUT_STEREO },
+  { "48k to 96k",           48000, 96000, AV_CH_LAYOUT_STEREO,  AV_CH_LAYOUT_STEREO },
+  { "96k to 48k",           96000, 48000, AV_CH_LAYOUT_STEREO,  AV_CH_LAYOUT_STEREO },
+  { "5.1 48k to 2.0 44.1k", 48000, 44100, AV_CH_LAYOUT_5POINT1, AV_CH_LAYOUT_STEREO },
+};
+
+const struct
+{
+  const char *label;
+  AEQuality quality;
+} QUALITIES[] = {
+  { "low", AE_QUALITY_LOW },
+  { "mid", AE_QUALITY_MID },
+  { "high", AE_QUALITY_HIGH },
+};
+
+IAEResample *CreateResampler(bool polyphase, const ResampleScenario &scenario, AEQuality quality)
+{
+  std::unique_ptr<IAEResample> resampler;
+  if (polyphase)
+    resampler.reset(new CActiveAEResamplePolyphase());
+  else
+    resampler.reset(new CActiveAEResampleFFMPEG());
+
+  const int srcChannels = av_get_channel_layout_nb_channels(scenario.srcLayout);
+  const int dstChannels = av_get_channel_layout_nb_channels(scenario.dstLayout);
+  if (!resampler->Init(scenario.dstLayout, dstChannels, scenario.dstRate, AV_SAMPLE_FMT_FLTP, 32, 0,
+                       scenario.srcLayout, srcChannels, scenario.srcRate, AV_SAMPLE_FMT_FLTP, 32, 0,
+                       false, true, NULL, quality, false))
+    return NULL;
+  return resampler.release();
+}
+
+/*!
+ \brief Resample a sine with a different level and phase on every channel.
+ */
+std::vector<std::vector<float>> ResampleSine(IAEResample *resampler, const ResampleScenario &scenario, double frequency)
+{
+  const int srcChannels = av_get_channel_layout_nb_channels(scenario.srcLayout);
+  const int dstChannels = av_get_channel_layout_nb_channels(scenario.dstLayout);
+  const int dstFrames = resampler->CalcDstSampleCount(PERIOD_FRAMES, scenario.dstRate, scenario.srcRate) * 2;
+
+  std::vector<std::vector<float>> input(srcChannels, std::vector<float>(PERIOD_FRAMES));
+  std::vector<std::vector<float>> output(dstChannels, std::vector<float>(dstFrames));
+  std::vector<std::vector<float>> result(dstChannels);
+  uint8_t *src[AE_CH_MAX], *dst[AE_CH_MAX];
+  for (int ch = 0; ch < srcChannels; ch++)
+    src[ch] = (uint8_t*)input[ch].data();
+  for (int ch = 0; ch < dstChannels; ch++)
+    dst[ch] = (uint8_t*)output[ch].data();
+
+  for (int pos = 0; pos < TEST_FRAMES; pos += PERIOD_FRAMES)
+  {
+    for (int ch = 0; ch < srcChannels; ch++)
+    {
+      for (int i = 0; i < PERIOD_FRAMES; i++)
+        input[ch][i] = 0.5f / (ch + 1) * (float)sin(2.0 * M_PI * frequency * (pos + i) / scenario.srcRate + 0.4 * ch);
+    }
+    int count = resampler->Resample(dst, dstFrames, src, PERIOD_FRAMES, 1.0);
+    if (count <= 0)
+      continue;
+    for (int ch = 0; ch < dstChannels; ch++)
+      result[ch].insert(result[ch].end(), output[ch].begin(), output[ch].begin() + count);
+  }
+  return result;
+}
+
+/*!
+ \brief The sine at the frequency fitted with least squares
+
+ Returns the complex amplitude and in noise the rms of the rest. The start is
+ skipped so the filter has settled.
+ */
+std::complex<double> FitSine(const std::vector<float> &samples, double frequency, int rate, double &noise)
+{
+  const unsigned int skip = samples.size() / 4;
+  double ss = 0.0, cc = 0.0, sc = 0.0, sy = 0.0, cy = 0.0;
+  for (unsigned int i = skip; i < samples.size(); i++)
+  {
+    const double s = sin(2.0 * M_PI * frequency * i / rate);
+    const double c = cos(2.0 * M_PI * frequency * i / rate);
+    ss += s * s;
+    cc += c * c;
+    sc += s * c;
+    sy += s * samples[i];
+    cy += c * samples[i];
+  }
+  const double det = ss * cc - sc * sc;
+  const double a = (sy * cc - cy * sc) / det;
+  const double b = (cy * ss - sy * sc) / det;
+
+  double sum = 0.0;
+  for (unsigned int i = skip; i < samples.size(); i++)
+  {
+    const double fit = a * sin(2.0 * M_PI * frequency * i / rate) + b * cos(2.0 * M_PI * frequency * i / rate);
+    sum += (samples[i] - fit) * (samples[i] - fit);
+  }
+  noise = sqrt(sum / (samples.size() - skip));
+  return std::complex<double>(b, -a);
+}
+}
+
+// The filters of both backends delay the output differently, so the sines
+// are compared with the phase of the first channel lined up. What is left
+// is the difference in gain, downmix and relative phase of the channels.
+TEST(TestActiveAEResample, PolyphaseMatchesFFMPEG)
+{
+  const double frequencies[] = { 1000.0, 6000.0 };
+
+  for (const ResampleScenario &scenario : SCENARIOS)
+  {
+    for (const auto &quality : QUALITIES)
+    {
+      for (double frequency : frequencies)
+      {
+        const std::string name = std::string(scenario.label) + " " + quality.label +
+                                 " at " + std::to_string((int)frequency) + "Hz";
+        std::unique_ptr<IAEResample> polyphase(CreateResampler(true, scenario, quality.quality));
+        std::unique_ptr<IAEResample> ffmpeg(CreateResampler(false, scenario, quality.quality));
+        ASSERT_TRUE(polyphase && ffmpeg) << name;
+        ASSERT_STREQ("ActiveAEResamplePolyphase", polyphase->GetName()) << name;
+
+        std::vector<std::vector<float>> expected = ResampleSine(ffmpeg.get(), scenario, frequency);
+        std::vector<std::vector<float>> actual = ResampleSine(polyphase.get(), scenario, frequency);
+        const size_t minFrames = (int64_t)TEST_FRAMES * scenario.dstRate / scenario.srcRate / 2;
+        ASSERT_EQ(expected.size(), actual.size()) << name;
+        ASSERT_GT(expected[0].size(), minFrames) << name;
+        ASSERT_GT(actual[0].size(), minFrames) << name;
+
+        std::complex<double> delay;
+        for (unsigned int ch = 0; ch < expected.size(); ch++)
+        {
+          double expectedNoise, actualNoise;
+          const std::complex<double> expectedSine = FitSine(expected[ch], frequency, scenario.dstRate, expectedNoise);
+          const std::complex<double> actualSine = FitSine(actual[ch], frequency, scenario.dstRate, actualNoise);
+          if (ch == 0)
+            delay = std::polar(1.0, std::arg(actualSine) - std::arg(expectedSine));
+
+          EXPECT_NEAR(0.0, std::abs(actualSine - expectedSine * delay), TOLERANCE) << name << " channel " << ch;
+          EXPECT_GT(TOLERANCE, expectedNoise) << name << " channel " << ch;
+          EXPECT_GT(TOLERANCE, actualNoise) << name << " channel " << ch;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,610 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AEKernels.h"
+#include "utils/CPUInfo.h"
+
+#include <algorithm>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP > 1)
+#include <emmintrin.h>
+#define HAS_AE_KERNELS_SSE2
+#if defined(__GNUC__)
+#include <immintrin.h>
+#define HAS_AE_KERNELS_AVX2
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER)
+#include <immintrin.h>
+#define HAS_AE_KERNELS_AVX2
+#define TARGET_AVX2
+#endif
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAS_AE_KERNELS_NEON
+#endif
+
+struct CAEKernels::Kernels
+{
+  const char *name;
+  void (*mul)(float *data, const float *src, float gain, unsigned int count);
+  void (*mulAdd)(float *data, const float *src, float gain, unsigned int count);
+  void (*mulGains)(float *data, const float *src, const float *gains, unsigned int frames, unsigned int channels);
+  void (*mulAddGains)(float *data, const float *src, const float *gains, unsigned int frames, unsigned int channels);
+  float (*peak)(const float *data, unsigned int count);
+  void (*softClamp)(float *data, unsigned int count);
+  float (*dot)(const float *a, const float *b, unsigned int count);
+};
+
+namespace
+{
+// the multiply and mix kernels share their loops, Add selects whether
+// src * gain is added to data or data is multiplied with gain
+
+inline float SoftClampSample(float x)
+{
+  // see CAEUtil::SoftClamp()
+  if (x < -3.0f)
+    return -1.0f;
+  else if (x > 3.0f)
+    return 1.0f;
+  float y = x * x;
+  return x * (27.0f + y) / (27.0f + 9.0f * y);
+}
+
+template<bool Add>
+void ApplyGainC(float *data, const float *src, float gain, unsigned int count)
+{
+  for (unsigned int i = 0; i < count; i++)
+    data[i] = Add ? data[i] + src[i] * gain : data[i] * gain;
+}
+
+template<bool Add>
+void ApplyGainsC(float *data, const float *src, const float *gains, unsigned int frames, unsigned int channels)
+{
+  for (unsigned int f = 0; f < frames; f++, data += channels, src += Add ? channels : 0)
+    ApplyGainC<Add>(data, src, gains[f], channels);
+}
+
+float PeakC(const float *data, unsigned int count)
+{
+  float peak = 0.0f;
+  for (unsigned int i = 0; i < count; i++)
+    peak = std::max(peak, fabsf(data[i]));
+  return peak;
+}
+
+void SoftClampC(float *data, unsigned int count)
+{
+  for (unsigned int i = 0; i < count; i++)
+    data[i] = SoftClampSample(data[i]);
+}
+
+float DotC(const float *a, const float *b, unsigned int count)
+{
+  float sum = 0.0f;
+  for (unsigned int i = 0; i < count; i++)
+    sum += a[i] * b[i];
+  return sum;
+}
+
+const CAEKernels::Kernels KERNELS_C = {
+  "c",
+  ApplyGainC<false>,
+  ApplyGainC<true>,
+  ApplyGainsC<false>,
+  ApplyGainsC<true>,
+  PeakC,
+  SoftClampC,
+  DotC
+};
+
+#ifdef HAS_AE_KERNELS_SSE2
+template<bool Add>
+inline __m128 ApplySSE2(const float *data, const float *src, __m128 gain)
+{
+  if (Add)
+    return _mm_add_ps(_mm_loadu_ps(data), _mm_mul_ps(_mm_loadu_ps(src), gain));
+  return _mm_mul_ps(_mm_loadu_ps(data), gain);
+}
+
+template<bool Add>
+void ApplyGainSSE2(float *data, const float *src, float gain, unsigned int count)
+{
+  const __m128 g = _mm_set1_ps(gain);
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m128 a = ApplySSE2<Add>(data + i, src + i, g);
+    __m128 b = ApplySSE2<Add>(data + i + 4, src + i + 4, g);
+    _mm_storeu_ps(data + i, a);
+    _mm_storeu_ps(data + i + 4, b);
+  }
+  for (; i + 4 <= count; i += 4)
+    _mm_storeu_ps(data + i, ApplySSE2<Add>(data + i, src + i, g));
+  ApplyGainC<Add>(data + i, src + i, gain, count - i);
+}
+
+template<bool Add>
+void ApplyGainsSSE2(float *data, const float *src, const float *gains, unsigned int frames, unsigned int channels)
+{
+  unsigned int f = 0;
+  if (channels == 1)
+  {
+    for (; f + 4 <= frames; f += 4)
+    {
+      __m128 g = _mm_loadu_ps(gains + f);
+      _mm_storeu_ps(data + f, ApplySSE2<Add>(data + f, src + f, g));
+    }
+  }
+  else if (channels == 2)
+  {
+    // four stereo frames with two vectors
+    for (; f + 4 <= frames; f += 4)
+    {
+      __m128 g = _mm_loadu_ps(gains + f);
+      __m128 a = ApplySSE2<Add>(data + f * 2, src + f * 2, _mm_unpacklo_ps(g, g));
+      __m128 b = ApplySSE2<Add>(data + f * 2 + 4, src + f * 2 + 4, _mm_unpackhi_ps(g, g));
+      _mm_storeu_ps(data + f * 2, a);
+      _mm_storeu_ps(data + f * 2 + 4, b);
+    }
+  }
+  else if (channels >= 4)
+  {
+    for (; f < frames; f++)
+    {
+      float *frame = data + f * channels;
+      const float *srcFrame = src + f * channels;
+      const __m128 g = _mm_set1_ps(gains[f]);
+      unsigned int c = 0;
+      for (; c + 4 <= channels; c += 4)
+        _mm_storeu_ps(frame + c, ApplySSE2<Add>(frame + c, srcFrame + c, g));
+      ApplyGainC<Add>(frame + c, srcFrame + c, gains[f], channels - c);
+    }
+  }
+
+  ApplyGainsC<Add>(data + f * channels, src + f * channels, gains + f, frames - f, channels);
+}
+
+float PeakSSE2(const float *data, unsigned int count)
+{
+  const __m128 mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+  __m128 peak = _mm_setzero_ps();
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4)
+    peak = _mm_max_ps(peak, _mm_and_ps(_mm_loadu_ps(data + i), mask));
+
+  peak = _mm_max_ps(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(1, 0, 3, 2)));
+  peak = _mm_max_ps(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(2, 3, 0, 1)));
+  return std::max(_mm_cvtss_f32(peak), PeakC(data + i, count - i));
+}
+
+void SoftClampSSE2(float *data, unsigned int count)
+{
+  const __m128 c27 = _mm_set1_ps(27.0f);
+  const __m128 c9 = _mm_set1_ps(9.0f);
+  const __m128 c3 = _mm_set1_ps(3.0f);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 sign = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 x = _mm_loadu_ps(data + i);
+    __m128 y = _mm_mul_ps(x, x);
+    __m128 clamped = _mm_div_ps(_mm_mul_ps(x, _mm_add_ps(c27, y)), _mm_add_ps(c27, _mm_mul_ps(c9, y)));
+    // +-1 beyond +-3
+    __m128 outside = _mm_cmpgt_ps(_mm_andnot_ps(sign, x), c3);
+    __m128 limit = _mm_or_ps(_mm_and_ps(x, sign), one);
+    _mm_storeu_ps(data + i, _mm_or_ps(_mm_and_ps(outside, limit), _mm_andnot_ps(outside, clamped)));
+  }
+  SoftClampC(data + i, count - i);
+}
+
+float DotSSE2(const float *a, const float *b, unsigned int count)
+{
+  // two accumulators hide the latency of the additions
+  __m128 sum0 = _mm_setzero_ps();
+  __m128 sum1 = _mm_setzero_ps();
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+  }
+  if (i + 4 <= count)
+  {
+    sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    i += 4;
+  }
+
+  sum0 = _mm_add_ps(sum0, sum1);
+  sum0 = _mm_add_ps(sum0, _mm_shuffle_ps(sum0, sum0, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum0 = _mm_add_ps(sum0, _mm_shuffle_ps(sum0, sum0, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtss_f32(sum0) + DotC(a + i, b + i, count - i);
+}
+
+const CAEKernels::Kernels KERNELS_SSE2 = {
+  "sse2",
+  ApplyGainSSE2<false>,
+  ApplyGainSSE2<true>,
+  ApplyGainsSSE2<false>,
+  ApplyGainsSSE2<true>,
+  PeakSSE2,
+  SoftClampSSE2,
+  DotSSE2
+};
+#endif
+
+#ifdef HAS_AE_KERNELS_AVX2
+template<bool Add>
+TARGET_AVX2 inline __m256 ApplyAVX2(const float *data, const float *src, __m256 gain)
+{
+  if (Add)
+    return _mm256_add_ps(_mm256_loadu_ps(data), _mm256_mul_ps(_mm256_loadu_ps(src), gain));
+  return _mm256_mul_ps(_mm256_loadu_ps(data), gain);
+}
+
+template<bool Add>
+TARGET_AVX2 void ApplyGainAVX2(float *data, const float *src, float gain, unsigned int count)
+{
+  const __m256 g = _mm256_set1_ps(gain);
+  unsigned int i = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    __m256 a = ApplyAVX2<Add>(data + i, src + i, g);
+    __m256 b = ApplyAVX2<Add>(data + i + 8, src + i + 8, g);
+    _mm256_storeu_ps(data + i, a);
+    _mm256_storeu_ps(data + i + 8, b);
+  }
+  for (; i + 8 <= count; i += 8)
+    _mm256_storeu_ps(data + i, ApplyAVX2<Add>(data + i, src + i, g));
+
+  // avoid the penalty of mixing AVX and SSE code
+  _mm256_zeroupper();
+  ApplyGainC<Add>(data + i, src + i, gain, count - i);
+}
+
+template<bool Add>
+TARGET_AVX2 void ApplyGainsAVX2(float *data, const float *src, const float *gains, unsigned int frames, unsigned int channels)
+{
+  unsigned int f = 0;
+  if (channels == 1)
+  {
+    for (; f + 8 <= frames; f += 8)
+      _mm256_storeu_ps(data + f, ApplyAVX2<Add>(data + f, src + f, _mm256_loadu_ps(gains + f)));
+  }
+  else if (channels == 2)
+  {
+    // eight stereo frames with two vectors
+    const __m256i low = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    const __m256i high = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+    for (; f + 8 <= frames; f += 8)
+    {
+      __m256 g = _mm256_loadu_ps(gains + f);
+      __m256 a = ApplyAVX2<Add>(data + f * 2, src + f * 2, _mm256_permutevar8x32_ps(g, low));
+      __m256 b = ApplyAVX2<Add>(data + f * 2 + 8, src + f * 2 + 8, _mm256_permutevar8x32_ps(g, high));
+      _mm256_storeu_ps(data + f * 2, a);
+      _mm256_storeu_ps(data + f * 2 + 8, b);
+    }
+  }
+  else if (channels >= 8)
+  {
+    for (; f < frames; f++)
+    {
+      float *frame = data + f * channels;
+      const float *srcFrame = src + f * channels;
+      const __m256 g = _mm256_set1_ps(gains[f]);
+      unsigned int c = 0;
+      for (; c + 8 <= channels; c += 8)
+        _mm256_storeu_ps(frame + c, ApplyAVX2<Add>(frame + c, srcFrame + c, g));
+      ApplyGainC<Add>(frame + c, srcFrame + c, gains[f], channels - c);
+    }
+  }
+
+  _mm256_zeroupper();
+  // 5.1 and the like are handled with SSE
+  ApplyGainsSSE2<Add>(data + f * channels, src + f * channels, gains + f, frames - f, channels);
+}
+
+TARGET_AVX2 float PeakAVX2(const float *data, unsigned int count)
+{
+  const __m256 mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+  __m256 peak = _mm256_setzero_ps();
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8)
+    peak = _mm256_max_ps(peak, _mm256_and_ps(_mm256_loadu_ps(data + i), mask));
+
+  __m128 peak4 = _mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1));
+  peak4 = _mm_max_ps(peak4, _mm_shuffle_ps(peak4, peak4, _MM_SHUFFLE(1, 0, 3, 2)));
+  peak4 = _mm_max_ps(peak4, _mm_shuffle_ps(peak4, peak4, _MM_SHUFFLE(2, 3, 0, 1)));
+  float result = _mm_cvtss_f32(peak4);
+  _mm256_zeroupper();
+  return std::max(result, PeakC(data + i, count - i));
+}
+
+TARGET_AVX2 void SoftClampAVX2(float *data, unsigned int count)
+{
+  const __m256 c27 = _mm256_set1_ps(27.0f);
+  const __m256 c9 = _mm256_set1_ps(9.0f);
+  const __m256 c3 = _mm256_set1_ps(3.0f);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 sign = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 x = _mm256_loadu_ps(data + i);
+    __m256 y = _mm256_mul_ps(x, x);
+    __m256 clamped = _mm256_div_ps(_mm256_mul_ps(x, _mm256_add_ps(c27, y)), _mm256_add_ps(c27, _mm256_mul_ps(c9, y)));
+    __m256 outside = _mm256_cmp_ps(_mm256_andnot_ps(sign, x), c3, _CMP_GT_OQ);
+    __m256 limit = _mm256_or_ps(_mm256_and_ps(x, sign), one);
+    _mm256_storeu_ps(data + i, _mm256_blendv_ps(clamped, limit, outside));
+  }
+  _mm256_zeroupper();
+  SoftClampC(data + i, count - i);
+}
+
+TARGET_AVX2 float DotAVX2(const float *a, const float *b, unsigned int count)
+{
+  __m256 sum0 = _mm256_setzero_ps();
+  __m256 sum1 = _mm256_setzero_ps();
+  unsigned int i = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+  }
+  if (i + 8 <= count)
+  {
+    sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    i += 8;
+  }
+
+  sum0 = _mm256_add_ps(sum0, sum1);
+  __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum0), _mm256_extractf128_ps(sum0, 1));
+  sum4 = _mm_add_ps(sum4, _mm_shuffle_ps(sum4, sum4, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum4 = _mm_add_ps(sum4, _mm_shuffle_ps(sum4, sum4, _MM_SHUFFLE(2, 3, 0, 1)));
+  float result = _mm_cvtss_f32(sum4);
+  _mm256_zeroupper();
+  return result + DotC(a + i, b + i, count - i);
+}
+
+const CAEKernels::Kernels KERNELS_AVX2 = {
+  "avx2",
+  ApplyGainAVX2<false>,
+  ApplyGainAVX2<true>,
+  ApplyGainsAVX2<false>,
+  ApplyGainsAVX2<true>,
+  PeakAVX2,
+  SoftClampAVX2,
+  DotAVX2
+};
+#endif
+
+#ifdef HAS_AE_KERNELS_NEON
+template<bool Add>
+inline float32x4_t ApplyNEON(const float *data, const float *src, float32x4_t gain)
+{
+  if (Add)
+    return vmlaq_f32(vld1q_f32(data), vld1q_f32(src), gain);
+  return vmulq_f32(vld1q_f32(data), gain);
+}
+
+template<bool Add>
+void ApplyGainNEON(float *data, const float *src, float gain, unsigned int count)
+{
+  const float32x4_t g = vdupq_n_f32(gain);
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    float32x4_t a = ApplyNEON<Add>(data + i, src + i, g);
+    float32x4_t b = ApplyNEON<Add>(data + i + 4, src + i + 4, g);
+    vst1q_f32(data + i, a);
+    vst1q_f32(data + i + 4, b);
+  }
+  for (; i + 4 <= count; i += 4)
+    vst1q_f32(data + i, ApplyNEON<Add>(data + i, src + i, g));
+  ApplyGainC<Add>(data + i, src + i, gain, count - i);
+}
+
+template<bool Add>
+void ApplyGainsNEON(float *data, const float *src, const float *gains, unsigned int frames, unsigned int channels)
+{
+  unsigned int f = 0;
+  if (channels == 1)
+  {
+    for (; f + 4 <= frames; f += 4)
+      vst1q_f32(data + f, ApplyNEON<Add>(data + f, src + f, vld1q_f32(gains + f)));
+  }
+  else if (channels == 2)
+  {
+    for (; f + 4 <= frames; f += 4)
+    {
+      float32x4x2_t g = vzipq_f32(vld1q_f32(gains + f), vld1q_f32(gains + f));
+      float32x4_t a = ApplyNEON<Add>(data + f * 2, src + f * 2, g.val[0]);
+      float32x4_t b = ApplyNEON<Add>(data + f * 2 + 4, src + f * 2 + 4, g.val[1]);
+      vst1q_f32(data + f * 2, a);
+      vst1q_f32(data + f * 2 + 4, b);
+    }
+  }
+  else if (channels >= 4)
+  {
+    for (; f < frames; f++)
+    {
+      float *frame = data + f * channels;
+      const float *srcFrame = src + f * channels;
+      const float32x4_t g = vdupq_n_f32(gains[f]);
+      unsigned int c = 0;
+      for (; c + 4 <= channels; c += 4)
+        vst1q_f32(frame + c, ApplyNEON<Add>(frame + c, srcFrame + c, g));
+      ApplyGainC<Add>(frame + c, srcFrame + c, gains[f], channels - c);
+    }
+  }
+
+  ApplyGainsC<Add>(data + f * channels, src + f * channels, gains + f, frames - f, channels);
+}
+
+float PeakNEON(const float *data, unsigned int count)
+{
+  float32x4_t peak = vdupq_n_f32(0.0f);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4)
+    peak = vmaxq_f32(peak, vabsq_f32(vld1q_f32(data + i)));
+
+  float32x2_t peak2 = vpmax_f32(vget_low_f32(peak), vget_high_f32(peak));
+  peak2 = vpmax_f32(peak2, peak2);
+  return std::max(vget_lane_f32(peak2, 0), PeakC(data + i, count - i));
+}
+
+void SoftClampNEON(float *data, unsigned int count)
+{
+  const float32x4_t c27 = vdupq_n_f32(27.0f);
+  const float32x4_t c9 = vdupq_n_f32(9.0f);
+  const float32x4_t c3 = vdupq_n_f32(3.0f);
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  const uint32x4_t sign = vdupq_n_u32(0x80000000);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    float32x4_t x = vld1q_f32(data + i);
+    float32x4_t y = vmulq_f32(x, x);
+    float32x4_t numerator = vmulq_f32(x, vaddq_f32(c27, y));
+    float32x4_t denominator = vmlaq_f32(c27, c9, y);
+    // there is no division, refine the reciprocal estimate twice instead
+    float32x4_t reciprocal = vrecpeq_f32(denominator);
+    reciprocal = vmulq_f32(vrecpsq_f32(denominator, reciprocal), reciprocal);
+    reciprocal = vmulq_f32(vrecpsq_f32(denominator, reciprocal), reciprocal);
+    float32x4_t clamped = vmulq_f32(numerator, reciprocal);
+
+    uint32x4_t outside = vcagtq_f32(x, c3);
+    float32x4_t limit = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(vreinterpretq_u32_f32(x), sign), vreinterpretq_u32_f32(one)));
+    vst1q_f32(data + i, vbslq_f32(outside, limit, clamped));
+  }
+  SoftClampC(data + i, count - i);
+}
+
+float DotNEON(const float *a, const float *b, unsigned int count)
+{
+  float32x4_t sum0 = vdupq_n_f32(0.0f);
+  float32x4_t sum1 = vdupq_n_f32(0.0f);
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    sum0 = vmlaq_f32(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+    sum1 = vmlaq_f32(sum1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+  }
+  if (i + 4 <= count)
+  {
+    sum0 = vmlaq_f32(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+    i += 4;
+  }
+
+  sum0 = vaddq_f32(sum0, sum1);
+  float32x2_t sum2 = vadd_f32(vget_low_f32(sum0), vget_high_f32(sum0));
+  sum2 = vpadd_f32(sum2, sum2);
+  return vget_lane_f32(sum2, 0) + DotC(a + i, b + i, count - i);
+}
+
+const CAEKernels::Kernels KERNELS_NEON = {
+  "neon",
+  ApplyGainNEON<false>,
+  ApplyGainNEON<true>,
+  ApplyGainsNEON<false>,
+  ApplyGainsNEON<true>,
+  PeakNEON,
+  SoftClampNEON,
+  DotNEON
+};
+#endif
+}
+
+std::atomic<const CAEKernels::Kernels*> CAEKernels::m_kernels(nullptr);
+
+const char* CAEKernels::Select(unsigned int cpuFeatures)
+{
+  const Kernels *kernels = &KERNELS_C;
+#ifdef HAS_AE_KERNELS_SSE2
+  if (cpuFeatures & CPU_FEATURE_SSE2)
+    kernels = &KERNELS_SSE2;
+#endif
+#ifdef HAS_AE_KERNELS_AVX2
+  if ((cpuFeatures & CPU_FEATURE_SSE2) && (cpuFeatures & CPU_FEATURE_AVX2))
+    kernels = &KERNELS_AVX2;
+#endif
+#ifdef HAS_AE_KERNELS_NEON
+  if (cpuFeatures & CPU_FEATURE_NEON)
+    kernels = &KERNELS_NEON;
+#endif
+
+  m_kernels = kernels;
+  return kernels->name;
+}
+
+const CAEKernels::Kernels& CAEKernels::Get()
+{
+  const Kernels *kernels = m_kernels;
+  if (kernels == nullptr)
+  {
+    Select(g_cpuInfo.GetCPUFeatures());
+    kernels = m_kernels;
+  }
+  return *kernels;
+}
+
+const char* CAEKernels::GetName()
+{
+  return Get().name;
+}
+
+void CAEKernels::Mul(float *data, float gain, unsigned int count)
+{
+  Get().mul(data, data, gain, count);
+}
+
+void CAEKernels::MulAdd(float *data, const float *src, float gain, unsigned int count)
+{
+  Get().mulAdd(data, src, gain, count);
+}
+
+void CAEKernels::MulGains(float *data, const float *gains, unsigned int frames, unsigned int channels)
+{
+  Get().mulGains(data, data, gains, frames, channels);
+}
+
+void CAEKernels::MulAddGains(float *data, const float *src, const float *gains, unsigned int frames, unsigned int channels)
+{
+  Get().mulAddGains(data, src, gains, frames, channels);
+}
+
+float CAEKernels::Peak(const float *data, unsigned int count)
+{
+  return Get().peak(data, count);
+}
+
+void CAEKernels::SoftClamp(float *data, unsigned int count)
+{
+  Get().softClamp(data, count);
+}
+
+float CAEKernels::Dot(const float *a, const float *b, unsigned int count)
+{
+  return Get().dot(a, b, count);
+}
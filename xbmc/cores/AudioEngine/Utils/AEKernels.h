@@ -0,0 +1,70 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+
+/**
+ * @brief Sample processing kernels used for mixing in the audio engine.
+ *
+ * The implementation is picked once at runtime from the features reported by
+ * CCPUInfo (AVX2, SSE2 or NEON, plain C++ otherwise). None of the kernels
+ * require aligned buffers. Interleaved buffers hold frames of channels
+ * samples, planar buffers are passed plane by plane with a single channel.
+ */
+class CAEKernels
+{
+public:
+  /*! \brief data[i] *= gain */
+  static void Mul(float *data, float gain, unsigned int count);
+  /*! \brief data[i] += src[i] * gain */
+  static void MulAdd(float *data, const float *src, float gain, unsigned int count);
+
+  /*! \brief Multiply every sample of frame f with gains[f] */
+  static void MulGains(float *data, const float *gains, unsigned int frames, unsigned int channels);
+  /*! \brief Add every sample of frame f of src multiplied with gains[f] */
+  static void MulAddGains(float *data, const float *src, const float *gains, unsigned int frames, unsigned int channels);
+
+  /*! \brief The largest absolute value of the samples */
+  static float Peak(const float *data, unsigned int count);
+  /*! \brief Softly limit the samples to [-1, 1], see CAEUtil::ClampArray() */
+  static void SoftClamp(float *data, unsigned int count);
+
+  /*! \brief The sum of a[i] * b[i], used for FIR filters */
+  static float Dot(const float *a, const float *b, unsigned int count);
+
+  /*! \brief The name of the selected implementation, e.g. "avx2" */
+  static const char* GetName();
+
+  /*! \brief Use the best implementation for the given CPU_FEATURE_* flags
+   Done automatically with the features of the CPU, this is meant for
+   comparing the implementations in tests and benchmarks.
+   \return the name of the selected implementation
+   */
+  static const char* Select(unsigned int cpuFeatures);
+
+  struct Kernels;
+
+private:
+  CAEKernels() = delete;
+
+  static const Kernels& Get();
+  static std::atomic<const Kernels*> m_kernels;
+};
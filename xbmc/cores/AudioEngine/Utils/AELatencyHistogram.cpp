@@ -0,0 +1,107 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AELatencyHistogram.h"
+#include "utils/StringUtils.h"
+
+namespace
+{
+std::string FormatMicroseconds(int64_t microseconds)
+{
+  if (microseconds < 1000)
+    return StringUtils::Format("%dus", (int)microseconds);
+  return StringUtils::Format("%.1fms", microseconds / 1000.0);
+}
+}
+
+CAELatencyHistogram::CAELatencyHistogram()
+{
+  Reset();
+}
+
+void CAELatencyHistogram::Add(int64_t microseconds)
+{
+  unsigned int bucket = 0;
+  while (bucket < BUCKETS - 1 && microseconds >= ((int64_t)2 << bucket))
+    bucket++;
+
+  // only one thread adds, so there is no need for read-modify-write operations
+  m_buckets[bucket].store(m_buckets[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  if (microseconds > m_max.load(std::memory_order_relaxed))
+    m_max.store(microseconds, std::memory_order_relaxed);
+}
+
+void CAELatencyHistogram::Reset()
+{
+  for (unsigned int i = 0; i < BUCKETS; i++)
+    m_buckets[i] = 0;
+  m_count = 0;
+  m_max = 0;
+}
+
+uint64_t CAELatencyHistogram::GetCount() const
+{
+  return m_count.load(std::memory_order_relaxed);
+}
+
+uint64_t CAELatencyHistogram::GetBucket(unsigned int bucket) const
+{
+  if (bucket >= BUCKETS)
+    return 0;
+  return m_buckets[bucket].load(std::memory_order_relaxed);
+}
+
+int64_t CAELatencyHistogram::GetMax() const
+{
+  return m_max.load(std::memory_order_relaxed);
+}
+
+int64_t CAELatencyHistogram::GetPercentile(double percentile) const
+{
+  uint64_t count = GetCount();
+  if (count == 0)
+    return 0;
+
+  uint64_t rank = (uint64_t)(count * percentile / 100.0);
+  if (rank >= count)
+    rank = count - 1;
+
+  uint64_t seen = 0;
+  for (unsigned int i = 0; i < BUCKETS - 1; i++)
+  {
+    seen += GetBucket(i);
+    if (seen > rank)
+      return (int64_t)2 << i;
+  }
+  return GetMax();
+}
+
+std::string CAELatencyHistogram::ToString() const
+{
+  if (GetCount() == 0)
+    return "no samples";
+
+  return StringUtils::Format("%llu samples, p50 < %s, p99 < %s, max %s",
+                             (unsigned long long)GetCount(),
+                             FormatMicroseconds(GetPercentile(50.0)).c_str(),
+                             FormatMicroseconds(GetPercentile(99.0)).c_str(),
+                             FormatMicroseconds(GetMax()).c_str());
+}
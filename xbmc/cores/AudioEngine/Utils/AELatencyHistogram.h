@@ -0,0 +1,62 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+/**
+ * @brief Histogram of latencies with power of two buckets.
+ *
+ * Bucket n counts latencies from 2^n up to 2^(n+1) microseconds, the first
+ * bucket includes everything below 2us and the last one everything above.
+ * Add() must only be called by one thread at a time and neither locks nor
+ * allocates, the getters can be called from any thread.
+ */
+class CAELatencyHistogram
+{
+public:
+  static const unsigned int BUCKETS = 24;
+
+  CAELatencyHistogram();
+
+  void Add(int64_t microseconds);
+  void Reset();
+
+  uint64_t GetCount() const;
+  uint64_t GetBucket(unsigned int bucket) const;
+  int64_t GetMax() const;
+
+  /*!
+   \brief The upper bound of the bucket the given percentile falls in
+   \param percentile 0 - 100
+   \return microseconds, 0 if nothing was added
+   */
+  int64_t GetPercentile(double percentile) const;
+
+  /*! \brief Summary for logging, e.g. "1200 samples, p50 < 4ms, p99 < 8ms, max 5.3ms" */
+  std::string ToString() const;
+
+private:
+  std::atomic<uint64_t> m_buckets[BUCKETS];
+  std::atomic<uint64_t> m_count;
+  std::atomic<int64_t> m_max;
+};
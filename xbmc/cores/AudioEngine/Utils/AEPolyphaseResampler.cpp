@@ -0,0 +1,274 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AEPolyphaseResampler.h"
+#include "AEKernels.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+// largest interpolation factor after reducing the ratio, 44.1kHz -> 48kHz
+// needs 160, 44.1kHz -> 96kHz 320
+#define MAX_INTERPOLATION 320
+// largest decimation relative to the interpolation, 192kHz -> 48kHz
+#define MAX_DECIMATION 4
+// rows of the filter table if the interpolation is smaller, ratio deviations
+// interpolate linearly between the rows
+#define MIN_PHASES 256
+
+namespace
+{
+struct FilterQuality
+{
+  unsigned int taps;
+  double cutoff;  // relative to the lower nyquist frequency
+  double beta;    // Kaiser window
+};
+
+// the transition band is centered at the cutoff, the longer filters get
+// closer to nyquist with a better stopband
+const FilterQuality QUALITY_LOW  = {  32, 0.88,  7.0 };
+const FilterQuality QUALITY_MID  = {  64, 0.94,  8.5 };
+const FilterQuality QUALITY_HIGH = { 128, 0.96, 10.0 };
+
+const FilterQuality& GetFilterQuality(AEQuality quality)
+{
+  switch (quality)
+  {
+    case AE_QUALITY_LOW:
+      return QUALITY_LOW;
+    case AE_QUALITY_HIGH:
+    case AE_QUALITY_REALLYHIGH:
+    case AE_QUALITY_GPU:
+      return QUALITY_HIGH;
+    default:
+      return QUALITY_MID;
+  }
+}
+
+unsigned int GreatestCommonDivisor(unsigned int a, unsigned int b)
+{
+  while (b)
+  {
+    unsigned int t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// modified Bessel function of the first kind, order 0
+double BesselI0(double x)
+{
+  double sum = 1.0;
+  double term = 1.0;
+  const double y = x * x / 4.0;
+  for (int k = 1; k < 50 && term > sum * 1e-12; k++)
+  {
+    term *= y / ((double)k * k);
+    sum += term;
+  }
+  return sum;
+}
+}
+
+CAEPolyphaseResampler::CAEPolyphaseResampler() :
+  m_channels(0),
+  m_interpolation(1),
+  m_decimation(1),
+  m_phases(1),
+  m_taps(0),
+  m_cutoff(1.0),
+  m_beta(0.0),
+  m_pos(0),
+  m_phase(0),
+  m_padding(0)
+{
+}
+
+bool CAEPolyphaseResampler::IsSupported(unsigned int srcRate, unsigned int dstRate)
+{
+  if (srcRate == 0 || dstRate == 0)
+    return false;
+
+  const unsigned int divisor = GreatestCommonDivisor(srcRate, dstRate);
+  const unsigned int interpolation = dstRate / divisor;
+  const unsigned int decimation = srcRate / divisor;
+  return interpolation <= MAX_INTERPOLATION && decimation <= interpolation * MAX_DECIMATION;
+}
+
+bool CAEPolyphaseResampler::Init(unsigned int srcRate, unsigned int dstRate, unsigned int channels, AEQuality quality)
+{
+  if (!IsSupported(srcRate, dstRate) || channels == 0)
+    return false;
+
+  const unsigned int divisor = GreatestCommonDivisor(srcRate, dstRate);
+  m_channels = channels;
+  m_interpolation = dstRate / divisor;
+  m_decimation = srcRate / divisor;
+  m_phases = m_interpolation * std::max(1U, MIN_PHASES / m_interpolation);
+
+  // when decimating the filter covers the same time at the output rate, so
+  // it gets longer in input frames. A multiple of 8 suits the vector kernels.
+  const FilterQuality &filter = GetFilterQuality(quality);
+  const double decimation = std::max(1.0, (double)m_decimation / m_interpolation);
+  m_taps = ((unsigned int)ceil(filter.taps * decimation) + 7) & ~7U;
+  m_cutoff = filter.cutoff / decimation;
+  m_beta = filter.beta;
+  m_filter.clear();
+
+  // start with half a filter of silence, the first output is centered on
+  // the first input frame
+  m_pos = m_taps / 2 - 1;
+  m_phase = 0;
+  m_padding = 0;
+  m_buffers.assign(m_channels, std::vector<float>(m_pos, 0.0f));
+  return true;
+}
+
+void CAEPolyphaseResampler::BuildFilter()
+{
+  const int half = m_taps / 2;
+  const double window = BesselI0(m_beta);
+  m_filter.resize((m_phases + 1) * m_taps);
+
+  // row p is used for outputs p / m_phases after the input frame at m_pos,
+  // tap k multiplies frame m_pos - (half - 1) + k
+  for (unsigned int p = 0; p <= m_phases; p++)
+  {
+    float *row = &m_filter[p * m_taps];
+    double sum = 0.0;
+    for (int k = 0; k < (int)m_taps; k++)
+    {
+      const double t = (double)p / m_phases + half - 1 - k;
+      const double x = t / half;
+      const double sinc = t == 0.0 ? m_cutoff : sin(M_PI * m_cutoff * t) / (M_PI * t);
+      const double value = sinc * BesselI0(m_beta * sqrt(std::max(0.0, 1.0 - x * x))) / window;
+      row[k] = (float)value;
+      sum += value;
+    }
+    // unity gain for DC in every phase
+    for (unsigned int k = 0; k < m_taps; k++)
+      row[k] = (float)(row[k] / sum);
+  }
+}
+
+void CAEPolyphaseResampler::AddFrames(const float * const *src, unsigned int frames)
+{
+  if (!src || frames == 0)
+    return;
+
+  if (m_padding)
+  {
+    // outputs may have stepped a little into the padding already
+    const unsigned int end = std::max((unsigned int)m_buffers[0].size() - m_padding, m_pos);
+    for (unsigned int ch = 0; ch < m_channels; ch++)
+      m_buffers[ch].resize(end);
+    m_padding = 0;
+  }
+
+  for (unsigned int ch = 0; ch < m_channels; ch++)
+    m_buffers[ch].insert(m_buffers[ch].end(), src[ch], src[ch] + frames);
+}
+
+unsigned int CAEPolyphaseResampler::GetFrames(float * const *dst, unsigned int frames, double ratio /* = 1.0 */)
+{
+  if (m_channels == 0)
+    return 0;
+
+  const unsigned int size = m_buffers[0].size();
+  const unsigned int half = m_taps / 2;
+  unsigned int out = 0;
+
+  if (m_interpolation == m_decimation && m_phase == 0 && ratio == 1.0)
+  {
+    const unsigned int end = size - m_padding;
+    out = m_pos < end ? std::min(frames, end - m_pos) : 0;
+    for (unsigned int ch = 0; ch < m_channels; ch++)
+      memcpy(dst[ch], &m_buffers[ch][m_pos], out * sizeof(float));
+    m_pos += out;
+  }
+  else
+  {
+    if (m_filter.empty())
+      BuildFilter();
+
+    const uint64_t phases = (uint64_t)m_phases << 32;
+    const uint64_t step = (uint64_t)llround((double)m_decimation * (m_phases / m_interpolation) / ratio * 4294967296.0);
+    for (; out < frames && m_pos + half < size; out++)
+    {
+      const unsigned int start = m_pos - (half - 1);
+      const float *row = &m_filter[(m_phase >> 32) * m_taps];
+      const uint32_t fraction = (uint32_t)m_phase;
+      if (fraction == 0)
+      {
+        for (unsigned int ch = 0; ch < m_channels; ch++)
+          dst[ch][out] = CAEKernels::Dot(row, &m_buffers[ch][start], m_taps);
+      }
+      else
+      {
+        const float weight = fraction / 4294967296.0f;
+        for (unsigned int ch = 0; ch < m_channels; ch++)
+        {
+          const float a = CAEKernels::Dot(row, &m_buffers[ch][start], m_taps);
+          const float b = CAEKernels::Dot(row + m_taps, &m_buffers[ch][start], m_taps);
+          dst[ch][out] = a + (b - a) * weight;
+        }
+      }
+
+      m_phase += step;
+      while (m_phase >= phases)
+      {
+        m_phase -= phases;
+        m_pos++;
+      }
+    }
+  }
+
+  // drop input older than the filter needs
+  const unsigned int history = half - 1;
+  if (m_pos > history)
+  {
+    for (unsigned int ch = 0; ch < m_channels; ch++)
+      m_buffers[ch].erase(m_buffers[ch].begin(), m_buffers[ch].begin() + (m_pos - history));
+    m_pos = history;
+  }
+  return out;
+}
+
+void CAEPolyphaseResampler::Flush()
+{
+  if (m_padding || GetDelay() <= 0.0)
+    return;
+
+  m_padding = m_taps / 2;
+  for (unsigned int ch = 0; ch < m_channels; ch++)
+    m_buffers[ch].resize(m_buffers[ch].size() + m_padding, 0.0f);
+}
+
+double CAEPolyphaseResampler::GetDelay() const
+{
+  if (m_channels == 0)
+    return 0.0;
+
+  const double pos = m_pos + (double)m_phase / ((uint64_t)m_phases << 32);
+  return std::max(0.0, m_buffers[0].size() - m_padding - pos);
+}
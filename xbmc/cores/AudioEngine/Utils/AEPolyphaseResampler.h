@@ -0,0 +1,97 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Interfaces/AE.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @brief Polyphase FIR resampler for planar float samples.
+ *
+ * Converts between rates with a small rational ratio like 44.1kHz <-> 48kHz
+ * or 48kHz <-> 96kHz. The Kaiser windowed sinc filter is computed once with
+ * one row of coefficients per output phase, so every output sample is a
+ * single dot product (see CAEKernels::Dot). Small deviations of the ratio,
+ * used to keep audio in sync, interpolate between neighbouring rows.
+ *
+ * Input is buffered until it has been used, any number of frames can be
+ * added and fetched. Equal rates are copied through as long as the ratio
+ * stays at 1.0.
+ */
+class CAEPolyphaseResampler
+{
+public:
+  CAEPolyphaseResampler();
+
+  /*! \brief Whether the ratio of the rates is small enough for the filter tables */
+  static bool IsSupported(unsigned int srcRate, unsigned int dstRate);
+
+  /*!
+   \brief Set up the filter, buffered input is dropped
+   \param quality selects the filter length and cutoff, see AEQuality
+   \return false if the rates are not supported
+   */
+  bool Init(unsigned int srcRate, unsigned int dstRate, unsigned int channels, AEQuality quality);
+
+  /*! \brief Append frames of every channel to the input */
+  void AddFrames(const float * const *src, unsigned int frames);
+
+  /*!
+   \brief Resample buffered input into dst
+   \param ratio output rate relative to the nominal one, e.g. 1.001 stretches the input by 0.1%
+   \return frames written to every plane of dst
+   */
+  unsigned int GetFrames(float * const *dst, unsigned int frames, double ratio = 1.0);
+
+  /*!
+   \brief Let the remaining input through the filter when no more follows
+   The look ahead of the filter is padded with silence, input added later
+   replaces the padding.
+   */
+  void Flush();
+
+  /*! \brief Input that has not been resampled yet, in input frames */
+  double GetDelay() const;
+
+  /*! \brief The length of the filter in input frames */
+  unsigned int GetTaps() const { return m_taps; }
+
+private:
+  void BuildFilter();
+
+  unsigned int m_channels;
+  unsigned int m_interpolation;
+  unsigned int m_decimation;
+  unsigned int m_phases;
+  unsigned int m_taps;
+  double m_cutoff;
+  double m_beta;
+  // m_phases + 1 rows of m_taps coefficients, built on first use
+  std::vector<float> m_filter;
+  std::vector<std::vector<float>> m_buffers;
+  // position of the next output: an index into the buffers and the filter
+  // row in 32.32 fixed point
+  unsigned int m_pos;
+  uint64_t m_phase;
+  // silence at the end of the buffers added by Flush()
+  unsigned int m_padding;
+};
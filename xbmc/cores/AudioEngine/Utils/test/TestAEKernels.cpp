@@ -0,0 +1,175 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AEKernels.h"
+#include "utils/CPUInfo.h"
+
+#include "gtest/gtest.h"
+
+#include <math.h>
+#include <vector>
+
+namespace
+{
+std::vector<float> CreateSamples(unsigned int count, float amplitude, unsigned int seed)
+{
+  std::vector<float> samples(count);
+  uint32_t state = seed;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    state = state * 1664525 + 1013904223;
+    samples[i] = ((float)(state >> 8) / (1 << 23) - 1.0f) * amplitude;
+  }
+  return samples;
+}
+
+// every implementation available on this CPU, the plain C++ one first
+std::vector<unsigned int> GetFeatureSets()
+{
+  std::vector<unsigned int> featureSets;
+  featureSets.push_back(0);
+  const unsigned int cpuFeatures = g_cpuInfo.GetCPUFeatures();
+  const unsigned int candidates[] = { CPU_FEATURE_SSE2, CPU_FEATURE_SSE2 | CPU_FEATURE_AVX2, CPU_FEATURE_NEON };
+  for (unsigned int features : candidates)
+  {
+    if ((cpuFeatures & features) == features)
+      featureSets.push_back(features);
+  }
+  return featureSets;
+}
+
+class TestAEKernels : public testing::Test
+{
+protected:
+  ~TestAEKernels()
+  {
+    CAEKernels::Select(g_cpuInfo.GetCPUFeatures());
+  }
+};
+}
+
+TEST_F(TestAEKernels, Select)
+{
+  EXPECT_STREQ("c", CAEKernels::Select(0));
+  EXPECT_STREQ("c", CAEKernels::GetName());
+}
+
+TEST_F(TestAEKernels, Mul)
+{
+  // odd counts run through the vector loops and the remainder
+  const unsigned int counts[] = { 0, 1, 7, 37, 1024 + 5 };
+  for (unsigned int features : GetFeatureSets())
+  {
+    const char *name = CAEKernels::Select(features);
+    for (unsigned int count : counts)
+    {
+      std::vector<float> src = CreateSamples(count, 1.0f, count);
+      std::vector<float> data = CreateSamples(count, 1.0f, count + 1);
+      std::vector<float> mixed = data;
+      std::vector<float> scaled = data;
+      CAEKernels::MulAdd(mixed.data(), src.data(), 0.3f, count);
+      CAEKernels::Mul(scaled.data(), 0.7f, count);
+      for (unsigned int i = 0; i < count; i++)
+      {
+        ASSERT_NEAR(data[i] + src[i] * 0.3f, mixed[i], 1e-6f) << name << " sample " << i;
+        ASSERT_FLOAT_EQ(data[i] * 0.7f, scaled[i]) << name << " sample " << i;
+      }
+    }
+  }
+}
+
+TEST_F(TestAEKernels, MulGains)
+{
+  const unsigned int frames = 67;
+  const unsigned int layouts[] = { 1, 2, 3, 6, 8, 10 };
+  std::vector<float> gains = CreateSamples(frames, 2.0f, 3);
+  for (unsigned int features : GetFeatureSets())
+  {
+    const char *name = CAEKernels::Select(features);
+    for (unsigned int channels : layouts)
+    {
+      std::vector<float> src = CreateSamples(frames * channels, 1.0f, channels);
+      std::vector<float> data = CreateSamples(frames * channels, 1.0f, channels + 1);
+      std::vector<float> mixed = data;
+      std::vector<float> scaled = data;
+      CAEKernels::MulAddGains(mixed.data(), src.data(), gains.data(), frames, channels);
+      CAEKernels::MulGains(scaled.data(), gains.data(), frames, channels);
+      for (unsigned int i = 0; i < frames * channels; i++)
+      {
+        ASSERT_NEAR(data[i] + src[i] * gains[i / channels], mixed[i], 1e-6f) << name << " " << channels << " channels, sample " << i;
+        ASSERT_FLOAT_EQ(data[i] * gains[i / channels], scaled[i]) << name << " " << channels << " channels, sample " << i;
+      }
+    }
+  }
+}
+
+TEST_F(TestAEKernels, Peak)
+{
+  for (unsigned int features : GetFeatureSets())
+  {
+    const char *name = CAEKernels::Select(features);
+    std::vector<float> samples = CreateSamples(101, 0.5f, 4);
+    EXPECT_EQ(0.0f, CAEKernels::Peak(samples.data(), 0)) << name;
+    EXPECT_GE(0.5f, CAEKernels::Peak(samples.data(), samples.size())) << name;
+
+    // the largest sample in the vector part and in the remainder
+    samples[13] = -1.5f;
+    EXPECT_EQ(1.5f, CAEKernels::Peak(samples.data(), samples.size())) << name;
+    samples[100] = 2.0f;
+    EXPECT_EQ(2.0f, CAEKernels::Peak(samples.data(), samples.size())) << name;
+  }
+}
+
+TEST_F(TestAEKernels, SoftClamp)
+{
+  const float input[] = { 0.0f, 0.5f, -0.5f, 1.0f, -1.0f, 2.0f, -2.0f, 3.0f, -3.0f, 3.5f, -10.0f, 0.99f };
+  const unsigned int count = sizeof(input) / sizeof(input[0]);
+  for (unsigned int features : GetFeatureSets())
+  {
+    const char *name = CAEKernels::Select(features);
+    std::vector<float> samples(input, input + count);
+    CAEKernels::SoftClamp(samples.data(), count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+      const float x = input[i];
+      const float expected = x < -3.0f ? -1.0f : x > 3.0f ? 1.0f : x * (27.0f + x * x) / (27.0f + 9.0f * x * x);
+      EXPECT_NEAR(expected, samples[i], 1e-6f) << name << " input " << x;
+      EXPECT_LE(fabsf(samples[i]), 1.0f) << name << " input " << x;
+    }
+  }
+}
+
+TEST_F(TestAEKernels, Dot)
+{
+  const unsigned int counts[] = { 0, 1, 3, 4, 12, 31, 64, 129 };
+  for (unsigned int features : GetFeatureSets())
+  {
+    const char *name = CAEKernels::Select(features);
+    for (unsigned int count : counts)
+    {
+      std::vector<float> a = CreateSamples(count, 1.0f, count + 5);
+      std::vector<float> b = CreateSamples(count, 1.0f, count + 6);
+      double expected = 0.0;
+      for (unsigned int i = 0; i < count; i++)
+        expected += (double)a[i] * b[i];
+      EXPECT_NEAR(expected, CAEKernels::Dot(a.data(), b.data(), count), 1e-5) << name << " count " << count;
+    }
+  }
+}
@@ -0,0 +1,67 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AELatencyHistogram.h"
+
+#include "gtest/gtest.h"
+
+TEST(TestAELatencyHistogram, Buckets)
+{
+  CAELatencyHistogram histogram;
+  EXPECT_EQ(0U, histogram.GetCount());
+  EXPECT_EQ(0, histogram.GetPercentile(50.0));
+  EXPECT_EQ("no samples", histogram.ToString());
+
+  histogram.Add(0);
+  histogram.Add(1);
+  histogram.Add(2);
+  histogram.Add(3);
+  histogram.Add(4);
+  histogram.Add(1000);
+  histogram.Add((int64_t)1 << 40);
+
+  EXPECT_EQ(7U, histogram.GetCount());
+  EXPECT_EQ(2U, histogram.GetBucket(0));
+  EXPECT_EQ(2U, histogram.GetBucket(1));
+  EXPECT_EQ(1U, histogram.GetBucket(2));
+  EXPECT_EQ(1U, histogram.GetBucket(9));
+  EXPECT_EQ(1U, histogram.GetBucket(CAELatencyHistogram::BUCKETS - 1));
+  EXPECT_EQ((int64_t)1 << 40, histogram.GetMax());
+
+  histogram.Reset();
+  EXPECT_EQ(0U, histogram.GetCount());
+  EXPECT_EQ(0, histogram.GetMax());
+}
+
+TEST(TestAELatencyHistogram, Percentile)
+{
+  CAELatencyHistogram histogram;
+  // 98 fast handoffs and two slow ones
+  for (int i = 0; i < 98; i++)
+    histogram.Add(300);
+  histogram.Add(5000);
+  histogram.Add(12000);
+
+  EXPECT_EQ(512, histogram.GetPercentile(50.0));
+  EXPECT_EQ(512, histogram.GetPercentile(97.0));
+  EXPECT_EQ(8192, histogram.GetPercentile(98.5));
+  EXPECT_EQ(16384, histogram.GetPercentile(100.0));
+  EXPECT_EQ("100 samples, p50 < 512us, p99 < 16.4ms, max 12.0ms", histogram.ToString());
+}
@@ -0,0 +1,209 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AEPolyphaseResampler.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+namespace
+{
+// resample a sine in chunks, the channels are out of phase by a quarter
+std::vector<std::vector<float>> ResampleSine(CAEPolyphaseResampler &resampler, unsigned int srcRate, unsigned int frames,
+                                             double frequency, double ratio = 1.0)
+{
+  const unsigned int chunk = 1000;
+  std::vector<std::vector<float>> input(2, std::vector<float>(chunk));
+  std::vector<std::vector<float>> output(2);
+  std::vector<float> planes[2] = { std::vector<float>(chunk * 4), std::vector<float>(chunk * 4) };
+  for (unsigned int pos = 0; pos < frames; pos += chunk)
+  {
+    for (unsigned int i = 0; i < chunk; i++)
+    {
+      const double t = 2.0 * M_PI * frequency * (pos + i) / srcRate;
+      input[0][i] = 0.5f * sin(t);
+      input[1][i] = 0.5f * cos(t);
+    }
+    const float *src[2] = { input[0].data(), input[1].data() };
+    float *dst[2] = { planes[0].data(), planes[1].data() };
+    resampler.AddFrames(src, chunk);
+    // fetch in two steps, the second one gets what did not fit
+    unsigned int count = resampler.GetFrames(dst, chunk / 2, ratio);
+    for (unsigned int ch = 0; ch < 2; ch++)
+      output[ch].insert(output[ch].end(), dst[ch], dst[ch] + count);
+    count = resampler.GetFrames(dst, chunk * 4, ratio);
+    for (unsigned int ch = 0; ch < 2; ch++)
+      output[ch].insert(output[ch].end(), dst[ch], dst[ch] + count);
+  }
+  return output;
+}
+
+// largest difference to the ideal sine after the filter has settled
+double MaxError(const std::vector<std::vector<float>> &output, unsigned int dstRate, double frequency, unsigned int skip)
+{
+  double error = 0.0;
+  for (unsigned int i = skip; i < output[0].size(); i++)
+  {
+    const double t = 2.0 * M_PI * frequency * i / dstRate;
+    error = std::max(error, fabs(output[0][i] - 0.5 * sin(t)));
+    error = std::max(error, fabs(output[1][i] - 0.5 * cos(t)));
+  }
+  return error;
+}
+}
+
+TEST(TestAEPolyphaseResampler, Supported)
+{
+  EXPECT_TRUE(CAEPolyphaseResampler::IsSupported(44100, 48000));
+  EXPECT_TRUE(CAEPolyphaseResampler::IsSupported(48000, 44100));
+  EXPECT_TRUE(CAEPolyphaseResampler::IsSupported(48000, 96000));
+  EXPECT_TRUE(CAEPolyphaseResampler::IsSupported(96000, 48000));
+  EXPECT_TRUE(CAEPolyphaseResampler::IsSupported(44100, 96000));
+  EXPECT_TRUE(CAEPolyphaseResampler::IsSupported(48000, 48000));
+  EXPECT_FALSE(CAEPolyphaseResampler::IsSupported(44100, 192000));
+  EXPECT_FALSE(CAEPolyphaseResampler::IsSupported(192000, 22050));
+  EXPECT_FALSE(CAEPolyphaseResampler::IsSupported(44100, 0));
+
+  CAEPolyphaseResampler resampler;
+  EXPECT_FALSE(resampler.Init(44100, 192000, 2, AE_QUALITY_MID));
+  EXPECT_TRUE(resampler.Init(44100, 48000, 2, AE_QUALITY_MID));
+}
+
+TEST(TestAEPolyphaseResampler, Passthrough)
+{
+  CAEPolyphaseResampler resampler;
+  ASSERT_TRUE(resampler.Init(48000, 48000, 1, AE_QUALITY_HIGH));
+
+  std::vector<float> input(100);
+  for (unsigned int i = 0; i < input.size(); i++)
+    input[i] = i * 0.01f;
+  std::vector<float> output(60);
+  const float *src[1] = { input.data() };
+  float *dst[1] = { output.data() };
+  resampler.AddFrames(src, input.size());
+  EXPECT_EQ(60U, resampler.GetFrames(dst, 60));
+  EXPECT_DOUBLE_EQ(40.0, resampler.GetDelay());
+  EXPECT_TRUE(std::equal(output.begin(), output.end(), input.begin()));
+  EXPECT_EQ(40U, resampler.GetFrames(dst, 60));
+  EXPECT_TRUE(std::equal(output.begin(), output.begin() + 40, input.begin() + 60));
+  EXPECT_DOUBLE_EQ(0.0, resampler.GetDelay());
+}
+
+TEST(TestAEPolyphaseResampler, Sine)
+{
+  const struct
+  {
+    unsigned int srcRate;
+    unsigned int dstRate;
+    AEQuality quality;
+    double frequency;
+    double maxError;
+  } conversions[] = {
+    { 44100, 48000, AE_QUALITY_LOW,  1000.0, 5e-4 },
+    { 44100, 48000, AE_QUALITY_MID,  1000.0, 5e-5 },
+    { 44100, 48000, AE_QUALITY_HIGH, 9000.0, 5e-6 },
+    { 48000, 44100, AE_QUALITY_MID,  1000.0, 5e-5 },
+    { 48000, 96000, AE_QUALITY_MID,  5000.0, 5e-5 },
+    { 96000, 48000, AE_QUALITY_MID,  5000.0, 5e-5 },
+  };
+
+  for (const auto &conversion : conversions)
+  {
+    CAEPolyphaseResampler resampler;
+    ASSERT_TRUE(resampler.Init(conversion.srcRate, conversion.dstRate, 2, conversion.quality));
+    const unsigned int frames = 20000;
+    std::vector<std::vector<float>> output = ResampleSine(resampler, conversion.srcRate, frames, conversion.frequency);
+
+    // everything but the look ahead of the filter comes out
+    const double expected = (frames - resampler.GetDelay()) * conversion.dstRate / conversion.srcRate;
+    EXPECT_NEAR(expected, output[0].size(), 1.0) << conversion.srcRate << " -> " << conversion.dstRate;
+    EXPECT_LE(resampler.GetDelay(), resampler.GetTaps() / 2 + 1);
+
+    const unsigned int skip = resampler.GetTaps() * conversion.dstRate / conversion.srcRate;
+    EXPECT_LT(MaxError(output, conversion.dstRate, conversion.frequency, skip), conversion.maxError)
+      << conversion.srcRate << " -> " << conversion.dstRate << " quality " << conversion.quality;
+  }
+}
+
+TEST(TestAEPolyphaseResampler, Stopband)
+{
+  // 30kHz does not fit into 48kHz and must not alias to 18kHz
+  CAEPolyphaseResampler resampler;
+  ASSERT_TRUE(resampler.Init(96000, 48000, 2, AE_QUALITY_MID));
+  std::vector<std::vector<float>> output = ResampleSine(resampler, 96000, 20000, 30000.0);
+  ASSERT_LT(200U, output[0].size());
+
+  double peak = 0.0;
+  for (unsigned int i = 200; i < output[0].size(); i++)
+    peak = std::max(peak, (double)fabsf(output[0][i]));
+  EXPECT_LT(peak, 1e-5);
+}
+
+TEST(TestAEPolyphaseResampler, Ratio)
+{
+  // sync adjustments stretch the input between the rows of the filter
+  const double ratios[] = { 1.01, 0.995 };
+  for (double ratio : ratios)
+  {
+    CAEPolyphaseResampler resampler;
+    ASSERT_TRUE(resampler.Init(48000, 48000, 2, AE_QUALITY_MID));
+    const unsigned int frames = 20000;
+    std::vector<std::vector<float>> output = ResampleSine(resampler, 48000, frames, 1000.0, ratio);
+
+    const double expected = (frames - resampler.GetDelay()) * ratio;
+    EXPECT_NEAR(expected, output[0].size(), 1.0) << "ratio " << ratio;
+    // the sine is played at a different speed
+    EXPECT_LT(MaxError(output, 48000, 1000.0 / ratio, resampler.GetTaps()), 5e-5) << "ratio " << ratio;
+  }
+}
+
+TEST(TestAEPolyphaseResampler, Flush)
+{
+  CAEPolyphaseResampler resampler;
+  ASSERT_TRUE(resampler.Init(44100, 48000, 1, AE_QUALITY_MID));
+
+  std::vector<float> input(4410, 0.25f);
+  std::vector<float> output(10000);
+  const float *src[1] = { input.data() };
+  float *dst[1] = { output.data() };
+  resampler.AddFrames(src, input.size());
+  unsigned int frames = resampler.GetFrames(dst, output.size());
+  EXPECT_GT(4800U, frames);
+
+  // the look ahead comes out once there is no more input
+  resampler.Flush();
+  dst[0] = output.data() + frames;
+  frames += resampler.GetFrames(dst, output.size() - frames);
+  EXPECT_EQ(4800U, frames);
+  EXPECT_DOUBLE_EQ(0.0, resampler.GetDelay());
+  EXPECT_NEAR(0.25f, output[4000], 1e-6f);
+  resampler.Flush();
+  EXPECT_EQ(0U, resampler.GetFrames(dst, output.size() - frames));
+
+  // more input replaces the padding
+  resampler.AddFrames(src, input.size());
+  EXPECT_NEAR(input.size(), resampler.GetDelay(), 1.0);
+  dst[0] = output.data();
+  resampler.GetFrames(dst, output.size());
+  EXPECT_NEAR(0.25f, output[0], 1e-6f);
+}
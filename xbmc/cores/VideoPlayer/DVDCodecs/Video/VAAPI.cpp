@@ -1496,6 +1496,8 @@ void COutput::Dispose()
   m_bStop = true;
   m_outMsgEvent.Set();
   StopThread();
+  m_controlPort.LogStats();
+  m_dataPort.LogStats();
   m_controlPort.Purge();
   m_dataPort.Purge();
 }
@@ -1349,6 +1349,8 @@ void CMixer::Dispose()
   m_outMsgEvent.Set();
   StopThread();
 
+  m_controlPort.LogStats();
+  m_dataPort.LogStats();
   m_controlPort.Purge();
   m_dataPort.Purge();
 }
@@ -2639,6 +2641,8 @@ void COutput::Dispose()
   m_bStop = true;
   m_outMsgEvent.Set();
   StopThread();
+  m_controlPort.LogStats();
+  m_dataPort.LogStats();
   m_controlPort.Purge();
   m_dataPort.Purge();
 }
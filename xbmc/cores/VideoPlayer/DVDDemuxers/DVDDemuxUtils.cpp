@@ -23,9 +23,15 @@
 #endif
 #include "DVDDemuxUtils.h"
 #include "DVDClock.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
 #include "utils/log.h"
 #include "system.h"
 
+#include <vector>
+
 #ifdef TARGET_POSIX
 #include "linux/XMemUtils.h"
 #endif
@@ -34,13 +40,230 @@ extern "C" {
 #include "libavcodec/avcodec.h"
 }
 
+namespace
+{
+
+/*!
+ * Payload buffers are prefixed with a header recording the size class they
+ * belong to, pData points right behind it. The header is 16 bytes so pData
+ * keeps the alignment of the underlying allocation.
+ */
+struct SPacketBufferHeader
+{
+  int32_t sizeClass; // -1 for buffers too large to be pooled
+  uint32_t capacity;
+  uint32_t reserved[2];
+};
+static_assert(sizeof(SPacketBufferHeader) == 16, "header size must keep payload alignment");
+
+/*!
+ * Thread-safe pool of demux packets and their payload buffers.
+ *
+ * Payloads are kept in power of two size classes from 1 KiB to 4 MiB. Every
+ * TRIM_INTERVAL the number of cached items per class is trimmed down to the
+ * highest number that was in use at once during the previous interval, so
+ * the pool follows the stream bitrate instead of holding on to a spike.
+ */
+class CDemuxPacketPool
+{
+public:
+  ~CDemuxPacketPool()
+  {
+    for (auto packet : m_packets.items)
+      delete static_cast<DemuxPacket*>(packet);
+    for (auto &sizeClass : m_buffers)
+    {
+      for (auto buffer : sizeClass.items)
+        _aligned_free(buffer);
+    }
+  }
+
+  DemuxPacket* AllocatePacket()
+  {
+    {
+      CSingleLock lock(m_section);
+      void *packet = Take(m_packets);
+      if (packet)
+        return static_cast<DemuxPacket*>(packet);
+    }
+
+    DemuxPacket *packet = new DemuxPacket;
+    CSingleLock lock(m_section);
+    Acquired(m_packets);
+    return packet;
+  }
+
+  void FreePacket(DemuxPacket* packet)
+  {
+    CSingleLock lock(m_section);
+    if (!Give(m_packets, packet))
+      delete packet;
+  }
+
+  uint8_t* AllocateBuffer(int size)
+  {
+    int sizeClass = GetSizeClass(size);
+    if (sizeClass >= 0)
+    {
+      CSingleLock lock(m_section);
+      void *buffer = Take(m_buffers[sizeClass]);
+      if (buffer)
+      {
+        m_hits++;
+        m_cachedBytes -= ClassCapacity(sizeClass);
+        return static_cast<uint8_t*>(buffer) + sizeof(SPacketBufferHeader);
+      }
+      m_misses++;
+    }
+
+    uint32_t capacity = sizeClass >= 0 ? ClassCapacity(sizeClass) : size;
+    uint8_t* buffer = (uint8_t*)_aligned_malloc(sizeof(SPacketBufferHeader) + capacity, 16);
+    if (!buffer)
+      return NULL;
+
+    if (sizeClass >= 0)
+    {
+      CSingleLock lock(m_section);
+      Acquired(m_buffers[sizeClass]);
+    }
+
+    SPacketBufferHeader *header = reinterpret_cast<SPacketBufferHeader*>(buffer);
+    header->sizeClass = sizeClass;
+    header->capacity = capacity;
+    return buffer + sizeof(SPacketBufferHeader);
+  }
+
+  void FreeBuffer(uint8_t* data)
+  {
+    uint8_t* buffer = data - sizeof(SPacketBufferHeader);
+    int sizeClass = reinterpret_cast<SPacketBufferHeader*>(buffer)->sizeClass;
+    if (sizeClass >= 0)
+    {
+      CSingleLock lock(m_section);
+      if (Give(m_buffers[sizeClass], buffer))
+      {
+        m_cachedBytes += ClassCapacity(sizeClass);
+        return;
+      }
+    }
+    _aligned_free(buffer);
+  }
+
+private:
+  static const int MIN_CLASS_SHIFT = 10;
+  static const int NUM_CLASSES = 13;
+  static const unsigned int TRIM_INTERVAL = 10000;
+
+  struct SFreeList
+  {
+    std::vector<void*> items;
+    unsigned int inUse = 0;
+    unsigned int peak = 0;
+    unsigned int highWater = 0;
+  };
+
+  static int GetSizeClass(int size)
+  {
+    for (int sizeClass = 0; sizeClass < NUM_CLASSES; sizeClass++)
+    {
+      if (size <= static_cast<int>(ClassCapacity(sizeClass)))
+        return sizeClass;
+    }
+    return -1;
+  }
+
+  static uint32_t ClassCapacity(int sizeClass)
+  {
+    return 1u << (MIN_CLASS_SHIFT + sizeClass);
+  }
+
+  // items are only counted as in use once they were handed out, a failed
+  // allocation after a miss mustn't raise the number of items kept
+  void Acquired(SFreeList &list)
+  {
+    list.inUse++;
+    list.peak = std::max(list.peak, list.inUse);
+  }
+
+  void* Take(SFreeList &list)
+  {
+    if (list.items.empty())
+      return NULL;
+    void *item = list.items.back();
+    list.items.pop_back();
+    Acquired(list);
+    return item;
+  }
+
+  bool Give(SFreeList &list, void *item)
+  {
+    if (list.inUse > 0)
+      list.inUse--;
+
+    unsigned int now = XbmcThreads::SystemClockMillis();
+    if (now - m_lastTrim >= TRIM_INTERVAL)
+      Trim(now);
+
+    // keep no more than we needed at the last high-water mark
+    if (list.items.size() + list.inUse >= std::max(list.highWater, list.peak))
+      return false;
+    list.items.push_back(item);
+    return true;
+  }
+
+  void Trim(unsigned int now)
+  {
+    m_lastTrim = now;
+    TrimList(m_packets, -1);
+    for (int sizeClass = 0; sizeClass < NUM_CLASSES; sizeClass++)
+      TrimList(m_buffers[sizeClass], sizeClass);
+
+    if (g_advancedSettings.CanLogComponent(LOGVIDEO))
+      CLog::Log(LOGDEBUG, "CDemuxPacketPool - %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " bytes cached",
+                m_hits, m_misses, m_cachedBytes);
+  }
+
+  void TrimList(SFreeList &list, int sizeClass)
+  {
+    list.highWater = list.peak;
+    list.peak = list.inUse;
+    while (!list.items.empty() && list.items.size() + list.inUse > list.highWater)
+    {
+      if (sizeClass < 0)
+        delete static_cast<DemuxPacket*>(list.items.back());
+      else
+      {
+        _aligned_free(list.items.back());
+        m_cachedBytes -= ClassCapacity(sizeClass);
+      }
+      list.items.pop_back();
+    }
+  }
+
+  CCriticalSection m_section;
+  SFreeList m_packets;
+  SFreeList m_buffers[NUM_CLASSES];
+  uint64_t m_hits = 0;
+  uint64_t m_misses = 0;
+  uint64_t m_cachedBytes = 0;
+  unsigned int m_lastTrim = 0;
+};
+
+CDemuxPacketPool& GetPacketPool()
+{
+  static CDemuxPacketPool pool;
+  return pool;
+}
+
+}
+
 void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 {
   if (pPacket)
   {
     try {
-      if (pPacket->pData) _aligned_free(pPacket->pData);
-      delete pPacket;
+      if (pPacket->pData) GetPacketPool().FreeBuffer(pPacket->pData);
+      GetPacketPool().FreePacket(pPacket);
     }
     catch(...) {
       CLog::Log(LOGERROR, "%s - Exception thrown while freeing packet", __FUNCTION__);
@@ -50,7 +273,7 @@ void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 
 DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
 {
-  DemuxPacket* pPacket = new DemuxPacket;
+  DemuxPacket* pPacket = GetPacketPool().AllocatePacket();
   if (!pPacket) return NULL;
 
   try
@@ -68,7 +291,7 @@ DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
         * Note, if the first 23 bits of the additional bytes are not 0 then damaged
         * MPEG bitstreams could cause overread and segfault
         */
-      pPacket->pData =(uint8_t*)_aligned_malloc(iDataSize + FF_INPUT_BUFFER_PADDING_SIZE, 16);
+      pPacket->pData = GetPacketPool().AllocateBuffer(iDataSize + FF_INPUT_BUFFER_PADDING_SIZE);
       if (!pPacket->pData)
       {
         FreeDemuxPacket(pPacket);
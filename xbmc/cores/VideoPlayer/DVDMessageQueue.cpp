@@ -30,6 +30,8 @@ CDVDMessageQueue::CDVDMessageQueue(const std::string &owner) : m_hEvent(true), m
   m_iDataSize     = 0;
   m_bAbortRequest = false;
   m_bInitialized = false;
+  m_drain = false;
+  m_waiting = false;
 
   m_TimeBack = DVD_NOPTS_VALUE;
   m_TimeFront = DVD_NOPTS_VALUE;
@@ -51,6 +53,13 @@ void CDVDMessageQueue::Init()
   m_TimeBack = DVD_NOPTS_VALUE;
   m_TimeFront = DVD_NOPTS_VALUE;
   m_drain = false;
+  m_waiting = false;
+}
+
+void CDVDMessageQueue::Reserve(size_t messages)
+{
+  CSingleLock lock(m_section);
+  m_messages.reserve(messages);
 }
 
 void CDVDMessageQueue::Flush(CDVDMsg::Message type)
@@ -125,9 +134,9 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front
   else
   {
     if (front)
-      m_messages.emplace_front(pMsg, priority);
+      m_messages.push_front(pMsg, priority);
     else
-      m_messages.emplace_back(pMsg, priority);
+      m_messages.push_back(pMsg, priority);
   }
 
   if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET) && priority == 0)
@@ -148,8 +157,10 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front
 
   pMsg->Release();
 
-  // inform waiter for new packet
-  m_hEvent.Set();
+  // inform waiter for new packet, the event stays set until Get() resets
+  // it so there is no need to signal when nobody is waiting
+  if (m_waiting)
+    m_hEvent.Set();
 
   return MSGQ_OK;
 }
@@ -170,11 +181,12 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
 
   while (!m_bAbortRequest)
   {
-    std::list<DVDMessageListItem> &msgs = (priority > 0 || !m_prioMessages.empty()) ? m_prioMessages : m_messages;
+    bool prio = priority > 0 || !m_prioMessages.empty();
+    bool empty = prio ? m_prioMessages.empty() : m_messages.empty();
 
-    if (!msgs.empty() && (msgs.back().priority >= priority || m_drain))
+    if (!empty && ((prio ? m_prioMessages.back() : m_messages.back()).priority >= priority || m_drain))
     {
-      DVDMessageListItem& item(msgs.back());
+      DVDMessageListItem& item(prio ? m_prioMessages.back() : m_messages.back());
       priority = item.priority;
 
       if (item.message->IsType(CDVDMsg::DEMUXER_PACKET) && item.priority == 0)
@@ -191,7 +203,10 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
       }
 
       *pMsg = item.message->Acquire();
-      msgs.pop_back();
+      if (prio)
+        m_prioMessages.pop_back();
+      else
+        m_messages.pop_back();
 
       ret = MSGQ_OK;
       break;
@@ -204,13 +219,16 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
     else
     {
       m_hEvent.Reset();
+      m_waiting = true;
       lock.Leave();
 
       // wait for a new message
-      if (!m_hEvent.WaitMSec(iTimeoutInMilliSeconds))
-        return MSGQ_TIMEOUT;
+      bool signaled = m_hEvent.WaitMSec(iTimeoutInMilliSeconds);
 
       lock.Enter();
+      m_waiting = false;
+      if (!signaled)
+        return MSGQ_TIMEOUT;
     }
   }
 
@@ -228,9 +246,9 @@ unsigned CDVDMessageQueue::GetPacketCount(CDVDMsg::Message type)
     return 0;
 
   unsigned count = 0;
-  for (const auto &item : m_messages)
+  for (size_t i = 0; i < m_messages.size(); i++)
   {
-    if(item.message->IsType(type))
+    if(m_messages[i].message->IsType(type))
       count++;
   }
   for (const auto &item : m_prioMessages)
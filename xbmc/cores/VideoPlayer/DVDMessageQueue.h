@@ -24,6 +24,7 @@
 #include <atomic>
 #include <string>
 #include <list>
+#include <vector>
 #include <algorithm>
 #include "threads/CriticalSection.h"
 #include "threads/Event.h"
@@ -41,6 +42,12 @@ struct DVDMessageListItem
     priority = 0;
   }
   DVDMessageListItem(const DVDMessageListItem&) = delete;
+  DVDMessageListItem(DVDMessageListItem&& other)
+  {
+    message = other.message;
+    priority = other.priority;
+    other.message = NULL;
+  }
  ~DVDMessageListItem()
   {
     if(message)
@@ -48,11 +55,113 @@ struct DVDMessageListItem
   }
 
   DVDMessageListItem& operator=(const DVDMessageListItem&) = delete;
+  DVDMessageListItem& operator=(DVDMessageListItem&& other)
+  {
+    if (this != &other)
+    {
+      if (message)
+        message->Release();
+      message = other.message;
+      priority = other.priority;
+      other.message = NULL;
+    }
+    return *this;
+  }
 
   CDVDMsg* message;
   int priority;
 };
 
+/**
+ * Ring of messages with the same front/back semantics as the std::list it
+ * replaces: new messages enter at the front, the consumer takes them from
+ * the back. Slots are reused, so once the ring has grown to the steady
+ * state number of queued packets no more allocations are done per message.
+ */
+class CDVDMessageRing
+{
+public:
+  CDVDMessageRing() : m_mask(0), m_head(0), m_count(0) {}
+
+  bool empty() const { return m_count == 0; }
+  size_t size() const { return m_count; }
+  size_t capacity() const { return m_items.size(); }
+
+  void reserve(size_t count)
+  {
+    if (count > m_items.size())
+      grow(count);
+  }
+
+  void push_front(CDVDMsg* msg, int priority)
+  {
+    if (m_count == m_items.size())
+      grow(m_count + 1);
+    m_items[(m_head + m_count) & m_mask] = DVDMessageListItem(msg, priority);
+    m_count++;
+  }
+
+  void push_back(CDVDMsg* msg, int priority)
+  {
+    if (m_count == m_items.size())
+      grow(m_count + 1);
+    m_head = (m_head - 1) & m_mask;
+    m_items[m_head] = DVDMessageListItem(msg, priority);
+    m_count++;
+  }
+
+  DVDMessageListItem& back() { return m_items[m_head]; }
+
+  void pop_back()
+  {
+    m_items[m_head] = DVDMessageListItem();
+    m_head = (m_head + 1) & m_mask;
+    m_count--;
+  }
+
+  // access in queue order, 0 being the back
+  const DVDMessageListItem& operator[](size_t i) const { return m_items[(m_head + i) & m_mask]; }
+
+  template<typename P>
+  void remove_if(P pred)
+  {
+    size_t kept = 0;
+    for (size_t i = 0; i < m_count; i++)
+    {
+      DVDMessageListItem &item = m_items[(m_head + i) & m_mask];
+      if (pred(item))
+        item = DVDMessageListItem();
+      else
+      {
+        if (kept != i)
+          m_items[(m_head + kept) & m_mask] = std::move(item);
+        kept++;
+      }
+    }
+    m_count = kept;
+  }
+
+private:
+  void grow(size_t count)
+  {
+    size_t capacity = 16;
+    while (capacity < count)
+      capacity <<= 1;
+
+    std::vector<DVDMessageListItem> items(capacity);
+    for (size_t i = 0; i < m_count; i++)
+      items[i] = std::move(m_items[(m_head + i) & m_mask]);
+    m_items.swap(items);
+    m_mask = capacity - 1;
+    m_head = 0;
+  }
+
+  std::vector<DVDMessageListItem> m_items;
+  size_t m_mask;
+  size_t m_head;
+  size_t m_count;
+};
+
 enum MsgQueueReturnCode
 {
   MSGQ_OK = 1,
@@ -100,6 +209,12 @@ public:
   bool IsFull() const { return GetLevel() == 100; }
   int GetLevel() const;
 
+  /**
+   * Preallocate room for the given number of queued messages so that Put()
+   * does not need to allocate while playing back.
+   */
+  void Reserve(size_t messages);
+
   void SetMaxDataSize(int iMaxDataSize) { m_iMaxDataSize = iMaxDataSize; }
   void SetMaxTimeSize(double sec) { m_TimeSize  = 1.0 / std::max(1.0, sec); }
   int GetMaxDataSize() const { return m_iMaxDataSize; }
@@ -115,6 +230,7 @@ private:
   std::atomic<bool> m_bAbortRequest;
   bool m_bInitialized;
   bool m_drain;
+  bool m_waiting;
 
   int m_iDataSize;
   double m_TimeFront;
@@ -124,7 +240,7 @@ private:
   int m_iMaxDataSize;
   std::string m_owner;
 
-  std::list<DVDMessageListItem> m_messages;
+  CDVDMessageRing m_messages;
   std::list<DVDMessageListItem> m_prioMessages;
 };
 
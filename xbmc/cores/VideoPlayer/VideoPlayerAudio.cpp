@@ -79,6 +79,8 @@ CVideoPlayerAudio::CVideoPlayerAudio(CDVDClock* pClock, CDVDMessageQueue& parent
 
   m_messageQueue.SetMaxDataSize(6 * 1024 * 1024);
   m_messageQueue.SetMaxTimeSize(8.0);
+  // 8 seconds of lossless audio packets, the ring grows beyond that if needed
+  m_messageQueue.Reserve(4096);
 }
 
 CVideoPlayerAudio::~CVideoPlayerAudio()
@@ -85,6 +85,8 @@ CVideoPlayerVideo::CVideoPlayerVideo(CDVDClock* pClock
   m_fForcedAspectRatio = 0;
   m_messageQueue.SetMaxDataSize(40 * 1024 * 1024);
   m_messageQueue.SetMaxTimeSize(8.0);
+  // 8 seconds of 60fps video packets
+  m_messageQueue.Reserve(512);
 
   m_iDroppedFrames = 0;
   m_fFrameRate = 25;
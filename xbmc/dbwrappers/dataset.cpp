@@ -82,6 +82,89 @@ std::string Database::prepare(const char *format, ...)
   return result;
 }
 
+std::string Database::bind(const std::string &sql, const BindList &params)
+{
+  std::map<std::string, std::vector<size_t> >::iterator it = placeholders.find(sql);
+  if (it == placeholders.end())
+  {
+    // keep this bounded, callers only use a handful of distinct statements
+    if (placeholders.size() >= 256)
+      placeholders.clear();
+
+    // skip literals, quoted identifiers and comments. A doubled quote inside
+    // a literal ends and restarts it, which leaves it quoted as well.
+    std::vector<size_t> offsets;
+    char quote = 0;
+    for (size_t i = 0; i < sql.size(); i++)
+    {
+      const char c = sql[i];
+      if (quote)
+      {
+        if (c == quote)
+          quote = 0;
+      }
+      else if (c == '\'' || c == '"' || c == '`')
+        quote = c;
+      else if (c == '-' && i + 1 < sql.size() && sql[i + 1] == '-')
+      {
+        i = sql.find('\n', i);
+        if (i == std::string::npos)
+          break;
+      }
+      else if (c == '/' && i + 1 < sql.size() && sql[i + 1] == '*')
+      {
+        i = sql.find("*/", i + 2);
+        if (i == std::string::npos)
+          break;
+        i++;
+      }
+      else if (c == '?')
+        offsets.push_back(i);
+    }
+    it = placeholders.insert(std::make_pair(sql, offsets)).first;
+  }
+
+  const std::vector<size_t> &offsets = it->second;
+  if (offsets.size() != params.size())
+    throw DbErrors("Wrong number of parameters (%u instead of %u) for: %s", (unsigned int)params.size(), (unsigned int)offsets.size(), sql.c_str());
+
+  std::string result;
+  result.reserve(sql.size() + 16 * params.size());
+  size_t pos = 0;
+  for (size_t i = 0; i < offsets.size(); i++)
+  {
+    result.append(sql, pos, offsets[i] - pos);
+    result += bind_value(params[i]);
+    pos = offsets[i] + 1;
+  }
+  result.append(sql, pos, std::string::npos);
+  return result;
+}
+
+std::string Database::bind_value(const field_value &value)
+{
+  if (value.get_isNull())
+    return "NULL";
+
+  switch (value.get_fType())
+  {
+    case ft_Boolean:
+      return value.get_asBool() ? "1" : "0";
+    case ft_Short:
+    case ft_UShort:
+    case ft_Int:
+    case ft_UInt:
+    case ft_Int64:
+      return value.get_asString();
+    case ft_Float:
+    case ft_Double:
+    case ft_LongDouble:
+      return prepare("%.15g", value.get_asDouble());
+    default:
+      return prepare("'%s'", value.get_asString().c_str());
+  }
+}
+
 //************* Dataset implementation ***************
 
 Dataset::Dataset():
@@ -357,6 +440,14 @@ bool Dataset::get_index_map_entry(const char *f_name) {
 }
 /********* INDEXMAP SECTION END *********/
 
+bool Dataset::query(const std::string &sql, const BindList &params) {
+  return query(db->bind(sql, params));
+}
+
+int Dataset::exec(const std::string &sql, const BindList &params) {
+  return exec(db->bind(sql, params));
+}
+
 const field_value Dataset::get_field_value(const char *f_name) {
   if (ds_state != dsInactive)
   {
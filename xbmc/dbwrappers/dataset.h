@@ -39,6 +39,8 @@
 namespace dbiplus {
 class Dataset;		// forward declaration of class Dataset
 
+typedef std::vector<field_value> BindList;
+
 
 #define S_NO_CONNECTION "No active connection";
 
@@ -163,8 +165,22 @@ public:
    */
   virtual std::string vprepare(const char *format, va_list args) = 0;
 
+  /*! \brief Substitute the "?" placeholders of a SQL statement with typed values.
+   Strings are escaped by the backend, so they must not be quoted in the statement.
+   \param sql - statement with "?" placeholders. "?" inside '' and "" literals, `` identifiers
+   and SQL comments is left alone.
+   \param params - values for the placeholders, in order.
+   \return the statement with the values substituted.
+   */
+  virtual std::string bind(const std::string &sql, const BindList &params);
+
   virtual bool in_transaction() {return false;};
 
+protected:
+  std::string bind_value(const field_value &value);
+
+  /* placeholder offsets of recently bound statements */
+  std::map<std::string, std::vector<size_t> > placeholders;
 };
 
 
@@ -308,6 +324,15 @@ public:
   virtual const void* getExecRes()=0;
 /* as open, but with our query exept Sql */
   virtual bool query(const std::string &sql) = 0;
+/* as query and exec, with the "?" placeholders in sql bound to params. Backends
+   supporting it keep the compiled statement for the next call */
+  virtual bool query(const std::string &sql, const BindList &params);
+  virtual int  exec(const std::string &sql, const BindList &params);
+/* as query, but rows are fetched one at a time while moving forward with
+   next(). Only the current row is held in memory, so num_rows() counts
+   the rows read so far and seeking backwards is not possible. Backends
+   without support fall back to a buffered query */
+  virtual bool query_forward(const std::string &sql) { return query(sql); }
 /* Close SQL Query*/
   virtual void close();
 /* This function looks for field Field_name with value equal Field_value
@@ -1440,17 +1440,14 @@ void MysqlDataset::fill_fields() {
   }
 
   //Filling result
-  if (result.records.size() != 0)
+  if (result.records.size() != 0 && (unsigned int)frecno < result.records.size())
   {
     const sql_record *row = result.records[frecno];
-    if (row)
-    {
-      const unsigned int ncols = row->size();
-      fields_object->resize(ncols);
-      for (unsigned int i = 0; i < ncols; i++)
-        (*fields_object)[i].val = row->at(i);
-      return;
-    }
+    const unsigned int ncols = row->size();
+    fields_object->resize(ncols);
+    for (unsigned int i = 0; i < ncols; i++)
+      (*fields_object)[i].val = row->at(i);
+    return;
   }
   const unsigned int ncols = result.record_header.size();
   fields_object->resize(ncols);
@@ -1581,13 +1578,13 @@ bool MysqlDataset::query(const std::string &query) {
     result.record_header[i].name = fields[i].name;
 
   // returned rows
+  result.reserve(mysql_num_rows(stmt));
   while ((row = mysql_fetch_row(stmt)))
   { // have a row of data
-    sql_record *res = new sql_record;
-    res->resize(numColumns);
+    unsigned long *lengths = mysql_fetch_lengths(stmt);
+    result.add_row();
     for (unsigned int i = 0; i < numColumns; i++)
     {
-      field_value &v = res->at(i);
       switch (fields[i].type)
       {
         case MYSQL_TYPE_LONGLONG:
@@ -1597,46 +1594,28 @@ bool MysqlDataset::query(const std::string &query) {
         case MYSQL_TYPE_SHORT:
         case MYSQL_TYPE_INT24:
         case MYSQL_TYPE_LONG:
-          if (row[i] != NULL)
-          {
-            v.set_asInt(atoi(row[i]));
-          }
-          else
-          {
-            v.set_asInt(0);
-          }
+          result.set_int(i, row[i] != NULL ? atoi(row[i]) : 0);
           break;
         case MYSQL_TYPE_FLOAT:
         case MYSQL_TYPE_DOUBLE:
-          if (row[i] != NULL)
-          {
-            v.set_asDouble(atof(row[i]));
-          }
-          else
-          {
-            v.set_asDouble(0);
-          }
+          result.set_double(i, row[i] != NULL ? atof(row[i]) : 0);
           break;
         case MYSQL_TYPE_STRING:
         case MYSQL_TYPE_VAR_STRING:
         case MYSQL_TYPE_VARCHAR:
-          if (row[i] != NULL) v.set_asString((const char *)row[i] );
-          break;
         case MYSQL_TYPE_TINY_BLOB:
         case MYSQL_TYPE_MEDIUM_BLOB:
         case MYSQL_TYPE_LONG_BLOB:
         case MYSQL_TYPE_BLOB:
-          if (row[i] != NULL) v.set_asString((const char *)row[i]);
+          if (row[i] != NULL) result.set_string(i, row[i], lengths[i]);
           break;
         case MYSQL_TYPE_NULL:
         default:
           CLog::Log(LOGDEBUG,"MYSQL: Unknown field type: %u", fields[i].type);
-          v.set_asString("");
-          v.set_isNull();
+          result.set_null(i);
           break;
       }
     }
-    result.records.push_back(res);
   }
   mysql_free_result(stmt);
   active = true;
@@ -1713,19 +1692,6 @@ void MysqlDataset::next(void) {
       fill_fields();
 }
 
-void MysqlDataset::free_row(void)
-{
-  if (frecno < 0 || (unsigned int)frecno >= result.records.size())
-    return;
-
-  sql_record *row = result.records[frecno];
-  if (row)
-  {
-    delete row;
-    result.records[frecno] = NULL;
-  }
-}
-
 bool MysqlDataset::seek(int pos) {
   if (ds_state == dsSelect)
   {
@@ -125,8 +125,6 @@ protected:
 /* This function works only with MySQL database
   Filling the fields information from select statement */
   virtual void fill_fields();
-/* Changing field values during dataset navigation */
-  virtual void free_row();  // free the memory allocated for the current row
 
 public:
 /* constructor */
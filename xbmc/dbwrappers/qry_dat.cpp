@@ -35,6 +35,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <stdexcept>
 
 #ifndef __GNUC__
 #pragma warning (disable:4800)
@@ -56,6 +59,13 @@ field_value::field_value(const char *s):
   field_type = ft_String;
   is_null = false;
 }
+
+field_value::field_value(const std::string &s):
+  str_value(s)
+{
+  field_type = ft_String;
+  is_null = false;
+}
   
 field_value::field_value(const bool b) {
   bool_value = b; 
@@ -742,4 +752,178 @@ std::string field_value::gft() {
   return tmp;
   }
 
+//field_view: strings are converted straight from the arena, everything
+//else goes through a temporary field_value which needs no allocation
+field_value field_view::get_value() const {
+  field_value fv;
+  switch (cell.type) {
+    case ft_Int:
+      fv.set_asInt((int)cell.int64_value);
+      break;
+    case ft_Int64:
+      fv.set_asInt64(cell.int64_value);
+      break;
+    case ft_Double:
+      fv.set_asDouble(cell.double_value);
+      break;
+    default:
+      fv.set_asString(std::string(str, cell.str_len));
+      break;
+  }
+  if (cell.is_null)
+    fv.set_isNull();
+  return fv;
+}
+
+field_view::operator field_value() const {
+  return get_value();
+}
+
+std::string field_view::get_asString() const {
+  if (cell.type == ft_String)
+    return std::string(str, cell.str_len);
+  return get_value().get_asString();
+}
+
+bool field_view::get_asBool() const {
+  if (cell.type == ft_String)
+    return strcmp(str, "True") == 0 || strcmp(str, "true") == 0 || strcmp(str, "1") == 0;
+  return get_value().get_asBool();
+}
+
+char field_view::get_asChar() const {
+  if (cell.type == ft_String)
+    return str[0];
+  return get_value().get_asChar();
+}
+
+short field_view::get_asShort() const {
+  if (cell.type == ft_String)
+    return (short)atoi(str);
+  return get_value().get_asShort();
+}
+
+unsigned short field_view::get_asUShort() const {
+  if (cell.type == ft_String)
+    return (unsigned short)atoi(str);
+  return get_value().get_asUShort();
+}
+
+int field_view::get_asInt() const {
+  if (cell.type == ft_String)
+    return atoi(str);
+  if (cell.type == ft_Double)
+    return (int)cell.double_value;
+  return (int)cell.int64_value;
+}
+
+unsigned int field_view::get_asUInt() const {
+  if (cell.type == ft_String)
+    return (unsigned int)atoi(str);
+  return get_value().get_asUInt();
+}
+
+float field_view::get_asFloat() const {
+  if (cell.type == ft_String)
+    return (float)atof(str);
+  return get_value().get_asFloat();
+}
+
+double field_view::get_asDouble() const {
+  if (cell.type == ft_String)
+    return atof(str);
+  if (cell.type == ft_Double)
+    return cell.double_value;
+  return get_value().get_asDouble();
+}
+
+int64_t field_view::get_asInt64() const {
+  if (cell.type == ft_String)
+    return _atoi64(str);
+  if (cell.type == ft_Double)
+    return (int64_t)cell.double_value;
+  return cell.type == ft_Int ? (int)cell.int64_value : cell.int64_value;
+}
+
+//sql_record
+field_view sql_record::at(unsigned int col) const {
+  if (!result || col >= result->num_columns())
+    throw std::out_of_range("sql_record::at");
+  return result->get_field(row, col);
+}
+
+field_view sql_record::operator[](unsigned int col) const {
+  return result->get_field(row, col);
+}
+
+unsigned int sql_record::size() const {
+  return result ? result->num_columns() : 0;
+}
+
+//result_set
+void result_set::reserve(size_t rows) {
+  columns.resize(record_header.size());
+  for (unsigned int i = 0; i < columns.size(); i++)
+    columns[i].reserve(rows);
+  records.rows.reserve(rows);
+}
+
+void result_set::add_row() {
+  // new fields default to an empty string, like a fresh field_value
+  column_cell cell;
+  cell.str_offset = 0;
+  cell.str_len = 0;
+  cell.type = ft_String;
+  cell.is_null = false;
+
+  columns.resize(record_header.size());
+  for (unsigned int i = 0; i < columns.size(); i++)
+    columns[i].push_back(cell);
+  records.rows.push_back(sql_record(this, records.rows.size()));
+}
+
+void result_set::set_null(unsigned int col) {
+  column_cell &cell = last_cell(col);
+  cell.type = ft_String;
+  cell.str_offset = 0;
+  cell.str_len = 0;
+  cell.is_null = true;
+}
+
+void result_set::set_string(unsigned int col, const char *s, size_t len) {
+  column_cell &cell = last_cell(col);
+  cell.type = ft_String;
+  cell.str_offset = arena.size();
+  cell.str_len = len;
+  cell.is_null = false;
+  // keep the terminator so the numeric conversions can work in place
+  arena.append(s, len);
+  arena.push_back('\0');
+}
+
+void result_set::set_string(unsigned int col, const char *s) {
+  set_string(col, s, strlen(s));
+}
+
+void result_set::set_int(unsigned int col, int i) {
+  column_cell &cell = last_cell(col);
+  cell.type = ft_Int;
+  cell.int64_value = i;
+  cell.is_null = false;
+}
+
+void result_set::set_int64(unsigned int col, int64_t i) {
+  column_cell &cell = last_cell(col);
+  cell.type = ft_Int64;
+  cell.int64_value = i;
+  cell.is_null = false;
+}
+
+void result_set::set_double(unsigned int col, double d) {
+  column_cell &cell = last_cell(col);
+  cell.type = ft_Double;
+  cell.double_value = d;
+  cell.is_null = false;
+}
+
 } //namespace 
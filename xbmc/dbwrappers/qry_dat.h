@@ -77,6 +77,7 @@ private:
 public:
   field_value();
   field_value(const char *s);
+  field_value(const std::string &s);
   field_value(const bool b);
   field_value(const char c);
   field_value(const short s);
@@ -208,37 +209,137 @@ struct field {
 
 
 typedef std::vector<field> Fields;
-typedef std::vector<field_value> sql_record;
 typedef std::vector<field_prop> record_prop;
-typedef std::vector<sql_record*> query_data;
 typedef field_value variant;
 
 //typedef Fields::iterator fld_itor;
-typedef sql_record::iterator rec_itor;
 typedef record_prop::iterator recprop_itor;
-typedef query_data::iterator qry_itor;
 
+class result_set;
+
+/* One value of a result_set column. Numbers are stored inline, strings
+   as an offset into the string arena of the owning result_set. */
+struct column_cell {
+  union {
+    int64_t int64_value;
+    double double_value;
+    size_t str_offset;
+  };
+  unsigned int str_len;
+  unsigned char type;           // fType of the value
+  bool is_null;
+};
+
+/* Read-only view of a single result_set value. It offers the getters of
+   field_value and converts lazily, so reading a number from a row never
+   touches a string and reading a string copies it exactly once. */
+class field_view {
+public:
+  field_view(const column_cell &cell, const char *str) : cell(cell), str(str) {}
+
+  fType get_fType() const {return (fType)cell.type;}
+  bool get_isNull() const {return cell.is_null;}
+  std::string get_asString() const;
+  bool get_asBool() const;
+  char get_asChar() const;
+  short get_asShort() const;
+  unsigned short get_asUShort() const;
+  int get_asInt() const;
+  unsigned int get_asUInt() const;
+  float get_asFloat() const;
+  double get_asDouble() const;
+  int64_t get_asInt64() const;
+
+  operator field_value() const;
+
+private:
+  field_value get_value() const;
+
+  const column_cell &cell;
+  const char *str;
+};
+
+/* A row of a result_set. Rows don't own any data, they just refer to
+   their position in the column storage of the result set. */
+class sql_record {
+public:
+  sql_record(const result_set *result = NULL, unsigned int row = 0) : result(result), row(row) {}
+
+  field_view at(unsigned int col) const;      // throws std::out_of_range
+  field_view operator[](unsigned int col) const;
+  unsigned int size() const;
+
+private:
+  const result_set *result;
+  unsigned int row;
+};
+
+/* The rows of a result_set, indexable like the former vector of row
+   pointers */
+class query_data {
+public:
+  const sql_record* at(size_t row) const {return &rows.at(row);}
+  const sql_record* operator[](size_t row) const {return &rows[row];}
+  size_t size() const {return rows.size();}
+  bool empty() const {return rows.empty();}
+
+private:
+  friend class result_set;
+  std::vector<sql_record> rows;
+};
+
+/* Query results stored column by column. Each column is one contiguous
+   vector of column_cell and all strings of the result share a single
+   arena, so a result costs a handful of allocations instead of one vector
+   plus one string per field.
+
+   Rows are appended with add_row() and filled with the set_* methods,
+   which always write to the last row. */
 class result_set
 {
 public:
   result_set()
   {
   };
-  ~result_set()
-  {
-    clear();
-  };
+  result_set(const result_set&) = delete;
+  result_set& operator=(const result_set&) = delete;
+
   void clear()
   {
-    for (unsigned int i = 0; i < records.size(); i++)
-      if (records[i])
-        delete records[i];
-    records.clear();
+    clear_rows();
     record_header.clear();
   };
+  void clear_rows()
+  {
+    columns.clear();
+    arena.clear();
+    records.rows.clear();
+  };
+
+  void reserve(size_t rows);
+  void add_row();
+  void set_null(unsigned int col);
+  void set_string(unsigned int col, const char *s, size_t len);
+  void set_string(unsigned int col, const char *s);
+  void set_int(unsigned int col, int i);
+  void set_int64(unsigned int col, int64_t i);
+  void set_double(unsigned int col, double d);
+
+  unsigned int num_columns() const {return columns.size();}
+  field_view get_field(unsigned int row, unsigned int col) const
+  {
+    const column_cell &cell = columns[col][row];
+    return field_view(cell, cell.type == ft_String && cell.str_len ? arena.c_str() + cell.str_offset : "");
+  }
 
   record_prop record_header;
   query_data records;
+
+private:
+  column_cell &last_cell(unsigned int col) {return columns.at(col).back();}
+
+  std::vector< std::vector<column_cell> > columns;
+  std::string arena;
 };
 
 } // namespace
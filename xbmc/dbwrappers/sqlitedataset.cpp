@@ -61,22 +61,14 @@ int callback(void* res_ptr,int ncol, char** reslt,char** cols)
 
   if (reslt != NULL)
   {
-    sql_record *rec = new sql_record;
-    rec->resize(ncol);
+    r->add_row();
     for (int i=0; i<ncol; i++)
     { 
-      field_value &v = rec->at(i);
       if (reslt[i] == NULL)
-      {
-        v.set_asString("");
-        v.set_isNull();
-      }
+        r->set_null(i);
       else
-      {
-        v.set_asString(reslt[i]);
-      }
+        r->set_string(i, reslt[i]);
     }
-    r->records.push_back(rec);
   }
   return 0;  
 }
@@ -87,6 +79,27 @@ static int busy_callback(void*, int busyCount)
   return 1;
 }
 
+// resets a cached statement and clears its bindings when leaving the scope,
+// also if an exception is thrown, so it doesn't keep a read transaction open
+class StatementReset
+{
+public:
+  explicit StatementReset(sqlite3_stmt *stmt) : m_stmt(stmt) {}
+  ~StatementReset() { if (m_stmt) Reset(); }
+
+  // returns the result of sqlite3_reset, the error of the last step if any
+  int Reset()
+  {
+    int res = sqlite3_reset(m_stmt);
+    sqlite3_clear_bindings(m_stmt);
+    m_stmt = NULL;
+    return res;
+  }
+
+private:
+  sqlite3_stmt *m_stmt;
+};
+
 //************* SqliteDatabase implementation ***************
 
 SqliteDatabase::SqliteDatabase() {
@@ -261,6 +274,7 @@ bool SqliteDatabase::exists(void)
 
 void SqliteDatabase::disconnect(void) {
   if (active == false) return;
+  clearStatements();
   sqlite3_close(conn);
   active = false;
 }
@@ -418,6 +432,32 @@ void SqliteDatabase::rollback_transaction() {
 
 // methods for formatting
 // ---------------------------------------------
+sqlite3_stmt *SqliteDatabase::getStatement(const std::string &sql)
+{
+  std::map<std::string, sqlite3_stmt*>::iterator it = statements.find(sql);
+  if (it != statements.end())
+    return it->second;
+
+  // the set of bound queries is small, so rather than tracking usage just
+  // start over if something keeps generating new ones
+  if (statements.size() >= 128)
+    clearStatements();
+
+  sqlite3_stmt *stmt = NULL;
+  if (setErr(sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, NULL), sql.c_str()) != SQLITE_OK)
+    throw DbErrors(getErrorMsg());
+
+  statements.insert(std::make_pair(sql, stmt));
+  return stmt;
+}
+
+void SqliteDatabase::clearStatements()
+{
+  for (std::map<std::string, sqlite3_stmt*>::iterator it = statements.begin(); it != statements.end(); ++it)
+    sqlite3_finalize(it->second);
+  statements.clear();
+}
+
 std::string SqliteDatabase::vprepare(const char *format, va_list args)
 {
   std::string strFormat = format;
@@ -451,6 +491,9 @@ std::string SqliteDatabase::vprepare(const char *format, va_list args)
 //************* SqliteDataset implementation ***************
 
 SqliteDataset::SqliteDataset():Dataset() {
+  fwd_stmt = NULL;
+  forward_only = false;
+  fwd_rows = 0;
   haveError = false;
   db = NULL;
   errmsg = NULL;
@@ -459,6 +502,9 @@ SqliteDataset::SqliteDataset():Dataset() {
 
 
 SqliteDataset::SqliteDataset(SqliteDatabase *newDb):Dataset(newDb) {
+  fwd_stmt = NULL;
+  forward_only = false;
+  fwd_rows = 0;
   haveError = false;
   db = newDb;
   errmsg = NULL;
@@ -466,6 +512,7 @@ SqliteDataset::SqliteDataset(SqliteDatabase *newDb):Dataset(newDb) {
 }
 
  SqliteDataset::~SqliteDataset(){
+   if (fwd_stmt) sqlite3_finalize(fwd_stmt);
    if (errmsg) sqlite3_free(errmsg);
  }
 
@@ -549,17 +596,14 @@ void SqliteDataset::fill_fields() {
   }
 
   //Filling result
-  if (result.records.size() != 0)
+  if (result.records.size() != 0 && (unsigned int)frecno < result.records.size())
   {
     const sql_record *row = result.records[frecno];
-    if (row)
-    {
-      const unsigned int ncols = row->size();
-      fields_object->resize(ncols);
-      for (unsigned int i = 0; i < ncols; i++)
-        (*fields_object)[i].val = row->at(i);
-      return;
-    }
+    const unsigned int ncols = row->size();
+    fields_object->resize(ncols);
+    for (unsigned int i = 0; i < ncols; i++)
+      (*fields_object)[i].val = row->at(i);
+    return;
   }
   const unsigned int ncols = result.record_header.size();
   fields_object->resize(ncols);
@@ -654,54 +698,188 @@ bool SqliteDataset::query(const std::string &query) {
   if (db->setErr(sqlite3_prepare_v2(handle(),query.c_str(),-1,&stmt, NULL),query.c_str()) != SQLITE_OK)
     throw DbErrors(db->getErrorMsg());
 
-  // column headers
+  fetch_rows(stmt);
+
+  if (db->setErr(sqlite3_finalize(stmt),query.c_str()) == SQLITE_OK)
+  {
+    active = true;
+    ds_state = dsSelect;
+    this->first();
+    return true;
+  }
+  else
+  {
+    throw DbErrors(db->getErrorMsg());
+  }  
+}
+
+void SqliteDataset::fetch_header(sqlite3_stmt *stmt) {
   const unsigned int numColumns = sqlite3_column_count(stmt);
   result.record_header.resize(numColumns);
   for (unsigned int i = 0; i < numColumns; i++)
     result.record_header[i].name = sqlite3_column_name(stmt, i);
+}
 
-  // returned rows
+void SqliteDataset::fetch_row(sqlite3_stmt *stmt) {
+  const unsigned int numColumns = result.record_header.size();
+  result.add_row();
+  for (unsigned int i = 0; i < numColumns; i++)
+  {
+    switch (sqlite3_column_type(stmt, i))
+    {
+    case SQLITE_INTEGER:
+      result.set_int64(i, sqlite3_column_int64(stmt, i));
+      break;
+    case SQLITE_FLOAT:
+      result.set_double(i, sqlite3_column_double(stmt, i));
+      break;
+    case SQLITE_TEXT:
+    case SQLITE_BLOB:
+      {
+        // text first, so the byte count is that of the utf-8 text
+        const char *text = (const char *)sqlite3_column_text(stmt, i);
+        result.set_string(i, text ? text : "", sqlite3_column_bytes(stmt, i));
+      }
+      break;
+    case SQLITE_NULL:
+    default:
+      result.set_null(i);
+      break;
+    }
+  }
+}
+
+void SqliteDataset::fetch_rows(sqlite3_stmt *stmt) {
+  fetch_header(stmt);
   while (sqlite3_step(stmt) == SQLITE_ROW)
-  { // have a row of data
-    sql_record *res = new sql_record;
-    res->resize(numColumns);
-    for (unsigned int i = 0; i < numColumns; i++)
+    fetch_row(stmt);
+}
+
+bool SqliteDataset::query_forward(const std::string &query) {
+  if(!handle()) throw DbErrors("No Database Connection");
+  std::string qry = query;
+  int fs = qry.find("select");
+  int fS = qry.find("SELECT");
+  if (!( fs >= 0 || fS >=0))
+    throw DbErrors("MUST be select SQL!");
+
+  close();
+
+  if (db->setErr(sqlite3_prepare_v2(handle(),query.c_str(),-1,&fwd_stmt, NULL),query.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+
+  fetch_header(fwd_stmt);
+  forward_only = true;
+  active = true;
+  ds_state = dsSelect;
+  frecno = 0;
+  fetch_next();
+  fbof = feof;
+  return true;
+}
+
+void SqliteDataset::fetch_next() {
+  // only the current row is kept, so it is always row 0 of the result set
+  result.clear_rows();
+  int res = sqlite3_step(fwd_stmt);
+  if (res == SQLITE_ROW)
+  {
+    fetch_row(fwd_stmt);
+    fwd_rows++;
+    feof = false;
+    fill_fields();
+    return;
+  }
+
+  feof = true;
+  res = sqlite3_finalize(fwd_stmt);
+  fwd_stmt = NULL;
+  if (res != SQLITE_OK && res != SQLITE_DONE)
+  {
+    db->setErr(res, "forward-only query");
+    throw DbErrors(db->getErrorMsg());
+  }
+}
+
+bool SqliteDataset::query(const std::string &query, const BindList &params) {
+  if (!handle()) throw DbErrors("No Database Connection");
+
+  close();
+
+  sqlite3_stmt *stmt = static_cast<SqliteDatabase*>(db)->getStatement(query);
+  StatementReset reset(stmt);
+  bind_params(stmt, params, query);
+  fetch_rows(stmt);
+
+  if (db->setErr(reset.Reset(), query.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+
+  active = true;
+  ds_state = dsSelect;
+  this->first();
+  return true;
+}
+
+int SqliteDataset::exec(const std::string &sql, const BindList &params) {
+  if (!handle()) throw DbErrors("No Database Connection");
+  exec_res.clear();
+
+  sqlite3_stmt *stmt = static_cast<SqliteDatabase*>(db)->getStatement(sql);
+  StatementReset reset(stmt);
+  bind_params(stmt, params, sql);
+
+  int res = sqlite3_step(stmt);
+  while (res == SQLITE_ROW)
+    res = sqlite3_step(stmt);
+  reset.Reset();
+
+  if (db->setErr(res == SQLITE_DONE ? SQLITE_OK : res, sql.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+  return SQLITE_OK;
+}
+
+void SqliteDataset::bind_params(sqlite3_stmt *stmt, const BindList &params, const std::string &sql) {
+  if (sqlite3_bind_parameter_count(stmt) != (int)params.size())
+    throw DbErrors("Wrong number of parameters (%u instead of %d) for: %s", (unsigned int)params.size(), sqlite3_bind_parameter_count(stmt), sql.c_str());
+
+  for (unsigned int i = 0; i < params.size(); i++)
+  {
+    const field_value &v = params[i];
+    int res;
+    if (v.get_isNull())
+      res = sqlite3_bind_null(stmt, i + 1);
+    else
     {
-      field_value &v = res->at(i);
-      switch (sqlite3_column_type(stmt, i))
+      switch (v.get_fType())
       {
-      case SQLITE_INTEGER:
-        v.set_asInt64(sqlite3_column_int64(stmt, i));
-        break;
-      case SQLITE_FLOAT:
-        v.set_asDouble(sqlite3_column_double(stmt, i));
+      case ft_Boolean:
+      case ft_Short:
+      case ft_UShort:
+      case ft_Int:
+      case ft_UInt:
+      case ft_Int64:
+        res = sqlite3_bind_int64(stmt, i + 1, v.get_asInt64());
         break;
-      case SQLITE_TEXT:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
+      case ft_Float:
+      case ft_Double:
+      case ft_LongDouble:
+        res = sqlite3_bind_double(stmt, i + 1, v.get_asDouble());
         break;
-      case SQLITE_BLOB:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_NULL:
       default:
-        v.set_asString("");
-        v.set_isNull();
+      {
+        const std::string str = v.get_asString();
+        res = sqlite3_bind_text(stmt, i + 1, str.c_str(), str.size(), SQLITE_TRANSIENT);
         break;
       }
+      }
+    }
+    if (res != SQLITE_OK)
+    {
+      sqlite3_clear_bindings(stmt);
+      db->setErr(res, sql.c_str());
+      throw DbErrors(db->getErrorMsg());
     }
-    result.records.push_back(res);
-  }
-  if (db->setErr(sqlite3_finalize(stmt),query.c_str()) == SQLITE_OK)
-  {
-    active = true;
-    ds_state = dsSelect;
-    this->first();
-    return true;
   }
-  else
-  {
-    throw DbErrors(db->getErrorMsg());
-  }  
 }
 
 void SqliteDataset::open(const std::string &sql) {
@@ -721,6 +899,13 @@ void SqliteDataset::open() {
 
 void SqliteDataset::close() {
   Dataset::close();
+  if (fwd_stmt)
+  {
+    sqlite3_finalize(fwd_stmt);
+    fwd_stmt = NULL;
+  }
+  forward_only = false;
+  fwd_rows = 0;
   result.clear();
   edit_object->clear();
   fields_object->clear();
@@ -740,6 +925,8 @@ void SqliteDataset::cancel() {
 
 
 int SqliteDataset::num_rows() {
+  if (forward_only)
+    return fwd_rows;
   return result.records.size();
 }
 
@@ -755,40 +942,48 @@ bool SqliteDataset::bof() {
 
 
 void SqliteDataset::first() {
+  if (forward_only)
+  {
+    if (fwd_rows > 1)
+      throw DbErrors("Can't rewind a forward-only query");
+    return;
+  }
   Dataset::first();
   this->fill_fields();
 }
 
 void SqliteDataset::last() {
+  if (forward_only)
+    throw DbErrors("Can't seek in a forward-only query");
   Dataset::last();
   fill_fields();
 }
 
 void SqliteDataset::prev(void) {
+  if (forward_only)
+    throw DbErrors("Can't seek in a forward-only query");
   Dataset::prev();
   fill_fields();
 }
 
 void SqliteDataset::next(void) {
+  if (forward_only)
+  {
+    if (!feof)
+    {
+      fbof = false;
+      fetch_next();
+    }
+    return;
+  }
   Dataset::next();
   if (!eof()) 
       fill_fields();
 }
 
-void SqliteDataset::free_row(void)
-{
-  if (frecno < 0 || (unsigned int)frecno >= result.records.size())
-    return;
-
-  sql_record *row = result.records[frecno];
-  if (row)
-  {
-    delete row;
-    result.records[frecno] = NULL;
-  }
-}
-
 bool SqliteDataset::seek(int pos) {
+  if (forward_only)
+    throw DbErrors("Can't seek in a forward-only query");
   if (ds_state == dsSelect) {
     Dataset::seek(pos);
     fill_fields();
@@ -44,6 +44,8 @@ protected:
   sqlite3 *conn;
   bool _in_transaction;
   int last_err;
+/* compiled statements of bound queries, see getStatement() */
+  std::map<std::string, sqlite3_stmt*> statements;
 
 public:
 /* default constructor */
@@ -55,6 +57,11 @@ public:
 
 /* func. returns connection handle with SQLite-server */
   sqlite3 *getHandle() {  return conn; }
+/* func. returns a compiled statement for sql, reusing a cached one when possible.
+   The statement must be reset after use. Throws DbErrors if sql doesn't compile */
+  sqlite3_stmt *getStatement(const std::string &sql);
+/* func. finalizes all cached statements */
+  void clearStatements();
 /* func. returns current status about SQLite-server connection */
   virtual int status();
   virtual int setErr(int err_code,const char * qry);
@@ -124,8 +131,21 @@ protected:
 /* This function works only with MySQL database
   Filling the fields information from select statement */
   virtual void fill_fields();
-/* Changing field values during dataset navigation */
-  virtual void free_row();  // free the memory allocated for the current row
+/* Binds params to the placeholders of stmt */
+  void bind_params(sqlite3_stmt *stmt, const BindList &params, const std::string &sql);
+/* Reads all rows of stmt into the result set */
+  void fetch_rows(sqlite3_stmt *stmt);
+/* Sets the column headers of the result set from stmt */
+  void fetch_header(sqlite3_stmt *stmt);
+/* Appends the current row of stmt to the result set */
+  void fetch_row(sqlite3_stmt *stmt);
+/* Steps the forward-only statement to the next row */
+  void fetch_next();
+
+/* statement of a forward-only query, still being stepped */
+  sqlite3_stmt *fwd_stmt;
+  bool forward_only;
+  int fwd_rows;
 
 public:
 /* constructor */
@@ -148,6 +168,10 @@ or insert() operations default = false) */
   virtual const void* getExecRes();
 /* as open, but with our query exept Sql */
   virtual bool query(const std::string &query);
+/* bound variants, using a cached compiled statement */
+  virtual bool query(const std::string &query, const BindList &params);
+  virtual int  exec(const std::string &sql, const BindList &params);
+  virtual bool query_forward(const std::string &query);
 /* func. closes a query */
   virtual void close(void);
 /* Cancel changes, made in insert or edit states of dataset */
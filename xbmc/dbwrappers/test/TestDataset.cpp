@@ -0,0 +1,136 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/sqlitedataset.h"
+#include "utils/StringUtils.h"
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+using namespace dbiplus;
+
+namespace
+{
+// sqlite database in memory, with access to the statement cache
+class CTestDatabase : public SqliteDatabase
+{
+public:
+  CTestDatabase()
+  {
+    if (sqlite3_open(":memory:", &conn) == SQLITE_OK)
+      active = true;
+  }
+  size_t GetStatementCount() const { return statements.size(); }
+};
+
+field_value NullValue()
+{
+  field_value value;
+  value.set_isNull();
+  return value;
+}
+}
+
+class TestDataset : public testing::Test
+{
+protected:
+  TestDataset()
+  {
+    ds.reset(db.CreateDataset());
+    ds->exec("CREATE TABLE item (id INTEGER PRIMARY KEY, size INTEGER, name TEXT)");
+  }
+
+  CTestDatabase db;
+  std::unique_ptr<Dataset> ds;
+};
+
+TEST_F(TestDataset, BindPlaceholders)
+{
+  EXPECT_EQ("SELECT * FROM item WHERE id=1 AND name='a'",
+            db.bind("SELECT * FROM item WHERE id=? AND name=?", BindList{ field_value(1), field_value("a") }));
+  EXPECT_EQ("SELECT 1", db.bind("SELECT 1", BindList()));
+  EXPECT_THROW(db.bind("SELECT * FROM item WHERE id=? AND name=?", BindList{ field_value(1) }), DbErrors);
+  EXPECT_THROW(db.bind("SELECT * FROM item", BindList{ field_value(1) }), DbErrors);
+}
+
+TEST_F(TestDataset, BindLiterals)
+{
+  // "?" in literals, identifiers and comments is not a placeholder
+  EXPECT_EQ("SELECT '?', 'it''s?', \"?\", `?` FROM item -- ?\nWHERE /* ? */ id=5",
+            db.bind("SELECT '?', 'it''s?', \"?\", `?` FROM item -- ?\nWHERE /* ? */ id=?", BindList{ field_value(5) }));
+  EXPECT_EQ("SELECT 1 -- ?", db.bind("SELECT 1 -- ?", BindList()));
+}
+
+TEST_F(TestDataset, BindValues)
+{
+  EXPECT_EQ("NULL", db.bind("?", BindList{ NullValue() }));
+  EXPECT_EQ("1099511627776", db.bind("?", BindList{ field_value((int64_t)1 << 40) }));
+  EXPECT_EQ("'it''s'", db.bind("?", BindList{ field_value("it's") }));
+}
+
+TEST_F(TestDataset, QueryValues)
+{
+  const int64_t size = ((int64_t)1 << 40) + 3;
+  EXPECT_EQ(SQLITE_OK, ds->exec("INSERT INTO item (id, size, name) VALUES (?, ?, ?)",
+                                BindList{ field_value(1), field_value(size), field_value("it's ?") }));
+  EXPECT_EQ(SQLITE_OK, ds->exec("INSERT INTO item (id, size, name) VALUES (?, ?, ?)",
+                                BindList{ field_value(2), NullValue(), NullValue() }));
+  EXPECT_THROW(ds->exec("INSERT INTO item (id, size, name) VALUES (?, ?, ?)", BindList{ field_value(3) }), DbErrors);
+
+  ASSERT_TRUE(ds->query("SELECT size, name FROM item WHERE id=?", BindList{ field_value(1) }));
+  ASSERT_EQ(1, ds->num_rows());
+  EXPECT_EQ(size, ds->fv(0).get_asInt64());
+  EXPECT_EQ("it's ?", ds->fv(1).get_asString());
+
+  ASSERT_TRUE(ds->query("SELECT size, name FROM item WHERE id=?", BindList{ field_value(2) }));
+  ASSERT_EQ(1, ds->num_rows());
+  EXPECT_TRUE(ds->fv(0).get_isNull());
+  EXPECT_TRUE(ds->fv(1).get_isNull());
+}
+
+TEST_F(TestDataset, StatementReuse)
+{
+  for (int i = 1; i <= 3; i++)
+    ds->exec("INSERT INTO item (id, size, name) VALUES (?, ?, ?)", BindList{ field_value(i), field_value(i * 10), field_value(StringUtils::Format("item%d", i)) });
+  const size_t statements = db.GetStatementCount();
+
+  // the same statement runs again once the rows of the last run are fetched
+  for (int i = 3; i >= 1; i--)
+  {
+    ASSERT_TRUE(ds->query("SELECT size FROM item WHERE id>=?", BindList{ field_value(i) }));
+    EXPECT_EQ(4 - i, ds->num_rows());
+    EXPECT_EQ(i * 10, ds->fv(0).get_asInt());
+    ds->close();
+  }
+  EXPECT_EQ(statements + 1, db.GetStatementCount());
+}
+
+TEST_F(TestDataset, StatementCacheLimit)
+{
+  for (int i = 0; i < 128; i++)
+    ds->query(StringUtils::Format("SELECT %d FROM item WHERE id=?", i), BindList{ field_value(i) });
+  EXPECT_EQ(128U, db.GetStatementCount());
+
+  // the cache starts over once it is full
+  ASSERT_TRUE(ds->query("SELECT name FROM item WHERE id=?", BindList{ field_value(1) }));
+  EXPECT_EQ(1U, db.GetStatementCount());
+  EXPECT_EQ(0, ds->num_rows());
+}
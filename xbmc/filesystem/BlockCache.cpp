@@ -0,0 +1,352 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include <new>
+#include <string.h>
+
+#include "BlockCache.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+
+using namespace XFILE;
+
+#define BLOCK_CACHE_BLOCK_SIZE (256 * 1024)
+
+CBlockCache::CBlockCache(size_t front, size_t back)
+ : CCacheStrategy()
+ , m_end(0)
+ , m_cur(0)
+ , m_size_front(front)
+ , m_size_back(back)
+ , m_blockSize(BLOCK_CACHE_BLOCK_SIZE)
+ , m_buf(NULL)
+ , m_useCounter(0)
+{
+  // small caches (e.g. sized to fit a small file) still get a useful number of blocks
+  size_t total = front + back;
+  while (m_blockSize > 4096 && total / m_blockSize < 8)
+    m_blockSize /= 2;
+}
+
+CBlockCache::~CBlockCache()
+{
+  Close();
+}
+
+int CBlockCache::Open()
+{
+  // the read-ahead may span one block more than its size, plus at least
+  // one block to keep behind the read position
+  size_t count = std::max((m_size_front + m_size_back) / m_blockSize, m_size_front / m_blockSize + 2) + 1;
+
+  m_buf = new (std::nothrow) uint8_t[count * m_blockSize];
+  if (m_buf == NULL)
+    return CACHE_RC_ERROR;
+
+  m_blocks.resize(count);
+  m_free.clear();
+  for (size_t i = 0; i < count; i++)
+  {
+    m_blocks[i].data = m_buf + i * m_blockSize;
+    m_free.push_back(&m_blocks[i]);
+  }
+  m_map.clear();
+  m_end = 0;
+  m_cur = 0;
+  m_useCounter = 0;
+  return CACHE_RC_OK;
+}
+
+void CBlockCache::Close()
+{
+  m_map.clear();
+  m_free.clear();
+  m_blocks.clear();
+  delete[] m_buf;
+  m_buf = NULL;
+}
+
+CBlockCache::CBlock *CBlockCache::FindBlock(int64_t pos)
+{
+  std::map<int64_t, CBlock*>::iterator it = m_map.find(pos / m_blockSize);
+  if (it == m_map.end())
+    return NULL;
+  return it->second;
+}
+
+bool CBlockCache::IsProtected(const CBlock *block) const
+{
+  // never evict data that is read-ahead and not yet consumed
+  return block->start <= m_end && block->start + (int64_t)m_blockSize > m_cur;
+}
+
+void CBlockCache::FreeBlock(CBlock *block)
+{
+  m_map.erase(block->start / m_blockSize);
+  m_free.push_back(block);
+}
+
+CBlockCache::CBlock *CBlockCache::GetWriteBlock(int64_t pos)
+{
+  CBlock *block = FindBlock(pos);
+  if (block)
+  {
+    // a block only tracks one valid range, start over if we can't extend it
+    if (pos < block->validBeg || pos > block->validEnd)
+      block->validBeg = block->validEnd = pos;
+    return block;
+  }
+
+  if (m_free.empty())
+  {
+    // evict the least recently used block that isn't needed for reading
+    CBlock *victim = NULL;
+    for (std::map<int64_t, CBlock*>::iterator it = m_map.begin(); it != m_map.end(); ++it)
+    {
+      if (IsProtected(it->second))
+        continue;
+      if (!victim || it->second->lastUse < victim->lastUse)
+        victim = it->second;
+    }
+    if (!victim)
+      return NULL;
+    FreeBlock(victim);
+  }
+
+  block = m_free.back();
+  m_free.pop_back();
+  block->start = pos - pos % m_blockSize;
+  block->validBeg = block->validEnd = pos;
+  block->lastUse = ++m_useCounter;
+  m_map[pos / m_blockSize] = block;
+  return block;
+}
+
+int64_t CBlockCache::ContiguousStart(int64_t pos)
+{
+  while (pos > 0)
+  {
+    CBlock *block = FindBlock(pos - 1);
+    if (!block || block->validBeg >= pos || block->validEnd < pos)
+      break;
+    pos = block->validBeg;
+  }
+  return pos;
+}
+
+int64_t CBlockCache::ContiguousEnd(int64_t pos)
+{
+  while (true)
+  {
+    CBlock *block = FindBlock(pos);
+    if (!block || block->validBeg > pos || block->validEnd <= pos)
+      break;
+    pos = block->validEnd;
+  }
+  return pos;
+}
+
+size_t CBlockCache::GetMaxWriteSize(const size_t& iRequestSize)
+{
+  CSingleLock lock(m_sync);
+
+  size_t front = (size_t)(m_end - m_cur);
+  if (front >= m_size_front)
+    return 0;
+
+  // Never return more than limit and size requested by caller
+  return std::min(iRequestSize, m_size_front - front);
+}
+
+/**
+ * Writes data at the current write position, allocating new blocks as
+ * needed. The read-ahead is limited to the front size, and only blocks
+ * outside the range between read and write position are evicted.
+ *
+ * Multiple calls may be needed to write all data.
+ */
+int CBlockCache::WriteToCache(const char *buf, size_t len)
+{
+  CSingleLock lock(m_sync);
+
+  size_t front = (size_t)(m_end - m_cur);
+  if (front >= m_size_front)
+    return 0;
+  len = std::min(len, m_size_front - front);
+
+  size_t written = 0;
+  while (written < len)
+  {
+    CBlock *block = GetWriteBlock(m_end);
+    if (!block)
+      break;
+
+    size_t offset = (size_t)(m_end - block->start);
+    size_t chunk = std::min(len - written, m_blockSize - offset);
+    memcpy(block->data + offset, buf + written, chunk);
+
+    written += chunk;
+    m_end += chunk;
+    block->validEnd = std::max(block->validEnd, m_end);
+    block->lastUse = ++m_useCounter;
+  }
+
+  if (written > 0)
+    m_written.Set();
+
+  return written;
+}
+
+/**
+ * Reads data from cache. Will only read up till the end of a block,
+ * so multiple calls may be needed to empty the whole cache.
+ */
+int CBlockCache::ReadFromCache(char *buf, size_t len)
+{
+  CSingleLock lock(m_sync);
+
+  CBlock *block = m_cur < m_end ? FindBlock(m_cur) : NULL;
+  if (!block || block->validBeg > m_cur || block->validEnd <= m_cur)
+  {
+    if(IsEndOfInput())
+      return 0;
+    else
+      return CACHE_RC_WOULD_BLOCK;
+  }
+
+  size_t avail = (size_t)(std::min(block->validEnd, m_end) - m_cur);
+  if (len > avail)
+    len = avail;
+
+  if (len == 0)
+    return 0;
+
+  memcpy(buf, block->data + (m_cur - block->start), len);
+  m_cur += len;
+  block->lastUse = ++m_useCounter;
+
+  m_space.Set();
+
+  return len;
+}
+
+/* Wait "millis" milliseconds for "minimum" amount of data to come in.
+ * Note that caller needs to make sure there's sufficient space in the forward
+ * buffer for "minimum" bytes else we may block the full timeout time
+ */
+int64_t CBlockCache::WaitForData(unsigned int minimum, unsigned int millis)
+{
+  CSingleLock lock(m_sync);
+  int64_t avail = m_end - m_cur;
+
+  if(millis == 0 || IsEndOfInput())
+    return avail;
+
+  if(minimum > m_size_front)
+    minimum = m_size_front;
+
+  XbmcThreads::EndTime endtime(millis);
+  while (!IsEndOfInput() && avail < minimum && !endtime.IsTimePast() )
+  {
+    lock.Leave();
+    m_written.WaitMSec(50); // may miss the deadline. shouldn't be a problem.
+    lock.Enter();
+    avail = m_end - m_cur;
+  }
+
+  return avail;
+}
+
+int64_t CBlockCache::Seek(int64_t pos)
+{
+  CSingleLock lock(m_sync);
+
+  // if seek is a bit over what we have, try to wait a few seconds for the data to be available.
+  // we try to avoid a (heavy) seek on the source
+  if (pos >= m_end && pos < m_end + 100000)
+  {
+    // consume the read-ahead, making sure there's sufficient forward space
+    m_cur = m_end;
+    lock.Leave();
+    WaitForData((size_t)(pos - m_cur), 5000);
+    lock.Enter();
+  }
+
+  // only positions leading up to the write position can be read without
+  // repositioning the source, anything else has to go through Reset()
+  if (pos <= m_end && pos >= ContiguousStart(m_end))
+  {
+    m_cur = pos;
+    return pos;
+  }
+
+  return CACHE_RC_ERROR;
+}
+
+bool CBlockCache::Reset(int64_t pos, bool clearAnyway)
+{
+  CSingleLock lock(m_sync);
+  if (!clearAnyway && IsCachedPosition(pos))
+  {
+    m_cur = pos;
+    m_end = ContiguousEnd(pos);
+    return false;
+  }
+
+  if (clearAnyway)
+  {
+    while (!m_map.empty())
+      FreeBlock(m_map.begin()->second);
+  }
+
+  // other cached ranges are kept, writing starts over at the new position
+  m_end = pos;
+  m_cur = pos;
+
+  return true;
+}
+
+int64_t CBlockCache::CachedDataEndPosIfSeekTo(int64_t iFilePosition)
+{
+  CSingleLock lock(m_sync);
+  if (IsCachedPosition(iFilePosition))
+    return std::max(ContiguousEnd(iFilePosition), iFilePosition);
+  return iFilePosition;
+}
+
+int64_t CBlockCache::CachedDataEndPos()
+{
+  return m_end;
+}
+
+bool CBlockCache::IsCachedPosition(int64_t iFilePosition)
+{
+  CSingleLock lock(m_sync);
+  if (iFilePosition == m_end)
+    return true;
+  CBlock *block = FindBlock(iFilePosition);
+  return block && iFilePosition >= block->validBeg && iFilePosition < block->validEnd;
+}
+
+CCacheStrategy *CBlockCache::CreateNew()
+{
+  return new CBlockCache(m_size_front, m_size_back);
+}
@@ -0,0 +1,99 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <vector>
+
+#include "CacheStrategy.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+
+namespace XFILE {
+
+/*!
+ \brief Cache strategy keeping several independent ranges of a file.
+
+ The cache memory is split into fixed size blocks, each mapped to a block
+ aligned region of the file. Unlike CCircularCache, which only keeps one
+ window around the read position, blocks outside the current read-ahead
+ window stay cached until they are the least recently used block and the
+ space is needed. Seeking back to the header or to an index at the end of
+ the file therefore does not have to go back to the source.
+
+ Reading is limited to the contiguous range between the read and write
+ position, just as with CCircularCache. Seek() and Reset() move both
+ positions to any cached range.
+ */
+class CBlockCache : public CCacheStrategy
+{
+public:
+  CBlockCache(size_t front, size_t back);
+  virtual ~CBlockCache();
+
+  virtual int Open();
+  virtual void Close();
+
+  virtual size_t GetMaxWriteSize(const size_t& iRequestSize);
+  virtual int WriteToCache(const char *buf, size_t len);
+  virtual int ReadFromCache(char *buf, size_t len);
+  virtual int64_t WaitForData(unsigned int minimum, unsigned int iMillis);
+
+  virtual int64_t Seek(int64_t pos);
+  virtual bool Reset(int64_t pos, bool clearAnyway=true);
+
+  virtual int64_t CachedDataEndPosIfSeekTo(int64_t iFilePosition);
+  virtual int64_t CachedDataEndPos();
+  virtual bool IsCachedPosition(int64_t iFilePosition);
+
+  virtual CCacheStrategy *CreateNew();
+
+protected:
+  struct CBlock
+  {
+    int64_t  start;    /**< position in file of the first byte of the block */
+    int64_t  validBeg; /**< position in file of the beginning of valid data */
+    int64_t  validEnd; /**< position in file of the end of valid data */
+    uint64_t lastUse;  /**< LRU stamp */
+    uint8_t *data;
+  };
+
+  CBlock *FindBlock(int64_t pos);
+  CBlock *GetWriteBlock(int64_t pos);
+  bool    IsProtected(const CBlock *block) const;
+  void    FreeBlock(CBlock *block);
+  int64_t ContiguousStart(int64_t pos);
+  int64_t ContiguousEnd(int64_t pos);
+
+  int64_t           m_end;       /**< index in file of the end of the data being written */
+  int64_t           m_cur;       /**< current reading index in file */
+  size_t            m_size_front;/**< maximum amount of read-ahead */
+  size_t            m_size_back; /**< size requested for the back buffer, kept for CreateNew() */
+  size_t            m_blockSize;
+  uint8_t          *m_buf;       /**< memory for all blocks */
+  uint64_t          m_useCounter;
+  std::vector<CBlock>       m_blocks;
+  std::vector<CBlock*>      m_free;
+  std::map<int64_t, CBlock*> m_map; /**< used blocks by block index in file */
+  CCriticalSection  m_sync;
+  CEvent            m_written;
+};
+
+} // namespace XFILE
@@ -20,14 +20,19 @@
 
 #include "DirectoryCache.h"
 #include "FileItem.h"
+#include "music/tags/MusicInfoTag.h"
+#include "settings/AdvancedSettings.h"
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
 #include "utils/StringUtils.h"
+#include "video/VideoInfoTag.h"
 #include "URL.h"
 #include "climits"
 
 #include <algorithm>
+#include <functional>
 
 // Maximum number of directories to keep in our cache
 #define MAX_CACHED_DIRS 50
@@ -37,6 +42,9 @@ using namespace XFILE;
 CDirectoryCache::CDir::CDir(DIR_CACHE_TYPE cacheType)
 {
   m_cacheType = cacheType;
+  m_cachedAt = XbmcThreads::SystemClockMillis();
+  m_ttl = 0;
+  m_bytes = 0;
   m_lastAccess = 0;
   m_Items = new CFileItemList;
   m_Items->SetIgnoreURLOptions(true);
@@ -48,47 +56,77 @@ CDirectoryCache::CDir::~CDir()
   delete m_Items;
 }
 
-void CDirectoryCache::CDir::SetLastAccess(unsigned int &accessCounter)
+void CDirectoryCache::CDir::SetLastAccess(std::atomic<unsigned int> &accessCounter)
 {
   m_lastAccess = accessCounter++;
 }
 
+bool CDirectoryCache::CDir::IsExpired(unsigned int now) const
+{
+  return m_ttl > 0 && now - m_cachedAt >= m_ttl;
+}
+
+void CDirectoryCache::CDir::UpdateSize()
+{
+  // rough estimate of the memory held by the items, the strings and tags
+  // make up most of it
+  m_bytes = sizeof(CFileItemList);
+  for (int i = 0; i < m_Items->Size(); i++)
+  {
+    const CFileItemPtr item = m_Items->Get(i);
+    m_bytes += sizeof(CFileItem) + item->GetPath().size() + item->GetLabel().size() + item->GetLabel2().size();
+    if (item->HasVideoInfoTag())
+      m_bytes += sizeof(CVideoInfoTag);
+    if (item->HasMusicInfoTag())
+      m_bytes += sizeof(MUSIC_INFO::CMusicInfoTag);
+  }
+}
+
 CDirectoryCache::CDirectoryCache(void)
 {
   m_accessCounter = 0;
-#ifdef _DEBUG
+  m_evictableDirs = 0;
+  m_evictableBytes = 0;
+  m_bytes = 0;
   m_cacheHits = 0;
   m_cacheMisses = 0;
-#endif
+  m_evictions = 0;
 }
 
 CDirectoryCache::~CDirectoryCache(void)
 {
+  Clear();
 }
 
-bool CDirectoryCache::GetDirectory(const std::string& strPath, CFileItemList &items, bool retrieveAll)
+CDirectoryCache::Shard& CDirectoryCache::GetShard(const std::string& storedPath)
 {
-  CSingleLock lock (m_cs);
+  return m_shards[std::hash<std::string>()(storedPath) % NUM_SHARDS];
+}
 
+bool CDirectoryCache::GetDirectory(const std::string& strPath, CFileItemList &items, bool retrieveAll)
+{
   // Get rid of any URL options, else the compare may be wrong
   std::string storedPath = CURL(strPath).GetWithoutOptions();
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ciCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
+  Shard& shard = GetShard(storedPath);
+  CSharedLock lock(shard.m_section);
+
+  ciCache i = shard.m_cache.find(storedPath);
+  if (i != shard.m_cache.end())
   {
     CDir* dir = i->second;
-    if (dir->m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
-       (dir->m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll))
+    if (!dir->IsExpired(XbmcThreads::SystemClockMillis()) &&
+        (dir->m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
+        (dir->m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll)))
     {
       items.Copy(*dir->m_Items);
       dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
-      m_cacheHits+=items.Size();
-#endif
+      m_cacheHits++;
       return true;
     }
   }
+  m_cacheMisses++;
   return false;
 }
 
@@ -108,20 +146,31 @@ void CDirectoryCache::SetDirectory(const std::string& strPath, const CFileItemLi
   // IDEALLY, any further processing on the item would actually create a new item
   // instead of altering it, but we can't really enforce that in an easy way, so
   // this is the best solution for now.
-  CSingleLock lock (m_cs);
 
   // Get rid of any URL options, else the compare may be wrong
   std::string storedPath = CURL(strPath).GetWithoutOptions();
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ClearDirectory(storedPath);
-
-  CheckIfFull();
-
+  // copy outside of the lock, it's the expensive part
   CDir* dir = new CDir(cacheType);
   dir->m_Items->Copy(items);
+  dir->m_ttl = g_advancedSettings.m_dirCacheTTL * 1000;
+  dir->UpdateSize();
   dir->SetLastAccess(m_accessCounter);
-  m_cache.insert(std::pair<std::string, CDir*>(storedPath, dir));
+
+  ClearDirectory(storedPath);
+
+  if (cacheType != DIR_CACHE_ALWAYS)
+    CheckIfFull(dir->m_bytes);
+
+  Shard& shard = GetShard(storedPath);
+  CExclusiveLock lock(shard.m_section);
+
+  // another thread may have cached it meanwhile
+  iCache i = shard.m_cache.find(storedPath);
+  if (i != shard.m_cache.end())
+    Delete(shard, i);
+  Insert(shard, storedPath, dir);
 }
 
 void CDirectoryCache::ClearFile(const std::string& strFile)
@@ -134,55 +183,66 @@ void CDirectoryCache::ClearFile(const std::string& strFile)
 
 void CDirectoryCache::ClearDirectory(const std::string& strPath)
 {
-  CSingleLock lock (m_cs);
-
   // Get rid of any URL options, else the compare may be wrong
   std::string storedPath = CURL(strPath).GetWithoutOptions();
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  iCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
-    Delete(i);
+  Shard& shard = GetShard(storedPath);
+  CExclusiveLock lock(shard.m_section);
+
+  iCache i = shard.m_cache.find(storedPath);
+  if (i != shard.m_cache.end())
+    Delete(shard, i);
 }
 
 void CDirectoryCache::ClearSubPaths(const std::string& strPath)
 {
-  CSingleLock lock (m_cs);
-
   // Get rid of any URL options, else the compare may be wrong
   std::string storedPath = CURL(strPath).GetWithoutOptions();
 
-  iCache i = m_cache.begin();
-  while (i != m_cache.end())
+  for (unsigned int s = 0; s < NUM_SHARDS; s++)
   {
-    if (URIUtils::PathHasParent(i->first, storedPath))
-      Delete(i++);
-    else
-      i++;
+    Shard& shard = m_shards[s];
+    CExclusiveLock lock(shard.m_section);
+
+    iCache i = shard.m_cache.begin();
+    while (i != shard.m_cache.end())
+    {
+      if (URIUtils::PathHasParent(i->first, storedPath))
+        Delete(shard, i++);
+      else
+        i++;
+    }
   }
 }
 
 void CDirectoryCache::AddFile(const std::string& strFile)
 {
-  CSingleLock lock (m_cs);
-
   // Get rid of any URL options, else the compare may be wrong
   std::string strPath = URIUtils::GetDirectory(CURL(strFile).GetWithoutOptions());
   URIUtils::RemoveSlashAtEnd(strPath);
 
-  ciCache i = m_cache.find(strPath);
-  if (i != m_cache.end())
+  Shard& shard = GetShard(strPath);
+  CExclusiveLock lock(shard.m_section);
+
+  ciCache i = shard.m_cache.find(strPath);
+  if (i != shard.m_cache.end())
   {
     CDir *dir = i->second;
     CFileItemPtr item(new CFileItem(strFile, false));
     dir->m_Items->Add(item);
     dir->SetLastAccess(m_accessCounter);
+
+    size_t bytes = sizeof(CFileItem) + strFile.size();
+    dir->m_bytes += bytes;
+    m_bytes += bytes;
+    if (dir->m_cacheType != DIR_CACHE_ALWAYS)
+      m_evictableBytes += bytes;
   }
 }
 
 bool CDirectoryCache::FileExists(const std::string& strFile, bool& bInCache)
 {
-  CSingleLock lock (m_cs);
   bInCache = false;
 
   // Get rid of any URL options, else the compare may be wrong
@@ -191,31 +251,34 @@ bool CDirectoryCache::FileExists(const std::string& strFile, bool& bInCache)
   std::string storedPath = URIUtils::GetDirectory(strPath);
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ciCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
+  Shard& shard = GetShard(storedPath);
+  CSharedLock lock(shard.m_section);
+
+  ciCache i = shard.m_cache.find(storedPath);
+  if (i != shard.m_cache.end() && !i->second->IsExpired(XbmcThreads::SystemClockMillis()))
   {
     bInCache = true;
     CDir *dir = i->second;
     dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
     m_cacheHits++;
-#endif
     return (URIUtils::PathEquals(strPath, storedPath) || dir->m_Items->Contains(strFile));
   }
-#ifdef _DEBUG
   m_cacheMisses++;
-#endif
   return false;
 }
 
 void CDirectoryCache::Clear()
 {
   // this routine clears everything
-  CSingleLock lock (m_cs);
+  for (unsigned int s = 0; s < NUM_SHARDS; s++)
+  {
+    Shard& shard = m_shards[s];
+    CExclusiveLock lock(shard.m_section);
 
-  iCache i = m_cache.begin();
-  while (i != m_cache.end() )
-    Delete(i++);
+    iCache i = shard.m_cache.begin();
+    while (i != shard.m_cache.end())
+      Delete(shard, i++);
+  }
 }
 
 void CDirectoryCache::InitCache(std::set<std::string>& dirs)
@@ -232,60 +295,121 @@ void CDirectoryCache::InitCache(std::set<std::string>& dirs)
 
 void CDirectoryCache::ClearCache(std::set<std::string>& dirs)
 {
-  iCache i = m_cache.begin();
-  while (i != m_cache.end())
+  for (std::set<std::string>::const_iterator it = dirs.begin(); it != dirs.end(); ++it)
+    ClearDirectory(*it);
+}
+
+void CDirectoryCache::CheckIfFull(size_t newBytes)
+{
+  // make room for one more folder, removing the least recently used ones
+  const uint64_t maxBytes = g_advancedSettings.m_dirCacheMemSize;
+  while (m_evictableDirs >= MAX_CACHED_DIRS ||
+         (maxBytes > 0 && m_evictableDirs > 0 && m_evictableBytes + newBytes > maxBytes))
   {
-    if (dirs.find(i->first) != dirs.end())
-      Delete(i++);
-    else
-      i++;
+    if (!EvictOne())
+      break;
   }
 }
 
-void CDirectoryCache::CheckIfFull()
+bool CDirectoryCache::EvictOne()
 {
-  CSingleLock lock (m_cs);
-
-  // find the last accessed folder, and remove if the number of cached folders is too many
-  iCache lastAccessed = m_cache.end();
-  unsigned int numCached = 0;
-  for (iCache i = m_cache.begin(); i != m_cache.end(); i++)
+  // find the least recently accessed folder over all shards, expired ones first
+  const unsigned int now = XbmcThreads::SystemClockMillis();
+  int victimShard = -1;
+  std::string victimPath;
+  bool victimExpired = false;
+  unsigned int victimAccess = 0;
+
+  for (unsigned int s = 0; s < NUM_SHARDS; s++)
   {
-    // ensure dirs that are always cached aren't cleared
-    if (i->second->m_cacheType != DIR_CACHE_ALWAYS)
+    Shard& shard = m_shards[s];
+    CSharedLock lock(shard.m_section);
+    for (ciCache i = shard.m_cache.begin(); i != shard.m_cache.end(); ++i)
     {
-      if (lastAccessed == m_cache.end() || i->second->GetLastAccess() < lastAccessed->second->GetLastAccess())
-        lastAccessed = i;
-      numCached++;
+      // ensure dirs that are always cached aren't cleared
+      if (i->second->m_cacheType == DIR_CACHE_ALWAYS)
+        continue;
+
+      const bool expired = i->second->IsExpired(now);
+      const unsigned int access = i->second->GetLastAccess();
+      if (victimShard < 0 || (expired && !victimExpired) ||
+          (expired == victimExpired && access < victimAccess))
+      {
+        victimShard = s;
+        victimPath = i->first;
+        victimExpired = expired;
+        victimAccess = access;
+      }
     }
   }
-  if (lastAccessed != m_cache.end() && numCached >= MAX_CACHED_DIRS)
-    Delete(lastAccessed);
+
+  if (victimShard < 0)
+    return false;
+
+  Shard& shard = m_shards[victimShard];
+  CExclusiveLock lock(shard.m_section);
+  iCache i = shard.m_cache.find(victimPath);
+  // it's fine if another thread removed or replaced it meanwhile
+  if (i != shard.m_cache.end() && i->second->m_cacheType != DIR_CACHE_ALWAYS)
+  {
+    Delete(shard, i);
+    m_evictions++;
+  }
+  return true;
 }
 
-void CDirectoryCache::Delete(iCache it)
+void CDirectoryCache::Insert(Shard& shard, const std::string& storedPath, CDir* dir)
+{
+  shard.m_cache.insert(std::make_pair(storedPath, dir));
+  m_bytes += dir->m_bytes;
+  if (dir->m_cacheType != DIR_CACHE_ALWAYS)
+  {
+    m_evictableDirs++;
+    m_evictableBytes += dir->m_bytes;
+  }
+}
+
+void CDirectoryCache::Delete(Shard& shard, iCache it)
 {
   CDir* dir = it->second;
+  m_bytes -= dir->m_bytes;
+  if (dir->m_cacheType != DIR_CACHE_ALWAYS)
+  {
+    m_evictableDirs--;
+    m_evictableBytes -= dir->m_bytes;
+  }
   delete dir;
-  m_cache.erase(it);
+  shard.m_cache.erase(it);
 }
 
-#ifdef _DEBUG
-void CDirectoryCache::PrintStats() const
+CDirectoryCache::Stats CDirectoryCache::GetStats() const
 {
-  CSingleLock lock (m_cs);
-  CLog::Log(LOGDEBUG, "%s - total of %u cache hits, and %u cache misses", __FUNCTION__, m_cacheHits, m_cacheMisses);
-  // run through and find the oldest and the number of items cached
-  unsigned int oldest = UINT_MAX;
-  unsigned int numItems = 0;
-  unsigned int numDirs = 0;
-  for (ciCache i = m_cache.begin(); i != m_cache.end(); i++)
+  Stats stats;
+  stats.hits = m_cacheHits;
+  stats.misses = m_cacheMisses;
+  stats.evictions = m_evictions;
+  stats.bytes = m_bytes;
+  stats.directories = 0;
+  stats.items = 0;
+  for (unsigned int s = 0; s < NUM_SHARDS; s++)
   {
-    CDir *dir = i->second;
-    oldest = std::min(oldest, dir->GetLastAccess());
-    numItems += dir->m_Items->Size();
-    numDirs++;
+    const Shard& shard = m_shards[s];
+    CSharedLock lock(shard.m_section);
+    for (ciCache i = shard.m_cache.begin(); i != shard.m_cache.end(); ++i)
+    {
+      stats.directories++;
+      stats.items += i->second->m_Items->Size();
+    }
   }
-  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total.  Oldest is %u, current is %u", __FUNCTION__, numDirs, numItems, oldest, m_accessCounter);
+  return stats;
+}
+
+#ifdef _DEBUG
+void CDirectoryCache::PrintStats() const
+{
+  Stats stats = GetStats();
+  CLog::Log(LOGDEBUG, "%s - total of %" PRIu64" cache hits, and %" PRIu64" cache misses", __FUNCTION__, stats.hits, stats.misses);
+  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total (~%" PRIu64" bytes), %" PRIu64" evicted", __FUNCTION__,
+            stats.directories, stats.items, stats.bytes, stats.evictions);
 }
 #endif
@@ -21,15 +21,27 @@
 
 #include "IDirectory.h"
 #include "Directory.h"
-#include "threads/CriticalSection.h"
+#include "threads/SharedSection.h"
 
-#include <map>
+#include <atomic>
 #include <set>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
 
 class CFileItem;
 
 namespace XFILE
 {
+  /*!
+   \brief Cache of directory listings.
+
+   Listings are spread over a number of shards by path hash, each with its
+   own reader/writer lock, so lookups from several threads don't contend.
+   Entries may expire after a configurable time and the cache is bounded by
+   both the number of directories and the estimated memory used by their
+   items, evicting the least recently used entries first.
+   */
   class CDirectoryCache
   {
     class CDir
@@ -38,15 +50,30 @@ namespace XFILE
       CDir(DIR_CACHE_TYPE cacheType);
       virtual ~CDir();
 
-      void SetLastAccess(unsigned int &accessCounter);
+      void SetLastAccess(std::atomic<unsigned int> &accessCounter);
       unsigned int GetLastAccess() const { return m_lastAccess; };
+      bool IsExpired(unsigned int now) const;
+      void UpdateSize();
 
       CFileItemList* m_Items;
       DIR_CACHE_TYPE m_cacheType;
+      unsigned int m_cachedAt;
+      unsigned int m_ttl;
+      size_t m_bytes;
     private:
-      unsigned int m_lastAccess;
+      std::atomic<unsigned int> m_lastAccess;
     };
   public:
+    struct Stats
+    {
+      uint64_t hits;
+      uint64_t misses;
+      uint64_t evictions;
+      unsigned int directories;
+      unsigned int items;
+      uint64_t bytes;
+    };
+
     CDirectoryCache(void);
     virtual ~CDirectoryCache(void);
     bool GetDirectory(const std::string& strPath, CFileItemList &items, bool retrieveAll = false);
@@ -57,27 +84,40 @@ namespace XFILE
     void Clear();
     void AddFile(const std::string& strFile);
     bool FileExists(const std::string& strPath, bool& bInCache);
+    Stats GetStats() const;
 #ifdef _DEBUG
     void PrintStats() const;
 #endif
   protected:
     void InitCache(std::set<std::string>& dirs);
     void ClearCache(std::set<std::string>& dirs);
-    void CheckIfFull();
+    void CheckIfFull(size_t newBytes);
+    bool EvictOne();
 
-    std::map<std::string, CDir*> m_cache;
-    typedef std::map<std::string, CDir*>::iterator iCache;
-    typedef std::map<std::string, CDir*>::const_iterator ciCache;
-    void Delete(iCache i);
+    typedef std::unordered_map<std::string, CDir*> CacheMap;
+    typedef CacheMap::iterator iCache;
+    typedef CacheMap::const_iterator ciCache;
 
-    CCriticalSection m_cs;
+    struct Shard
+    {
+      CSharedSection m_section;
+      CacheMap m_cache;
+    };
+    static const unsigned int NUM_SHARDS = 16;
 
-    unsigned int m_accessCounter;
+    Shard& GetShard(const std::string& storedPath);
+    void Insert(Shard& shard, const std::string& storedPath, CDir* dir);
+    void Delete(Shard& shard, iCache i);
 
-#ifdef _DEBUG
-    unsigned int m_cacheHits;
-    unsigned int m_cacheMisses;
-#endif
+    Shard m_shards[NUM_SHARDS];
+
+    std::atomic<unsigned int> m_accessCounter;
+    std::atomic<unsigned int> m_evictableDirs;   //!< cached dirs, not counting DIR_CACHE_ALWAYS ones
+    std::atomic<uint64_t> m_evictableBytes;
+    std::atomic<uint64_t> m_bytes;
+    std::atomic<uint64_t> m_cacheHits;
+    std::atomic<uint64_t> m_cacheMisses;
+    std::atomic<uint64_t> m_evictions;
   };
 }
 extern XFILE::CDirectoryCache g_directoryCache;
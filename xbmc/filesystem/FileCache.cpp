@@ -24,9 +24,13 @@
 #include "File.h"
 #include "URL.h"
 
+#include "BlockCache.h"
 #include "CircularCache.h"
+#include "MediaCache.h"
+#include "ReadAheadController.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
+#include "utils/URIUtils.h"
 #include "settings/AdvancedSettings.h"
 
 #if !defined(TARGET_WINDOWS)
@@ -44,6 +48,7 @@
 using namespace XFILE;
 
 #define READ_CACHE_CHUNK_SIZE (64*1024)
+#define READ_CACHE_MAX_CHUNK_SIZE (1024*1024)
 
 class CWriteRate
 {
@@ -94,6 +99,8 @@ private:
 CFileCache::CFileCache(const unsigned int flags)
   : CThread("FileCache")
   , m_pCache(NULL)
+  , m_diskCache(NULL)
+  , m_sourceSeekNeeded(false)
   , m_bDeleteCache(true)
   , m_seekPossible(0)
   , m_nSeekResult(0)
@@ -111,6 +118,8 @@ CFileCache::CFileCache(const unsigned int flags)
 
 CFileCache::CFileCache(CCacheStrategy *pCache, bool bDeleteCache /* = true */)
   : CThread("FileCacheStrategy")
+  , m_diskCache(NULL)
+  , m_sourceSeekNeeded(false)
   , m_seekPossible(0)
   , m_chunkSize(0)
   , m_writeRate(0)
@@ -207,7 +216,10 @@ bool CFileCache::Open(const CURL& url)
         front /= 2;
         back /= 2;
       }
-      m_pCache = new CCircularCache(front, back);
+      if (g_advancedSettings.m_cacheSegmented && m_seekPossible > 0)
+        m_pCache = new CBlockCache(front, back);
+      else
+        m_pCache = new CCircularCache(front, back);
       m_forwardCacheSize = front;
     }
 
@@ -226,6 +238,17 @@ bool CFileCache::Open(const CURL& url)
     return false;
   }
   
+  // keep what we read from slow sources on disk so a later playback of the
+  // same file doesn't have to fetch it again
+  if (g_advancedSettings.m_cacheDiskSize > 0 && m_seekPossible > 0 && m_fileSize > 0 &&
+      !URIUtils::IsHD(m_sourcePath))
+  {
+    struct __stat64 st;
+    if (m_source.Stat(&st) == 0)
+      m_diskCache = CMediaCache::GetInstance().Open(url, m_fileSize, st.st_mtime);
+  }
+  m_sourceSeekNeeded = false;
+
   m_readPos = 0;
   m_writePos = 0;
   m_writeRate = 1024 * 1024;
@@ -246,8 +269,11 @@ void CFileCache::Process()
     return;
   }
 
+  CReadAheadController controller(m_chunkSize, READ_CACHE_MAX_CHUNK_SIZE);
+  const bool adaptive = g_advancedSettings.m_cacheAdaptive;
+
   // create our read buffer
-  std::unique_ptr<char[]> buffer(new char[m_chunkSize]);
+  std::unique_ptr<char[]> buffer(new char[adaptive ? controller.MaxChunkSize() : m_chunkSize]);
   if (buffer.get() == NULL)
   {
     CLog::Log(LOGERROR, "%s - failed to allocate read buffer", __FUNCTION__);
@@ -270,7 +296,12 @@ void CFileCache::Process()
       int64_t cacheMaxPos = m_pCache->CachedDataEndPosIfSeekTo(m_seekPos);
       cacheReachEOF = (cacheMaxPos == m_fileSize);
       bool sourceSeekFailed = false;
-      if (!cacheReachEOF)
+      if (!cacheReachEOF && m_diskCache && m_diskCache->CachedLength(cacheMaxPos) > 0)
+      {
+        // data is on disk, the source is only repositioned once we run out of it
+        m_sourceSeekNeeded = true;
+      }
+      else if (!cacheReachEOF)
       {
         m_nSeekResult = m_source.Seek(cacheMaxPos, SEEK_SET);
         if (m_nSeekResult != cacheMaxPos)
@@ -279,6 +310,8 @@ void CFileCache::Process()
           m_seekPossible = m_source.IoControl(IOCTRL_SEEK_POSSIBLE, NULL);
           sourceSeekFailed = true;
         }
+        else
+          m_sourceSeekNeeded = false;
       }
       if (!sourceSeekFailed)
       {
@@ -288,13 +321,39 @@ void CFileCache::Process()
         assert(m_writePos == cacheMaxPos);
         average.Reset(m_writePos, bCompleteReset); // Can only recalculate new average from scratch after a full reset (empty cache)
         limiter.Reset(m_writePos);
+        controller.Reset();
         m_nSeekResult = m_seekPos;
       }
 
       m_seekEnded.Set();
     }
 
-    while (m_writeRate)
+    unsigned chunkSize = m_chunkSize;
+    if (adaptive && m_writeRate)
+    {
+      while (!m_bStop)
+      {
+        if (controller.Refill(m_writePos - m_readPos, m_writeRate, m_forwardCacheSize))
+        {
+          chunkSize = controller.ChunkSize();
+          limiter.Reset(m_writePos);
+          break;
+        }
+
+        // enough buffered, follow the stream without flooding the source
+        if (limiter.Rate(m_writePos) < m_writeRate)
+          break;
+
+        if (m_seekEvent.WaitMSec(100))
+        {
+          if (!m_bStop)
+            m_seekEvent.Set();
+          break;
+        }
+      }
+    }
+
+    while (m_writeRate && !adaptive)
     {
       if (m_writePos - m_readPos < m_writeRate * g_advancedSettings.m_cacheReadFactor)
       {
@@ -313,7 +372,7 @@ void CFileCache::Process()
       }
     }
 
-    size_t maxWrite = m_pCache->GetMaxWriteSize(m_chunkSize);
+    size_t maxWrite = m_pCache->GetMaxWriteSize(chunkSize);
 
     /* Only read from source if there's enough write space in the cache
      * else we may keep disposing data and seeking back on (slow) source
@@ -326,7 +385,13 @@ void CFileCache::Process()
 
     ssize_t iRead = 0;
     if (!cacheReachEOF)
-      iRead = m_source.Read(buffer.get(), maxWrite);
+    {
+      const unsigned start = XbmcThreads::SystemClockMillis();
+      iRead = ReadSource(buffer.get(), maxWrite);
+      // data from the disk cache says nothing about the source
+      if (!m_sourceSeekNeeded)
+        controller.SourceRead(iRead, XbmcThreads::SystemClockMillis() - start);
+    }
     if (iRead == 0)
     {
       // Check for actual EOF and retry as long as we still have data in our cache
@@ -537,6 +602,39 @@ int64_t CFileCache::Seek(int64_t iFilePosition, int iWhence)
   return m_nSeekResult;
 }
 
+ssize_t CFileCache::ReadSource(char *buffer, size_t size)
+{
+  if (m_diskCache)
+  {
+    int64_t cached = m_diskCache->CachedLength(m_writePos);
+    if (cached > 0)
+    {
+      ssize_t iRead = m_diskCache->Read(m_writePos, buffer, (size_t)std::min((int64_t)size, cached));
+      if (iRead > 0)
+      {
+        m_sourceSeekNeeded = true;
+        return iRead;
+      }
+    }
+  }
+
+  if (m_sourceSeekNeeded)
+  {
+    int64_t pos = m_source.Seek(m_writePos, SEEK_SET);
+    if (pos != m_writePos)
+    {
+      CLog::Log(LOGERROR, "CFileCache::ReadSource - Error %d seeking. Seek returned %" PRId64, (int)GetLastError(), pos);
+      return -1;
+    }
+    m_sourceSeekNeeded = false;
+  }
+
+  ssize_t iRead = m_source.Read(buffer, size);
+  if (iRead > 0 && m_diskCache)
+    m_diskCache->Write(m_writePos, buffer, iRead);
+  return iRead;
+}
+
 void CFileCache::Close()
 {
   StopThread();
@@ -545,6 +643,12 @@ void CFileCache::Close()
   if (m_pCache)
     m_pCache->Close();
 
+  if (m_diskCache)
+  {
+    CMediaCache::GetInstance().Close(m_diskCache);
+    m_diskCache = NULL;
+  }
+
   m_source.Close();
 }
 
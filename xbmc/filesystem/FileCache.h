@@ -28,6 +28,7 @@
 
 namespace XFILE
 {
+  class CMediaCacheEntry;
 
   class CFileCache : public IFile, public CThread
   {
@@ -63,7 +64,11 @@ namespace XFILE
     virtual std::string GetContentCharset(void);
 
   private:
+    ssize_t ReadSource(char *buffer, size_t size);
+
     CCacheStrategy *m_pCache;
+    CMediaCacheEntry *m_diskCache;
+    bool      m_sourceSeekNeeded;
     bool      m_bDeleteCache;
     int        m_seekPossible;
     CFile      m_source;
@@ -0,0 +1,420 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MediaCache.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <time.h>
+
+#include "Directory.h"
+#include "File.h"
+#include "FileItem.h"
+#include "SpecialProtocol.h"
+#include "URL.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+#include "utils/md5.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "utils/XBMCTinyXML.h"
+#if defined(TARGET_POSIX)
+#include "posix/PosixFile.h"
+#define CacheLocalFile CPosixFile
+#elif defined(TARGET_WINDOWS)
+#include "win32/Win32File.h"
+#define CacheLocalFile CWin32File
+#endif // TARGET_WINDOWS
+
+#define MEDIACACHE_PATH "special://temp/mediacache/"
+
+using namespace XFILE;
+
+CMediaCacheEntry::CMediaCacheEntry(CMediaCache &cache, const std::string &id, const std::string &url, int64_t size, int64_t mtime)
+  : m_cache(cache)
+  , m_id(id)
+  , m_url(url)
+  , m_size(size)
+  , m_mtime(mtime)
+  , m_bytes(0)
+  , m_lastUsed(0)
+  , m_openCount(0)
+  , m_dirty(false)
+  , m_file(NULL)
+{
+}
+
+CMediaCacheEntry::~CMediaCacheEntry()
+{
+  Close();
+}
+
+bool CMediaCacheEntry::Open(const std::string &dataFile)
+{
+  CSingleLock lock(m_section);
+  if (m_file)
+    return true;
+
+  m_file = new CacheLocalFile();
+  if (!m_file->OpenForWrite(CURL(CSpecialProtocol::TranslatePath(dataFile)), false))
+  {
+    CLog::Log(LOGERROR, "CMediaCacheEntry::Open - failed to open %s", dataFile.c_str());
+    delete m_file;
+    m_file = NULL;
+    return false;
+  }
+  return true;
+}
+
+void CMediaCacheEntry::Close()
+{
+  CSingleLock lock(m_section);
+  if (m_file)
+  {
+    m_file->Close();
+    delete m_file;
+    m_file = NULL;
+  }
+}
+
+int64_t CMediaCacheEntry::CachedLength(int64_t pos)
+{
+  CSingleLock lock(m_section);
+
+  // first range starting after pos, the one before may contain it
+  std::map<int64_t, int64_t>::const_iterator it = m_ranges.upper_bound(pos);
+  if (it == m_ranges.begin())
+    return 0;
+  --it;
+  if (pos >= it->second)
+    return 0;
+  return it->second - pos;
+}
+
+ssize_t CMediaCacheEntry::Read(int64_t pos, void *buffer, size_t size)
+{
+  CSingleLock lock(m_section);
+  if (!m_file)
+    return -1;
+
+  size = (size_t)std::min((int64_t)size, CachedLength(pos));
+  if (size == 0)
+    return 0;
+
+  if (m_file->Seek(pos, SEEK_SET) != pos)
+    return -1;
+  return m_file->Read(buffer, size);
+}
+
+bool CMediaCacheEntry::Write(int64_t pos, const void *buffer, size_t size)
+{
+  if (size == 0)
+    return false;
+
+  // only data that isn't cached yet grows the cache
+  uint64_t reserved;
+  {
+    CSingleLock lock(m_section);
+    reserved = MissingBytes(pos, pos + size);
+  }
+
+  // make room before growing, the cache is never locked while holding an entry
+  if (!m_cache.Reserve(reserved))
+    return false;
+
+  CSingleLock lock(m_section);
+  ssize_t written = -1;
+  if (m_file && m_file->Seek(pos, SEEK_SET) == pos)
+    written = m_file->Write(buffer, size);
+
+  // ranges only grow while the entry is open, so other writers can only have
+  // added some of the reserved bytes in the meantime
+  uint64_t added = written > 0 ? AddRange(pos, pos + written) : 0;
+  m_cache.Release(reserved - std::min(added, reserved));
+  return written == (ssize_t)size;
+}
+
+uint64_t CMediaCacheEntry::MissingBytes(int64_t start, int64_t end) const
+{
+  uint64_t missing = end - start;
+  std::map<int64_t, int64_t>::const_iterator it = m_ranges.upper_bound(start);
+  if (it != m_ranges.begin())
+    --it;
+  for (; it != m_ranges.end() && it->first < end; ++it)
+  {
+    const int64_t from = std::max(start, it->first);
+    const int64_t to = std::min(end, it->second);
+    if (to > from)
+      missing -= to - from;
+  }
+  return missing;
+}
+
+uint64_t CMediaCacheEntry::AddRange(int64_t start, int64_t end)
+{
+  const uint64_t bytes = m_bytes;
+
+  // merge with any range overlapping or touching [start, end)
+  std::map<int64_t, int64_t>::iterator it = m_ranges.upper_bound(start);
+  if (it != m_ranges.begin())
+  {
+    std::map<int64_t, int64_t>::iterator prev = it;
+    --prev;
+    if (prev->second >= start)
+      it = prev;
+  }
+  while (it != m_ranges.end() && it->first <= end)
+  {
+    start = std::min(start, it->first);
+    end = std::max(end, it->second);
+    m_bytes -= it->second - it->first;
+    it = m_ranges.erase(it);
+  }
+  m_ranges[start] = end;
+  m_bytes += end - start;
+  m_dirty = true;
+  return m_bytes - bytes;
+}
+
+CMediaCache &CMediaCache::GetInstance()
+{
+  static CMediaCache sMediaCache;
+  return sMediaCache;
+}
+
+CMediaCache::CMediaCache()
+  : m_loaded(false)
+  , m_cachedBytes(0)
+{
+}
+
+CMediaCache::~CMediaCache()
+{
+}
+
+std::string CMediaCache::GetPath(const std::string &id, const char *extension) const
+{
+  return MEDIACACHE_PATH + id + extension;
+}
+
+void CMediaCache::Load()
+{
+  if (m_loaded)
+    return;
+  m_loaded = true;
+
+  if (!CDirectory::Exists(MEDIACACHE_PATH))
+  {
+    CDirectory::Create(MEDIACACHE_PATH);
+    return;
+  }
+
+  CFileItemList items;
+  CDirectory::GetDirectory(MEDIACACHE_PATH, items, "", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_BYPASS_CACHE);
+  for (int i = 0; i < items.Size(); i++)
+  {
+    const std::string path = items[i]->GetPath();
+    const std::string id = URIUtils::GetFileName(URIUtils::ReplaceExtension(path, ""));
+
+    if (URIUtils::HasExtension(path, ".data"))
+    {
+      // data without index was left behind by a crash, it's useless
+      if (!CFile::Exists(GetPath(id, ".xml")))
+        CFile::Delete(path);
+      continue;
+    }
+
+    if (!URIUtils::HasExtension(path, ".xml"))
+      continue;
+
+    CXBMCTinyXML doc;
+    const TiXmlElement *root = NULL;
+    if (doc.LoadFile(path))
+      root = doc.RootElement();
+    std::string url;
+    int64_t size = 0, mtime = 0, lastUsed = 0;
+    if (!root || root->ValueStr() != "mediacache" ||
+        root->QueryStringAttribute("url", &url) != TIXML_SUCCESS ||
+        root->QueryValueAttribute("size", &size) != TIXML_SUCCESS ||
+        root->QueryValueAttribute("mtime", &mtime) != TIXML_SUCCESS ||
+        root->QueryValueAttribute("lastused", &lastUsed) != TIXML_SUCCESS)
+    {
+      CLog::Log(LOGWARNING, "CMediaCache::Load - removing invalid index %s", path.c_str());
+      Remove(id);
+      continue;
+    }
+
+    std::unique_ptr<CMediaCacheEntry> entry(new CMediaCacheEntry(*this, id, url, size, mtime));
+    entry->m_lastUsed = (time_t)lastUsed;
+    for (const TiXmlElement *range = root->FirstChildElement("range"); range; range = range->NextSiblingElement("range"))
+    {
+      const char *start = range->Attribute("start");
+      const char *end = range->Attribute("end");
+      if (start && end)
+        entry->AddRange(strtoll(start, NULL, 10), strtoll(end, NULL, 10));
+    }
+    entry->m_dirty = false;
+    m_cachedBytes += entry->m_bytes;
+    m_entries[id] = std::move(entry);
+  }
+
+  CLog::Log(LOGDEBUG, "CMediaCache::Load - %u entries, %" PRIu64" bytes", (unsigned int)m_entries.size(), GetCachedBytes());
+}
+
+bool CMediaCache::SaveIndex(CMediaCacheEntry *entry)
+{
+  CXBMCTinyXML doc;
+  TiXmlElement root("mediacache");
+  root.SetAttribute("url", entry->m_url.c_str());
+  root.SetAttribute("size", StringUtils::Format("%" PRId64, entry->m_size).c_str());
+  root.SetAttribute("mtime", StringUtils::Format("%" PRId64, entry->m_mtime).c_str());
+  root.SetAttribute("lastused", StringUtils::Format("%" PRId64, (int64_t)entry->m_lastUsed).c_str());
+  for (std::map<int64_t, int64_t>::const_iterator it = entry->m_ranges.begin(); it != entry->m_ranges.end(); ++it)
+  {
+    TiXmlElement range("range");
+    range.SetAttribute("start", StringUtils::Format("%" PRId64, it->first).c_str());
+    range.SetAttribute("end", StringUtils::Format("%" PRId64, it->second).c_str());
+    root.InsertEndChild(range);
+  }
+  doc.InsertEndChild(root);
+
+  if (!doc.SaveFile(GetPath(entry->m_id, ".xml")))
+  {
+    CLog::Log(LOGERROR, "CMediaCache::SaveIndex - failed to save index for %s", CURL::GetRedacted(entry->m_url).c_str());
+    return false;
+  }
+  entry->m_dirty = false;
+  return true;
+}
+
+CMediaCacheEntry *CMediaCache::Open(const CURL &url, int64_t size, int64_t mtime)
+{
+  uint64_t maxBytes = (uint64_t)g_advancedSettings.m_cacheDiskSize * 1024 * 1024;
+  if (maxBytes == 0 || size <= 0)
+    return NULL;
+
+  CSingleLock lock(m_section);
+  Load();
+
+  const std::string path = url.Get();
+  const std::string id = XBMC::XBMC_MD5::GetMD5(StringUtils::Format("%s|%" PRId64"|%" PRId64, path.c_str(), size, mtime));
+
+  std::unique_ptr<CMediaCacheEntry> &entry = m_entries[id];
+  if (!entry)
+    entry.reset(new CMediaCacheEntry(*this, id, path, size, mtime));
+
+  if (!entry->Open(GetPath(id, ".data")))
+  {
+    if (entry->m_openCount == 0)
+      Remove(id);
+    return NULL;
+  }
+
+  CSingleLock entryLock(entry->m_section);
+  entry->m_openCount++;
+  entry->m_lastUsed = time(NULL);
+  return entry.get();
+}
+
+void CMediaCache::Close(CMediaCacheEntry *entry)
+{
+  if (!entry)
+    return;
+
+  CSingleLock lock(m_section);
+  {
+    CSingleLock entryLock(entry->m_section);
+    if (entry->m_dirty)
+      SaveIndex(entry);
+    if (--entry->m_openCount > 0)
+      return;
+    entry->Close();
+  }
+
+  Evict((uint64_t)g_advancedSettings.m_cacheDiskSize * 1024 * 1024);
+}
+
+uint64_t CMediaCache::GetCachedBytes()
+{
+  return m_cachedBytes;
+}
+
+bool CMediaCache::Reserve(uint64_t bytes)
+{
+  // entries in use share the budget, the ones that aren't make room
+  const uint64_t maxBytes = (uint64_t)g_advancedSettings.m_cacheDiskSize * 1024 * 1024;
+  if (bytes > maxBytes)
+    return false;
+  if (TryReserve(bytes, maxBytes))
+    return true;
+
+  CSingleLock lock(m_section);
+  Evict(maxBytes - bytes);
+  return TryReserve(bytes, maxBytes);
+}
+
+bool CMediaCache::TryReserve(uint64_t bytes, uint64_t maxBytes)
+{
+  uint64_t cached = m_cachedBytes;
+  do
+  {
+    if (cached + bytes > maxBytes)
+      return false;
+  } while (!m_cachedBytes.compare_exchange_weak(cached, cached + bytes));
+  return true;
+}
+
+void CMediaCache::Release(uint64_t bytes)
+{
+  m_cachedBytes -= bytes;
+}
+
+void CMediaCache::Evict(uint64_t maxBytes)
+{
+  while (m_cachedBytes > maxBytes)
+  {
+    // drop the least recently used entry that isn't in use
+    CMediaCacheEntry *victim = NULL;
+    for (std::map<std::string, std::unique_ptr<CMediaCacheEntry> >::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+      if (it->second->m_openCount == 0 && (!victim || it->second->m_lastUsed < victim->m_lastUsed))
+        victim = it->second.get();
+    }
+    if (!victim)
+      break;
+
+    CLog::Log(LOGDEBUG, "CMediaCache::Evict - removing %s", CURL::GetRedacted(victim->m_url).c_str());
+    Remove(victim->m_id);
+  }
+}
+
+void CMediaCache::Remove(const std::string &id)
+{
+  CFile::Delete(GetPath(id, ".data"));
+  CFile::Delete(GetPath(id, ".xml"));
+
+  std::map<std::string, std::unique_ptr<CMediaCacheEntry> >::iterator it = m_entries.find(id);
+  if (it != m_entries.end())
+  {
+    m_cachedBytes -= it->second->m_bytes;
+    m_entries.erase(it);
+  }
+}
@@ -0,0 +1,147 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <stdint.h>
+
+#include "threads/CriticalSection.h"
+
+class CURL;
+
+namespace XFILE
+{
+  class IFile;
+  class CMediaCache;
+
+  /*!
+   \brief Cached data of one source file in the persistent media cache.
+
+   Data is stored at its original offset in a sparse file, the ranges that
+   are present are tracked in memory and written to an index file on close.
+   All methods are thread-safe.
+   */
+  class CMediaCacheEntry
+  {
+  public:
+    ~CMediaCacheEntry();
+
+    /*!
+     \brief Get the amount of contiguous data cached at a position
+     \param pos position in the source file
+     \return number of bytes cached from pos on, 0 if pos is not cached
+     */
+    int64_t CachedLength(int64_t pos);
+
+    /*!
+     \brief Read cached data
+     \return number of bytes read, -1 on error
+     */
+    ssize_t Read(int64_t pos, void *buffer, size_t size);
+
+    /*!
+     \brief Store data read from the source
+     \return false if the data could not be stored, e.g. because entries in use fill the cache
+     */
+    bool Write(int64_t pos, const void *buffer, size_t size);
+
+  private:
+    friend class CMediaCache;
+    CMediaCacheEntry(CMediaCache &cache, const std::string &id, const std::string &url, int64_t size, int64_t mtime);
+
+    bool Open(const std::string &dataFile);
+    void Close();
+    uint64_t MissingBytes(int64_t start, int64_t end) const;
+    uint64_t AddRange(int64_t start, int64_t end); //!< returns the amount of data added
+
+    CMediaCache &m_cache;
+    std::string m_id;
+    std::string m_url;
+    int64_t m_size;
+    int64_t m_mtime;
+    uint64_t m_bytes;       //!< amount of cached data
+    time_t m_lastUsed;
+    unsigned int m_openCount;
+    bool m_dirty;
+    std::map<int64_t, int64_t> m_ranges; //!< cached ranges, start -> end
+    IFile *m_file;
+    CCriticalSection m_section;
+  };
+
+  /*!
+   \brief Persistent, size bounded disk cache for remote media files.
+
+   CFileCache stores everything it reads from a source here and serves
+   reads from it when the same file is opened again, even after a restart.
+   Entries are keyed by URL, size and modification time of the source, so a
+   changed file never hits stale data. When the cache grows beyond its size
+   limit the least recently used entries are removed.
+
+   Enabled by setting <cache><disksize> (in MB) in advancedsettings.xml.
+   */
+  class CMediaCache
+  {
+  public:
+    static CMediaCache &GetInstance();
+
+    /*!
+     \brief Open the cache entry for a source file, creating it if needed
+     \param url the source file
+     \param size size of the source file
+     \param mtime modification time of the source file
+     \return the entry, to be released with Close(), or NULL if the cache is disabled
+     */
+    CMediaCacheEntry *Open(const CURL &url, int64_t size, int64_t mtime);
+
+    /*!
+     \brief Release an entry, saving its index and enforcing the size limit
+     */
+    void Close(CMediaCacheEntry *entry);
+
+    /*!
+     \brief Total amount of data in the cache
+     */
+    uint64_t GetCachedBytes();
+
+  private:
+    friend class CMediaCacheEntry;
+    CMediaCache();
+    ~CMediaCache();
+    CMediaCache(const CMediaCache&) = delete;
+    CMediaCache& operator=(const CMediaCache&) = delete;
+
+    void Load();
+    bool SaveIndex(CMediaCacheEntry *entry);
+    bool Reserve(uint64_t bytes);
+    bool TryReserve(uint64_t bytes, uint64_t maxBytes);
+    void Release(uint64_t bytes);
+    void Evict(uint64_t maxBytes);
+    void Remove(const std::string &id);
+    std::string GetPath(const std::string &id, const char *extension) const;
+
+    bool m_loaded;
+    std::map<std::string, std::unique_ptr<CMediaCacheEntry> > m_entries;
+    std::atomic<uint64_t> m_cachedBytes; //!< sum of m_bytes of all entries plus space reserved by writers
+    CCriticalSection m_section;
+  };
+}
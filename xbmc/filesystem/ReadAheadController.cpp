@@ -0,0 +1,100 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ReadAheadController.h"
+#include "threads/SystemClock.h"
+
+#include <algorithm>
+
+using namespace XFILE;
+
+CReadAheadController::CReadAheadController(unsigned minChunk, unsigned maxChunk)
+  : m_minChunk(minChunk)
+  , m_maxChunk(std::max(minChunk, maxChunk))
+  , m_sourceRate(0)
+  , m_readBytes(0)
+  , m_readTime(0)
+  , m_stall(0)
+  , m_stallStamp(XbmcThreads::SystemClockMillis())
+  , m_refilling(true)
+{
+}
+
+void CReadAheadController::Reset()
+{
+  m_refilling = true;
+}
+
+void CReadAheadController::SourceRead(ssize_t bytes, unsigned time)
+{
+  const unsigned now = XbmcThreads::SystemClockMillis();
+  if (now - m_stallStamp > STALL_DECAY_TIME)
+  {
+    m_stall /= 2;
+    m_stallStamp = now;
+  }
+  if (time > m_stall)
+  {
+    m_stall = time;
+    m_stallStamp = now;
+  }
+
+  if (bytes <= 0)
+    return;
+
+  m_readBytes += bytes;
+  m_readTime += time;
+  if (m_readTime >= RATE_WINDOW)
+  {
+    const double rate = 1000.0 * m_readBytes / m_readTime;
+    m_sourceRate = m_sourceRate == 0 ? rate : 0.75 * m_sourceRate + 0.25 * rate;
+    m_readBytes = 0;
+    m_readTime = 0;
+  }
+}
+
+bool CReadAheadController::Refill(int64_t ahead, unsigned rate, int64_t maxAhead)
+{
+  int64_t low = (int64_t)rate * (MIN_READAHEAD_TIME + 2 * m_stall) / 1000;
+  if (m_sourceRate > 0 && m_sourceRate < 2.0 * rate && maxAhead > 0)
+    low = maxAhead;
+  // stop refilling once the forward cache is full at the latest, or the
+  // upper mark could never be reached
+  int64_t high = 2 * low;
+  if (maxAhead > 0)
+  {
+    high = std::min(high, maxAhead);
+    low = std::min(low, high * 3 / 4);
+  }
+
+  if (ahead < low)
+    m_refilling = true;
+  else if (ahead >= high)
+    m_refilling = false;
+
+  return m_refilling;
+}
+
+unsigned CReadAheadController::ChunkSize() const
+{
+  unsigned chunk = (unsigned)std::min(m_sourceRate / 10, (double)m_maxChunk);
+  chunk = (chunk + m_minChunk - 1) / m_minChunk * m_minChunk;
+  return std::min(std::max(chunk, m_minChunk), m_maxChunk);
+}
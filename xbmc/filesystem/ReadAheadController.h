@@ -0,0 +1,87 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "PlatformDefs.h" // for ssize_t
+
+#include <stdint.h>
+
+namespace XFILE
+{
+  /*!
+   \brief Sizes read-ahead and read chunks from consumption rate and source throughput.
+
+   The cache is refilled at full speed once the data ahead of the reader drops
+   below a low watermark, until twice that amount is buffered. In between the
+   source is only read at the consumption rate. The watermark covers a minimum
+   amount of playback time plus twice the longest recent source stall, so
+   unstable sources buffer more. If the source is barely faster than the stream
+   the whole forward cache is used. With a limited forward cache the refill
+   stops once it is full and starts again below three quarters of it.
+   */
+  class CReadAheadController
+  {
+  public:
+    CReadAheadController(unsigned minChunk, unsigned maxChunk);
+
+    unsigned MaxChunkSize() const { return m_maxChunk; }
+
+    /*!
+     \brief Start refilling again, e.g. after a seek
+     */
+    void Reset();
+
+    /*!
+     \brief Account for a read from the source
+     \param bytes amount of data returned
+     \param time time spent in the read in ms
+     */
+    void SourceRead(ssize_t bytes, unsigned time);
+
+    /*!
+     \brief Decide whether the source should be read at full speed
+     \param ahead amount of data cached ahead of the reader
+     \param rate consumption rate in bytes per second
+     \param maxAhead size of the forward cache, 0 if unlimited
+     */
+    bool Refill(int64_t ahead, unsigned rate, int64_t maxAhead);
+
+    /*!
+     \brief Read size for a full speed refill, about 100ms of source data
+
+     A multiple of the minimum chunk size, clamped to the minimum and maximum.
+     */
+    unsigned ChunkSize() const;
+
+    static const unsigned MIN_READAHEAD_TIME = 5000;
+    static const unsigned STALL_DECAY_TIME = 10000;
+    static const unsigned RATE_WINDOW = 1000;
+
+  private:
+    unsigned m_minChunk;
+    unsigned m_maxChunk;
+    double   m_sourceRate; //!< source throughput in bytes per second
+    int64_t  m_readBytes;
+    unsigned m_readTime;
+    unsigned m_stall;      //!< longest recent source read in ms
+    unsigned m_stallStamp;
+    bool     m_refilling;
+  };
+}
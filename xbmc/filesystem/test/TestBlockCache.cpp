@@ -0,0 +1,143 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/BlockCache.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace XFILE;
+
+namespace
+{
+const size_t blockSize = 256 * 1024;
+
+std::vector<char> MakeData(int64_t pos, size_t len)
+{
+  std::vector<char> data(len);
+  for (size_t i = 0; i < len; i++)
+    data[i] = (char)((pos + i) * 7);
+  return data;
+}
+
+// fill the cache from pos with len bytes, consuming as we go
+void Fill(CBlockCache &cache, int64_t pos, size_t len)
+{
+  std::vector<char> data = MakeData(pos, len);
+  std::vector<char> buf(blockSize);
+  size_t written = 0;
+  while (written < len)
+  {
+    int ret = cache.WriteToCache(data.data() + written, len - written);
+    ASSERT_GE(ret, 0);
+    written += ret;
+    while (cache.ReadFromCache(buf.data(), buf.size()) > 0);
+  }
+}
+}
+
+TEST(TestBlockCache, ReadWrite)
+{
+  CBlockCache cache(4 * blockSize, blockSize);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  std::vector<char> data = MakeData(0, 1000);
+  EXPECT_EQ(1000, cache.WriteToCache(data.data(), data.size()));
+  EXPECT_EQ(1000, cache.WaitForData(0, 0));
+
+  std::vector<char> buf(1000);
+  EXPECT_EQ(1000, cache.ReadFromCache(buf.data(), buf.size()));
+  EXPECT_EQ(data, buf);
+  EXPECT_EQ(CACHE_RC_WOULD_BLOCK, cache.ReadFromCache(buf.data(), buf.size()));
+
+  cache.EndOfInput();
+  EXPECT_EQ(0, cache.ReadFromCache(buf.data(), buf.size()));
+}
+
+TEST(TestBlockCache, FrontLimit)
+{
+  CBlockCache cache(2 * blockSize, blockSize);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  std::vector<char> data = MakeData(0, 3 * blockSize);
+  EXPECT_EQ((int)(2 * blockSize), cache.WriteToCache(data.data(), data.size()));
+  EXPECT_EQ(0U, cache.GetMaxWriteSize(blockSize));
+}
+
+TEST(TestBlockCache, KeepsRanges)
+{
+  CBlockCache cache(4 * blockSize, 4 * blockSize);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  // header
+  Fill(cache, 0, blockSize);
+
+  // index at the end of the file
+  const int64_t index = 100 * blockSize;
+  EXPECT_TRUE(cache.Reset(index, false));
+  Fill(cache, index, blockSize);
+
+  // the header is still cached after playing from somewhere else
+  const int64_t play = 50 * blockSize;
+  EXPECT_TRUE(cache.Reset(play, false));
+  Fill(cache, play, 2 * blockSize);
+
+  EXPECT_TRUE(cache.IsCachedPosition(100));
+  EXPECT_EQ((int64_t)blockSize, cache.CachedDataEndPosIfSeekTo(100));
+  EXPECT_FALSE(cache.Reset(100, false));
+  EXPECT_EQ((int64_t)blockSize, cache.CachedDataEndPos());
+
+  std::vector<char> buf(50);
+  EXPECT_EQ(50, cache.ReadFromCache(buf.data(), buf.size()));
+  EXPECT_EQ(MakeData(100, 50), buf);
+
+  EXPECT_TRUE(cache.IsCachedPosition(index + 10));
+  EXPECT_FALSE(cache.IsCachedPosition(10 * blockSize));
+}
+
+TEST(TestBlockCache, EvictsLeastRecentlyUsed)
+{
+  CBlockCache cache(2 * blockSize, 2 * blockSize);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  Fill(cache, 0, blockSize);
+  for (int64_t i = 1; i <= 8; i++)
+  {
+    EXPECT_TRUE(cache.Reset(i * 10 * blockSize, false));
+    Fill(cache, i * 10 * blockSize, blockSize);
+  }
+
+  EXPECT_FALSE(cache.IsCachedPosition(0));
+  EXPECT_TRUE(cache.IsCachedPosition(80 * blockSize));
+}
+
+TEST(TestBlockCache, Seek)
+{
+  CBlockCache cache(4 * blockSize, blockSize);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  std::vector<char> data = MakeData(0, 2 * blockSize);
+  EXPECT_EQ((int)data.size(), cache.WriteToCache(data.data(), data.size()));
+
+  EXPECT_EQ((int64_t)blockSize + 10, cache.Seek(blockSize + 10));
+  EXPECT_EQ(5, cache.Seek(5));
+  EXPECT_EQ(CACHE_RC_ERROR, cache.Seek(10 * blockSize));
+}
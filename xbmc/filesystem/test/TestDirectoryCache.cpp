@@ -0,0 +1,110 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/DirectoryCache.h"
+#include "FileItem.h"
+#include "settings/AdvancedSettings.h"
+#include "utils/StringUtils.h"
+
+#include "gtest/gtest.h"
+
+using namespace XFILE;
+
+namespace
+{
+void FillItems(CFileItemList &items, const std::string &path, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    CFileItemPtr item(new CFileItem(StringUtils::Format("%s/file%d.mkv", path.c_str(), i), false));
+    items.Add(item);
+  }
+}
+}
+
+TEST(TestDirectoryCache, GetDirectory)
+{
+  CDirectoryCache cache;
+  CFileItemList items;
+  FillItems(items, "smb://server/share", 10);
+  cache.SetDirectory("smb://server/share/", items, DIR_CACHE_ALWAYS);
+
+  CFileItemList cached;
+  EXPECT_TRUE(cache.GetDirectory("smb://server/share", cached));
+  EXPECT_EQ(10, cached.Size());
+  EXPECT_FALSE(cache.GetDirectory("smb://server/other", cached));
+
+  bool inCache;
+  EXPECT_TRUE(cache.FileExists("smb://server/share/file3.mkv", inCache));
+  EXPECT_TRUE(inCache);
+  EXPECT_FALSE(cache.FileExists("smb://server/share/missing.mkv", inCache));
+  EXPECT_TRUE(inCache);
+
+  CDirectoryCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(1u, stats.directories);
+  EXPECT_EQ(10u, stats.items);
+  EXPECT_EQ(3u, stats.hits);
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_GT(stats.bytes, 0u);
+
+  cache.ClearSubPaths("smb://server/");
+  EXPECT_FALSE(cache.GetDirectory("smb://server/share", cached));
+  EXPECT_EQ(0u, cache.GetStats().bytes);
+}
+
+TEST(TestDirectoryCache, Eviction)
+{
+  CDirectoryCache cache;
+  for (int i = 0; i < 60; i++)
+  {
+    CFileItemList items;
+    std::string path = StringUtils::Format("smb://server/dir%d", i);
+    FillItems(items, path, 1);
+    cache.SetDirectory(path, items, DIR_CACHE_ONCE);
+  }
+
+  // only the most recent ones are kept
+  CDirectoryCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(50u, stats.directories);
+  EXPECT_EQ(10u, stats.evictions);
+  CFileItemList cached;
+  EXPECT_FALSE(cache.GetDirectory("smb://server/dir0", cached, true));
+  EXPECT_TRUE(cache.GetDirectory("smb://server/dir59", cached, true));
+}
+
+TEST(TestDirectoryCache, MemoryLimit)
+{
+  unsigned int memSize = g_advancedSettings.m_dirCacheMemSize;
+  g_advancedSettings.m_dirCacheMemSize = 64 * 1024;
+
+  CDirectoryCache cache;
+  for (int i = 0; i < 20; i++)
+  {
+    CFileItemList items;
+    std::string path = StringUtils::Format("smb://server/dir%d", i);
+    FillItems(items, path, 20);
+    cache.SetDirectory(path, items, DIR_CACHE_ONCE);
+  }
+  g_advancedSettings.m_dirCacheMemSize = memSize;
+
+  CDirectoryCache::Stats stats = cache.GetStats();
+  EXPECT_LE(stats.bytes, 64u * 1024);
+  EXPECT_GT(stats.evictions, 0u);
+}
@@ -0,0 +1,171 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/MediaCache.h"
+#include "settings/AdvancedSettings.h"
+#include "URL.h"
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace XFILE;
+
+class TestMediaCache : public testing::Test
+{
+protected:
+  TestMediaCache()
+  {
+    g_advancedSettings.m_cacheDiskSize = 1;
+  }
+  ~TestMediaCache()
+  {
+    g_advancedSettings.m_cacheDiskSize = 0;
+  }
+};
+
+TEST_F(TestMediaCache, Disabled)
+{
+  g_advancedSettings.m_cacheDiskSize = 0;
+  EXPECT_EQ(NULL, CMediaCache::GetInstance().Open(CURL("http://localhost/disabled.mkv"), 1000, 1));
+}
+
+TEST_F(TestMediaCache, Ranges)
+{
+  const CURL url("http://localhost/ranges.mkv");
+  std::vector<char> data(100, 'x');
+  std::vector<char> out(300);
+
+  CMediaCacheEntry *entry = CMediaCache::GetInstance().Open(url, 100000, 1);
+  ASSERT_TRUE(entry != NULL);
+  EXPECT_TRUE(entry->Write(1000, data.data(), data.size()));
+  EXPECT_TRUE(entry->Write(1100, data.data(), data.size()));
+  EXPECT_TRUE(entry->Write(5000, data.data(), data.size()));
+  EXPECT_EQ(200, entry->CachedLength(1000));
+  EXPECT_EQ(50, entry->CachedLength(1150));
+  EXPECT_EQ(0, entry->CachedLength(1200));
+  EXPECT_EQ(0, entry->CachedLength(999));
+  EXPECT_EQ(200, entry->Read(1000, out.data(), out.size()));
+  EXPECT_EQ('x', out[199]);
+  CMediaCache::GetInstance().Close(entry);
+
+  // same file again, data is still there
+  entry = CMediaCache::GetInstance().Open(url, 100000, 1);
+  ASSERT_TRUE(entry != NULL);
+  EXPECT_EQ(200, entry->CachedLength(1000));
+  EXPECT_EQ(100, entry->CachedLength(5000));
+  CMediaCache::GetInstance().Close(entry);
+
+  // modified file, nothing cached
+  entry = CMediaCache::GetInstance().Open(url, 100000, 2);
+  ASSERT_TRUE(entry != NULL);
+  EXPECT_EQ(0, entry->CachedLength(1000));
+  CMediaCache::GetInstance().Close(entry);
+}
+
+TEST_F(TestMediaCache, SizeLimit)
+{
+  const uint64_t maxBytes = 1024 * 1024;
+  std::vector<char> data(400 * 1024, 'y');
+
+  for (int i = 0; i < 4; i++)
+  {
+    CMediaCacheEntry *entry = CMediaCache::GetInstance().Open(CURL("http://localhost/limit.mkv"), 10000000, i);
+    ASSERT_TRUE(entry != NULL);
+    EXPECT_TRUE(entry->Write(0, data.data(), data.size()));
+    EXPECT_TRUE(entry->Write(data.size(), data.data(), data.size()));
+    // a single entry can't outgrow the cache
+    EXPECT_FALSE(entry->Write(2 * data.size(), data.data(), data.size()));
+    CMediaCache::GetInstance().Close(entry);
+  }
+
+  EXPECT_LE(CMediaCache::GetInstance().GetCachedBytes(), maxBytes);
+}
+
+TEST_F(TestMediaCache, SharedLimit)
+{
+  const uint64_t maxBytes = 1024 * 1024;
+  std::vector<char> data(400 * 1024, 'z');
+
+  // entries open at the same time share the budget
+  CMediaCacheEntry *first = CMediaCache::GetInstance().Open(CURL("http://localhost/shared1.mkv"), 10000000, 1);
+  CMediaCacheEntry *second = CMediaCache::GetInstance().Open(CURL("http://localhost/shared2.mkv"), 10000000, 1);
+  ASSERT_TRUE(first != NULL);
+  ASSERT_TRUE(second != NULL);
+  EXPECT_TRUE(first->Write(0, data.data(), data.size()));
+  EXPECT_TRUE(second->Write(0, data.data(), data.size()));
+  EXPECT_FALSE(first->Write(data.size(), data.data(), data.size()));
+  EXPECT_FALSE(second->Write(data.size(), data.data(), data.size()));
+  EXPECT_LE(CMediaCache::GetInstance().GetCachedBytes(), maxBytes);
+
+  // rewriting cached data needs no room
+  const uint64_t cached = CMediaCache::GetInstance().GetCachedBytes();
+  EXPECT_TRUE(first->Write(0, data.data(), data.size()));
+  EXPECT_TRUE(first->Write(1024, data.data(), data.size() - 1024));
+  EXPECT_EQ(cached, CMediaCache::GetInstance().GetCachedBytes());
+  CMediaCache::GetInstance().Close(first);
+
+  // closed entries make room for the ones in use
+  EXPECT_TRUE(second->Write(data.size(), data.data(), data.size()));
+  EXPECT_LE(CMediaCache::GetInstance().GetCachedBytes(), maxBytes);
+  CMediaCache::GetInstance().Close(second);
+}
+
+TEST_F(TestMediaCache, ConcurrentWriters)
+{
+  const uint64_t maxBytes = 1024 * 1024;
+  const int writers = 4;
+  std::vector<char> data(64 * 1024, 'w');
+  std::vector<CMediaCacheEntry*> entries;
+  std::vector<int> stored(writers, 0);
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < writers; i++)
+  {
+    entries.push_back(CMediaCache::GetInstance().Open(CURL("http://localhost/concurrent.mkv"), 10000000, i));
+    ASSERT_TRUE(entries.back() != NULL);
+  }
+
+  // every writer tries to fill the whole cache on its own
+  for (int i = 0; i < writers; i++)
+  {
+    threads.push_back(std::thread([&, i]()
+    {
+      for (size_t pos = 0; pos < maxBytes; pos += data.size())
+      {
+        if (entries[i]->Write(pos, data.data(), data.size()))
+          stored[i]++;
+      }
+    }));
+  }
+  for (std::thread &thread : threads)
+    thread.join();
+
+  int total = 0;
+  for (int i = 0; i < writers; i++)
+    total += stored[i];
+  EXPECT_GT(total, 0);
+  EXPECT_LE(total * data.size(), maxBytes);
+  EXPECT_LE(CMediaCache::GetInstance().GetCachedBytes(), maxBytes);
+
+  for (int i = 0; i < writers; i++)
+    CMediaCache::GetInstance().Close(entries[i]);
+}
@@ -0,0 +1,142 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/ReadAheadController.h"
+
+#include "gtest/gtest.h"
+
+using namespace XFILE;
+
+namespace
+{
+const unsigned minChunk = 64 * 1024;
+const unsigned maxChunk = 1024 * 1024;
+
+// one rate window worth of reads from a source delivering rate bytes per second
+void ReadSecond(CReadAheadController &controller, unsigned rate)
+{
+  for (int i = 0; i < 10; i++)
+    controller.SourceRead(rate / 10, CReadAheadController::RATE_WINDOW / 10);
+}
+}
+
+TEST(TestReadAheadController, SequentialGrowth)
+{
+  CReadAheadController controller(minChunk, maxChunk);
+  EXPECT_EQ(minChunk, controller.ChunkSize());
+  ReadSecond(controller, 256 * 1024);
+  EXPECT_EQ(minChunk, controller.ChunkSize());
+
+  // the chunk follows the measured rate up to the maximum as reads go on
+  unsigned last = controller.ChunkSize();
+  bool between = false;
+  for (int i = 0; i < 20; i++)
+  {
+    ReadSecond(controller, 20 * 1024 * 1024);
+    const unsigned chunk = controller.ChunkSize();
+    EXPECT_GE(chunk, last);
+    EXPECT_EQ(0U, chunk % minChunk);
+    between |= chunk > minChunk && chunk < maxChunk;
+    last = chunk;
+  }
+  EXPECT_TRUE(between);
+  EXPECT_EQ(maxChunk, last);
+
+  // a source that slows down gets smaller chunks again
+  for (int i = 0; i < 20; i++)
+    ReadSecond(controller, 2 * 1024 * 1024);
+  EXPECT_LT(controller.ChunkSize(), maxChunk);
+  EXPECT_GE(controller.ChunkSize(), 2U * 1024 * 1024 / 10);
+}
+
+TEST(TestReadAheadController, Limits)
+{
+  CReadAheadController slow(minChunk, maxChunk);
+  ReadSecond(slow, 100 * 1024);
+  EXPECT_EQ(minChunk, slow.ChunkSize());
+
+  CReadAheadController fast(minChunk, maxChunk);
+  ReadSecond(fast, 100 * 1024 * 1024);
+  EXPECT_EQ(maxChunk, fast.ChunkSize());
+
+  // the maximum is never below the minimum
+  CReadAheadController inverted(maxChunk, minChunk);
+  EXPECT_EQ(maxChunk, inverted.MaxChunkSize());
+  ReadSecond(inverted, 100 * 1024 * 1024);
+  EXPECT_EQ(maxChunk, inverted.ChunkSize());
+}
+
+TEST(TestReadAheadController, Watermark)
+{
+  const unsigned rate = 100 * 1000;
+  const int64_t low = (int64_t)rate * CReadAheadController::MIN_READAHEAD_TIME / 1000;
+  CReadAheadController controller(minChunk, maxChunk);
+
+  // refill up to twice the watermark, then follow the stream until below it
+  EXPECT_TRUE(controller.Refill(low + 1, rate, 0));
+  EXPECT_FALSE(controller.Refill(2 * low, rate, 0));
+  EXPECT_FALSE(controller.Refill(low + 1, rate, 0));
+  EXPECT_TRUE(controller.Refill(low - 1, rate, 0));
+
+  // a limited forward cache caps the watermark, refilling stops once it is full
+  EXPECT_FALSE(controller.Refill(low * 3 / 2, rate, low));
+  EXPECT_TRUE(controller.Refill(low * 3 / 4 - 1, rate, low));
+  EXPECT_TRUE(controller.Refill(low - 1, rate, low));
+  EXPECT_FALSE(controller.Refill(low, rate, low));
+  EXPECT_FALSE(controller.Refill(low * 3 / 4, rate, low));
+
+  // a source barely faster than the stream fills the whole forward cache
+  CReadAheadController slow(minChunk, maxChunk);
+  ReadSecond(slow, rate * 3 / 2);
+  const int64_t maxAhead = 4 * low;
+  EXPECT_TRUE(slow.Refill(3 * low, rate, maxAhead));
+  EXPECT_FALSE(slow.Refill(maxAhead, rate, maxAhead));
+  EXPECT_FALSE(slow.Refill(3 * low, rate, maxAhead));
+  EXPECT_TRUE(slow.Refill(3 * low - 1, rate, maxAhead));
+}
+
+TEST(TestReadAheadController, SeekReset)
+{
+  const unsigned rate = 100 * 1000;
+  const int64_t low = (int64_t)rate * CReadAheadController::MIN_READAHEAD_TIME / 1000;
+  CReadAheadController controller(minChunk, maxChunk);
+
+  EXPECT_FALSE(controller.Refill(2 * low, rate, 0));
+  EXPECT_FALSE(controller.Refill(low + 1, rate, 0));
+
+  // after a seek the cache is refilled at full speed right away
+  controller.Reset();
+  EXPECT_TRUE(controller.Refill(low + 1, rate, 0));
+  EXPECT_FALSE(controller.Refill(2 * low, rate, 0));
+}
+
+TEST(TestReadAheadController, Stall)
+{
+  const unsigned rate = 100 * 1000;
+  const int64_t low = (int64_t)rate * CReadAheadController::MIN_READAHEAD_TIME / 1000;
+  CReadAheadController controller(minChunk, maxChunk);
+  EXPECT_FALSE(controller.Refill(2 * low, rate, 0));
+
+  // a read that blocked for two seconds adds four seconds to the watermark
+  controller.SourceRead(0, 2000);
+  const int64_t stalled = low + (int64_t)rate * 4;
+  EXPECT_TRUE(controller.Refill(stalled - 1, rate, 0));
+  EXPECT_FALSE(controller.Refill(2 * stalled, rate, 0));
+}
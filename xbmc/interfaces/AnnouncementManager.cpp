@@ -33,11 +33,24 @@
 #include "ServiceBroker.h"
 
 #define LOOKUP_PROPERTY "database-lookup"
+// maximum number of announcements waiting to be delivered
+#define ANNOUNCEMENT_QUEUE_SIZE 4096
 
 using namespace ANNOUNCEMENT;
 
+namespace
+{
+// unlike CVariant::operator== two null values are equal
+bool IsSameData(const CVariant &lhs, const CVariant &rhs)
+{
+  return (lhs.isNull() && rhs.isNull()) || lhs == rhs;
+}
+}
+
 CAnnouncementManager::CAnnouncementManager() : CThread("Announce")
 {
+  m_dropped = 0;
+  m_coalesced = 0;
 }
 
 CAnnouncementManager::~CAnnouncementManager()
@@ -62,6 +75,10 @@ void CAnnouncementManager::Deinitialize()
   StopThread();
   CSingleLock lock (m_critSection);
   m_announcers.clear();
+
+  CSingleLock queueLock (m_queueCritSection);
+  if (m_dropped > 0 || m_coalesced > 0)
+    CLog::Log(LOGDEBUG, "CAnnouncementManager - %u announcements dropped, %u coalesced", m_dropped, m_coalesced);
 }
 
 void CAnnouncementManager::AddAnnouncer(IAnnouncer *listener)
@@ -118,12 +135,43 @@ void CAnnouncementManager::Announce(AnnouncementFlag flag, const char *sender, c
     announcement.item = CFileItemPtr(new CFileItem(*item));
 
   {
-    CSingleLock lock (m_critSection);
-    m_announcementQueue.push_back(announcement);
+    // announcing never waits for the announcers, those are called by Process()
+    CSingleLock lock (m_queueCritSection);
+
+    // an announcement identical to the last one which hasn't been delivered
+    // yet is dropped, so e.g. a library scan updating the same item several
+    // times in a row results in a single announcement. Merging with any
+    // earlier one would reorder it against the announcements in between.
+    if (item == nullptr && !m_announcementQueue.empty())
+    {
+      const CAnnounceData &last = m_announcementQueue.back();
+      if (last.item == nullptr && last.flag == flag && last.message == announcement.message &&
+          last.sender == announcement.sender && IsSameData(last.data, announcement.data))
+      {
+        m_coalesced++;
+        return;
+      }
+    }
+
+    if (m_announcementQueue.size() >= ANNOUNCEMENT_QUEUE_SIZE)
+    {
+      if (m_dropped++ == 0)
+        CLog::Log(LOGWARNING, "CAnnouncementManager - Queue is full, dropping the oldest announcements");
+      m_announcementQueue.pop_front();
+    }
+
+    m_announcementQueue.push_back(std::move(announcement));
   }
   m_queueEvent.Set();
 }
 
+void CAnnouncementManager::GetStatistics(unsigned int &dropped, unsigned int &coalesced)
+{
+  CSingleLock lock (m_queueCritSection);
+  dropped = m_dropped;
+  coalesced = m_coalesced;
+}
+
 void CAnnouncementManager::DoAnnounce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
 {
   CLog::Log(LOGDEBUG, "CAnnouncementManager - Announcement: %s from %s", message, sender);
@@ -289,19 +337,19 @@ void CAnnouncementManager::Process()
 
   while (!m_bStop)
   {
-    CSingleLock lock (m_critSection);
+    CSingleLock lock (m_queueCritSection);
     if (!m_announcementQueue.empty())
     {
-      auto announcement = m_announcementQueue.front();
+      CAnnounceData announcement = std::move(m_announcementQueue.front());
       m_announcementQueue.pop_front();
       {
-        CSingleExit ex(m_critSection);
+        CSingleExit ex(m_queueCritSection);
         DoAnnounce(announcement.flag, announcement.sender.c_str(), announcement.message.c_str(), announcement.item, announcement.data);
       }
     }
     else
     {
-      CSingleExit ex(m_critSection);
+      CSingleExit ex(m_queueCritSection);
       m_queueEvent.Wait();
     }
   }
@@ -18,6 +18,7 @@
  *  <http://www.gnu.org/licenses/>.
  *
  */
+#include <list>
 #include <vector>
 
 #include "IAnnouncer.h"
@@ -52,6 +53,14 @@ namespace ANNOUNCEMENT
     void Announce(AnnouncementFlag flag, const char *sender, const char *message,
         const std::shared_ptr<const CFileItem>& item, const CVariant &data);
 
+    /*!
+     \brief Get the number of announcements which were never delivered
+     \param dropped Announcements dropped because the queue was full
+     \param coalesced Announcements dropped because they were identical to
+     the previous one, which wasn't delivered yet
+     */
+    void GetStatistics(unsigned int &dropped, unsigned int &coalesced);
+
   protected:
     void Process();
     void DoAnnounce(AnnouncementFlag flag, const char *sender, const char *message, CFileItemPtr item, const CVariant &data);
@@ -66,6 +75,9 @@ namespace ANNOUNCEMENT
       CVariant data;
     };
     std::list<CAnnounceData> m_announcementQueue;
+    unsigned int m_dropped;
+    unsigned int m_coalesced;
+    CCriticalSection m_queueCritSection;
     CEvent m_queueEvent;
 
   private:
@@ -18,7 +18,9 @@
  *
  */
 
+#include <memory>
 #include <string.h>
+#include <vector>
 
 #include "JSONRPC.h"
 #include "ServiceDescription.h"
@@ -30,6 +32,7 @@
 #include "playlists/SmartPlayList.h"
 #include "settings/AdvancedSettings.h"
 #include "utils/log.h"
+#include "utils/ParallelJobs.h"
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
 #include "TextureDatabase.h"
@@ -235,7 +238,16 @@ JSONRPC_STATUS CJSONRPC::NotifyAll(const std::string &method, ITransportLayer *t
 
 std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client)
 {
-  CVariant inputroot, outputroot, result;
+  CVariant outputroot;
+  bool hasResponse = MethodCall(inputString, transport, client, outputroot);
+
+  std::string str = hasResponse ? CJSONVariantWriter::Write(outputroot, g_advancedSettings.m_jsonOutputCompact) : "";
+  return str;
+}
+
+bool CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client, CVariant &outputroot)
+{
+  CVariant inputroot;
   bool hasResponse = false;
 
   if(g_advancedSettings.CanLogComponent(LOGJSONRPC))
@@ -253,17 +265,7 @@ std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer
         hasResponse = true;
       }
       else
-      {
-        for (CVariant::const_iterator_array itr = inputroot.begin_array(); itr != inputroot.end_array(); itr++)
-        {
-          CVariant response;
-          if (HandleMethodCall(*itr, response, transport, client))
-          {
-            outputroot.append(response);
-            hasResponse = true;
-          }
-        }
-      }
+        hasResponse = HandleBatchCall(inputroot, outputroot, transport, client);
     }
     else
       hasResponse = HandleMethodCall(inputroot, outputroot, transport, client);
@@ -275,8 +277,7 @@ std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer
     hasResponse = true;
   }
 
-  std::string str = hasResponse ? CJSONVariantWriter::Write(outputroot, g_advancedSettings.m_jsonOutputCompact) : "";
-  return str;
+  return hasResponse;
 }
 
 bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client)
@@ -311,6 +312,55 @@ bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITr
   return !isNotification;
 }
 
+bool CJSONRPC::HandleBatchCall(const CVariant& requests, CVariant& responses, ITransportLayer *transport, IClient *client)
+{
+  const size_t count = requests.size();
+  std::vector<CVariant> results(count);
+  std::unique_ptr<bool[]> hasResults(new bool[count]());
+
+  // Consecutive read-only calls are executed at the same time while every
+  // other call waits for the ones before it and is waited for by the ones
+  // after it, so a client still sees the effects of its calls in order
+  size_t begin = 0;
+  while (begin < count)
+  {
+    size_t end = begin + 1;
+    if (IsReadOnlyCall(requests[begin]))
+    {
+      while (end < count && IsReadOnlyCall(requests[end]))
+        end++;
+    }
+
+    CParallelJobs::Run(end - begin, g_advancedSettings.m_jsonBatchThreads, [&](size_t index)
+    {
+      hasResults[begin + index] = HandleMethodCall(requests[begin + index], results[begin + index], transport, client);
+    });
+    begin = end;
+  }
+
+  bool hasResponse = false;
+  for (size_t index = 0; index < count; index++)
+  {
+    if (hasResults[index])
+    {
+      responses.append(std::move(results[index]));
+      hasResponse = true;
+    }
+  }
+
+  return hasResponse;
+}
+
+bool CJSONRPC::IsReadOnlyCall(const CVariant& request)
+{
+  if (!IsProperJSONRPC(request))
+    return false;
+
+  std::string methodName = request["method"].asString();
+  StringUtils::ToLower(methodName);
+  return CJSONServiceDescription::IsReadOnly(methodName);
+}
+
 inline bool CJSONRPC::IsProperJSONRPC(const CVariant& inputroot)
 {
   return inputroot.isObject() && inputroot.isMember("jsonrpc") && inputroot["jsonrpc"].isString() && inputroot["jsonrpc"] == CVariant("2.0") && inputroot.isMember("method") && inputroot["method"].isString() && (!inputroot.isMember("params") || inputroot["params"].isArray() || inputroot["params"].isObject());
@@ -64,6 +64,19 @@ namespace JSONRPC
      */
     static std::string MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client);
 
+    /*!
+     \brief Handles the given JSON-RPC request without serializing the response
+     \param inputString JSON-RPC request to be handled
+     \param transport Transport protocol on which the request arrived
+     \param client Client which sent the request
+     \param response JSON-RPC response to be sent back to the client
+     \return True if there is a response to be sent back, otherwise false
+
+     Allows the transport to serialize the response while sending it (see
+     CJSONVariantStreamWriter) instead of holding all of it in memory.
+     */
+    static bool MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client, CVariant &response);
+
     static JSONRPC_STATUS Introspect(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Version(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Permission(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
@@ -75,6 +88,8 @@ namespace JSONRPC
   private:
     static void setup();
     static bool HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client);
+    static bool HandleBatchCall(const CVariant& requests, CVariant& responses, ITransportLayer *transport, IClient *client);
+    static bool IsReadOnlyCall(const CVariant& request);
     static inline bool IsProperJSONRPC(const CVariant& inputroot);
 
     inline static void BuildResponse(const CVariant& request, JSONRPC_STATUS code, const CVariant& result, CVariant& response);
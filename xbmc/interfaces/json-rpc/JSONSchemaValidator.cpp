@@ -0,0 +1,312 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "JSONSchemaValidator.h"
+#include "JSONServiceDescription.h"
+#include "utils/StringUtils.h"
+
+#include <algorithm>
+
+using namespace JSONRPC;
+
+CJSONSchemaValidator::CJSONSchemaValidator(const std::vector<JSONSchemaTypeDefinitionPtr> &parameters)
+{
+  CompiledNodes compiled;
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::const_iterator parameter = parameters.begin(); parameter != parameters.end(); ++parameter)
+    m_parameters.push_back(compileProperty(*parameter, compiled));
+}
+
+bool CJSONSchemaValidator::Validate(const CVariant &requestParameters, CVariant &outputParameters) const
+{
+  // same rules as JsonRpcMethod::Check()
+  unsigned int handled = 0;
+  for (unsigned int position = 0; position < m_parameters.size(); position++)
+  {
+    const Property &parameter = m_parameters[position];
+    if (requestParameters.isObject() && requestParameters.isMember(parameter.name))
+    {
+      if (!validate(parameter.node, requestParameters[parameter.name], outputParameters[parameter.name]))
+        return false;
+      handled++;
+    }
+    else if (requestParameters.isArray() && requestParameters.size() > position)
+    {
+      if (!validate(parameter.node, requestParameters[position], outputParameters[parameter.name]))
+        return false;
+      handled++;
+    }
+    else if (parameter.optional)
+      outputParameters[parameter.name] = parameter.defaultValue;
+    else
+      return false;
+  }
+
+  return handled >= requestParameters.size();
+}
+
+size_t CJSONSchemaValidator::compile(const JSONSchemaTypeDefinitionPtr &type, CompiledNodes &compiled)
+{
+  // a type referencing another one is checked against the referenced type,
+  // see JSONSchemaTypeDefinition::Set()
+  const JSONSchemaTypeDefinition &schema = type->referencedType != NULL ? *type->referencedType : *type;
+
+  // types can (indirectly) contain themselves
+  CompiledNodes::const_iterator node = compiled.find(&schema);
+  if (node != compiled.end())
+    return node->second;
+
+  const size_t index = m_nodes.size();
+  compiled.insert(std::make_pair(&schema, index));
+  m_nodes.push_back(Node());
+
+  // compile the children first as they add to m_nodes
+  std::vector<size_t> unionTypes = compile(schema.unionTypes, compiled);
+  std::vector<size_t> extends = compile(schema.extends, compiled);
+  std::vector<size_t> items = compile(schema.items, compiled);
+  std::vector<size_t> additionalItems = compile(schema.additionalItems, compiled);
+
+  std::vector<Property> properties;
+  for (JSONSchemaTypeDefinition::CJsonSchemaPropertiesMap::JSONSchemaPropertiesIterator property = schema.properties.begin(); property != schema.properties.end(); ++property)
+  {
+    properties.push_back(compileProperty(property->second, compiled));
+    properties.back().key = property->first;
+  }
+
+  size_t additionalProperties = NoNode;
+  if (schema.hasAdditionalProperties && schema.additionalProperties != NULL)
+    additionalProperties = compile(schema.additionalProperties, compiled);
+
+  Node &compiledNode = m_nodes[index];
+  compiledNode.type = schema.type;
+  compiledNode.unionTypes.swap(unionTypes);
+  compiledNode.extends.swap(extends);
+  compiledNode.items.swap(items);
+  compiledNode.additionalItems.swap(additionalItems);
+  compiledNode.minItems = schema.minItems;
+  compiledNode.maxItems = schema.maxItems;
+  compiledNode.uniqueItems = schema.uniqueItems;
+  compiledNode.properties.swap(properties);
+  compiledNode.hasAdditionalProperties = schema.hasAdditionalProperties;
+  compiledNode.additionalProperties = additionalProperties;
+  compiledNode.enums = schema.enums;
+  compiledNode.minimum = schema.minimum;
+  compiledNode.maximum = schema.maximum;
+  compiledNode.exclusiveMinimum = schema.exclusiveMinimum;
+  compiledNode.exclusiveMaximum = schema.exclusiveMaximum;
+  compiledNode.divisibleBy = schema.divisibleBy;
+  compiledNode.minLength = schema.minLength;
+  compiledNode.maxLength = schema.maxLength;
+
+  return index;
+}
+
+std::vector<size_t> CJSONSchemaValidator::compile(const std::vector<JSONSchemaTypeDefinitionPtr> &types, CompiledNodes &compiled)
+{
+  std::vector<size_t> nodes;
+  nodes.reserve(types.size());
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::const_iterator type = types.begin(); type != types.end(); ++type)
+    nodes.push_back(compile(*type, compiled));
+
+  return nodes;
+}
+
+CJSONSchemaValidator::Property CJSONSchemaValidator::compileProperty(const JSONSchemaTypeDefinitionPtr &type, CompiledNodes &compiled)
+{
+  Property property;
+  property.name = type->name;
+  property.key = type->name;
+  StringUtils::ToLower(property.key);
+  property.node = compile(type, compiled);
+  property.optional = type->optional;
+  property.defaultValue = type->defaultValue;
+
+  return property;
+}
+
+bool CJSONSchemaValidator::validate(size_t index, const CVariant &value, CVariant &outputValue) const
+{
+  // mirrors JSONSchemaTypeDefinition::Check() without collecting error details
+  const Node &node = m_nodes[index];
+
+  if (!IsType(value, node.type))
+    return false;
+  if (value.isNull() && !HasType(node.type, NullValue))
+    return false;
+
+  if (!node.unionTypes.empty())
+  {
+    bool ok = false;
+    for (std::vector<size_t>::const_iterator unionType = node.unionTypes.begin(); unionType != node.unionTypes.end(); ++unionType)
+    {
+      CVariant testOutput = outputValue;
+      if (validate(*unionType, value, testOutput))
+      {
+        outputValue = std::move(testOutput);
+        ok = true;
+        break;
+      }
+    }
+
+    if (!ok)
+      return false;
+  }
+
+  for (std::vector<size_t>::const_iterator extends = node.extends.begin(); extends != node.extends.end(); ++extends)
+  {
+    if (!validate(*extends, value, outputValue))
+      return false;
+  }
+
+  if (HasType(node.type, ArrayValue) && value.isArray())
+  {
+    outputValue = CVariant(CVariant::VariantTypeArray);
+    if ((node.minItems > 0 && value.size() < node.minItems) || (node.maxItems > 0 && value.size() > node.maxItems))
+      return false;
+
+    if (node.items.empty())
+      outputValue = value;
+    else if (node.items.size() == 1)
+    {
+      for (CVariant::const_iterator_array item = value.begin_array(); item != value.end_array(); ++item)
+      {
+        CVariant temp;
+        if (!validate(node.items[0], *item, temp))
+          return false;
+        outputValue.push_back(std::move(temp));
+      }
+    }
+    // tuple typing
+    else
+    {
+      if (value.size() < node.items.size() || (value.size() != node.items.size() && node.additionalItems.empty()))
+        return false;
+
+      unsigned int arrayIndex;
+      for (arrayIndex = 0; arrayIndex < node.items.size(); arrayIndex++)
+      {
+        if (!validate(node.items[arrayIndex], value[arrayIndex], outputValue[arrayIndex]))
+          return false;
+      }
+
+      if (!node.additionalItems.empty())
+      {
+        for (; arrayIndex < value.size(); arrayIndex++)
+        {
+          bool ok = false;
+          for (std::vector<size_t>::const_iterator additionalItem = node.additionalItems.begin(); additionalItem != node.additionalItems.end(); ++additionalItem)
+          {
+            if (validate(*additionalItem, value[arrayIndex], outputValue[arrayIndex]))
+            {
+              ok = true;
+              break;
+            }
+          }
+
+          if (!ok)
+            return false;
+        }
+      }
+    }
+
+    if (node.uniqueItems)
+    {
+      for (unsigned int checkingIndex = 0; checkingIndex < outputValue.size(); checkingIndex++)
+      {
+        for (unsigned int checkedIndex = checkingIndex + 1; checkedIndex < outputValue.size(); checkedIndex++)
+        {
+          if (outputValue[checkingIndex] == outputValue[checkedIndex])
+            return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  if (HasType(node.type, ObjectValue) && value.isObject())
+  {
+    unsigned int handled = 0;
+    for (std::vector<Property>::const_iterator property = node.properties.begin(); property != node.properties.end(); ++property)
+    {
+      if (value.isMember(property->name))
+      {
+        if (!validate(property->node, value[property->name], outputValue[property->name]))
+          return false;
+        handled++;
+      }
+      else if (property->optional)
+        outputValue[property->name] = property->defaultValue;
+      else
+        return false;
+    }
+
+    if (handled < value.size())
+    {
+      if (!node.hasAdditionalProperties || node.additionalProperties == NoNode)
+        return false;
+
+      const Node &additionalProperties = m_nodes[node.additionalProperties];
+      for (CVariant::const_iterator_map member = value.begin_map(); member != value.end_map(); ++member)
+      {
+        if (isProperty(node, member->first))
+          continue;
+
+        if (additionalProperties.type == AnyValue)
+          outputValue[member->first] = member->second;
+        else if (!validate(node.additionalProperties, member->second, outputValue[member->first]))
+          return false;
+      }
+    }
+
+    return true;
+  }
+
+  if (!node.enums.empty() && std::find(node.enums.begin(), node.enums.end(), value) == node.enums.end())
+    return false;
+
+  if ((HasType(node.type, NumberValue) && value.isDouble()) || (HasType(node.type, IntegerValue) && value.isInteger()))
+  {
+    const double numberValue = value.isDouble() ? value.asDouble() : (double)value.asInteger();
+    if ((node.exclusiveMinimum && numberValue <= node.minimum) || (!node.exclusiveMinimum && numberValue < node.minimum) ||
+        (node.exclusiveMaximum && numberValue >= node.maximum) || (!node.exclusiveMaximum && numberValue > node.maximum))
+      return false;
+
+    if (HasType(node.type, IntegerValue) && node.divisibleBy > 0 && ((int)numberValue % node.divisibleBy) != 0)
+      return false;
+  }
+
+  if (HasType(node.type, StringValue) && value.isString())
+  {
+    const int size = value.size();
+    if (size < node.minLength || (node.maxLength >= 0 && size > node.maxLength))
+      return false;
+  }
+
+  outputValue = value;
+  return true;
+}
+
+bool CJSONSchemaValidator::isProperty(const Node &node, const std::string &key) const
+{
+  // the properties are sorted by their key
+  std::vector<Property>::const_iterator property = std::lower_bound(node.properties.begin(), node.properties.end(), key,
+    [](const Property &property, const std::string &key) { return property.key < key; });
+  return property != node.properties.end() && property->key == key;
+}
@@ -0,0 +1,112 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "JSONUtils.h"
+#include "utils/Variant.h"
+
+namespace JSONRPC
+{
+  class JSONSchemaTypeDefinition;
+  typedef std::shared_ptr<JSONSchemaTypeDefinition> JSONSchemaTypeDefinitionPtr;
+
+  /*!
+   \ingroup jsonrpc
+   \brief Validation program for the parameters of a json rpc method.
+
+   Compiled once from the json schema type definitions of a method's
+   parameters. All referenced types are resolved and all limits, enums,
+   property names and default values are copied into a flat list of nodes,
+   so validating a call neither walks nor modifies the type definitions.
+
+   Only checks whether the parameters are valid and builds the cleaned up
+   parameter list. It doesn't produce any error details, for those the call
+   has to be checked again with JSONSchemaTypeDefinition::Check().
+   */
+  class CJSONSchemaValidator : protected CJSONUtils
+  {
+  public:
+    explicit CJSONSchemaValidator(const std::vector<JSONSchemaTypeDefinitionPtr> &parameters);
+
+    /*!
+     \brief Validates the parameters of a method call
+     \param requestParameters Parameters from the request
+     \param outputParameters Cleaned up parameter list, including the
+     default values of all missing optional parameters
+     \return True if the parameters are valid. Otherwise the content of
+     outputParameters is undefined.
+     */
+    bool Validate(const CVariant &requestParameters, CVariant &outputParameters) const;
+
+  private:
+    static const size_t NoNode = static_cast<size_t>(-1);
+
+    struct Property
+    {
+      std::string name;
+      std::string key;
+      size_t node;
+      bool optional;
+      CVariant defaultValue;
+    };
+
+    struct Node
+    {
+      JSONSchemaType type;
+      std::vector<size_t> unionTypes;
+      std::vector<size_t> extends;
+
+      std::vector<size_t> items;
+      std::vector<size_t> additionalItems;
+      unsigned int minItems;
+      unsigned int maxItems;
+      bool uniqueItems;
+
+      std::vector<Property> properties;
+      bool hasAdditionalProperties;
+      size_t additionalProperties;
+
+      std::vector<CVariant> enums;
+      double minimum;
+      double maximum;
+      bool exclusiveMinimum;
+      bool exclusiveMaximum;
+      unsigned int divisibleBy;
+      int minLength;
+      int maxLength;
+    };
+
+    typedef std::map<const JSONSchemaTypeDefinition*, size_t> CompiledNodes;
+
+    size_t compile(const JSONSchemaTypeDefinitionPtr &type, CompiledNodes &compiled);
+    std::vector<size_t> compile(const std::vector<JSONSchemaTypeDefinitionPtr> &types, CompiledNodes &compiled);
+    Property compileProperty(const JSONSchemaTypeDefinitionPtr &type, CompiledNodes &compiled);
+    bool validate(size_t index, const CVariant &value, CVariant &outputValue) const;
+    bool isProperty(const Node &node, const std::string &key) const;
+
+    std::vector<Node> m_nodes;
+    std::vector<Property> m_parameters;
+  };
+}
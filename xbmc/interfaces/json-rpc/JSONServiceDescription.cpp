@@ -20,6 +20,7 @@
 
 #include "ServiceDescription.h"
 #include "JSONServiceDescription.h"
+#include "JSONSchemaValidator.h"
 #include "utils/log.h"
 #include "utils/JSONVariantParser.h"
 #include "utils/StringUtils.h"
@@ -99,6 +100,7 @@ JsonRpcMethodMap CJSONServiceDescription::m_methodMaps[] = {
   { "Files.SetFileDetails",                         CFileOperations::SetFileDetails },
   { "Files.PrepareDownload",                        CFileOperations::PrepareDownload },
   { "Files.Download",                               CFileOperations::Download },
+  { "Files.GetDirectoryCacheStats",                 CFileOperations::GetDirectoryCacheStats },
 
 // Music Library
   { "AudioLibrary.GetProperties",                   CAudioLibrary::GetProperties },
@@ -1307,6 +1309,16 @@ JSONRPC_STATUS JsonRpcMethod::Check(const CVariant &requestParameters, ITranspor
     {
       methodCall = method;
 
+      // Valid calls only need the compiled validation, invalid ones
+      // are checked again below to get the details of the error
+      if (validator != NULL)
+      {
+        if (validator->Validate(requestParameters, outputParameters))
+          return OK;
+
+        outputParameters = CVariant();
+      }
+
       // Count the number of actually handled (present)
       // parameters
       unsigned int handled = 0;
@@ -1380,7 +1392,7 @@ JSONRPC_STATUS JsonRpcMethod::checkParameter(const CVariant &requestParameters,
   if (ParameterExists(requestParameters, type->name, position))
   {
     // Get the parameter
-    CVariant parameterValue = GetParameter(requestParameters, type->name, position);
+    const CVariant &parameterValue = IsValueMember(requestParameters, type->name) ? requestParameters[type->name] : requestParameters[position];
 
     // Evaluate the type of the parameter
     JSONRPC_STATUS status = type->Check(parameterValue, outputParameters[type->name], errorData["stack"]);
@@ -1522,6 +1534,7 @@ bool CJSONServiceDescription::addMethod(const std::string &jsonMethod, MethodCal
     return false;
   }
 
+  newMethod.validator = std::make_shared<CJSONSchemaValidator>(newMethod.parameters);
   m_actionMap.add(newMethod);
 
   return true;
@@ -1899,6 +1912,12 @@ JSONRPC_STATUS CJSONServiceDescription::CheckCall(const char* const method, cons
   return MethodNotFound;
 }
 
+bool CJSONServiceDescription::IsReadOnly(const std::string &method)
+{
+  CJsonRpcMethodMap::JsonRpcMethodIterator iter = m_actionMap.find(method);
+  return iter != m_actionMap.end() && iter->second.permission == ReadData;
+}
+
 JSONSchemaTypeDefinitionPtr CJSONServiceDescription::GetType(const std::string &identification)
 {
   std::map<std::string, JSONSchemaTypeDefinitionPtr>::iterator iter = m_types.find(identification);
@@ -2048,9 +2067,27 @@ CJSONServiceDescription::CJsonRpcMethodMap::CJsonRpcMethodMap():
 {
 }
 
+CJSONServiceDescription::CJsonRpcMethodMap::CJsonRpcMethodMap(const CJsonRpcMethodMap &other):
+  m_actionmap(other.m_actionmap)
+{
+  index();
+}
+
+CJSONServiceDescription::CJsonRpcMethodMap& CJSONServiceDescription::CJsonRpcMethodMap::operator=(const CJsonRpcMethodMap &other)
+{
+  if (this != &other)
+  {
+    m_actionmap = other.m_actionmap;
+    index();
+  }
+
+  return *this;
+}
+
 void CJSONServiceDescription::CJsonRpcMethodMap::clear()
 {
   m_actionmap.clear();
+  m_index.clear();
 }
 
 void CJSONServiceDescription::CJsonRpcMethodMap::add(const JsonRpcMethod &method)
@@ -2058,6 +2095,7 @@ void CJSONServiceDescription::CJsonRpcMethodMap::add(const JsonRpcMethod &method
   std::string name = method.name;
   StringUtils::ToLower(name);
   m_actionmap[name] = method;
+  m_index[name] = m_actionmap.find(name);
 }
 
 CJSONServiceDescription::CJsonRpcMethodMap::JsonRpcMethodIterator CJSONServiceDescription::CJsonRpcMethodMap::begin() const
@@ -2067,10 +2105,22 @@ CJSONServiceDescription::CJsonRpcMethodMap::JsonRpcMethodIterator CJSONServiceDe
 
 CJSONServiceDescription::CJsonRpcMethodMap::JsonRpcMethodIterator CJSONServiceDescription::CJsonRpcMethodMap::find(const std::string& key) const
 {
-  return m_actionmap.find(key);
+  std::unordered_map<std::string, JsonRpcMethodIterator>::const_iterator method = m_index.find(key);
+  if (method == m_index.end())
+    return m_actionmap.end();
+
+  return method->second;
 }
 
 CJSONServiceDescription::CJsonRpcMethodMap::JsonRpcMethodIterator CJSONServiceDescription::CJsonRpcMethodMap::end() const
 {
   return m_actionmap.end();
 }
+
+void CJSONServiceDescription::CJsonRpcMethodMap::index()
+{
+  // the iterators of the copied index would point into the other map
+  m_index.clear();
+  for (JsonRpcMethodIterator method = m_actionmap.begin(); method != m_actionmap.end(); ++method)
+    m_index[method->first] = method;
+}
@@ -23,6 +23,7 @@
 #include <vector>
 #include <limits>
 #include <memory>
+#include <unordered_map>
 
 #include "JSONUtils.h"
 #include "utils/Variant.h"
@@ -31,6 +32,7 @@ namespace JSONRPC
 {
   class JSONSchemaTypeDefinition;
   typedef std::shared_ptr<JSONSchemaTypeDefinition> JSONSchemaTypeDefinitionPtr;
+  class CJSONSchemaValidator;
 
   /*! 
    \ingroup jsonrpc
@@ -274,6 +276,12 @@ namespace JSONRPC
      \brief Definition of the return value
      */
     JSONSchemaTypeDefinitionPtr returns;
+    /*!
+     \brief Compiled validation of the parameters,
+     used before falling back to the parameter
+     definitions to get the error details
+     */
+    std::shared_ptr<const CJSONSchemaValidator> validator;
   
   private:
     bool parseParameter(const CVariant &value, JSONSchemaTypeDefinitionPtr parameter);
@@ -390,6 +398,15 @@ namespace JSONRPC
      given parameters from the request against the json schema description for the given method.
      */
     static JSONRPC_STATUS CheckCall(const char* method, const CVariant &requestParameters, ITransportLayer *transport, IClient *client, bool notification, MethodCall &methodCall, CVariant &outputParameters);
+
+    /*!
+     \brief Checks whether the given method only reads data
+     \param method Lower case name of the method
+     \return True if the method exists and only needs the ReadData permission
+
+     Read-only methods of a batch call can be executed at the same time.
+     */
+    static bool IsReadOnly(const std::string &method);
     
     static JSONSchemaTypeDefinitionPtr GetType(const std::string &identification);
 
@@ -405,10 +422,18 @@ namespace JSONRPC
 
     static void getReferencedTypes(const JSONSchemaTypeDefinitionPtr type, std::vector<std::string> &referencedTypes);
 
+    /*!
+     \brief Maps the lower case name of a method to its definition
+
+     Methods are iterated in the order of their names while looking
+     up a method by name goes through a hash index.
+     */
     class CJsonRpcMethodMap
     {
     public:
       CJsonRpcMethodMap();
+      CJsonRpcMethodMap(const CJsonRpcMethodMap &other);
+      CJsonRpcMethodMap& operator=(const CJsonRpcMethodMap &other);
 
       void add(const JsonRpcMethod &method);
 
@@ -419,7 +444,10 @@ namespace JSONRPC
 
       void clear();
     private:
+      void index();
+
       std::map<std::string, JsonRpcMethod> m_actionmap;
+      std::unordered_map<std::string, JsonRpcMethodIterator> m_index;
     };
 
     static CJsonRpcMethodMap m_actionMap;
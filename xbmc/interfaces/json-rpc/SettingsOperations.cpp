@@ -601,7 +601,9 @@ bool CSettingsOperations::SerializeSettingList(const CSettingList* setting, CVar
   SerializeSettingListValues(CSettingUtils::GetList(setting), obj["value"]);
   SerializeSettingListValues(CSettingUtils::ListToValues(setting, setting->GetDefault()), obj["default"]);
 
-  obj["elementtype"] = obj["definition"]["type"];
+  // copy the type first, adding "elementtype" moves the other members
+  CVariant elementType = obj["definition"]["type"];
+  obj["elementtype"] = elementType;
   obj["delimiter"] = setting->GetDelimiter();
   obj["minimumItems"] = setting->GetMinimumItems();
   obj["maximumItems"] = setting->GetMaximumItems();
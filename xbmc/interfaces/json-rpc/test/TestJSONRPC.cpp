@@ -0,0 +1,207 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "interfaces/json-rpc/IClient.h"
+#include "interfaces/json-rpc/ITransportLayer.h"
+#include "interfaces/json-rpc/JSONRPC.h"
+#include "interfaces/json-rpc/JSONServiceDescription.h"
+#include "settings/AdvancedSettings.h"
+#include "utils/Variant.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+using namespace JSONRPC;
+
+namespace
+{
+class CTestTransport : public ITransportLayer
+{
+public:
+  bool PrepareDownload(const char *path, CVariant &details, std::string &protocol) override { return false; }
+  bool Download(const char *path, CVariant &result) override { return false; }
+  int GetCapabilities() override { return TRANSPORT_LAYER_CAPABILITY_ALL; }
+};
+
+class CTestClient : public IClient
+{
+public:
+  int GetPermissionFlags() override { return OPERATION_PERMISSION_ALL; }
+  int GetAnnouncementFlags() override { return 0; }
+  bool SetAnnouncementFlags(int flags) override { return false; }
+};
+
+std::atomic<int> running;
+std::atomic<int> maxRunning;
+std::atomic<int> reads;
+std::atomic<int> writes;
+
+// returns its id and the number of finished writes when it started
+JSONRPC_STATUS TestRead(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  int current = ++running;
+  int highest = maxRunning;
+  while (current > highest && !maxRunning.compare_exchange_weak(highest, current))
+    ;
+
+  result["id"] = parameterObject["id"];
+  result["writes"] = writes.load();
+  std::this_thread::sleep_for(std::chrono::milliseconds(parameterObject["delay"].asInteger()));
+
+  ++reads;
+  --running;
+  return OK;
+}
+
+// returns the number of reads running and finished when it started
+JSONRPC_STATUS TestWrite(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  result["running"] = running.load();
+  result["reads"] = reads.load();
+  ++writes;
+  return OK;
+}
+
+const char *TEST_READ =
+  "\"Test.Read\": { \"type\": \"method\", \"description\": \"\", \"transport\": \"Response\", \"permission\": \"ReadData\","
+  " \"params\": ["
+  " { \"name\": \"id\", \"type\": \"integer\", \"required\": true },"
+  " { \"name\": \"delay\", \"type\": \"integer\", \"minimum\": 0, \"default\": 0 }"
+  " ], \"returns\": \"object\" }";
+
+const char *TEST_WRITE =
+  "\"Test.Write\": { \"type\": \"method\", \"description\": \"\", \"transport\": \"Response\", \"permission\": \"UpdateData\","
+  " \"params\": [], \"returns\": \"object\" }";
+
+std::string Read(int id, int delay)
+{
+  return "{ \"jsonrpc\": \"2.0\", \"method\": \"Test.Read\", \"params\": { \"id\": " + std::to_string(id) +
+         ", \"delay\": " + std::to_string(delay) + " }, \"id\": " + std::to_string(id) + " }";
+}
+
+std::string Write(int id)
+{
+  return "{ \"jsonrpc\": \"2.0\", \"method\": \"Test.Write\", \"id\": " + std::to_string(id) + " }";
+}
+}
+
+class TestJSONRPC : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    ASSERT_TRUE(CJSONServiceDescription::AddMethod(TEST_READ, TestRead));
+    ASSERT_TRUE(CJSONServiceDescription::AddMethod(TEST_WRITE, TestWrite));
+    m_batchThreads = g_advancedSettings.m_jsonBatchThreads;
+    g_advancedSettings.m_jsonBatchThreads = 4;
+    running = 0;
+    maxRunning = 0;
+    reads = 0;
+    writes = 0;
+  }
+
+  void TearDown() override
+  {
+    g_advancedSettings.m_jsonBatchThreads = m_batchThreads;
+    CJSONServiceDescription::Cleanup();
+  }
+
+  CVariant Call(const std::string &request)
+  {
+    CTestTransport transport;
+    CTestClient client;
+    CVariant response;
+    if (!CJSONRPC::MethodCall(request, &transport, &client, response))
+      return CVariant();
+    return response;
+  }
+
+  unsigned int m_batchThreads;
+};
+
+TEST_F(TestJSONRPC, BatchOrder)
+{
+  // the first calls take longest, so they finish last
+  CVariant responses = Call("[ " + Read(1, 60) + ", " + Read(2, 40) + ", " + Read(3, 20) + ", " + Read(4, 0) + " ]");
+  ASSERT_TRUE(responses.isArray());
+  ASSERT_EQ(4U, responses.size());
+  for (unsigned int index = 0; index < responses.size(); index++)
+  {
+    EXPECT_EQ(index + 1, responses[index]["id"].asUnsignedInteger());
+    EXPECT_EQ(index + 1, responses[index]["result"]["id"].asUnsignedInteger());
+  }
+  EXPECT_GT(maxRunning.load(), 1);
+}
+
+TEST_F(TestJSONRPC, BatchBarrier)
+{
+  CVariant responses = Call("[ " + Read(1, 50) + ", " + Read(2, 20) + ", " + Write(3) + ", " +
+                            Read(4, 0) + ", " + Read(5, 0) + " ]");
+  ASSERT_TRUE(responses.isArray());
+  ASSERT_EQ(5U, responses.size());
+
+  // the write waits for the reads before it
+  EXPECT_EQ(3, responses[2]["id"].asInteger());
+  EXPECT_EQ(0, responses[2]["result"]["running"].asInteger());
+  EXPECT_EQ(2, responses[2]["result"]["reads"].asInteger());
+
+  // and the reads after it wait for the write
+  EXPECT_EQ(0, responses[0]["result"]["writes"].asInteger());
+  EXPECT_EQ(0, responses[1]["result"]["writes"].asInteger());
+  EXPECT_EQ(1, responses[3]["result"]["writes"].asInteger());
+  EXPECT_EQ(1, responses[4]["result"]["writes"].asInteger());
+}
+
+TEST_F(TestJSONRPC, BatchNotifications)
+{
+  const std::string notification = "{ \"jsonrpc\": \"2.0\", \"method\": \"Test.Write\" }";
+  CVariant responses = Call("[ " + Read(1, 0) + ", " + notification + ", " + Read(2, 0) + " ]");
+  ASSERT_TRUE(responses.isArray());
+  ASSERT_EQ(2U, responses.size());
+  EXPECT_EQ(1, responses[0]["id"].asInteger());
+  EXPECT_EQ(2, responses[1]["id"].asInteger());
+  EXPECT_EQ(1, writes.load());
+
+  // a batch of notifications only has no response at all
+  EXPECT_TRUE(Call("[ " + notification + ", " + notification + " ]").isNull());
+  EXPECT_EQ(3, writes.load());
+}
+
+TEST_F(TestJSONRPC, BatchLargerThanThreads)
+{
+  g_advancedSettings.m_jsonBatchThreads = 2;
+
+  std::string request = "[ ";
+  for (int id = 1; id <= 10; id++)
+    request += (id > 1 ? ", " : "") + Read(id, 5);
+  request += " ]";
+
+  CVariant responses = Call(request);
+  ASSERT_TRUE(responses.isArray());
+  ASSERT_EQ(10U, responses.size());
+  for (unsigned int index = 0; index < responses.size(); index++)
+    EXPECT_EQ(index + 1, responses[index]["result"]["id"].asUnsignedInteger());
+  EXPECT_EQ(10, reads.load());
+  EXPECT_LE(maxRunning.load(), 2);
+}
@@ -0,0 +1,176 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "interfaces/json-rpc/IClient.h"
+#include "interfaces/json-rpc/ITransportLayer.h"
+#include "interfaces/json-rpc/JSONSchemaValidator.h"
+#include "interfaces/json-rpc/JSONServiceDescription.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+
+using namespace JSONRPC;
+
+namespace
+{
+class CTestTransport : public ITransportLayer
+{
+public:
+  bool PrepareDownload(const char *path, CVariant &details, std::string &protocol) override { return false; }
+  bool Download(const char *path, CVariant &result) override { return false; }
+  int GetCapabilities() override { return TRANSPORT_LAYER_CAPABILITY_ALL; }
+};
+
+class CTestClient : public IClient
+{
+public:
+  int GetPermissionFlags() override { return OPERATION_PERMISSION_ALL; }
+  int GetAnnouncementFlags() override { return 0; }
+  bool SetAnnouncementFlags(int flags) override { return false; }
+};
+
+JSONRPC_STATUS TestMethod(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  return ACK;
+}
+
+const char *TEST_TYPES[] = {
+  "\"Test.Id\": { \"type\": \"integer\", \"minimum\": 0, \"maximum\": 2, \"default\": -1 }",
+  "\"Test.Property\": { \"type\": \"string\", \"enum\": [ \"title\", \"year\", \"rating\" ] }",
+  "\"Test.Filter\": { \"type\": [ { \"type\": \"object\", \"properties\": {"
+    " \"field\": { \"$ref\": \"Test.Property\", \"required\": true },"
+    " \"value\": { \"type\": \"string\", \"default\": \"none\" } }, \"additionalProperties\": false },"
+    " { \"type\": \"object\", \"properties\": {"
+    " \"and\": { \"type\": \"array\", \"items\": { \"$ref\": \"Test.Filter\" }, \"minItems\": 1, \"required\": true } },"
+    " \"additionalProperties\": false } ] }",
+  "\"Test.Options\": { \"type\": \"object\", \"properties\": {"
+    " \"limit\": { \"type\": \"integer\", \"minimum\": 1, \"default\": 10 } },"
+    " \"additionalProperties\": { \"type\": \"boolean\" } }"
+};
+
+const char *TEST_METHOD =
+  "{ \"Test.Method\": { \"type\": \"method\", \"description\": \"\", \"transport\": \"Response\", \"permission\": \"ReadData\","
+  " \"params\": ["
+  " { \"name\": \"playerid\", \"$ref\": \"Test.Id\", \"required\": true },"
+  " { \"name\": \"properties\", \"type\": \"array\", \"uniqueItems\": true, \"items\": { \"$ref\": \"Test.Property\" } },"
+  " { \"name\": \"filter\", \"$ref\": \"Test.Filter\" },"
+  " { \"name\": \"options\", \"$ref\": \"Test.Options\" },"
+  " { \"name\": \"label\", \"type\": [ \"null\", \"string\" ], \"minLength\": 2, \"maxLength\": 5, \"default\": null }"
+  " ], \"returns\": \"string\" } }";
+}
+
+class TestJSONSchemaValidator : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    for (unsigned int index = 0; index < sizeof(TEST_TYPES) / sizeof(TEST_TYPES[0]); index++)
+      ASSERT_TRUE(CJSONServiceDescription::AddType(TEST_TYPES[index]));
+    ASSERT_TRUE(m_method.Parse(CJSONVariantParser::Parse(TEST_METHOD)["Test.Method"]));
+    m_method.name = "Test.Method";
+    m_method.method = TestMethod;
+  }
+
+  void TearDown() override
+  {
+    CJSONServiceDescription::Cleanup();
+  }
+
+  // validates the parameters with the compiled validator and with the
+  // type definitions and makes sure both come to the same result
+  bool Validate(const std::string &parameters, CVariant &output)
+  {
+    const CVariant requestParameters = CJSONVariantParser::Parse(parameters);
+    CTestTransport transport;
+    CTestClient client;
+    MethodCall methodCall;
+
+    CVariant checked;
+    const bool valid = m_method.Check(requestParameters, &transport, &client, false, methodCall, checked) == OK;
+
+    CJSONSchemaValidator validator(m_method.parameters);
+    output = CVariant();
+    EXPECT_EQ(valid, validator.Validate(requestParameters, output));
+    if (valid)
+    {
+      EXPECT_EQ(CJSONVariantWriter::Write(checked, true), CJSONVariantWriter::Write(output, true));
+    }
+
+    return valid;
+  }
+
+  JsonRpcMethod m_method;
+};
+
+TEST_F(TestJSONSchemaValidator, DefaultValues)
+{
+  CVariant output;
+  EXPECT_TRUE(Validate("{ \"playerid\": 1 }", output));
+  EXPECT_EQ(1, output["playerid"].asInteger());
+  EXPECT_TRUE(output["properties"].isArray());
+  EXPECT_EQ(0U, output["properties"].size());
+  EXPECT_TRUE(output["label"].isNull());
+}
+
+TEST_F(TestJSONSchemaValidator, Positional)
+{
+  CVariant output;
+  EXPECT_TRUE(Validate("[ 2, [ \"title\", \"year\" ] ]", output));
+  EXPECT_EQ(2, output["playerid"].asInteger());
+  EXPECT_EQ(2U, output["properties"].size());
+  EXPECT_FALSE(Validate("[ 2, [ \"title\" ], null, null, null, 1 ]", output));
+}
+
+TEST_F(TestJSONSchemaValidator, InvalidValues)
+{
+  CVariant output;
+  EXPECT_FALSE(Validate("{ }", output));
+  EXPECT_FALSE(Validate("{ \"playerid\": 3 }", output));
+  EXPECT_FALSE(Validate("{ \"playerid\": \"1\" }", output));
+  EXPECT_FALSE(Validate("{ \"playerid\": 1, \"properties\": [ \"genre\" ] }", output));
+  EXPECT_FALSE(Validate("{ \"playerid\": 1, \"properties\": [ \"year\", \"year\" ] }", output));
+  EXPECT_FALSE(Validate("{ \"playerid\": 1, \"label\": \"a\" }", output));
+  EXPECT_FALSE(Validate("{ \"playerid\": 1, \"label\": \"abcdef\" }", output));
+  EXPECT_FALSE(Validate("{ \"playerid\": 1, \"unknown\": 1 }", output));
+}
+
+TEST_F(TestJSONSchemaValidator, Objects)
+{
+  CVariant output;
+  EXPECT_TRUE(Validate("{ \"playerid\": 0, \"options\": { \"sorted\": true } }", output));
+  EXPECT_EQ(10, output["options"]["limit"].asInteger());
+  EXPECT_TRUE(output["options"]["sorted"].asBoolean());
+  EXPECT_FALSE(Validate("{ \"playerid\": 0, \"options\": { \"sorted\": 1 } }", output));
+  EXPECT_FALSE(Validate("{ \"playerid\": 0, \"options\": { \"limit\": 0 } }", output));
+}
+
+TEST_F(TestJSONSchemaValidator, RecursiveUnion)
+{
+  CVariant output;
+  EXPECT_TRUE(Validate("{ \"playerid\": 0, \"filter\": { \"field\": \"year\" } }", output));
+  EXPECT_EQ("none", output["filter"]["value"].asString());
+  EXPECT_TRUE(Validate("{ \"playerid\": 0, \"filter\": { \"and\": [ { \"field\": \"year\", \"value\": \"2000\" },"
+                       " { \"and\": [ { \"field\": \"title\" } ] } ] } }", output));
+  EXPECT_EQ("title", output["filter"]["and"][1]["and"][0]["field"].asString());
+  EXPECT_FALSE(Validate("{ \"playerid\": 0, \"filter\": { \"and\": [ { \"field\": \"genre\" } ] } }", output));
+  EXPECT_FALSE(Validate("{ \"playerid\": 0, \"filter\": { \"and\": [ ] } }", output));
+}
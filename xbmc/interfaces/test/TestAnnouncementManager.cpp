@@ -0,0 +1,148 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "interfaces/AnnouncementManager.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+using namespace ANNOUNCEMENT;
+
+namespace
+{
+class CTestAnnouncer : public IAnnouncer
+{
+public:
+  explicit CTestAnnouncer(size_t expected) : m_expected(expected) { }
+
+  void Announce(AnnouncementFlag /* flag */, const char* /* sender */, const char *message, const CVariant &data) override
+  {
+    CSingleLock lock(m_critSection);
+    m_messages.push_back(message);
+    m_data.push_back(data);
+    if (m_messages.size() >= m_expected)
+      m_received.Set();
+  }
+
+  bool Wait() { return m_received.WaitMSec(5000); }
+
+  size_t m_expected;
+  CCriticalSection m_critSection;
+  CEvent m_received;
+  std::vector<std::string> m_messages;
+  std::vector<CVariant> m_data;
+};
+
+CVariant Item(int id)
+{
+  CVariant data;
+  data["item"]["type"] = "movie";
+  data["item"]["id"] = id;
+  return data;
+}
+}
+
+TEST(TestAnnouncementManager, Coalesce)
+{
+  CAnnouncementManager manager;
+
+  // nothing is delivered before the manager is started
+  manager.Announce(VideoLibrary, "test", "OnUpdate", Item(1));
+  manager.Announce(VideoLibrary, "test", "OnUpdate", Item(1));
+  manager.Announce(VideoLibrary, "test", "OnUpdate", Item(2));
+  manager.Announce(VideoLibrary, "test", "OnUpdate", Item(1));
+  manager.Announce(System, "test", "OnWake");
+  manager.Announce(System, "test", "OnWake");
+
+  CTestAnnouncer announcer(4);
+  manager.AddAnnouncer(&announcer);
+  manager.Start();
+  ASSERT_TRUE(announcer.Wait());
+  manager.Deinitialize();
+
+  // only repeated announcements in a row are merged
+  ASSERT_EQ(4U, announcer.m_messages.size());
+  EXPECT_EQ("OnUpdate", announcer.m_messages[0]);
+  EXPECT_EQ(1, announcer.m_data[0]["item"]["id"].asInteger());
+  EXPECT_EQ("OnUpdate", announcer.m_messages[1]);
+  EXPECT_EQ(2, announcer.m_data[1]["item"]["id"].asInteger());
+  EXPECT_EQ("OnUpdate", announcer.m_messages[2]);
+  EXPECT_EQ(1, announcer.m_data[2]["item"]["id"].asInteger());
+  EXPECT_EQ("OnWake", announcer.m_messages[3]);
+
+  unsigned int dropped, coalesced;
+  manager.GetStatistics(dropped, coalesced);
+  EXPECT_EQ(0U, dropped);
+  EXPECT_EQ(2U, coalesced);
+}
+
+TEST(TestAnnouncementManager, Order)
+{
+  CAnnouncementManager manager;
+
+  // a listener has to end up in the state of the last announcement
+  manager.Announce(Player, "test", "OnPlay", Item(1));
+  manager.Announce(Player, "test", "OnStop", Item(1));
+  manager.Announce(Player, "test", "OnPlay", Item(1));
+
+  CTestAnnouncer announcer(3);
+  manager.AddAnnouncer(&announcer);
+  manager.Start();
+  ASSERT_TRUE(announcer.Wait());
+  manager.Deinitialize();
+
+  ASSERT_EQ(3U, announcer.m_messages.size());
+  EXPECT_EQ("OnPlay", announcer.m_messages[0]);
+  EXPECT_EQ("OnStop", announcer.m_messages[1]);
+  EXPECT_EQ("OnPlay", announcer.m_messages[2]);
+
+  unsigned int dropped, coalesced;
+  manager.GetStatistics(dropped, coalesced);
+  EXPECT_EQ(0U, coalesced);
+}
+
+TEST(TestAnnouncementManager, BoundedQueue)
+{
+  const int count = 5000;
+  CAnnouncementManager manager;
+  for (int id = 0; id < count; id++)
+    manager.Announce(VideoLibrary, "test", "OnUpdate", Item(id));
+
+  unsigned int dropped, coalesced;
+  manager.GetStatistics(dropped, coalesced);
+  ASSERT_GT(dropped, 0U);
+  EXPECT_EQ(0U, coalesced);
+
+  CTestAnnouncer announcer(count - dropped);
+  manager.AddAnnouncer(&announcer);
+  manager.Start();
+  ASSERT_TRUE(announcer.Wait());
+  manager.Deinitialize();
+
+  // the oldest announcements are dropped
+  ASSERT_EQ(count - dropped, announcer.m_messages.size());
+  EXPECT_EQ((int64_t)dropped, announcer.m_data.front()["item"]["id"].asInteger());
+  EXPECT_EQ(count - 1, announcer.m_data.back()["item"]["id"].asInteger());
+}
@@ -1132,14 +1132,14 @@ int CMusicDatabase::AddGenre(const std::string& strGenre1)
       return it->second;
 
 
-    strSQL=PrepareSQL("select * from genre where strGenre like '%s'", strGenre.c_str());
-    m_pDS->query(strSQL);
+    strSQL = "select * from genre where strGenre like ?";
+    m_pDS->query(strSQL, { strGenre });
     if (m_pDS->num_rows() == 0)
     {
       m_pDS->close();
       // doesnt exists, add it
-      strSQL=PrepareSQL("insert into genre (idGenre, strGenre) values( NULL, '%s' )", strGenre.c_str());
-      m_pDS->exec(strSQL);
+      strSQL = "insert into genre (idGenre, strGenre) values( NULL, ? )";
+      m_pDS->exec(strSQL, { strGenre });
 
       int idGenre = (int)m_pDS->lastinsertid();
       m_genreCache.insert(std::pair<std::string, int>(strGenre1, idGenre));
@@ -1197,9 +1197,8 @@ int CMusicDatabase::AddArtist(const std::string& strArtist, const std::string& s
     if (!strMusicBrainzArtistID.empty())
     {
       // 1.a) Match on a MusicBrainz ID
-      strSQL = PrepareSQL("SELECT idArtist, strArtist FROM artist WHERE strMusicBrainzArtistID = '%s'",
-                          strMusicBrainzArtistID.c_str());
-      m_pDS->query(strSQL);
+      strSQL = "SELECT idArtist, strArtist FROM artist WHERE strMusicBrainzArtistID = ?";
+      m_pDS->query(strSQL, { strMusicBrainzArtistID });
       if (m_pDS->num_rows() > 0)
       {
         int idArtist = (int)m_pDS->fv("idArtist").get_asInt();
@@ -1218,8 +1217,8 @@ int CMusicDatabase::AddArtist(const std::string& strArtist, const std::string& s
 
       // 1.b) No match on MusicBrainz ID. Look for a previously added artist with no MusicBrainz ID
       //     and update that if it exists.
-      strSQL = PrepareSQL("SELECT idArtist FROM artist WHERE strArtist LIKE '%s' AND strMusicBrainzArtistID IS NULL", strArtist.c_str());
-      m_pDS->query(strSQL);
+      strSQL = "SELECT idArtist FROM artist WHERE strArtist LIKE ? AND strMusicBrainzArtistID IS NULL";
+      m_pDS->query(strSQL, { strArtist });
       if (m_pDS->num_rows() > 0)
       {
         int idArtist = (int)m_pDS->fv("idArtist").get_asInt();
@@ -1239,10 +1238,9 @@ int CMusicDatabase::AddArtist(const std::string& strArtist, const std::string& s
     }
     else
     {
-      strSQL = PrepareSQL("SELECT idArtist FROM artist WHERE strArtist LIKE '%s'",
-                          strArtist.c_str());
+      strSQL = "SELECT idArtist FROM artist WHERE strArtist LIKE ?";
 
-      m_pDS->query(strSQL);
+      m_pDS->query(strSQL, { strArtist });
       if (m_pDS->num_rows() > 0)
       {
         int idArtist = (int)m_pDS->fv("idArtist").get_asInt();
@@ -1424,8 +1422,8 @@ int CMusicDatabase::AddRole(const std::string &strRole)
   {
     if (NULL == m_pDB.get()) return -1;
     if (NULL == m_pDS.get()) return -1;
-    strSQL = PrepareSQL("SELECT idRole FROM role WHERE strRole LIKE '%s'", strRole.c_str());
-    m_pDS->query(strSQL);
+    strSQL = "SELECT idRole FROM role WHERE strRole LIKE ?";
+    m_pDS->query(strSQL, { strRole });
     if (m_pDS->num_rows() > 0)
       idRole = m_pDS->fv("idRole").get_asInt();
     m_pDS->close();
@@ -1886,14 +1884,14 @@ int CMusicDatabase::AddPath(const std::string& strPath1)
     if (it != m_pathCache.end())
       return it->second;
 
-    strSQL=PrepareSQL( "select * from path where strPath='%s'", strPath.c_str());
-    m_pDS->query(strSQL);
+    strSQL = "select * from path where strPath=?";
+    m_pDS->query(strSQL, { strPath });
     if (m_pDS->num_rows() == 0)
     {
       m_pDS->close();
       // doesnt exists, add it
-      strSQL=PrepareSQL("insert into path (idPath, strPath) values( NULL, '%s' )", strPath.c_str());
-      m_pDS->exec(strSQL);
+      strSQL = "insert into path (idPath, strPath) values( NULL, ? )";
+      m_pDS->exec(strSQL, { strPath });
 
       int idPath = (int)m_pDS->lastinsertid();
       m_pathCache.insert(std::pair<std::string, int>(strPath, idPath));
@@ -2181,9 +2179,8 @@ int CMusicDatabase::GetAlbumIdByPath(const std::string& strPath)
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    std::string strSQL = PrepareSQL("SELECT DISTINCT idAlbum FROM song JOIN path ON song.idPath = path.idPath WHERE path.strPath='%s'", strPath.c_str());
     // run query
-    if (!m_pDS->query(strSQL)) return false;
+    if (!m_pDS->query("SELECT DISTINCT idAlbum FROM song JOIN path ON song.idPath = path.idPath WHERE path.strPath=?", { strPath })) return false;
     int iRowsFound = m_pDS->num_rows();
 
     int idAlbum = -1; // If no album is found, or more than one album is found then -1 is returned
@@ -5475,7 +5472,7 @@ bool CMusicDatabase::GetPaths(std::set<std::string> &paths)
     paths.clear();
 
     // find all paths
-    if (!m_pDS->query("select strPath from path")) return false;
+    if (!m_pDS->query_forward("select strPath from path")) return false;
     int iRowsFound = m_pDS->num_rows();
     if (iRowsFound == 0)
     {
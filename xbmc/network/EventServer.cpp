@@ -26,6 +26,7 @@
 #include "EventPacket.h"
 #include "EventClient.h"
 #include "Socket.h"
+#include "SocketReactor.h"
 #include "threads/CriticalSection.h"
 #include "Application.h"
 #include "ServiceBroker.h"
@@ -41,6 +42,7 @@
 #include <map>
 #include <queue>
 #include <cassert>
+#include <errno.h>
 
 using namespace EVENTSERVER;
 using namespace EVENTPACKET;
@@ -154,7 +156,8 @@ void CEventServer::Process()
 
 void CEventServer::Run()
 {
-  CSocketListener listener;
+  CSocketReactor reactor;
+  std::vector<CSocketReactor::Event> events;
   int packetSize = 0;
 
   CLog::Log(LOGNOTICE, "ES: Starting UDP Event server on port %d", m_iPort);
@@ -189,6 +192,13 @@ void CEventServer::Run()
     return;
   }
 
+  // watch our socket, which has to be drained on every wakeup
+  if (!reactor.Initialize() || !CSocketReactor::SetNonBlocking(m_pSocket->Socket()) || !reactor.Add(m_pSocket->Socket()))
+  {
+    CLog::Log(LOGERROR, "ES: Could not watch socket, aborting!");
+    return;
+  }
+
   // publish service
   std::vector<std::pair<std::string, std::string> > txt;
   CZeroconf::GetInstance()->PublishService("servers.eventserver",
@@ -197,9 +207,6 @@ void CEventServer::Run()
                                m_iPort,
                                txt);
 
-  // add our socket to the 'select' listener
-  listener.AddSocket(m_pSocket);
-
   m_bRunning = true;
 
   while (!m_bStop)
@@ -207,11 +214,28 @@ void CEventServer::Run()
     try
     {
       // start listening until we timeout
-      if (listener.Listen(m_iListenTimeout))
+      if (!reactor.Wait(m_iListenTimeout, events))
+      {
+        CLog::Log(LOGERROR, "ES: Waiting for socket failed");
+        break;
+      }
+
+      if (!events.empty())
       {
-        CAddress addr;
-        if ((packetSize = m_pSocket->Read(addr, PACKET_SIZE, (void *)m_pPacketBuffer)) > -1)
+        // the socket is only reported again once all queued packets are read
+        while (true)
         {
+          CAddress addr;
+          if ((packetSize = m_pSocket->Read(addr, PACKET_SIZE, (void *)m_pPacketBuffer)) < 0)
+          {
+            if (errno == EINTR)
+              continue;
+            // on other errors re-arm the socket, it's reported again if
+            // packets are still queued
+            if (!CSocketReactor::WouldBlock())
+              reactor.Modify(m_pSocket->Socket(), false);
+            break;
+          }
           ProcessPacket(addr, packetSize);
         }
       }
@@ -0,0 +1,236 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SocketReactor.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+
+#include <errno.h>
+
+#if defined(TARGET_LINUX)
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+#if !defined(TARGET_WINDOWS)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/select.h>
+#endif
+
+// maximum number of events fetched from the kernel with a single call
+#define REACTOR_MAX_EVENTS 64
+
+CSocketReactor::CSocketReactor()
+{
+#if defined(TARGET_LINUX)
+  m_epoll = -1;
+#endif
+}
+
+CSocketReactor::~CSocketReactor()
+{
+  Deinitialize();
+}
+
+bool CSocketReactor::Initialize()
+{
+  Deinitialize();
+
+#if defined(TARGET_LINUX)
+  m_epoll = epoll_create1(EPOLL_CLOEXEC);
+  if (m_epoll < 0)
+  {
+    CLog::Log(LOGERROR, "CSocketReactor: failed to create epoll instance: %d", errno);
+    return false;
+  }
+#endif
+
+  return true;
+}
+
+void CSocketReactor::Deinitialize()
+{
+#if defined(TARGET_LINUX)
+  if (m_epoll >= 0)
+    close(m_epoll);
+  m_epoll = -1;
+#else
+  CSingleLock lock(m_critSection);
+  m_sockets.clear();
+#endif
+}
+
+bool CSocketReactor::Add(SOCKET socket, bool writable /* = false */)
+{
+#if defined(TARGET_LINUX)
+  struct epoll_event event = {};
+  event.events = EPOLLIN | EPOLLRDHUP | EPOLLET | (writable ? (uint32_t)EPOLLOUT : 0u);
+  event.data.fd = socket;
+  if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, socket, &event) < 0)
+  {
+    CLog::Log(LOGERROR, "CSocketReactor: failed to watch socket %d: %d", (int)socket, errno);
+    return false;
+  }
+#else
+  CSingleLock lock(m_critSection);
+  m_sockets[socket] = Readable | (writable ? Writable : 0);
+#endif
+
+  return true;
+}
+
+bool CSocketReactor::Modify(SOCKET socket, bool writable, bool readable /* = true */)
+{
+#if defined(TARGET_LINUX)
+  // re-arming also reports a socket that is already readable or writable again
+  struct epoll_event event = {};
+  event.events = EPOLLRDHUP | EPOLLET | (readable ? (uint32_t)EPOLLIN : 0u) | (writable ? (uint32_t)EPOLLOUT : 0u);
+  event.data.fd = socket;
+  if (epoll_ctl(m_epoll, EPOLL_CTL_MOD, socket, &event) < 0)
+    return false;
+#else
+  CSingleLock lock(m_critSection);
+  std::map<SOCKET, int>::iterator it = m_sockets.find(socket);
+  if (it == m_sockets.end())
+    return false;
+  it->second = (readable ? Readable : 0) | (writable ? Writable : 0);
+#endif
+
+  return true;
+}
+
+void CSocketReactor::Remove(SOCKET socket)
+{
+#if defined(TARGET_LINUX)
+  // the event argument is ignored but must not be NULL before linux 2.6.9
+  struct epoll_event event = {};
+  epoll_ctl(m_epoll, EPOLL_CTL_DEL, socket, &event);
+#else
+  CSingleLock lock(m_critSection);
+  m_sockets.erase(socket);
+#endif
+}
+
+bool CSocketReactor::Wait(int timeoutMs, std::vector<Event> &events)
+{
+  events.clear();
+
+#if defined(TARGET_LINUX)
+  struct epoll_event ready[REACTOR_MAX_EVENTS];
+  int count = epoll_wait(m_epoll, ready, REACTOR_MAX_EVENTS, timeoutMs);
+  if (count < 0)
+    return errno == EINTR;
+
+  for (int i = 0; i < count; i++)
+  {
+    Event event;
+    event.socket = ready[i].data.fd;
+    event.events = 0;
+    if (ready[i].events & EPOLLIN)
+      event.events |= Readable;
+    if (ready[i].events & EPOLLOUT)
+      event.events |= Writable;
+    if (ready[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP))
+      event.events |= Closed | Readable;
+    events.push_back(event);
+  }
+#else
+  fd_set rfds, wfds;
+  FD_ZERO(&rfds);
+  FD_ZERO(&wfds);
+  SOCKET max_fd = 0;
+  {
+    CSingleLock lock(m_critSection);
+    for (std::map<SOCKET, int>::const_iterator it = m_sockets.begin(); it != m_sockets.end(); ++it)
+    {
+      if (it->second & Readable)
+        FD_SET(it->first, &rfds);
+      if (it->second & Writable)
+        FD_SET(it->first, &wfds);
+      if ((intptr_t)it->first > (intptr_t)max_fd)
+        max_fd = it->first;
+    }
+  }
+
+  struct timeval to = { timeoutMs / 1000, (timeoutMs % 1000) * 1000 };
+  int count = select((intptr_t)max_fd + 1, &rfds, &wfds, NULL, timeoutMs < 0 ? NULL : &to);
+  if (count < 0)
+    return errno == EINTR;
+
+  CSingleLock lock(m_critSection);
+  for (std::map<SOCKET, int>::const_iterator it = m_sockets.begin(); it != m_sockets.end(); ++it)
+  {
+    Event event;
+    event.socket = it->first;
+    event.events = 0;
+    if (FD_ISSET(it->first, &rfds))
+      event.events |= Readable;
+    if (FD_ISSET(it->first, &wfds))
+      event.events |= Writable;
+    if (event.events != 0)
+      events.push_back(event);
+  }
+#endif
+
+  return true;
+}
+
+bool CSocketReactor::SetNonBlocking(SOCKET socket)
+{
+#ifdef TARGET_WINDOWS
+  u_long nonblocking = 1;
+  return ioctlsocket(socket, FIONBIO, &nonblocking) == 0;
+#else
+  int flags = fcntl(socket, F_GETFL);
+  return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+bool CSocketReactor::WouldBlock()
+{
+#ifdef TARGET_WINDOWS
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+bool CSocketReactor::WaitWritable(SOCKET socket, int timeoutMs)
+{
+#ifdef TARGET_WINDOWS
+  fd_set wfds;
+  FD_ZERO(&wfds);
+  FD_SET(socket, &wfds);
+  struct timeval to = { timeoutMs / 1000, (timeoutMs % 1000) * 1000 };
+  return select((intptr_t)socket + 1, NULL, &wfds, NULL, &to) > 0;
+#else
+  // poll() isn't limited to descriptors below FD_SETSIZE
+  struct pollfd pfd = {};
+  pfd.fd = socket;
+  pfd.events = POLLOUT;
+  int res;
+  do
+  {
+    res = poll(&pfd, 1, timeoutMs);
+  } while (res < 0 && errno == EINTR);
+
+  return res > 0 && (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) == 0;
+#endif
+}
@@ -0,0 +1,108 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <vector>
+
+#include "system.h"
+#include "threads/CriticalSection.h"
+
+/*!
+ \brief Waits for any number of sockets to become readable or writable.
+
+ On Linux the sockets are watched by an edge-triggered epoll instance, so a
+ wakeup only costs as much as the number of sockets that are actually ready,
+ no matter how many are connected. Other platforms fall back to select().
+
+ Because of the edge-triggered notifications the owner has to read from
+ (respectively write to) a reported socket until the call fails with
+ EAGAIN/EWOULDBLOCK, otherwise the socket isn't reported again. All sockets
+ therefore have to be non-blocking, see SetNonBlocking().
+
+ Wait() is meant to be called by a single thread, the sockets can be added,
+ modified and removed from any thread.
+ */
+class CSocketReactor
+{
+public:
+  enum SocketEvents
+  {
+    Readable = 0x1,
+    Writable = 0x2,
+    Closed   = 0x4
+  };
+
+  struct Event
+  {
+    SOCKET socket;
+    int events;
+  };
+
+  CSocketReactor();
+  ~CSocketReactor();
+
+  bool Initialize();
+  void Deinitialize();
+
+  /*!
+   \brief Starts watching the given socket
+   \param socket Non-blocking socket
+   \param writable Whether to report the socket when it becomes writable
+   */
+  bool Add(SOCKET socket, bool writable = false);
+  /*!
+   \brief Changes the events the given socket is reported for
+   \param readable Whether to report the socket when it becomes readable, a
+          socket that still has data queued is reported again once re-enabled
+   */
+  bool Modify(SOCKET socket, bool writable, bool readable = true);
+  void Remove(SOCKET socket);
+
+  /*!
+   \brief Waits until at least one of the sockets is ready
+   \param timeoutMs Timeout in ms, -1 waits forever
+   \param events Ready sockets, cleared before waiting
+   \return False if waiting failed, true otherwise (including timeouts)
+   */
+  bool Wait(int timeoutMs, std::vector<Event> &events);
+
+  static bool SetNonBlocking(SOCKET socket);
+  /*!
+   \brief Whether the last failed socket call would have blocked
+   */
+  static bool WouldBlock();
+  /*!
+   \brief Blocks until a single socket is writable
+   \return True if the socket is writable, false on timeout and errors
+   */
+  static bool WaitWritable(SOCKET socket, int timeoutMs);
+
+private:
+  CSocketReactor(const CSocketReactor&) = delete;
+  CSocketReactor& operator=(const CSocketReactor&) = delete;
+
+#if defined(TARGET_LINUX)
+  int m_epoll;
+#else
+  CCriticalSection m_critSection;
+  std::map<SOCKET, int> m_sockets; // socket => SocketEvents
+#endif
+};
@@ -19,6 +19,8 @@
  */
 
 #include "TCPServer.h"
+#include <algorithm>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
@@ -28,6 +30,7 @@
 #include "settings/AdvancedSettings.h"
 #include "interfaces/json-rpc/JSONRPC.h"
 #include "interfaces/AnnouncementManager.h"
+#include "utils/JSONVariantWriter.h"
 #include "utils/log.h"
 #include "utils/Variant.h"
 #include "threads/SingleLock.h"
@@ -57,6 +60,15 @@ using namespace JSONRPC;
 using namespace ANNOUNCEMENT;
 
 #define RECEIVEBUFFER 1024
+#define TCP_RESPONSE_CHUNK_SIZE (32 * 1024)
+// output queued for a client that isn't reading fast enough
+#define TCP_MAX_PENDING_OUTPUT (1024 * 1024)
+// time in ms before accepting is tried again after running out of resources
+#define TCP_ACCEPT_RETRY_INTERVAL 100
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
 
 CTCPServer *CTCPServer::ServerInstance = NULL;
 
@@ -113,118 +125,173 @@ CTCPServer::CTCPServer(int port, bool nonlocal) : CThread("TCPServer")
   m_port = port;
   m_nonlocal = nonlocal;
   m_sdpd = NULL;
+  m_acceptPending = false;
 }
 
 void CTCPServer::Process()
 {
   m_bStop = false;
 
+  std::vector<CSocketReactor::Event> events;
   while (!m_bStop)
   {
-    SOCKET          max_fd = 0;
-    fd_set          rfds;
-    struct timeval  to     = {1, 0};
-    FD_ZERO(&rfds);
+    int timeout = 1000;
+    if (m_acceptPending)
+      timeout = std::min(timeout, (int)m_acceptRetry.MillisLeft());
 
-    for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); ++it)
+    if (!m_reactor.Wait(timeout, events))
     {
-      FD_SET(*it, &rfds);
-      if ((intptr_t)*it > (intptr_t)max_fd)
-        max_fd = *it;
+      CLog::Log(LOGERROR, "JSONRPC Server: Waiting for sockets failed");
+      Sleep(1000);
+      Initialize();
+      continue;
     }
 
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+    // the listeners aren't reported again while the connections that
+    // couldn't be accepted are queued, re-arming reports them if they still are
+    if (m_acceptPending && m_acceptRetry.IsTimePast())
     {
-      FD_SET(m_connections[i]->m_socket, &rfds);
-      if ((intptr_t)m_connections[i]->m_socket > (intptr_t)max_fd)
-        max_fd = m_connections[i]->m_socket;
+      m_acceptPending = false;
+      for (std::vector<SOCKET>::const_iterator it = m_servers.begin(); it != m_servers.end(); ++it)
+        m_reactor.Modify(*it, false);
     }
 
-    int res = select((intptr_t)max_fd+1, &rfds, NULL, NULL, &to);
-    if (res < 0)
+    // only the sockets which are ready are reported, no matter how many
+    // clients are connected
+    for (std::vector<CSocketReactor::Event>::const_iterator event = events.begin(); event != events.end(); ++event)
     {
-      CLog::Log(LOGERROR, "JSONRPC Server: Select failed");
-      Sleep(1000);
-      Initialize();
+      if (std::find(m_servers.begin(), m_servers.end(), event->socket) != m_servers.end())
+      {
+        if (!AcceptConnections(event->socket))
+          break;
+        continue;
+      }
+
+      // the connection may already be gone because of an earlier event
+      std::map<SOCKET, CTCPClient*>::iterator connection = m_connections.find(event->socket);
+      if (connection == m_connections.end())
+        continue;
+
+      bool close = false;
+      if (event->events & CSocketReactor::Writable)
+        close = !connection->second->Flush();
+      if (!close && (event->events & CSocketReactor::Readable))
+        close = !ReadConnection(connection);
+
+      if (close)
+      {
+        CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
+        CloseConnection(connection);
+      }
     }
-    else if (res > 0)
+  }
+
+  Deinitialize();
+}
+
+bool CTCPServer::AcceptConnections(SOCKET server)
+{
+  // the listening socket is only reported again once all pending
+  // connections have been accepted
+  while (true)
+  {
+    CTCPClient *newconnection = new CTCPClient();
+    newconnection->m_socket = accept(server, (sockaddr*)&newconnection->m_cliaddr, &newconnection->m_addrlen);
+
+    if (newconnection->m_socket == INVALID_SOCKET)
     {
-      for (int i = m_connections.size() - 1; i >= 0; i--)
+      int error = errno;
+      bool wouldBlock = CSocketReactor::WouldBlock();
+      delete newconnection;
+
+      if (wouldBlock)
+        return true;
+
+      // the failed connection is gone, the ones behind it are still queued
+      if (error == EINTR || error == ECONNABORTED || error == EPROTO)
+        continue;
+
+      CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed: %d", error);
+      if (EBADF == error)
       {
-        int socket = m_connections[i]->m_socket;
-        if (FD_ISSET(socket, &rfds))
-        {
-          char buffer[RECEIVEBUFFER] = {};
-          int  nread = 0;
-          nread = recv(socket, (char*)&buffer, RECEIVEBUFFER, 0);
-          bool close = false;
-          if (nread > 0)
-          {
-            std::string response;
-            if (m_connections[i]->IsNew())
-            {
-              CWebSocket *websocket = CWebSocketManager::Handle(buffer, nread, response);
-
-              if (!response.empty())
-                m_connections[i]->Send(response.c_str(), response.size());
-
-              if (websocket != NULL)
-              {
-                // Replace the CTCPClient with a CWebSocketClient
-                CWebSocketClient *websocketClient = new CWebSocketClient(websocket, *(m_connections[i]));
-                delete m_connections[i];
-                m_connections.erase(m_connections.begin() + i);
-                m_connections.insert(m_connections.begin() + i, websocketClient);
-              }
-            }
-
-            if (response.size() <= 0)
-              m_connections[i]->PushBuffer(this, buffer, nread);
-
-            close = m_connections[i]->Closing();
-          }
-          else
-            close = true;
-
-          if (close)
-          {
-            CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
-            m_connections[i]->Disconnect();
-            delete m_connections[i];
-            m_connections.erase(m_connections.begin() + i);
-          }
-        }
+        Sleep(1000);
+        Initialize();
+        return false;
       }
 
-      for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); ++it)
+      // out of descriptors or memory, try again once some may have been freed
+      m_acceptPending = true;
+      m_acceptRetry.Set(TCP_ACCEPT_RETRY_INTERVAL);
+      return true;
+    }
+
+    CLog::Log(LOGDEBUG, "JSONRPC Server: New connection detected");
+    if (!CSocketReactor::SetNonBlocking(newconnection->m_socket) || !m_reactor.Add(newconnection->m_socket))
+    {
+      CLog::Log(LOGERROR, "JSONRPC Server: Failed to watch new connection");
+      newconnection->Disconnect();
+      delete newconnection;
+      continue;
+    }
+
+    CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
+    newconnection->m_reactor = &m_reactor;
+    CSingleLock lock(m_connectionsSection);
+    m_connections.insert(std::make_pair(newconnection->m_socket, newconnection));
+  }
+}
+
+bool CTCPServer::ReadConnection(std::map<SOCKET, CTCPClient*>::iterator connection)
+{
+  // read until the socket would block as it won't be reported again before,
+  // unless a response is still being sent which stops reading until it is
+  while (!connection->second->IsBusy())
+  {
+    char buffer[RECEIVEBUFFER] = {};
+    int nread = recv(connection->first, (char*)&buffer, RECEIVEBUFFER, 0);
+    if (nread < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return CSocketReactor::WouldBlock();
+    }
+    if (nread == 0)
+      return false;
+
+    std::string response;
+    if (connection->second->IsNew())
+    {
+      CWebSocket *websocket = CWebSocketManager::Handle(buffer, nread, response);
+
+      if (!response.empty())
+        connection->second->Send(response.c_str(), response.size());
+
+      if (websocket != NULL)
       {
-        if (FD_ISSET(*it, &rfds))
-        {
-          CLog::Log(LOGDEBUG, "JSONRPC Server: New connection detected");
-          CTCPClient *newconnection = new CTCPClient();
-          newconnection->m_socket = accept(*it, (sockaddr*)&newconnection->m_cliaddr, &newconnection->m_addrlen);
-
-          if (newconnection->m_socket == INVALID_SOCKET)
-          {
-            CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed: %d", errno);
-            if (EBADF == errno)
-            {
-              Sleep(1000);
-              Initialize();
-              break;
-            }
-          }
-          else
-          {
-            CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
-            m_connections.push_back(newconnection);
-          }
-        }
+        // Replace the CTCPClient with a CWebSocketClient
+        CWebSocketClient *websocketClient = new CWebSocketClient(websocket, *(connection->second));
+        CSingleLock lock(m_connectionsSection);
+        delete connection->second;
+        connection->second = websocketClient;
       }
     }
+
+    if (response.size() <= 0)
+      connection->second->PushBuffer(this, buffer, nread);
+
+    if (connection->second->Closing())
+      return false;
   }
 
-  Deinitialize();
+  return true;
+}
+
+void CTCPServer::CloseConnection(std::map<SOCKET, CTCPClient*>::iterator connection)
+{
+  CSingleLock lock(m_connectionsSection);
+  connection->second->Disconnect();
+  delete connection->second;
+  m_connections.erase(connection);
 }
 
 bool CTCPServer::PrepareDownload(const char *path, CVariant &details, std::string &protocol)
@@ -246,15 +313,25 @@ void CTCPServer::Announce(AnnouncementFlag flag, const char *sender, const char
 {
   std::string str = IJSONRPCAnnouncer::AnnouncementToJSONRPC(flag, sender, message, data, g_advancedSettings.m_jsonOutputCompact);
 
-  for (unsigned int i = 0; i < m_connections.size(); i++)
+  CSingleLock connectionsLock(m_connectionsSection);
+  for (std::map<SOCKET, CTCPClient*>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
   {
+    CTCPClient *connection = it->second;
     {
-      CSingleLock lock (m_connections[i]->m_critSection);
-      if ((m_connections[i]->GetAnnouncementFlags() & flag) == 0)
+      CSingleLock lock (connection->m_critSection);
+      if ((connection->GetAnnouncementFlags() & flag) == 0)
+        continue;
+
+      // don't let a client which stopped reading make us queue announcements forever
+      if (connection->GetPendingOutput() > TCP_MAX_PENDING_OUTPUT)
+      {
+        CLog::Log(LOGWARNING, "JSONRPC Server: Client isn't reading its announcements, disconnecting");
+        shutdown(connection->m_socket, SHUT_RDWR);
         continue;
+      }
     }
 
-    m_connections[i]->Send(str.c_str(), str.size());
+    connection->Send(str.c_str(), str.size());
   }
 }
 
@@ -267,6 +344,15 @@ bool CTCPServer::Initialize()
   started |= InitializeBlue();
   started |= InitializeTCP();
 
+  if (started && !m_reactor.Initialize())
+    started = false;
+
+  for (std::vector<SOCKET>::iterator it = m_servers.begin(); started && it != m_servers.end(); ++it)
+  {
+    if (!CSocketReactor::SetNonBlocking(*it) || !m_reactor.Add(*it))
+      started = false;
+  }
+
   if (started)
   {
     CAnnouncementManager::GetInstance().AddAnnouncer(this);
@@ -472,18 +558,21 @@ bool CTCPServer::InitializeTCP()
 
 void CTCPServer::Deinitialize()
 {
-  for (unsigned int i = 0; i < m_connections.size(); i++)
+  CSingleLock lock(m_connectionsSection);
+  for (std::map<SOCKET, CTCPClient*>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
   {
-    m_connections[i]->Disconnect();
-    delete m_connections[i];
+    it->second->Disconnect();
+    delete it->second;
   }
 
   m_connections.clear();
+  lock.Leave();
 
   for (unsigned int i = 0; i < m_servers.size(); i++)
     closesocket(m_servers[i]);
 
   m_servers.clear();
+  m_reactor.Deinitialize();
 
 #ifdef HAVE_LIBBLUETOOTH
   if (m_sdpd)
@@ -499,10 +588,13 @@ CTCPServer::CTCPClient::CTCPClient()
   m_new = true;
   m_announcementflags = ANNOUNCE_ALL;
   m_socket = INVALID_SOCKET;
+  m_reactor = NULL;
   m_beginBrackets = 0;
   m_endBrackets = 0;
   m_beginChar = 0;
   m_endChar = 0;
+  m_readable = true;
+  m_writable = false;
 
   m_addrlen = sizeof(m_cliaddr);
 }
@@ -512,6 +604,10 @@ CTCPServer::CTCPClient::CTCPClient(const CTCPClient& client)
   Copy(client);
 }
 
+CTCPServer::CTCPClient::~CTCPClient()
+{
+}
+
 CTCPServer::CTCPClient& CTCPServer::CTCPClient::operator=(const CTCPClient& client)
 {
   Copy(client);
@@ -536,12 +632,145 @@ bool CTCPServer::CTCPClient::SetAnnouncementFlags(int flags)
 
 void CTCPServer::CTCPClient::Send(const char *data, unsigned int size)
 {
-  unsigned int sent = 0;
-  do
+  CSingleLock lock (m_critSection);
+
+  // keep announcements from being sent in between the parts of a response
+  if (!m_responses.empty())
+    m_deferred.append(data, size);
+  else
+    Queue(data, size);
+}
+
+bool CTCPServer::CTCPClient::Queue(const char *data, size_t size)
+{
+  if (m_socket == INVALID_SOCKET)
+    return false;
+
+  // only send directly if nothing is queued to keep the order
+  size_t sent = 0;
+  if (m_output.empty())
   {
-    CSingleLock lock (m_critSection);
-    sent += send(m_socket, data + sent, size - sent, 0);
-  } while (sent < size);
+    while (sent < size)
+    {
+      int res = send(m_socket, data + sent, size - sent, MSG_NOSIGNAL);
+      if (res < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        // on errors the reactor reports the socket as closed
+        if (!CSocketReactor::WouldBlock())
+          return false;
+        break;
+      }
+      sent += res;
+    }
+  }
+
+  if (sent < size)
+  {
+    // let the reactor report when the rest can be sent
+    m_output.append(data + sent, size - sent);
+    UpdateEvents();
+  }
+
+  return true;
+}
+
+bool CTCPServer::CTCPClient::Flush()
+{
+  CSingleLock lock (m_critSection);
+  size_t sent = 0;
+  while (sent < m_output.size())
+  {
+    int res = send(m_socket, m_output.c_str() + sent, m_output.size() - sent, MSG_NOSIGNAL);
+    if (res < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      if (!CSocketReactor::WouldBlock())
+        return false;
+      break;
+    }
+    sent += res;
+  }
+
+  m_output.erase(0, sent);
+  Produce();
+  UpdateEvents();
+
+  return true;
+}
+
+size_t CTCPServer::CTCPClient::GetPendingOutput()
+{
+  CSingleLock lock (m_critSection);
+  return m_output.size() + m_deferred.size();
+}
+
+bool CTCPServer::CTCPClient::IsBusy()
+{
+  CSingleLock lock (m_critSection);
+  return !m_responses.empty();
+}
+
+void CTCPServer::CTCPClient::Produce()
+{
+  // only serialize as much as the client has room for instead of keeping
+  // all of the response in memory
+  while (!m_responses.empty() && m_output.size() < TCP_RESPONSE_CHUNK_SIZE)
+  {
+    if (!m_writer)
+      m_writer.reset(new CJSONVariantStreamWriter(m_responses.front(), g_advancedSettings.m_jsonOutputCompact));
+
+    std::string data;
+    if (!m_writer->Write(data, TCP_RESPONSE_CHUNK_SIZE))
+      CLog::Log(LOGERROR, "JSONRPC Server: Failed to serialize the response");
+
+    if (!Queue(data.c_str(), data.size()))
+    {
+      m_writer.reset();
+      m_responses.clear();
+      m_deferred.clear();
+      return;
+    }
+
+    if (m_writer->IsDone())
+    {
+      m_writer.reset();
+      m_responses.pop_front();
+
+      // announcements sent meanwhile follow the response
+      std::string deferred;
+      deferred.swap(m_deferred);
+      Queue(deferred.c_str(), deferred.size());
+    }
+  }
+}
+
+void CTCPServer::CTCPClient::UpdateEvents()
+{
+  // stop reading requests while a response is sent and wait for the client
+  // to read what's queued, the reactor reports pending requests on resuming
+  const bool readable = m_responses.empty();
+  const bool writable = !m_output.empty();
+  if (m_reactor == NULL || m_socket == INVALID_SOCKET || (readable == m_readable && writable == m_writable))
+    return;
+
+  m_readable = readable;
+  m_writable = writable;
+  m_reactor->Modify(m_socket, writable, readable);
+}
+
+void CTCPServer::CTCPClient::SendResponse(CVariant &&response)
+{
+  CSingleLock lock (m_critSection);
+  if (m_socket == INVALID_SOCKET)
+    return;
+
+  // sent by Flush() as far as the client doesn't read it right away
+  m_responses.push_back(std::move(response));
+  Produce();
+  UpdateEvents();
 }
 
 void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
@@ -572,8 +801,9 @@ void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, in
         m_endBrackets++;
       if (m_beginBrackets > 0 && m_endBrackets > 0 && m_beginBrackets == m_endBrackets)
       {
-        std::string line = CJSONRPC::MethodCall(m_buffer, host, this);
-        Send(line.c_str(), line.size());
+        CVariant response;
+        if (CJSONRPC::MethodCall(m_buffer, host, this, response))
+          SendResponse(std::move(response));
         m_beginChar = m_beginBrackets = m_endBrackets = 0;
         m_buffer.clear();
       }
@@ -586,6 +816,16 @@ void CTCPServer::CTCPClient::Disconnect()
   if (m_socket > 0)
   {
     CSingleLock lock (m_critSection);
+    // last chance for queued data like websocket close frames
+    m_writer.reset();
+    m_responses.clear();
+    m_deferred.clear();
+    if (!m_output.empty())
+      Flush();
+    m_output.clear();
+
+    if (m_reactor != NULL)
+      m_reactor->Remove(m_socket);
     shutdown(m_socket, SHUT_RDWR);
     closesocket(m_socket);
     m_socket = INVALID_SOCKET;
@@ -596,6 +836,7 @@ void CTCPServer::CTCPClient::Copy(const CTCPClient& client)
 {
   m_new               = client.m_new;
   m_socket            = client.m_socket;
+  m_reactor           = client.m_reactor;
   m_cliaddr           = client.m_cliaddr;
   m_addrlen           = client.m_addrlen;
   m_announcementflags = client.m_announcementflags;
@@ -604,6 +845,12 @@ void CTCPServer::CTCPClient::Copy(const CTCPClient& client)
   m_beginChar         = client.m_beginChar;
   m_endChar           = client.m_endChar;
   m_buffer            = client.m_buffer;
+  m_output            = client.m_output;
+  m_readable          = client.m_readable;
+  m_writable          = client.m_writable;
+  // responses are only queued once a client has sent requests, so there are
+  // none left to copy when replacing a new client
+  m_deferred          = client.m_deferred;
 }
 
 CTCPServer::CWebSocketClient::CWebSocketClient(CWebSocket *websocket)
@@ -648,6 +895,22 @@ void CTCPServer::CWebSocketClient::Send(const char *data, unsigned int size)
     CTCPClient::Send(frames.at(index)->GetFrameData(), (unsigned int)frames.at(index)->GetFrameLength());
 }
 
+void CTCPServer::CWebSocketClient::SendResponse(CVariant &&response)
+{
+  // every call to Send() results in a separate websocket message, so the
+  // whole response is queued at once and a client which doesn't read its
+  // responses can't be throttled but only dropped
+  if (GetPendingOutput() > TCP_MAX_PENDING_OUTPUT)
+  {
+    CLog::Log(LOGWARNING, "JSONRPC Server: Client isn't reading its responses, disconnecting");
+    shutdown(m_socket, SHUT_RDWR);
+    return;
+  }
+
+  std::string data = CJSONVariantWriter::Write(response, g_advancedSettings.m_jsonOutputCompact);
+  Send(data.c_str(), data.size());
+}
+
 void CTCPServer::CWebSocketClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
 {
   bool send;
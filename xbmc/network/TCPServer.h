@@ -19,18 +19,24 @@
  *
  */
 
+#include <deque>
+#include <map>
+#include <memory>
 #include <vector>
 #include <sys/socket.h>
 
 #include "system.h"
+#include "SocketReactor.h"
 #include "interfaces/json-rpc/IClient.h"
 #include "interfaces/json-rpc/IJSONRPCAnnouncer.h"
 #include "interfaces/json-rpc/ITransportLayer.h"
 #include "threads/CriticalSection.h"
+#include "threads/SystemClock.h"
 #include "threads/Thread.h"
+#include "utils/Variant.h"
 #include "websocket/WebSocket.h"
 
-class CVariant;
+class CJSONVariantStreamWriter;
 
 namespace JSONRPC
 {
@@ -63,32 +69,56 @@ namespace JSONRPC
       //when adding a member variable, make sure to copy it in CTCPClient::Copy
       CTCPClient(const CTCPClient& client);
       CTCPClient& operator=(const CTCPClient& client);
-      virtual ~CTCPClient() { };
+      virtual ~CTCPClient();
 
       virtual int  GetPermissionFlags();
       virtual int  GetAnnouncementFlags();
       virtual bool SetAnnouncementFlags(int flags);
 
+      // queues whatever can't be sent without blocking, see Flush()
       virtual void Send(const char *data, unsigned int size);
+      // serializes the response as the client reads it, the connection isn't
+      // read meanwhile, see IsBusy()
+      virtual void SendResponse(CVariant &&response);
       virtual void PushBuffer(CTCPServer *host, const char *buffer, int length);
       virtual void Disconnect();
 
       virtual bool IsNew() const { return m_new; }
       virtual bool Closing() const { return false; }
 
+      // sends as much of the queued output as possible, false on errors
+      bool Flush();
+      size_t GetPendingOutput();
+      // whether a response is still being sent, no further requests are read until it is
+      bool IsBusy();
+
       SOCKET           m_socket;
       sockaddr_storage m_cliaddr;
       socklen_t        m_addrlen;
       CCriticalSection m_critSection;
+      CSocketReactor  *m_reactor;
 
     protected:
       void Copy(const CTCPClient& client);
+      // sends or queues data in order, false if the connection failed
+      bool Queue(const char *data, size_t size);
     private:
+      // serializes queued responses while little output is pending
+      void Produce();
+      // (un)registers for readable and writable events as needed
+      void UpdateEvents();
+
       bool m_new;
       int m_announcementflags;
       int m_beginBrackets, m_endBrackets;
       char m_beginChar, m_endChar;
       std::string m_buffer;
+      std::string m_output;
+      std::deque<CVariant> m_responses;                   // the first one is being sent
+      std::unique_ptr<CJSONVariantStreamWriter> m_writer; // for m_responses.front()
+      std::string m_deferred;                             // data sent while a response was being sent
+      bool m_readable;
+      bool m_writable;
     };
 
     class CWebSocketClient : public CTCPClient
@@ -101,6 +131,7 @@ namespace JSONRPC
       ~CWebSocketClient();
 
       virtual void Send(const char *data, unsigned int size);
+      virtual void SendResponse(CVariant &&response);
       virtual void PushBuffer(CTCPServer *host, const char *buffer, int length);
       virtual void Disconnect();
 
@@ -111,7 +142,17 @@ namespace JSONRPC
       CWebSocket *m_websocket;
     };
 
-    std::vector<CTCPClient*> m_connections;
+    bool AcceptConnections(SOCKET server);
+    bool ReadConnection(std::map<SOCKET, CTCPClient*>::iterator connection);
+    void CloseConnection(std::map<SOCKET, CTCPClient*>::iterator connection);
+
+    CSocketReactor m_reactor;
+    // connections left queued on the listeners because accepting failed
+    bool m_acceptPending;
+    XbmcThreads::EndTime m_acceptRetry;
+    std::map<SOCKET, CTCPClient*> m_connections;
+    // guards m_connections against announcements, only the server thread changes it
+    CCriticalSection m_connectionsSection;
     std::vector<SOCKET> m_servers;
     int m_port;
     bool m_nonlocal;
@@ -31,10 +31,14 @@
 #include <utility>
 
 #if defined(TARGET_POSIX)
+#include <fcntl.h>
 #include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
 #include "network/httprequesthandler/HTTPRequestHandlerUtils.h"
 #include "network/httprequesthandler/IHTTPRequestHandler.h"
 #include "settings/AdvancedSettings.h"
@@ -43,6 +47,7 @@
 #include "URL.h"
 #include "Util.h"
 #include "utils/Base64.h"
+#include "utils/CPUInfo.h"
 #include "utils/log.h"
 #include "utils/Mime.h"
 #include "utils/StringUtils.h"
@@ -67,6 +72,27 @@
 
 #define HEADER_NEWLINE        "\r\n"
 
+// size of the blocks read from streamed responses
+#define STREAM_BLOCK_SIZE     (32 * 1024)
+// size of the blocks read from files which can't be sent by the kernel
+#define FILE_BLOCK_SIZE       (64 * 1024)
+
+// libmicrohttpd can send file descriptors with sendfile()
+#if (MHD_VERSION >= 0x00094400) && defined(TARGET_POSIX)
+#define HAS_WEB_SERVER_SENDFILE
+#endif
+
+// same values as in microhttpd.h of versions defining them
+#ifndef MHD_SIZE_UNKNOWN
+#define MHD_SIZE_UNKNOWN ((uint64_t) -1LL)
+#endif
+#ifndef MHD_CONTENT_READER_END_OF_STREAM
+#define MHD_CONTENT_READER_END_OF_STREAM ((ssize_t) -1)
+#endif
+#ifndef MHD_CONTENT_READER_END_WITH_ERROR
+#define MHD_CONTENT_READER_END_WITH_ERROR ((ssize_t) -2)
+#endif
+
 typedef struct {
   std::shared_ptr<XFILE::CFile> file;
   CHttpRanges ranges;
@@ -79,6 +105,10 @@ typedef struct {
   uint64_t writePosition;
 } HttpFileDownloadContext;
 
+typedef struct {
+  std::shared_ptr<IHTTPRequestHandler> handler;
+} HttpStreamDownloadContext;
+
 CWebServer::CWebServer()
   : m_port(0),
     m_daemon_ip6(nullptr),
@@ -116,6 +146,36 @@ static MHD_Response* create_response(size_t size, void* data, int free, int copy
 #endif
 }
 
+#ifdef HAS_WEB_SERVER_SENDFILE
+// creates a response for part of a file on a local filesystem which is sent
+// without copying it through ContentReaderCallback()
+static MHD_Response* create_local_file_response(const std::string &filePath, uint64_t offset, uint64_t length)
+{
+  // anything with a protocol (e.g. smb:// or zip://) has to be read through CFile
+  const std::string localPath = CSpecialProtocol::TranslatePath(filePath);
+  if (localPath.empty() || localPath[0] != '/')
+    return nullptr;
+
+  int fd = open(localPath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return nullptr;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || offset + length > static_cast<uint64_t>(st.st_size))
+  {
+    close(fd);
+    return nullptr;
+  }
+
+  // the file descriptor is closed by libmicrohttpd with the response
+  MHD_Response *response = MHD_create_response_from_fd_at_offset64(length, fd, offset);
+  if (response == nullptr)
+    close(fd);
+
+  return response;
+}
+#endif
+
 int CWebServer::AskForAuthentication(struct MHD_Connection *connection) const
 {
   struct MHD_Response *response = create_response(0, nullptr, MHD_NO, MHD_NO);
@@ -502,6 +562,10 @@ int CWebServer::HandleRequest(const std::shared_ptr<IHTTPRequestHandler>& handle
       ret = CreateMemoryDownloadResponse(handler, response);
       break;
 
+    case HTTPStreamDownload:
+      ret = CreateStreamDownloadResponse(handler, response);
+      break;
+
     case HTTPError:
       ret = CreateErrorResponse(request.connection, responseDetails.status, request.method, response);
       break;
@@ -850,18 +914,29 @@ int CWebServer::CreateFileDownloadResponse(const std::shared_ptr<IHTTPRequestHan
     // set the initial write position
     context->ranges.GetFirstPosition(context->writePosition);
 
-    // create the response object
-    response = MHD_create_response_from_callback(totalLength, 2048,
-                                                  &CWebServer::ContentReaderCallback,
-                                                  context.get(),
-                                                  &CWebServer::ContentReaderFreeCallback);
+#ifdef HAS_WEB_SERVER_SENDFILE
+    // a single range of a local file doesn't need any multipart boundaries
+    // so it can be sent by the kernel
+    CHttpRange range;
+    if (context->rangeCountTotal == 1 && context->ranges.GetFirst(range))
+      response = create_local_file_response(filePath, range.GetFirstPosition(), range.GetLength());
+#endif
+
     if (response == nullptr)
     {
-      CLog::Log(LOGERROR, "CWebServer[%hu]: failed to create a HTTP response for %s to be filled from %s", m_port, request.pathUrl.c_str(), filePath.c_str());
-      return MHD_NO;
-    }
+      // create the response object
+      response = MHD_create_response_from_callback(totalLength, FILE_BLOCK_SIZE,
+                                                    &CWebServer::ContentReaderCallback,
+                                                    context.get(),
+                                                    &CWebServer::ContentReaderFreeCallback);
+      if (response == nullptr)
+      {
+        CLog::Log(LOGERROR, "CWebServer[%hu]: failed to create a HTTP response for %s to be filled from %s", m_port, request.pathUrl.c_str(), filePath.c_str());
+        return MHD_NO;
+      }
 
-    context.release(); // ownership was passed to mhd
+      context.release(); // ownership was passed to mhd
+    }
 
     // add Content-Range header
     if (ranged)
@@ -886,6 +961,43 @@ int CWebServer::CreateFileDownloadResponse(const std::shared_ptr<IHTTPRequestHan
   return MHD_YES;
 }
 
+int CWebServer::CreateStreamDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, struct MHD_Response *&response) const
+{
+  if (handler == nullptr)
+    return MHD_NO;
+
+  const HTTPRequest &request = handler->GetRequest();
+  if (request.method == HEAD)
+  {
+    response = create_response(0, nullptr, MHD_NO, MHD_NO);
+    if (response == nullptr)
+    {
+      CLog::Log(LOGERROR, "CWebServer[%hu]: failed to create a HTTP HEAD response for %s", m_port, request.pathUrl.c_str());
+      return MHD_NO;
+    }
+
+    return MHD_YES;
+  }
+
+  std::unique_ptr<HttpStreamDownloadContext> context(new HttpStreamDownloadContext());
+  context->handler = handler;
+
+  // the length is unknown so the response is sent with chunked transfer encoding
+  response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, STREAM_BLOCK_SIZE,
+                                                &CWebServer::StreamReaderCallback,
+                                                context.get(),
+                                                &CWebServer::StreamReaderFreeCallback);
+  if (response == nullptr)
+  {
+    CLog::Log(LOGERROR, "CWebServer[%hu]: failed to create a streamed HTTP response for %s", m_port, request.pathUrl.c_str());
+    return MHD_NO;
+  }
+
+  context.release(); // ownership was passed to mhd
+
+  return MHD_YES;
+}
+
 int CWebServer::CreateErrorResponse(struct MHD_Connection *connection, int responseType, HTTPMethod method, struct MHD_Response *&response) const
 {
   size_t payloadSize = 0;
@@ -1087,6 +1199,39 @@ void CWebServer::ContentReaderFreeCallback(void *cls)
     CLog::Log(LOGDEBUG, "CWebServer [OUT] done");
 }
 
+#if (MHD_VERSION >= 0x00090200)
+ssize_t CWebServer::StreamReaderCallback(void *cls, uint64_t pos, char *buf, size_t max)
+#elif (MHD_VERSION >= 0x00040001)
+int CWebServer::StreamReaderCallback(void *cls, uint64_t pos, char *buf, int max)
+#else   //libmicrohttpd < 0.4.0
+int CWebServer::StreamReaderCallback(void *cls, size_t pos, char *buf, int max)
+#endif
+{
+  HttpStreamDownloadContext *context = (HttpStreamDownloadContext *)cls;
+  if (context == nullptr || context->handler == nullptr)
+    return MHD_CONTENT_READER_END_WITH_ERROR;
+
+  ssize_t written = context->handler->ReadResponseData(buf, static_cast<size_t>(max));
+  if (written < 0)
+    return MHD_CONTENT_READER_END_WITH_ERROR;
+  if (written == 0)
+    return MHD_CONTENT_READER_END_OF_STREAM;
+
+  if (g_advancedSettings.CanLogComponent(LOGWEBSERVER))
+    CLog::Log(LOGDEBUG, "CWebServer [OUT] streamed %zd bytes from %" PRIu64, written, static_cast<uint64_t>(pos));
+
+  return written;
+}
+
+void CWebServer::StreamReaderFreeCallback(void *cls)
+{
+  HttpStreamDownloadContext *context = (HttpStreamDownloadContext *)cls;
+  delete context;
+
+  if (g_advancedSettings.CanLogComponent(LOGWEBSERVER))
+    CLog::Log(LOGDEBUG, "CWebServer [OUT] done");
+}
+
 // local helper
 static void panicHandlerForMHD(void* unused, const char* file, unsigned int line, const char *reason)
 {
@@ -1116,25 +1261,63 @@ static void logFromMHD(void* unused, const char* fmt, va_list ap)
   }
 }
 
+unsigned int CWebServer::GetThreadPoolSize()
+{
+  unsigned int threadPoolSize = g_advancedSettings.m_webserverThreadPoolSize;
+#if (MHD_VERSION >= 0x00040002) && (MHD_VERSION < 0x00090B01)
+  // without a thread pool only one request can be handled at a time. Most of
+  // the time is spent waiting for (network) filesystems so use more threads
+  // than there are cores
+  if (threadPoolSize == 0)
+    threadPoolSize = std::min(std::max(g_cpuInfo.getCPUCount() * 2, 4), 16);
+#endif
+
+  return std::min(threadPoolSize, g_advancedSettings.m_webserverMaxConnections);
+}
+
 struct MHD_Daemon* CWebServer::StartMHD(unsigned int flags, int port)
 {
   unsigned int timeout = 60 * 60 * 24;
+  unsigned int threadPoolSize = GetThreadPoolSize();
 
 #if MHD_VERSION >= 0x00040500
   MHD_set_panic_func(&panicHandlerForMHD, nullptr);
 #endif
 
+#if (MHD_VERSION >= 0x00040002)
+  if (threadPoolSize > 0)
+  {
+    CLog::Log(LOGDEBUG, "CWebServer[%d]: using a pool of %u threads", port, threadPoolSize);
+    return MHD_start_daemon(flags |
+                            // the connections are spread over the threads of the pool
+                            MHD_USE_SELECT_INTERNALLY
+#if (MHD_VERSION >= 0x00040001)
+                            | MHD_USE_DEBUG /* Print MHD error messages to log */
+#endif
+                            ,
+                            port,
+                            nullptr,
+                            nullptr,
+                            &CWebServer::AnswerToConnection,
+                            this,
+
+                            MHD_OPTION_THREAD_POOL_SIZE, threadPoolSize,
+                            MHD_OPTION_CONNECTION_LIMIT, g_advancedSettings.m_webserverMaxConnections,
+                            MHD_OPTION_CONNECTION_TIMEOUT, timeout,
+                            MHD_OPTION_URI_LOG_CALLBACK, &CWebServer::UriRequestLogger, this,
+#if (MHD_VERSION >= 0x00040001)
+                            MHD_OPTION_EXTERNAL_LOGGER, &logFromMHD, nullptr,
+#endif // MHD_VERSION >= 0x00040001
+                            MHD_OPTION_THREAD_STACK_SIZE, m_thread_stacksize,
+                            MHD_OPTION_END);
+  }
+#endif
+
   return MHD_start_daemon(flags |
-#if (MHD_VERSION >= 0x00040002) && (MHD_VERSION < 0x00090B01)
-                          // use main thread for each connection, can only handle one request at a
-                          // time [unless you set the thread pool size]
-                          MHD_USE_SELECT_INTERNALLY
-#else
                           // one thread per connection
                           // WARNING: set MHD_OPTION_CONNECTION_TIMEOUT to something higher than 1
                           // otherwise on libmicrohttpd 0.4.4-1 it spins a busy loop
                           MHD_USE_THREAD_PER_CONNECTION
-#endif
 #if (MHD_VERSION >= 0x00040001)
                           | MHD_USE_DEBUG /* Print MHD error messages to log */
 #endif 
@@ -1145,10 +1328,7 @@ struct MHD_Daemon* CWebServer::StartMHD(unsigned int flags, int port)
                           &CWebServer::AnswerToConnection,
                           this,
 
-#if (MHD_VERSION >= 0x00040002) && (MHD_VERSION < 0x00090B01)
-                          MHD_OPTION_THREAD_POOL_SIZE, 4,
-#endif
-                          MHD_OPTION_CONNECTION_LIMIT, 512,
+                          MHD_OPTION_CONNECTION_LIMIT, g_advancedSettings.m_webserverMaxConnections,
                           MHD_OPTION_CONNECTION_TIMEOUT, timeout,
                           MHD_OPTION_URI_LOG_CALLBACK, &CWebServer::UriRequestLogger, this,
 #if (MHD_VERSION >= 0x00040001)
@@ -76,6 +76,7 @@ protected:
 
 private:
   struct MHD_Daemon* StartMHD(unsigned int flags, int port);
+  static unsigned int GetThreadPoolSize();
 
   int AskForAuthentication(struct MHD_Connection *connection) const;
   bool IsAuthenticated(struct MHD_Connection *connection) const;
@@ -85,6 +86,7 @@ private:
 
   int CreateRedirect(struct MHD_Connection *connection, const std::string &strURL, struct MHD_Response *&response) const;
   int CreateFileDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, struct MHD_Response *&response) const;
+  int CreateStreamDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, struct MHD_Response *&response) const;
   int CreateErrorResponse(struct MHD_Connection *connection, int responseType, HTTPMethod method, struct MHD_Response *&response) const;
   int CreateMemoryDownloadResponse(struct MHD_Connection *connection, const void *data, size_t size, bool free, bool copy, struct MHD_Response *&response) const;
 
@@ -106,6 +108,15 @@ private:
 #endif
   static void ContentReaderFreeCallback(void *cls);
 
+#if (MHD_VERSION >= 0x00090200)
+  static ssize_t StreamReaderCallback (void *cls, uint64_t pos, char *buf, size_t max);
+#elif (MHD_VERSION >= 0x00040001)
+  static int StreamReaderCallback (void *cls, uint64_t pos, char *buf, int max);
+#else
+  static int StreamReaderCallback (void *cls, size_t pos, char *buf, int max);
+#endif
+  static void StreamReaderFreeCallback(void *cls);
+
 #if (MHD_VERSION >= 0x00040001)
   static int AnswerToConnection (void *cls, struct MHD_Connection *connection,
                         const char *url, const char *method,
@@ -26,7 +26,7 @@
 #include "interfaces/json-rpc/JSONUtils.h"
 #include "network/WebServer.h"
 #include "network/httprequesthandler/HTTPRequestHandlerUtils.h"
-#include "utils/JSONVariantWriter.h"
+#include "settings/AdvancedSettings.h"
 #include "utils/log.h"
 #include "utils/Variant.h"
 
@@ -82,19 +82,24 @@ int CHTTPJsonRpcHandler::HandleRequest()
       jsonpCallback = argument->second;
   }
 
+  bool hasResponse = false;
+  bool compact = false;
   if (isRequest)
   {
-    m_responseData = JSONRPC::CJSONRPC::MethodCall(m_requestData, &m_transportLayer, &client);
+    hasResponse = JSONRPC::CJSONRPC::MethodCall(m_requestData, &m_transportLayer, &client, m_responseObject);
+    compact = g_advancedSettings.m_jsonOutputCompact;
 
     if (!jsonpCallback.empty())
-      m_responseData = jsonpCallback + "(" + m_responseData + ");";
+    {
+      m_responseData = jsonpCallback + "(";
+      m_responseSuffix = ");";
+    }
   }
   else if (jsonpCallback.empty())
   {
     // get the whole output of JSONRPC.Introspect
-    CVariant result;
-    JSONRPC::CJSONServiceDescription::Print(result, &m_transportLayer, &client);
-    m_responseData = CJSONVariantWriter::Write(result, false);
+    JSONRPC::CJSONServiceDescription::Print(m_responseObject, &m_transportLayer, &client);
+    hasResponse = true;
   }
   else
   {
@@ -106,12 +111,24 @@ int CHTTPJsonRpcHandler::HandleRequest()
 
   m_requestData.clear();
 
-  m_responseRange.SetData(m_responseData.c_str(), m_responseData.size());
-
-  m_response.type = HTTPMemoryDownloadNoFreeCopy;
   m_response.status = MHD_HTTP_OK;
   m_response.contentType = "application/json";
-  m_response.totalLength = m_responseData.size();
+
+  if (hasResponse)
+  {
+    // serialize the response while sending it instead of keeping all of it in memory
+    m_responseWriter.reset(new CJSONVariantStreamWriter(m_responseObject, compact));
+    m_response.type = HTTPStreamDownload;
+    m_response.totalLength = 0;
+  }
+  else
+  {
+    m_responseData += m_responseSuffix;
+    m_responseRange.SetData(m_responseData.c_str(), m_responseData.size());
+
+    m_response.type = HTTPMemoryDownloadNoFreeCopy;
+    m_response.totalLength = m_responseData.size();
+  }
 
   return MHD_YES;
 }
@@ -124,6 +141,34 @@ HttpResponseRanges CHTTPJsonRpcHandler::GetResponseData() const
   return ranges;
 }
 
+ssize_t CHTTPJsonRpcHandler::ReadResponseData(char *buffer, size_t size)
+{
+  if (m_responseWriter == nullptr)
+    return -1;
+
+  // serialize the next part of the response if there isn't enough left
+  if (m_responseData.size() - m_responseDataPosition < size && !m_responseWriter->IsDone())
+  {
+    m_responseData.erase(0, m_responseDataPosition);
+    m_responseDataPosition = 0;
+
+    if (!m_responseWriter->Write(m_responseData, size - m_responseData.size()))
+    {
+      CLog::Log(LOGERROR, "JSONRPC: Failed to serialize the response");
+      return -1;
+    }
+
+    if (m_responseWriter->IsDone())
+      m_responseData += m_responseSuffix;
+  }
+
+  size_t length = std::min(size, m_responseData.size() - m_responseDataPosition);
+  memcpy(buffer, m_responseData.c_str() + m_responseDataPosition, length);
+  m_responseDataPosition += length;
+
+  return length;
+}
+
 #if (MHD_VERSION >= 0x00040001)
 bool CHTTPJsonRpcHandler::appendPostData(const char *data, size_t size)
 #else
@@ -19,11 +19,14 @@
  *
  */
 
+#include <memory>
 #include <string>
 
 #include "interfaces/json-rpc/IClient.h"
 #include "interfaces/json-rpc/ITransportLayer.h"
 #include "network/httprequesthandler/IHTTPRequestHandler.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/Variant.h"
 
 class CHTTPJsonRpcHandler : public IHTTPRequestHandler
 {
@@ -38,12 +41,14 @@ public:
   virtual int HandleRequest();
 
   virtual HttpResponseRanges GetResponseData() const;
+  virtual ssize_t ReadResponseData(char *buffer, size_t size);
 
   virtual int GetPriority() const { return 5; }
 
 protected:
   explicit CHTTPJsonRpcHandler(const HTTPRequest &request)
-    : IHTTPRequestHandler(request)
+    : IHTTPRequestHandler(request),
+      m_responseDataPosition(0)
   { }
 
 #if (MHD_VERSION >= 0x00040001)
@@ -57,6 +62,12 @@ private:
   std::string m_responseData;
   CHttpResponseRange m_responseRange;
 
+  // the response is serialized while it is being sent
+  CVariant m_responseObject;
+  std::unique_ptr<CJSONVariantStreamWriter> m_responseWriter;
+  size_t m_responseDataPosition;
+  std::string m_responseSuffix;
+
   class CHTTPTransportLayer : public JSONRPC::ITransportLayer
   {
   public:
@@ -65,7 +65,10 @@ typedef enum HTTPResponseType
   HTTPMemoryDownloadFreeNoCopy,
   // creates a HTTP response from a buffer by copying followed by freeing the buffer
   // the buffer must have been malloc'ed and not new'ed
-  HTTPMemoryDownloadFreeCopy
+  HTTPMemoryDownloadFreeCopy,
+  // creates a HTTP response of unknown length (using chunked transfer encoding)
+  // which is read from the request handler while it is being sent
+  HTTPStreamDownload
 } HTTPResponseType;
 
 typedef struct HTTPRequest
@@ -172,6 +175,19 @@ public:
   */
   virtual std::string GetResponseFile() const { return ""; }
 
+  /*!
+  * \brief Reads the next part of the response data into the given buffer.
+  *
+  * \details This is only used if the response type is HTTPStreamDownload.
+  * It's called from the web server's thread until the end of the response
+  * data has been reached.
+  *
+  * \param buffer Buffer to write the response data to
+  * \param size Maximum number of bytes to write
+  * \return Number of bytes written, 0 at the end of the response data or -1 on error.
+  */
+  virtual ssize_t ReadResponseData(char *buffer, size_t size) { return -1; }
+
   /*!
   * \brief Returns the HTTP request handled by the HTTP request handler.
   */
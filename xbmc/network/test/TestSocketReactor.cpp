@@ -0,0 +1,143 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+
+#ifndef TARGET_WINDOWS
+
+#include "network/SocketReactor.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+class TestSocketReactor : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    ASSERT_TRUE(reactor.Initialize());
+    for (int i = 0; i < 2; i++)
+    {
+      ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, pairs[i]));
+      ASSERT_TRUE(CSocketReactor::SetNonBlocking(pairs[i][0]));
+    }
+  }
+
+  void TearDown() override
+  {
+    reactor.Deinitialize();
+    for (int i = 0; i < 2; i++)
+    {
+      close(pairs[i][0]);
+      close(pairs[i][1]);
+    }
+  }
+
+  CSocketReactor reactor;
+  int pairs[2][2];
+  std::vector<CSocketReactor::Event> events;
+};
+
+TEST_F(TestSocketReactor, Timeout)
+{
+  ASSERT_TRUE(reactor.Add(pairs[0][0]));
+  EXPECT_TRUE(reactor.Wait(10, events));
+  EXPECT_TRUE(events.empty());
+}
+
+TEST_F(TestSocketReactor, OnlyReadySockets)
+{
+  ASSERT_TRUE(reactor.Add(pairs[0][0]));
+  ASSERT_TRUE(reactor.Add(pairs[1][0]));
+
+  ASSERT_EQ(4, write(pairs[1][1], "ping", 4));
+  ASSERT_TRUE(reactor.Wait(1000, events));
+  ASSERT_EQ(1U, events.size());
+  EXPECT_EQ(pairs[1][0], events[0].socket);
+  EXPECT_TRUE((events[0].events & CSocketReactor::Readable) != 0);
+
+  // drain the socket until it would block
+  char buffer[16];
+  EXPECT_EQ(4, read(pairs[1][0], buffer, sizeof(buffer)));
+  EXPECT_EQ(-1, read(pairs[1][0], buffer, sizeof(buffer)));
+  EXPECT_TRUE(CSocketReactor::WouldBlock());
+
+  EXPECT_TRUE(reactor.Wait(10, events));
+  EXPECT_TRUE(events.empty());
+}
+
+TEST_F(TestSocketReactor, Writable)
+{
+  ASSERT_TRUE(reactor.Add(pairs[0][0], true));
+  ASSERT_TRUE(reactor.Wait(1000, events));
+  ASSERT_EQ(1U, events.size());
+  EXPECT_TRUE((events[0].events & CSocketReactor::Writable) != 0);
+
+  // not interested in writing anymore
+  ASSERT_TRUE(reactor.Modify(pairs[0][0], false));
+  EXPECT_TRUE(reactor.Wait(10, events));
+  EXPECT_TRUE(events.empty());
+
+  EXPECT_TRUE(CSocketReactor::WaitWritable(pairs[0][0], 1000));
+}
+
+TEST_F(TestSocketReactor, NotReadable)
+{
+  ASSERT_TRUE(reactor.Add(pairs[0][0]));
+  ASSERT_TRUE(reactor.Modify(pairs[0][0], false, false));
+
+  ASSERT_EQ(4, write(pairs[0][1], "ping", 4));
+  EXPECT_TRUE(reactor.Wait(10, events));
+  EXPECT_TRUE(events.empty());
+
+  // data that arrived in the meantime is reported once reading is resumed
+  ASSERT_TRUE(reactor.Modify(pairs[0][0], false, true));
+  ASSERT_TRUE(reactor.Wait(1000, events));
+  ASSERT_EQ(1U, events.size());
+  EXPECT_TRUE((events[0].events & CSocketReactor::Readable) != 0);
+}
+
+TEST_F(TestSocketReactor, Closed)
+{
+  ASSERT_TRUE(reactor.Add(pairs[0][0]));
+  close(pairs[0][1]);
+  pairs[0][1] = -1;
+
+  ASSERT_TRUE(reactor.Wait(1000, events));
+  ASSERT_EQ(1U, events.size());
+  EXPECT_TRUE((events[0].events & CSocketReactor::Readable) != 0);
+
+  char buffer[16];
+  EXPECT_EQ(0, read(pairs[0][0], buffer, sizeof(buffer)));
+}
+
+TEST_F(TestSocketReactor, Remove)
+{
+  ASSERT_TRUE(reactor.Add(pairs[0][0]));
+  reactor.Remove(pairs[0][0]);
+
+  ASSERT_EQ(4, write(pairs[0][1], "ping", 4));
+  EXPECT_TRUE(reactor.Wait(10, events));
+  EXPECT_TRUE(events.empty());
+}
+
+#endif
@@ -787,4 +787,60 @@ TEST_F(TestWebServer, CanGetCachedRangedFileWithNewerIfRange)
   curl.SetRequestHeader(MHD_HTTP_HEADER_IF_RANGE, lastModifiedNewer.GetAsRFC1123DateTime());
   ASSERT_TRUE(curl.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
   CheckRangesTestFileResponse(curl, result, ranges);
-}
\ No newline at end of file
+}
+TEST_F(TestWebServer, CanGetRangedLargeLocalFile)
+{
+  // single ranges of a local file are sent from its file descriptor, make the
+  // file span several blocks of ContentReaderCallback() to compare the two
+  const size_t fileSize = 300 * 1024;
+  std::string fileContent(fileSize, ' ');
+  for (size_t i = 0; i < fileSize; i++)
+    fileContent[i] = 'a' + (i * 7) % 26;
+
+  CFile *file = XBMC_CREATETEMPFILE(".txt");
+  ASSERT_TRUE(file != nullptr);
+  ASSERT_EQ(static_cast<ssize_t>(fileSize), file->Write(fileContent.c_str(), fileSize));
+  file->Flush();
+  const std::string filePath = XBMC_TEMPFILEPATH(file);
+
+  CMediaSource source;
+  source.strName = "WebServer Temp";
+  source.strPath = URIUtils::GetDirectory(filePath);
+  source.vecPaths.push_back(source.strPath);
+  source.m_allowSharing = true;
+  source.m_iDriveType = CMediaSource::SOURCE_TYPE_LOCAL;
+  source.m_iLockMode = LOCK_MODE_EVERYONE;
+  source.m_ignore = true;
+  CMediaSourceSettings::GetInstance().AddShare("videos", source);
+
+  const std::string url = GetUrl(URIUtils::AddFileToFolder("vfs", CURL::Encode(filePath)));
+
+  // the whole file
+  std::string result;
+  CCurlFile curl;
+  ASSERT_TRUE(curl.Get(url, result));
+  EXPECT_TRUE(curl.GetHttpHeader().GetProtoLine().find(StringUtils::Format(" %d ", MHD_HTTP_OK)) != std::string::npos);
+  EXPECT_EQ(fileSize, result.size());
+  EXPECT_TRUE(result == fileContent);
+
+  // a range starting and ending within blocks
+  const uint64_t first = 100 * 1024 + 17;
+  const uint64_t last = 250 * 1024 + 3;
+  CCurlFile rangedCurl;
+  rangedCurl.SetRequestHeader(MHD_HTTP_HEADER_RANGE, GenerateRangeHeaderValue(first, last));
+  ASSERT_TRUE(rangedCurl.Get(url, result));
+  const CHttpHeader& httpHeader = rangedCurl.GetHttpHeader();
+  EXPECT_TRUE(httpHeader.GetProtoLine().find(StringUtils::Format(" %d ", MHD_HTTP_PARTIAL_CONTENT)) != std::string::npos);
+  EXPECT_STREQ(HttpRangeUtils::GenerateContentRangeHeaderValue(first, last, fileSize).c_str(), httpHeader.GetValue(MHD_HTTP_HEADER_CONTENT_RANGE).c_str());
+  EXPECT_STREQ(StringUtils::Format("%u", static_cast<unsigned int>(last - first + 1)).c_str(), httpHeader.GetValue(MHD_HTTP_HEADER_CONTENT_LENGTH).c_str());
+  EXPECT_EQ(last - first + 1, result.size());
+  EXPECT_TRUE(result == fileContent.substr(first, last - first + 1));
+
+  // the end of the file like a player seeking into it
+  CCurlFile seekCurl;
+  seekCurl.SetRequestHeader(MHD_HTTP_HEADER_RANGE, StringUtils::Format("bytes=%u-", static_cast<unsigned int>(fileSize / 2 + 1)));
+  ASSERT_TRUE(seekCurl.Get(url, result));
+  EXPECT_TRUE(result == fileContent.substr(fileSize / 2 + 1));
+
+  XBMC_DELETETEMPFILE(file);
+}
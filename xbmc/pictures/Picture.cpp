@@ -26,6 +26,7 @@
 #include <algorithm>
 
 #include "Picture.h"
+#include "PictureScaler.h"
 #include "URL.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
@@ -343,6 +344,16 @@ bool CPicture::ScaleImage(uint8_t *in_pixels, unsigned int in_width, unsigned in
                           uint8_t *out_pixels, unsigned int out_width, unsigned int out_height, unsigned int out_pitch,
                           CPictureScalingAlgorithm::Algorithm scalingAlgorithm /* = CPictureScalingAlgorithm::NoAlgorithm */)
 {
+  if (CPictureScalingAlgorithm::IsBuiltIn(scalingAlgorithm))
+  {
+    if (scalingAlgorithm == CPictureScalingAlgorithm::NoAlgorithm)
+      scalingAlgorithm = CPictureScalingAlgorithm::Default;
+
+    CPictureScaler::Filter filter = scalingAlgorithm == CPictureScalingAlgorithm::FastLanczos ? CPictureScaler::Lanczos : CPictureScaler::AveragingArea;
+    return CPictureScaler::Scale(in_pixels, in_width, in_height, in_pitch,
+                                 out_pixels, out_width, out_height, out_pitch, filter);
+  }
+
   struct SwsContext *context = sws_getContext(in_width, in_height, AV_PIX_FMT_BGRA,
                                                          out_width, out_height, AV_PIX_FMT_BGRA,
                                                          CPictureScalingAlgorithm::ToSwscale(scalingAlgorithm), NULL, NULL, NULL);
@@ -0,0 +1,357 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "PictureScaler.h"
+#include "utils/CPUInfo.h"
+#include "utils/ParallelJobs.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP > 1)
+#include <emmintrin.h>
+#define HAS_SCALER_SSE2
+#if defined(__GNUC__)
+#include <immintrin.h>
+#define HAS_SCALER_AVX2
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER)
+#include <immintrin.h>
+#define HAS_SCALER_AVX2
+#define TARGET_AVX2
+#endif
+#endif
+
+// bands of rows scaled by one thread are at least this high, the rows shared
+// with the neighbouring bands are filtered horizontally by both of them
+#define SCALER_MIN_BAND_ROWS 32
+
+namespace
+{
+const double PI = 3.14159265358979323846;
+
+// the weights of the input samples for every output sample in one direction
+struct CFilterTaps
+{
+  unsigned int taps; // number of weights of every output sample
+  std::vector<unsigned int> first; // first input sample of every output sample
+  std::vector<float> weights; // taps weights of every output sample
+  std::vector<float> weights4; // weights repeated for the 4 channels of a pixel
+};
+
+double Lanczos3(double x)
+{
+  x = fabs(x);
+  if (x < 1e-8)
+    return 1.0;
+  if (x >= 3.0)
+    return 0.0;
+
+  const double px = PI * x;
+  return 3.0 * sin(px) * sin(px / 3.0) / (px * px);
+}
+
+CFilterTaps CreateTaps(unsigned int inSize, unsigned int outSize, CPictureScaler::Filter filter)
+{
+  const double ratio = (double)inSize / outSize;
+  const bool area = filter == CPictureScaler::AveragingArea && ratio > 1.0;
+  // distance from the center with a non-zero weight in input samples
+  const double support = filter == CPictureScaler::Lanczos ? 3.0 * std::max(ratio, 1.0) : 1.0;
+
+  // determine the input samples contributing to every output sample
+  std::vector<int> low(outSize), high(outSize);
+  CFilterTaps taps;
+  taps.taps = 1;
+  for (unsigned int i = 0; i < outSize; i++)
+  {
+    if (area)
+    {
+      low[i] = (int)floor(i * ratio);
+      high[i] = (int)ceil((i + 1) * ratio) - 1;
+    }
+    else
+    {
+      const double center = (i + 0.5) * ratio - 0.5;
+      low[i] = (int)floor(center - support) + 1;
+      high[i] = (int)ceil(center + support) - 1;
+    }
+    low[i] = std::max(low[i], 0);
+    high[i] = std::min(high[i], (int)inSize - 1);
+    taps.taps = std::max(taps.taps, (unsigned int)(high[i] - low[i] + 1));
+  }
+
+  // every output sample uses the same number of weights, the ones outside of
+  // its window are zero
+  taps.first.resize(outSize);
+  taps.weights.resize(outSize * taps.taps);
+  for (unsigned int i = 0; i < outSize; i++)
+  {
+    const unsigned int first = std::min((unsigned int)low[i], inSize - taps.taps);
+    const double center = (i + 0.5) * ratio - 0.5;
+    float *weights = &taps.weights[i * taps.taps];
+    double sum = 0.0;
+    for (unsigned int k = 0; k < taps.taps; k++)
+    {
+      const int j = first + k;
+      double weight = 0.0;
+      if (j >= low[i] && j <= high[i])
+      {
+        if (area)
+          weight = std::min((i + 1) * ratio, j + 1.0) - std::max(i * ratio, (double)j);
+        else if (filter == CPictureScaler::Lanczos)
+          weight = Lanczos3((j - center) / std::max(ratio, 1.0));
+        else
+          weight = 1.0 - fabs(j - center);
+        weight = std::max(weight, 0.0);
+      }
+      weights[k] = (float)weight;
+      sum += weight;
+    }
+
+    // samples outside of the image are left out, so normalize what remains
+    if (sum > 0.0)
+    {
+      for (unsigned int k = 0; k < taps.taps; k++)
+        weights[k] = (float)(weights[k] / sum);
+    }
+    else
+      weights[std::min((unsigned int)low[i] - first, taps.taps - 1)] = 1.0f;
+
+    taps.first[i] = first;
+  }
+
+  taps.weights4.resize(taps.weights.size() * 4);
+  for (size_t i = 0; i < taps.weights.size(); i++)
+    std::fill_n(taps.weights4.begin() + i * 4, 4, taps.weights[i]);
+
+  return taps;
+}
+
+inline uint8_t ToPixel(float value)
+{
+  return (uint8_t)std::min(std::max(lrintf(value), 0L), 255L);
+}
+
+// filters one row of pixels into out_width * 4 floats
+void HorizontalScalar(const uint8_t *src, float *dst, unsigned int outWidth, const CFilterTaps &taps)
+{
+  for (unsigned int x = 0; x < outWidth; x++)
+  {
+    const uint8_t *pixel = src + taps.first[x] * 4;
+    const float *weights = &taps.weights[x * taps.taps];
+    float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (unsigned int k = 0; k < taps.taps; k++, pixel += 4)
+    {
+      for (unsigned int c = 0; c < 4; c++)
+        sum[c] += weights[k] * pixel[c];
+    }
+    memcpy(dst + x * 4, sum, sizeof(sum));
+  }
+}
+
+// filters taps rows of floats, stride floats apart, into one row of pixels
+void VerticalScalar(const float *rows, size_t stride, const float *weights, unsigned int taps, uint8_t *dst, unsigned int outWidth)
+{
+  for (unsigned int i = 0; i < outWidth * 4; i++)
+  {
+    float sum = 0.0f;
+    for (unsigned int k = 0; k < taps; k++)
+      sum += weights[k] * rows[k * stride + i];
+    dst[i] = ToPixel(sum);
+  }
+}
+
+#ifdef HAS_SCALER_SSE2
+inline __m128 LoadPixelSSE2(const uint8_t *pixel)
+{
+  int32_t value;
+  memcpy(&value, pixel, sizeof(value));
+  const __m128i zero = _mm_setzero_si128();
+  __m128i channels = _mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero);
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(channels, zero));
+}
+
+inline void StorePixelSSE2(uint8_t *dst, __m128 value)
+{
+  __m128i channels = _mm_cvtps_epi32(value);
+  channels = _mm_packs_epi32(channels, channels);
+  int32_t pixel = _mm_cvtsi128_si32(_mm_packus_epi16(channels, channels));
+  memcpy(dst, &pixel, sizeof(pixel));
+}
+
+void HorizontalSSE2(const uint8_t *src, float *dst, unsigned int outWidth, const CFilterTaps &taps)
+{
+  for (unsigned int x = 0; x < outWidth; x++)
+  {
+    const uint8_t *pixel = src + taps.first[x] * 4;
+    const float *weights = &taps.weights4[x * taps.taps * 4];
+    __m128 sum = _mm_setzero_ps();
+    for (unsigned int k = 0; k < taps.taps; k++)
+      sum = _mm_add_ps(sum, _mm_mul_ps(LoadPixelSSE2(pixel + k * 4), _mm_loadu_ps(weights + k * 4)));
+    _mm_storeu_ps(dst + x * 4, sum);
+  }
+}
+
+void VerticalSSE2(const float *rows, size_t stride, const float *weights, unsigned int taps, uint8_t *dst, unsigned int outWidth)
+{
+  unsigned int x = 0;
+  // four pixels at once so they can be packed into a single store
+  for (; x + 4 <= outWidth; x += 4)
+  {
+    __m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps(), sum2 = _mm_setzero_ps(), sum3 = _mm_setzero_ps();
+    const float *row = rows + x * 4;
+    for (unsigned int k = 0; k < taps; k++, row += stride)
+    {
+      const __m128 weight = _mm_set1_ps(weights[k]);
+      sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(row), weight));
+      sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(row + 4), weight));
+      sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(row + 8), weight));
+      sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_loadu_ps(row + 12), weight));
+    }
+    __m128i pixels01 = _mm_packs_epi32(_mm_cvtps_epi32(sum0), _mm_cvtps_epi32(sum1));
+    __m128i pixels23 = _mm_packs_epi32(_mm_cvtps_epi32(sum2), _mm_cvtps_epi32(sum3));
+    _mm_storeu_si128((__m128i*)(dst + x * 4), _mm_packus_epi16(pixels01, pixels23));
+  }
+
+  for (; x < outWidth; x++)
+  {
+    __m128 sum = _mm_setzero_ps();
+    const float *row = rows + x * 4;
+    for (unsigned int k = 0; k < taps; k++, row += stride)
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(row), _mm_set1_ps(weights[k])));
+    StorePixelSSE2(dst + x * 4, sum);
+  }
+}
+#endif
+
+#ifdef HAS_SCALER_AVX2
+TARGET_AVX2 void HorizontalAVX2(const uint8_t *src, float *dst, unsigned int outWidth, const CFilterTaps &taps)
+{
+  for (unsigned int x = 0; x < outWidth; x++)
+  {
+    const uint8_t *pixel = src + taps.first[x] * 4;
+    const float *weights = &taps.weights4[x * taps.taps * 4];
+    // two neighbouring pixels at once
+    __m256 sum2 = _mm256_setzero_ps();
+    unsigned int k = 0;
+    for (; k + 2 <= taps.taps; k += 2)
+    {
+      __m256 pixels = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(pixel + k * 4))));
+      sum2 = _mm256_add_ps(sum2, _mm256_mul_ps(pixels, _mm256_loadu_ps(weights + k * 4)));
+    }
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum2), _mm256_extractf128_ps(sum2, 1));
+    if (k < taps.taps)
+      sum = _mm_add_ps(sum, _mm_mul_ps(LoadPixelSSE2(pixel + k * 4), _mm_loadu_ps(weights + k * 4)));
+    _mm_storeu_ps(dst + x * 4, sum);
+  }
+}
+
+TARGET_AVX2 void VerticalAVX2(const float *rows, size_t stride, const float *weights, unsigned int taps, uint8_t *dst, unsigned int outWidth)
+{
+  // packing works within the 128-bit lanes, this puts the pixels back in order
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+  unsigned int x = 0;
+  for (; x + 8 <= outWidth; x += 8)
+  {
+    __m256 sum0 = _mm256_setzero_ps(), sum1 = _mm256_setzero_ps(), sum2 = _mm256_setzero_ps(), sum3 = _mm256_setzero_ps();
+    const float *row = rows + x * 4;
+    for (unsigned int k = 0; k < taps; k++, row += stride)
+    {
+      const __m256 weight = _mm256_set1_ps(weights[k]);
+      sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(row), weight));
+      sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(_mm256_loadu_ps(row + 8), weight));
+      sum2 = _mm256_add_ps(sum2, _mm256_mul_ps(_mm256_loadu_ps(row + 16), weight));
+      sum3 = _mm256_add_ps(sum3, _mm256_mul_ps(_mm256_loadu_ps(row + 24), weight));
+    }
+    __m256i pixels01 = _mm256_packs_epi32(_mm256_cvtps_epi32(sum0), _mm256_cvtps_epi32(sum1));
+    __m256i pixels23 = _mm256_packs_epi32(_mm256_cvtps_epi32(sum2), _mm256_cvtps_epi32(sum3));
+    __m256i pixels = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(pixels01, pixels23), order);
+    _mm256_storeu_si256((__m256i*)(dst + x * 4), pixels);
+  }
+
+  // avoid the penalty of mixing AVX and SSE code
+  _mm256_zeroupper();
+  VerticalSSE2(rows + x * 4, stride, weights, taps, dst + x * 4, outWidth - x);
+}
+#endif
+
+typedef void (*HorizontalFunc)(const uint8_t *src, float *dst, unsigned int outWidth, const CFilterTaps &taps);
+typedef void (*VerticalFunc)(const float *rows, size_t stride, const float *weights, unsigned int taps, uint8_t *dst, unsigned int outWidth);
+}
+
+bool CPictureScaler::Scale(const uint8_t *in_pixels, unsigned int in_width, unsigned int in_height, unsigned int in_pitch,
+                           uint8_t *out_pixels, unsigned int out_width, unsigned int out_height, unsigned int out_pitch,
+                           Filter filter, unsigned int threads /* = 0 */, unsigned int cpuFeatures /* = ~0U */)
+{
+  if (in_pixels == nullptr || out_pixels == nullptr ||
+      in_width == 0 || in_height == 0 || out_width == 0 || out_height == 0)
+    return false;
+
+  HorizontalFunc horizontal = HorizontalScalar;
+  VerticalFunc vertical = VerticalScalar;
+  cpuFeatures &= g_cpuInfo.GetCPUFeatures();
+#ifdef HAS_SCALER_SSE2
+  if (cpuFeatures & CPU_FEATURE_SSE2)
+  {
+    horizontal = HorizontalSSE2;
+    vertical = VerticalSSE2;
+  }
+#endif
+#ifdef HAS_SCALER_AVX2
+  if ((cpuFeatures & CPU_FEATURE_AVX2) && (cpuFeatures & CPU_FEATURE_SSE2))
+  {
+    horizontal = HorizontalAVX2;
+    vertical = VerticalAVX2;
+  }
+#endif
+
+  const CFilterTaps horizontalTaps = CreateTaps(in_width, out_width, filter);
+  const CFilterTaps verticalTaps = CreateTaps(in_height, out_height, filter);
+
+  if (threads == 0)
+    threads = CParallelJobs::GetThreads((size_t)out_width * out_height);
+  const size_t bands = std::max<size_t>(std::min<size_t>(threads, out_height / SCALER_MIN_BAND_ROWS), 1);
+  const size_t stride = (size_t)out_width * 4;
+
+  CParallelJobs::Run(bands, threads, [&](size_t band)
+  {
+    const unsigned int firstRow = (unsigned int)(out_height * band / bands);
+    const unsigned int lastRow = (unsigned int)(out_height * (band + 1) / bands);
+
+    // the input rows needed by the output rows of this band
+    const unsigned int firstInput = verticalTaps.first[firstRow];
+    const unsigned int lastInput = verticalTaps.first[lastRow - 1] + verticalTaps.taps;
+    std::vector<float> buffer((lastInput - firstInput) * stride);
+    for (unsigned int y = firstInput; y < lastInput; y++)
+      horizontal(in_pixels + (size_t)y * in_pitch, &buffer[(y - firstInput) * stride], out_width, horizontalTaps);
+
+    for (unsigned int y = firstRow; y < lastRow; y++)
+    {
+      vertical(&buffer[(verticalTaps.first[y] - firstInput) * stride], stride,
+               &verticalTaps.weights[y * verticalTaps.taps], verticalTaps.taps,
+               out_pixels + (size_t)y * out_pitch, out_width);
+    }
+  });
+
+  return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+
+/*!
+ \brief Scales 32-bit BGRA images with a separable filter.
+
+ Used instead of swscale for the "fast_*" algorithms of
+ CPictureScalingAlgorithm. Every row is filtered horizontally into a
+ floating point buffer which is then filtered vertically, using AVX2 or SSE2
+ where the CPU supports it. Large images are split into bands of rows which
+ are scaled in parallel by CParallelJobs.
+ */
+class CPictureScaler
+{
+public:
+  enum Filter
+  {
+    AveragingArea, ///< \brief mean of the covered pixels, bilinear when enlarging
+    Lanczos        ///< \brief windowed sinc with three lobes
+  };
+
+  /*!
+   \brief Scale an image
+   \param threads the maximum number of threads to use, 0 to decide by the image size
+   \param cpuFeatures the CPU_FEATURE_* flags which may be used in addition to
+   being supported by the CPU, mainly to compare the implementations
+   \return false if one of the images is empty
+   */
+  static bool Scale(const uint8_t *in_pixels, unsigned int in_width, unsigned int in_height, unsigned int in_pitch,
+                    uint8_t *out_pixels, unsigned int out_width, unsigned int out_height, unsigned int out_pitch,
+                    Filter filter, unsigned int threads = 0, unsigned int cpuFeatures = ~0U);
+
+private:
+  CPictureScaler() = delete;
+};
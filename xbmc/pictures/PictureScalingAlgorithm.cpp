@@ -30,17 +30,19 @@ extern "C" {
 CPictureScalingAlgorithm::Algorithm CPictureScalingAlgorithm::Default = CPictureScalingAlgorithm::Bicubic;
 
 CPictureScalingAlgorithm::AlgorithmMap CPictureScalingAlgorithm::m_algorithms = {
-  { FastBilinear,     { "fast_bilinear",    SWS_FAST_BILINEAR } },
-  { Bilinear,         { "bilinear",         SWS_BILINEAR } },
-  { Bicubic,          { "bicubic",          SWS_BICUBIC } },
-  { Experimental,     { "experimental",     SWS_X } },
-  { NearestNeighbor,  { "nearest_neighbor", SWS_POINT } },
-  { AveragingArea,    { "averaging_area",   SWS_AREA } },
-  { Bicublin,         { "bicublin",         SWS_BICUBLIN } },
-  { Gaussian,         { "gaussian",         SWS_GAUSS } },
-  { Sinc,             { "sinc",             SWS_SINC } },
-  { Lanczos,          { "lanczos",          SWS_LANCZOS } },
-  { BicubicSpline,    { "bicubic_spline",   SWS_SPLINE } },
+  { FastBilinear,       { "fast_bilinear",        SWS_FAST_BILINEAR,  false } },
+  { Bilinear,           { "bilinear",             SWS_BILINEAR,       false } },
+  { Bicubic,            { "bicubic",              SWS_BICUBIC,        false } },
+  { Experimental,       { "experimental",         SWS_X,              false } },
+  { NearestNeighbor,    { "nearest_neighbor",     SWS_POINT,          false } },
+  { AveragingArea,      { "averaging_area",       SWS_AREA,           false } },
+  { Bicublin,           { "bicublin",             SWS_BICUBLIN,       false } },
+  { Gaussian,           { "gaussian",             SWS_GAUSS,          false } },
+  { Sinc,               { "sinc",                 SWS_SINC,           false } },
+  { Lanczos,            { "lanczos",              SWS_LANCZOS,        false } },
+  { BicubicSpline,      { "bicubic_spline",       SWS_SPLINE,         false } },
+  { FastAveragingArea,  { "fast_averaging_area",  SWS_AREA,           true } },
+  { FastLanczos,        { "fast_lanczos",         SWS_LANCZOS,        true } },
 };
 
 CPictureScalingAlgorithm::Algorithm CPictureScalingAlgorithm::FromString(const std::string& scalingAlgorithm)
@@ -75,3 +77,15 @@ int CPictureScalingAlgorithm::ToSwscale(Algorithm scalingAlgorithm)
 
   return ToSwscale(Default);
 }
+
+bool CPictureScalingAlgorithm::IsBuiltIn(Algorithm scalingAlgorithm)
+{
+  if (scalingAlgorithm == NoAlgorithm)
+    scalingAlgorithm = Default;
+
+  const auto& algorithm = m_algorithms.find(scalingAlgorithm);
+  if (algorithm != m_algorithms.end())
+    return algorithm->second.builtIn;
+
+  return false;
+}
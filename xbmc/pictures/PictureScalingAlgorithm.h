@@ -38,7 +38,10 @@ public:
     Gaussian,
     Sinc,
     Lanczos,
-    BicubicSpline
+    BicubicSpline,
+    // scaled by CPictureScaler instead of swscale
+    FastAveragingArea,
+    FastLanczos
   } Algorithm;
 
   static Algorithm Default;
@@ -47,6 +50,10 @@ public:
   static std::string ToString(Algorithm scalingAlgorithm);
   static int ToSwscale(const std::string& scalingAlgorithm);
   static int ToSwscale(Algorithm scalingAlgorithm);
+  /*!
+   \brief Whether images are scaled by CPictureScaler rather than by swscale
+   */
+  static bool IsBuiltIn(Algorithm scalingAlgorithm);
 
 private:
   CPictureScalingAlgorithm();
@@ -55,6 +62,7 @@ private:
   {
     std::string name;
     int swscale;
+    bool builtIn;
   } ScalingAlgorithm;
 
   typedef std::map<CPictureScalingAlgorithm::Algorithm, CPictureScalingAlgorithm::ScalingAlgorithm> AlgorithmMap;
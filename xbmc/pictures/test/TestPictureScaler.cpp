@@ -0,0 +1,152 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "pictures/PictureScaler.h"
+#include "utils/CPUInfo.h"
+
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+#include <vector>
+
+namespace
+{
+std::vector<uint8_t> CreateImage(unsigned int width, unsigned int height, unsigned int seed)
+{
+  std::vector<uint8_t> pixels(width * height * 4);
+  uint32_t state = seed;
+  for (size_t i = 0; i < pixels.size(); i++)
+  {
+    state = state * 1664525 + 1013904223;
+    pixels[i] = (uint8_t)(state >> 24);
+  }
+  return pixels;
+}
+
+std::vector<uint8_t> Scale(const std::vector<uint8_t> &in, unsigned int in_width, unsigned int in_height,
+                           unsigned int out_width, unsigned int out_height,
+                           CPictureScaler::Filter filter, unsigned int threads, unsigned int cpuFeatures)
+{
+  std::vector<uint8_t> out(out_width * out_height * 4);
+  EXPECT_TRUE(CPictureScaler::Scale(in.data(), in_width, in_height, in_width * 4,
+                                    out.data(), out_width, out_height, out_width * 4,
+                                    filter, threads, cpuFeatures));
+  return out;
+}
+}
+
+TEST(TestPictureScaler, InvalidSize)
+{
+  std::vector<uint8_t> in(4), out(4);
+  EXPECT_FALSE(CPictureScaler::Scale(in.data(), 0, 1, 0, out.data(), 1, 1, 4, CPictureScaler::Lanczos));
+  EXPECT_FALSE(CPictureScaler::Scale(in.data(), 1, 1, 4, out.data(), 1, 0, 4, CPictureScaler::Lanczos));
+}
+
+TEST(TestPictureScaler, UniformColor)
+{
+  const unsigned int sizes[][4] = {
+    { 640, 360, 213, 120 },
+    { 100, 100, 31, 7 },
+    { 40, 30, 97, 71 },
+    { 1, 1, 5, 3 }
+  };
+
+  for (unsigned int filter = CPictureScaler::AveragingArea; filter <= CPictureScaler::Lanczos; filter++)
+  {
+    for (const auto &size : sizes)
+    {
+      std::vector<uint8_t> in(size[0] * size[1] * 4);
+      for (size_t i = 0; i < in.size(); i += 4)
+      {
+        in[i] = 0x10;
+        in[i + 1] = 0x80;
+        in[i + 2] = 0xF0;
+        in[i + 3] = 0xFF;
+      }
+
+      std::vector<uint8_t> out = Scale(in, size[0], size[1], size[2], size[3], (CPictureScaler::Filter)filter, 1, ~0U);
+      for (size_t i = 0; i < out.size(); i += 4)
+      {
+        ASSERT_EQ(0x10, out[i]);
+        ASSERT_EQ(0x80, out[i + 1]);
+        ASSERT_EQ(0xF0, out[i + 2]);
+        ASSERT_EQ(0xFF, out[i + 3]);
+      }
+    }
+  }
+}
+
+TEST(TestPictureScaler, AveragingArea)
+{
+  // every output pixel is the mean of a 2x2 block
+  const uint8_t in[] = {
+    10, 20, 30, 40,    30, 40, 50, 60,    0, 0, 0, 0,          4, 8, 12, 16,
+    50, 60, 70, 80,    70, 80, 90, 100,   255, 255, 255, 255,  0, 0, 0, 0
+  };
+  uint8_t out[8] = { 0 };
+  ASSERT_TRUE(CPictureScaler::Scale(in, 4, 2, 16, out, 2, 1, 8, CPictureScaler::AveragingArea, 1));
+
+  const uint8_t expected[] = { 40, 50, 60, 70, 65, 66, 67, 68 };
+  for (unsigned int i = 0; i < sizeof(expected); i++)
+    EXPECT_EQ(expected[i], out[i]) << "channel " << i;
+}
+
+TEST(TestPictureScaler, SameSize)
+{
+  std::vector<uint8_t> in = CreateImage(37, 23, 1);
+  for (unsigned int filter = CPictureScaler::AveragingArea; filter <= CPictureScaler::Lanczos; filter++)
+    EXPECT_EQ(in, Scale(in, 37, 23, 37, 23, (CPictureScaler::Filter)filter, 1, ~0U));
+}
+
+TEST(TestPictureScaler, InstructionSets)
+{
+  // the SIMD implementations sum up in a different order
+  const unsigned int features[] = { CPU_FEATURE_SSE2, CPU_FEATURE_SSE2 | CPU_FEATURE_AVX2 };
+  const unsigned int sizes[][4] = {
+    { 333, 217, 120, 77 },
+    { 50, 40, 97, 83 },
+    { 1920, 1080, 1280, 720 }
+  };
+
+  for (unsigned int filter = CPictureScaler::AveragingArea; filter <= CPictureScaler::Lanczos; filter++)
+  {
+    for (const auto &size : sizes)
+    {
+      std::vector<uint8_t> in = CreateImage(size[0], size[1], size[2]);
+      std::vector<uint8_t> scalar = Scale(in, size[0], size[1], size[2], size[3], (CPictureScaler::Filter)filter, 1, 0);
+      for (unsigned int feature : features)
+      {
+        std::vector<uint8_t> simd = Scale(in, size[0], size[1], size[2], size[3], (CPictureScaler::Filter)filter, 1, feature);
+        for (size_t i = 0; i < scalar.size(); i++)
+          ASSERT_LE(abs(scalar[i] - simd[i]), 1) << "byte " << i << " with features " << feature;
+      }
+    }
+  }
+}
+
+TEST(TestPictureScaler, Threads)
+{
+  std::vector<uint8_t> in = CreateImage(1000, 750, 2);
+  for (unsigned int filter = CPictureScaler::AveragingArea; filter <= CPictureScaler::Lanczos; filter++)
+  {
+    std::vector<uint8_t> serial = Scale(in, 1000, 750, 320, 240, (CPictureScaler::Filter)filter, 1, ~0U);
+    EXPECT_EQ(serial, Scale(in, 1000, 750, 320, 240, (CPictureScaler::Filter)filter, 4, ~0U));
+  }
+}
@@ -39,6 +39,7 @@
 #include "settings/Settings.h"
 #include "settings/SettingUtils.h"
 #include "system.h"
+#include "utils/JobManager.h"
 #include "utils/LangCodeExpander.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
@@ -65,6 +66,8 @@ void CAdvancedSettings::OnSettingsLoaded()
   // load advanced settings
   Load();
 
+  CJobManager::GetInstance().SetWorkStealing(m_jobManagerWorkStealing, m_jobManagerQueues);
+
   // default players?
   CLog::Log(LOGNOTICE, "Default Video Player: %s", m_videoDefaultPlayer.c_str());
   CLog::Log(LOGNOTICE, "Default Audio Player: %s", m_audioDefaultPlayer.c_str());
@@ -118,6 +121,8 @@ void CAdvancedSettings::Initialize()
   //default hold time of 25 ms, this allows a 20 hertz sine to pass undistorted
   m_limiterHold = 0.025f;
   m_limiterRelease = 0.1f;
+  m_audioSinkQueue = true;
+  m_audioPolyphaseResampler = false;
 
   m_seekSteps = { 10, 30, 60, 180, 300, 600, 1800 };
 
@@ -360,11 +365,29 @@ void CAdvancedSettings::Initialize()
   // the following setting determines the readRate of a player data
   // as multiply of the default data read rate
   m_cacheReadFactor = 4.0f;
+  // keep several cached ranges per file instead of a single window
+  m_cacheSegmented = false;
+  // size of the persistent media cache in MB, 0 disables it
+  m_cacheDiskSize = 0;
+  // size read-ahead from stream bitrate and source throughput instead of readfactor
+  m_cacheAdaptive = false;
+
+  m_jobManagerWorkStealing = false;
+  m_jobManagerQueues = 0; // one per CPU core
+  m_jobManagerParallelThreshold = 10000;
+  m_jobManagerParallelThreads = 0; // up to 4, depending on the CPU cores
+
+  m_dirCacheTTL = 0; // seconds, 0 keeps listings until they're cleared or evicted
+  m_dirCacheMemSize = 1024 * 1024 * 16;
 
   m_addonPackageFolderSize = 200;
 
   m_jsonOutputCompact = true;
   m_jsonTcpPort = 9090;
+  m_jsonBatchThreads = 4; // read-only methods of a batch call running at the same time
+
+  m_webserverThreadPoolSize = 0; // 0 = one thread per connection if supported by libmicrohttpd
+  m_webserverMaxConnections = 512;
 
   m_enableMultimediaKeys = false;
 
@@ -526,6 +549,8 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
 
     XMLUtils::GetFloat(pElement, "limiterhold", m_limiterHold, 0.0f, 100.0f);
     XMLUtils::GetFloat(pElement, "limiterrelease", m_limiterRelease, 0.001f, 100.0f);
+    XMLUtils::GetBoolean(pElement, "sinkqueue", m_audioSinkQueue);
+    XMLUtils::GetBoolean(pElement, "polyphaseresampler", m_audioPolyphaseResampler);
   }
 
   pElement = pRootElement->FirstChildElement("omx");
@@ -799,6 +824,25 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetUInt(pElement, "memorysize", m_cacheMemSize);
     XMLUtils::GetUInt(pElement, "buffermode", m_cacheBufferMode, 0, 4);
     XMLUtils::GetFloat(pElement, "readfactor", m_cacheReadFactor);
+    XMLUtils::GetBoolean(pElement, "segmented", m_cacheSegmented);
+    XMLUtils::GetUInt(pElement, "disksize", m_cacheDiskSize);
+    XMLUtils::GetBoolean(pElement, "adaptive", m_cacheAdaptive);
+  }
+
+  pElement = pRootElement->FirstChildElement("jobmanager");
+  if (pElement)
+  {
+    XMLUtils::GetBoolean(pElement, "workstealing", m_jobManagerWorkStealing);
+    XMLUtils::GetUInt(pElement, "queues", m_jobManagerQueues, 0, 16);
+    XMLUtils::GetUInt(pElement, "parallelthreshold", m_jobManagerParallelThreshold);
+    XMLUtils::GetUInt(pElement, "parallelthreads", m_jobManagerParallelThreads, 0, 16);
+  }
+
+  pElement = pRootElement->FirstChildElement("directorycache");
+  if (pElement)
+  {
+    XMLUtils::GetUInt(pElement, "ttl", m_dirCacheTTL);
+    XMLUtils::GetUInt(pElement, "memorysize", m_dirCacheMemSize);
   }
 
   pElement = pRootElement->FirstChildElement("jsonrpc");
@@ -806,6 +850,14 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
   {
     XMLUtils::GetBoolean(pElement, "compactoutput", m_jsonOutputCompact);
     XMLUtils::GetUInt(pElement, "tcpport", m_jsonTcpPort);
+    XMLUtils::GetUInt(pElement, "batchthreads", m_jsonBatchThreads, 1, 16);
+  }
+
+  pElement = pRootElement->FirstChildElement("webserver");
+  if (pElement)
+  {
+    XMLUtils::GetUInt(pElement, "threadpoolsize", m_webserverThreadPoolSize, 0, 64);
+    XMLUtils::GetUInt(pElement, "maxconnections", m_webserverMaxConnections, 1, 4096);
   }
 
   pElement = pRootElement->FirstChildElement("samba");
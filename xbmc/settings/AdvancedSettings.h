@@ -143,6 +143,8 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     bool m_VideoPlayerIgnoreDTSinWAV;
     float m_limiterHold;
     float m_limiterRelease;
+    bool m_audioSinkQueue;
+    bool m_audioPolyphaseResampler;
 
     bool  m_omxDecodeStartWithValidFrame;
 
@@ -345,9 +347,24 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     unsigned int m_cacheMemSize;
     unsigned int m_cacheBufferMode;
     float m_cacheReadFactor;
+    bool m_cacheSegmented;
+    unsigned int m_cacheDiskSize;
+    bool m_cacheAdaptive;
+
+    bool m_jobManagerWorkStealing;
+    unsigned int m_jobManagerQueues;
+    unsigned int m_jobManagerParallelThreshold;
+    unsigned int m_jobManagerParallelThreads;
+
+    unsigned int m_dirCacheTTL;
+    unsigned int m_dirCacheMemSize;
 
     bool m_jsonOutputCompact;
     unsigned int m_jsonTcpPort;
+    unsigned int m_jsonBatchThreads;
+
+    unsigned int m_webserverThreadPoolSize;
+    unsigned int m_webserverMaxConnections;
 
     bool m_enableMultimediaKeys;
     std::vector<std::string> m_settingsFiles;
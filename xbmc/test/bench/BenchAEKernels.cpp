@@ -0,0 +1,113 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+#include "cores/AudioEngine/Utils/AEKernels.h"
+#include "utils/CPUInfo.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+// frames of one period of the engine
+const unsigned int PERIOD_FRAMES = 1024;
+
+std::vector<float> CreateSamples(unsigned int count, float amplitude)
+{
+  std::vector<float> samples(count);
+  uint32_t state = count;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    state = state * 1664525 + 1013904223;
+    samples[i] = ((float)(state >> 8) / (1 << 23) - 1.0f) * amplitude;
+  }
+  return samples;
+}
+}
+
+// Scale() is the number of periods processed per run
+KODI_BENCHMARK(AEKernels)
+{
+  const struct
+  {
+    const char *label;
+    unsigned int cpuFeatures;
+  } implementations[] = {
+    { "c", 0 },
+    { "sse2", CPU_FEATURE_SSE2 },
+    { "avx2", CPU_FEATURE_SSE2 | CPU_FEATURE_AVX2 },
+    { "neon", CPU_FEATURE_NEON }
+  };
+  const unsigned int layouts[] = { 2, 6, 8 };
+
+  std::vector<float> gains(PERIOD_FRAMES, 0.9f);
+  for (const auto &implementation : implementations)
+  {
+    if ((g_cpuInfo.GetCPUFeatures() & implementation.cpuFeatures) != implementation.cpuFeatures)
+      continue;
+    CAEKernels::Select(implementation.cpuFeatures);
+
+    for (unsigned int channels : layouts)
+    {
+      const unsigned int count = PERIOD_FRAMES * channels;
+      const std::string name = std::string(implementation.label) + " " + std::to_string(channels) + "ch ";
+      std::vector<float> streams[3] = { CreateSamples(count, 0.8f), CreateSamples(count + 1, 0.8f), CreateSamples(count + 2, 0.8f) };
+      std::vector<float> out(count);
+
+      state.Measure(name + "mul", [&]() {
+        for (unsigned int i = 0; i < state.Scale(); i++)
+          CAEKernels::Mul(out.data(), 0.999f, count);
+      });
+      state.Measure(name + "muladd", [&]() {
+        for (unsigned int i = 0; i < state.Scale(); i++)
+          CAEKernels::MulAdd(out.data(), streams[0].data(), 0.5f, count);
+      });
+      state.Measure(name + "mulgains", [&]() {
+        for (unsigned int i = 0; i < state.Scale(); i++)
+          CAEKernels::MulAddGains(out.data(), streams[0].data(), gains.data(), PERIOD_FRAMES, channels);
+      });
+      state.Measure(name + "softclamp", [&]() {
+        for (unsigned int i = 0; i < state.Scale(); i++)
+        {
+          out = streams[0];
+          CAEKernels::Mul(out.data(), 2.0f, count);
+          CAEKernels::SoftClamp(out.data(), count);
+        }
+      });
+
+      // what RunStages() does for a movie with two gui sounds playing on top
+      state.Measure(name + "mix 3 streams", [&]() {
+        for (unsigned int i = 0; i < state.Scale(); i++)
+        {
+          out = streams[0];
+          CAEKernels::MulGains(out.data(), gains.data(), PERIOD_FRAMES, channels);
+          CAEKernels::MulAdd(out.data(), streams[1].data(), 0.7f, count);
+          CAEKernels::MulAdd(out.data(), streams[2].data(), 0.7f, count);
+          if (CAEKernels::Peak(out.data(), count) > 1.0f)
+            CAEKernels::SoftClamp(out.data(), count);
+        }
+      });
+    }
+  }
+
+  CAEKernels::Select(g_cpuInfo.GetCPUFeatures());
+}
@@ -0,0 +1,219 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+#include "cores/AudioEngine/Engines/ActiveAE/ActiveAEResampleFFMPEG.h"
+#include "cores/AudioEngine/Engines/ActiveAE/ActiveAEResamplePolyphase.h"
+
+extern "C" {
+#include "libavutil/channel_layout.h"
+}
+
+#include <algorithm>
+#include <math.h>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace ActiveAE;
+
+namespace
+{
+// frames of one period of the engine
+const unsigned int PERIOD_FRAMES = 1024;
+
+struct ResampleScenario
+{
+  const char *label;
+  int srcRate;
+  int dstRate;
+  uint64_t srcLayout;
+  uint64_t dstLayout;
+};
+
+const ResampleScenario SCENARIOS[] =
+{
+  { "44.1k to 48k",        44100, 48000, AV_CH_LAYOUT_STEREO,  AV_CH_LAYOUT_STEREO },
+  { "48k to 44.1k",        48000, 44100, AV_CH_LAYOUT_STEREO,  AV_CH_LAYOUT_STEREO },
+  { "48k to 96k",          48000, 96000, AV_CH_LAYOUT_STEREO,  AV_CH_LAYOUT_STEREO },
+  { "96k to 48k",          96000, 48000, AV_CH_LAYOUT_STEREO,  AV_CH_LAYOUT_STEREO },
+  { "5.1 48k to 2.0 44.1k", 48000, 44100, AV_CH_LAYOUT_5POINT1, AV_CH_LAYOUT_STEREO },
+};
+
+const struct
+{
+  const char *label;
+  AEQuality quality;
+} QUALITIES[] = {
+  { "low", AE_QUALITY_LOW },
+  { "mid", AE_QUALITY_MID },
+  { "high", AE_QUALITY_HIGH },
+};
+
+IAEResample *CreateResampler(bool polyphase, const ResampleScenario &scenario, AEQuality quality)
+{
+  IAEResample *resampler;
+  if (polyphase)
+    resampler = new CActiveAEResamplePolyphase();
+  else
+    resampler = new CActiveAEResampleFFMPEG();
+
+  const int srcChannels = av_get_channel_layout_nb_channels(scenario.srcLayout);
+  const int dstChannels = av_get_channel_layout_nb_channels(scenario.dstLayout);
+  if (!resampler->Init(scenario.dstLayout, dstChannels, scenario.dstRate, AV_SAMPLE_FMT_FLTP, 32, 0,
+                       scenario.srcLayout, srcChannels, scenario.srcRate, AV_SAMPLE_FMT_FLTP, 32, 0,
+                       false, true, NULL, quality, false))
+  {
+    delete resampler;
+    return NULL;
+  }
+  return resampler;
+}
+
+/*!
+ \brief Resample a sine played on every channel and return the first output channel.
+ */
+std::vector<float> ResampleSine(IAEResample *resampler, const ResampleScenario &scenario, double frequency, unsigned int frames)
+{
+  const int srcChannels = av_get_channel_layout_nb_channels(scenario.srcLayout);
+  const int dstChannels = av_get_channel_layout_nb_channels(scenario.dstLayout);
+  const int dstFrames = resampler->CalcDstSampleCount(PERIOD_FRAMES, scenario.dstRate, scenario.srcRate) * 2;
+
+  std::vector<float> input(PERIOD_FRAMES);
+  std::vector<std::vector<float>> output(dstChannels, std::vector<float>(dstFrames));
+  uint8_t *src[AE_CH_MAX], *dst[AE_CH_MAX];
+  for (int ch = 0; ch < srcChannels; ch++)
+    src[ch] = (uint8_t*)input.data();
+  for (int ch = 0; ch < dstChannels; ch++)
+    dst[ch] = (uint8_t*)output[ch].data();
+
+  std::vector<float> result;
+  for (unsigned int pos = 0; pos < frames; pos += PERIOD_FRAMES)
+  {
+    for (unsigned int i = 0; i < PERIOD_FRAMES; i++)
+      input[i] = 0.5f * (float)sin(2.0 * M_PI * frequency * (pos + i) / scenario.srcRate);
+    int count = resampler->Resample(dst, dstFrames, src, PERIOD_FRAMES, 1.0);
+    if (count > 0)
+      result.insert(result.end(), output[0].begin(), output[0].begin() + count);
+  }
+  return result;
+}
+
+/*!
+ \brief Signal to noise ratio in dB of a resampled sine of unknown phase.
+
+ The sine and cosine at the frequency are fitted with least squares, the rest
+ is noise and distortion. The start is skipped so the filter has settled.
+ */
+double SineSNR(const std::vector<float> &samples, double frequency, int rate)
+{
+  const unsigned int skip = samples.size() / 4;
+  double ss = 0.0, cc = 0.0, sc = 0.0, sy = 0.0, cy = 0.0;
+  for (unsigned int i = skip; i < samples.size(); i++)
+  {
+    const double s = sin(2.0 * M_PI * frequency * i / rate);
+    const double c = cos(2.0 * M_PI * frequency * i / rate);
+    ss += s * s;
+    cc += c * c;
+    sc += s * c;
+    sy += s * samples[i];
+    cy += c * samples[i];
+  }
+  const double det = ss * cc - sc * sc;
+  const double a = (sy * cc - cy * sc) / det;
+  const double b = (cy * ss - sy * sc) / det;
+
+  double signal = 0.0, noise = 0.0;
+  for (unsigned int i = skip; i < samples.size(); i++)
+  {
+    const double fit = a * sin(2.0 * M_PI * frequency * i / rate) + b * cos(2.0 * M_PI * frequency * i / rate);
+    signal += fit * fit;
+    noise += (samples[i] - fit) * (samples[i] - fit);
+  }
+  return 10.0 * log10(signal / std::max(noise, 1e-30));
+}
+
+double PeakDB(const std::vector<float> &samples)
+{
+  double peak = 1e-15;
+  for (unsigned int i = samples.size() / 4; i < samples.size(); i++)
+    peak = std::max(peak, (double)fabsf(samples[i]));
+  return 20.0 * log10(peak / 0.5);
+}
+}
+
+// Scale() is the number of periods of 1024 input frames resampled per run.
+// Next to the timing the signal to noise ratio of a resampled sine and, when
+// the rate goes down, the level of a tone above the new nyquist frequency
+// are reported in dB.
+KODI_BENCHMARK(AEResample)
+{
+  const unsigned int accuracyFrames = 65536;
+
+  for (const ResampleScenario &scenario : SCENARIOS)
+  {
+    for (const auto &quality : QUALITIES)
+    {
+      for (bool polyphase : { false, true })
+      {
+        std::unique_ptr<IAEResample> resampler(CreateResampler(polyphase, scenario, quality.quality));
+        if (!resampler)
+        {
+          fprintf(stderr, "%s: unable to init the resampler for %s\n", state.Name().c_str(), scenario.label);
+          continue;
+        }
+        if (polyphase && std::string(resampler->GetName()) != "ActiveAEResamplePolyphase")
+          fprintf(stderr, "%s: %s fell back to %s\n", state.Name().c_str(), scenario.label, resampler->GetName());
+
+        const std::string name = std::string(polyphase ? "polyphase " : "ffmpeg ") + quality.label + " " + scenario.label;
+        const int srcChannels = av_get_channel_layout_nb_channels(scenario.srcLayout);
+        const int dstChannels = av_get_channel_layout_nb_channels(scenario.dstLayout);
+        const int dstFrames = resampler->CalcDstSampleCount(PERIOD_FRAMES, scenario.dstRate, scenario.srcRate) * 2;
+        std::vector<std::vector<float>> input(srcChannels, std::vector<float>(PERIOD_FRAMES, 0.25f));
+        std::vector<std::vector<float>> output(dstChannels, std::vector<float>(dstFrames));
+        uint8_t *src[AE_CH_MAX], *dst[AE_CH_MAX];
+        for (int ch = 0; ch < srcChannels; ch++)
+          src[ch] = (uint8_t*)input[ch].data();
+        for (int ch = 0; ch < dstChannels; ch++)
+          dst[ch] = (uint8_t*)output[ch].data();
+
+        state.Measure(name, [&]() {
+          for (unsigned int i = 0; i < state.Scale(); i++)
+            resampler->Resample(dst, dstFrames, src, PERIOD_FRAMES, 1.0);
+        });
+
+        // accuracy on fresh instances, the timing runs left input behind
+        resampler.reset(CreateResampler(polyphase, scenario, quality.quality));
+        const double frequency = 1000.0;
+        std::vector<double> snr = { SineSNR(ResampleSine(resampler.get(), scenario, frequency, accuracyFrames), frequency, scenario.dstRate) };
+        state.Report(name + " snr dB", snr);
+
+        if (scenario.dstRate < scenario.srcRate)
+        {
+          resampler.reset(CreateResampler(polyphase, scenario, quality.quality));
+          const double alias = scenario.dstRate * 0.5 + (scenario.srcRate - scenario.dstRate) * 0.25;
+          std::vector<double> stopband = { PeakDB(ResampleSine(resampler.get(), scenario, alias, accuracyFrames)) };
+          state.Report(name + " stopband dB", stopband);
+        }
+      }
+    }
+  }
+}
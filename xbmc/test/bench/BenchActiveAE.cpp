@@ -0,0 +1,231 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+#include "ServiceBroker.h"
+#include "cores/AudioEngine/AEFactory.h"
+#include "cores/AudioEngine/Interfaces/AEStream.h"
+#include "cores/AudioEngine/Utils/AEBitstreamPacker.h"
+#include "cores/AudioEngine/Utils/AEStreamInfo.h"
+#include "settings/Settings.h"
+#include "threads/Thread.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct EngineScenario
+{
+  const char *label;
+  unsigned int streams;
+  unsigned int streamRate;
+  unsigned int outputRate;
+  enum AEStdChLayout outputLayout;
+  bool upmix;
+  double tempo;
+};
+
+const EngineScenario ENGINE_SCENARIOS[] =
+{
+  { "4 pcm streams",         4, 48000, 48000, AE_CH_LAYOUT_2_0, false, 1.0  },
+  { "resample 44.1k to 48k", 1, 44100, 48000, AE_CH_LAYOUT_2_0, false, 1.0  },
+  { "resample 44.1k to 96k", 1, 44100, 96000, AE_CH_LAYOUT_2_0, false, 1.0  },
+  { "upmix 2.0 to 7.1",      1, 48000, 48000, AE_CH_LAYOUT_7_1, true,  1.0  },
+  { "atempo 1.25",           1, 48000, 48000, AE_CH_LAYOUT_2_0, false, 1.25 },
+};
+
+struct PackScenario
+{
+  const char *label;
+  CAEStreamInfo::DataType type;
+  unsigned int repeat;
+  unsigned int frameSize;
+  double framesPerSecond;
+};
+
+// typical frame sizes of 48kHz streams, the packer does not look into the data
+const PackScenario PACK_SCENARIOS[] =
+{
+  { "pack ac3",    CAEStreamInfo::STREAM_TYPE_AC3,     1, 1792, 48000.0 / 1536 },
+  { "pack eac3",   CAEStreamInfo::STREAM_TYPE_EAC3,    1, 2560, 48000.0 / 1536 },
+  { "pack dts",    CAEStreamInfo::STREAM_TYPE_DTS_512, 1, 2012, 48000.0 / 512  },
+  { "pack truehd", CAEStreamInfo::STREAM_TYPE_TRUEHD,  1, 1000, 48000.0 / 40   },
+};
+
+// the first second fills the buffers of the engine and is not measured
+const double WARMUP_SECONDS = 1.0;
+
+void ConfigureEngine(const EngineScenario &scenario)
+{
+  CSettings &settings = CServiceBroker::GetSettings();
+  settings.SetInt(CSettings::SETTING_AUDIOOUTPUT_SAMPLERATE, scenario.outputRate);
+  settings.SetInt(CSettings::SETTING_AUDIOOUTPUT_CHANNELS, scenario.outputLayout);
+  settings.SetBool(CSettings::SETTING_AUDIOOUTPUT_STEREOUPMIX, scenario.upmix);
+  CAEFactory::OnSettingsChange(CSettings::SETTING_AUDIOOUTPUT_CONFIG);
+}
+
+/*!
+ \brief Play a sine on every stream of the scenario for the given time.
+
+ The NULL sink consumes audio in real time, so the process time spent per
+ second of wall clock is the load the engine puts on the system.
+ */
+void RunEngineScenario(CBenchmarkState &state, const EngineScenario &scenario, double seconds)
+{
+  ConfigureEngine(scenario);
+
+  AEAudioFormat format;
+  format.m_dataFormat = AE_FMT_FLOAT;
+  format.m_sampleRate = scenario.streamRate;
+  format.m_channelLayout = CAEChannelInfo(AE_CH_LAYOUT_2_0);
+  const unsigned int channels = format.m_channelLayout.Count();
+
+  std::vector<IAEStream*> streams;
+  for (unsigned int i = 0; i < scenario.streams; i++)
+  {
+    AEAudioFormat streamFormat = format;
+    IAEStream *stream = CAEFactory::MakeStream(streamFormat);
+    if (!stream)
+    {
+      fprintf(stderr, "%s: unable to create a stream for %s\n", state.Name().c_str(), scenario.label);
+      break;
+    }
+    if (scenario.tempo != 1.0)
+      stream->SetResampleRatio(1.0 / scenario.tempo);
+    streams.push_back(stream);
+  }
+
+  // 20ms of a 440Hz sine, the period is not continued across chunks
+  const unsigned int frames = scenario.streamRate / 50;
+  std::vector<float> chunk(frames * channels);
+  for (unsigned int i = 0; i < frames; i++)
+  {
+    float value = 0.5f * sinf(2.0f * (float)M_PI * 440.0f * i / scenario.streamRate);
+    std::fill_n(chunk.begin() + i * channels, channels, value);
+  }
+  const uint8_t *data[1] = { (const uint8_t*)chunk.data() };
+  const unsigned int chunkBytes = frames * channels * sizeof(float);
+
+  std::vector<double> cpu, latency;
+  auto start = std::chrono::steady_clock::now();
+  auto windowStart = start;
+  std::clock_t windowCpu = std::clock();
+  while (!streams.empty())
+  {
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - start;
+    if (elapsed.count() >= seconds + WARMUP_SECONDS)
+      break;
+
+    bool added = false;
+    for (IAEStream *stream : streams)
+    {
+      if (stream->GetSpace() < chunkBytes)
+        continue;
+      stream->AddData(data, 0, frames);
+      if (elapsed.count() >= WARMUP_SECONDS)
+        latency.push_back(stream->GetDelay() * 1000.0);
+      added = true;
+    }
+    if (!added)
+      XbmcThreads::ThreadSleep(1);
+
+    std::chrono::duration<double> window = now - windowStart;
+    if (window.count() >= 1.0)
+    {
+      std::clock_t cpuNow = std::clock();
+      if (elapsed.count() > WARMUP_SECONDS)
+        cpu.push_back((double)(cpuNow - windowCpu) * 1000.0 / CLOCKS_PER_SEC / window.count());
+      windowStart = now;
+      windowCpu = cpuNow;
+    }
+  }
+
+  for (IAEStream *stream : streams)
+    CAEFactory::FreeStream(stream);
+
+  state.Report(std::string(scenario.label) + " cpu ms per s", cpu);
+  state.Report(std::string(scenario.label) + " latency", latency);
+}
+
+void RunPackScenario(CBenchmarkState &state, const PackScenario &scenario, double seconds)
+{
+  CAEStreamInfo info;
+  info.m_type = scenario.type;
+  info.m_sampleRate = 48000;
+  info.m_channels = 2;
+  info.m_dataIsLE = false;
+  info.m_repeat = scenario.repeat;
+
+  std::vector<uint8_t> frame(scenario.frameSize);
+  for (unsigned int i = 0; i < frame.size(); i++)
+    frame[i] = (uint8_t)(i * 7);
+
+  CAEBitstreamPacker packer;
+  const unsigned int count = (unsigned int)(scenario.framesPerSecond * seconds);
+  std::vector<double> samples;
+  for (unsigned int run = 0; run <= state.Iterations(); run++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < count; i++)
+      packer.Pack(info, frame.data(), frame.size());
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    // the first run is the warm-up
+    if (run)
+      samples.push_back(elapsed.count() / seconds);
+  }
+  state.Report(std::string(scenario.label) + " cpu ms per s", samples);
+}
+}
+
+// Scale() is the audio played or packed per scenario in milliseconds. The
+// engine runs on the NULL sink in real time, so the defaults take about a
+// minute. Latency is the delay reported by the stream after each chunk.
+KODI_BENCHMARK(ActiveAE)
+{
+  const double seconds = std::max(state.Scale(), 1000U) / 1000.0;
+
+  for (const PackScenario &scenario : PACK_SCENARIOS)
+    RunPackScenario(state, scenario, seconds);
+
+  CSettings &settings = CServiceBroker::GetSettings();
+  settings.SetString(CSettings::SETTING_AUDIOOUTPUT_AUDIODEVICE, "NULL:NULL");
+  settings.SetInt(CSettings::SETTING_AUDIOOUTPUT_CONFIG, AE_CONFIG_FIXED);
+  settings.SetBool(CSettings::SETTING_AUDIOOUTPUT_PASSTHROUGH, false);
+  settings.SetInt(CSettings::SETTING_AUDIOOUTPUT_GUISOUNDMODE, AE_SOUND_OFF);
+
+  if (!CAEFactory::LoadEngine() || !CAEFactory::StartEngine())
+  {
+    fprintf(stderr, "%s: unable to start the audio engine\n", state.Name().c_str());
+    CAEFactory::UnLoadEngine();
+    return;
+  }
+
+  for (const EngineScenario &scenario : ENGINE_SCENARIOS)
+    RunEngineScenario(state, scenario, seconds);
+
+  CAEFactory::UnLoadEngine();
+}
@@ -0,0 +1,103 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+#include "threads/Thread.h"
+#include "utils/ActorProtocol.h"
+
+#include <stdint.h>
+
+using namespace Actor;
+
+namespace
+{
+enum Signals
+{
+  REQUEST,
+  REPLY,
+};
+
+// a second actor answering every message of the port
+class CResponder : public CThread
+{
+public:
+  CResponder(Protocol &port, CEvent &event) :
+    CThread("BenchResponder"), m_port(port), m_event(event) {}
+
+protected:
+  void Process() override
+  {
+    while (!m_bStop)
+    {
+      Message *msg;
+      if (!m_port.ReceiveOutMessage(&msg))
+      {
+        m_event.WaitMSec(10);
+        continue;
+      }
+      msg->Reply(REPLY, msg->data, msg->payloadSize);
+      msg->Release();
+    }
+  }
+
+  Protocol &m_port;
+  CEvent &m_event;
+};
+}
+
+// Scale() is the number of messages per run
+KODI_BENCHMARK(ActorProtocol)
+{
+  CEvent inEvent, outEvent;
+  Protocol port("BenchPort", &inEvent, &outEvent);
+  uint8_t payload[1024] = {};
+  const int sizes[] = { 8, 256, 1024 };
+
+  // what one actor thread does with the messages of another, on one thread
+  for (int size : sizes)
+  {
+    state.Measure("send receive " + std::to_string(size) + " bytes", [&]() {
+      Message *msg;
+      for (unsigned int i = 0; i < state.Scale(); i++)
+      {
+        port.SendOutMessage(REQUEST, payload, size);
+        if (port.ReceiveOutMessage(&msg))
+          msg->Release();
+      }
+    });
+  }
+
+  CResponder responder(port, outEvent);
+  responder.Create();
+  for (int size : sizes)
+  {
+    state.Measure("sync " + std::to_string(size) + " bytes", [&]() {
+      Message *reply;
+      for (unsigned int i = 0; i < state.Scale(); i++)
+      {
+        if (port.SendOutMessageSync(REQUEST, &reply, 1000, payload, size))
+          reply->Release();
+      }
+    });
+  }
+  responder.StopThread();
+
+  port.LogStats();
+}
@@ -0,0 +1,141 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+#include "interfaces/json-rpc/IClient.h"
+#include "interfaces/json-rpc/ITransportLayer.h"
+#include "interfaces/json-rpc/JSONRPC.h"
+#include "interfaces/json-rpc/JSONServiceDescription.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+#include <algorithm>
+
+using namespace JSONRPC;
+
+namespace
+{
+// requests of a remote app showing the now playing screen, which polls the
+// player every second, recorded together with their relative frequency
+struct RecordedRequest
+{
+  unsigned int weight;
+  const char *request;
+};
+
+const RecordedRequest REQUEST_MIX[] = {
+  { 10, "{\"jsonrpc\":\"2.0\",\"method\":\"Player.GetProperties\",\"params\":{\"playerid\":1,\"properties\":[\"percentage\",\"time\",\"totaltime\",\"speed\",\"position\",\"playlistid\",\"shuffled\",\"repeat\",\"canseek\",\"currentaudiostream\",\"currentsubtitle\",\"subtitleenabled\"]},\"id\":1}" },
+  { 5, "{\"jsonrpc\":\"2.0\",\"method\":\"Player.GetActivePlayers\",\"id\":2}" },
+  { 3, "{\"jsonrpc\":\"2.0\",\"method\":\"Player.GetItem\",\"params\":{\"playerid\":1,\"properties\":[\"title\",\"artist\",\"album\",\"thumbnail\",\"file\",\"duration\",\"showtitle\",\"season\",\"episode\",\"fanart\"]},\"id\":3}" },
+  { 3, "{\"jsonrpc\":\"2.0\",\"method\":\"Application.GetProperties\",\"params\":{\"properties\":[\"volume\",\"muted\"]},\"id\":4}" },
+  { 2, "{\"jsonrpc\":\"2.0\",\"method\":\"XBMC.GetInfoBooleans\",\"params\":{\"booleans\":[\"System.ScreenSaverActive\",\"Player.Paused\"]},\"id\":5}" },
+  { 2, "{\"jsonrpc\":\"2.0\",\"method\":\"JSONRPC.Ping\",\"id\":6}" },
+  { 1, "{\"jsonrpc\":\"2.0\",\"method\":\"Playlist.GetItems\",\"params\":{\"playlistid\":1,\"properties\":[\"title\",\"duration\",\"thumbnail\"],\"limits\":{\"start\":0,\"end\":50}},\"id\":7}" },
+  { 1, "{\"jsonrpc\":\"2.0\",\"method\":\"VideoLibrary.GetMovies\",\"params\":{\"properties\":[\"title\",\"year\",\"rating\",\"thumbnail\",\"playcount\"],\"limits\":{\"start\":0,\"end\":100},\"sort\":{\"method\":\"label\",\"order\":\"ascending\",\"ignorearticle\":true}},\"id\":8}" },
+  { 1, "{\"jsonrpc\":\"2.0\",\"method\":\"Player.GetProperties\",\"params\":{\"playerid\":7,\"properties\":[\"speed\"]},\"id\":9}" }
+};
+
+const size_t BATCH_SIZE = 20;
+
+class CBenchTransport : public ITransportLayer
+{
+public:
+  bool PrepareDownload(const char *path, CVariant &details, std::string &protocol) override { return false; }
+  bool Download(const char *path, CVariant &result) override { return false; }
+  int GetCapabilities() override { return Response; }
+};
+
+class CBenchClient : public IClient
+{
+public:
+  int GetPermissionFlags() override { return OPERATION_PERMISSION_ALL; }
+  int GetAnnouncementFlags() override { return 0; }
+  bool SetAnnouncementFlags(int flags) override { return false; }
+};
+}
+
+KODI_BENCHMARK(JSONRPC)
+{
+  CJSONRPC::Initialize();
+
+  // replay the recorded mix until there are Scale() requests
+  std::vector<std::string> requests;
+  while (requests.size() < state.Scale())
+  {
+    for (unsigned int i = 0; i < sizeof(REQUEST_MIX) / sizeof(REQUEST_MIX[0]) && requests.size() < state.Scale(); i++)
+    {
+      for (unsigned int weight = 0; weight < REQUEST_MIX[i].weight && requests.size() < state.Scale(); weight++)
+        requests.push_back(REQUEST_MIX[i].request);
+    }
+  }
+
+  std::vector<CVariant> parsedRequests;
+  std::vector<std::string> methods;
+  for (std::vector<std::string>::const_iterator request = requests.begin(); request != requests.end(); ++request)
+  {
+    parsedRequests.push_back(CJSONVariantParser::Parse(*request));
+    methods.push_back(parsedRequests.back()["method"].asString());
+    StringUtils::ToLower(methods.back());
+  }
+
+  CBenchTransport transport;
+  CBenchClient client;
+
+  // method lookup and parameter validation only
+  unsigned int valid = 0;
+  state.Measure("check call", [&]() {
+    for (size_t i = 0; i < parsedRequests.size(); i++)
+    {
+      MethodCall method;
+      CVariant params;
+      if (CJSONServiceDescription::CheckCall(methods[i].c_str(), parsedRequests[i]["params"], &transport, &client, false, method, params) == OK)
+        valid++;
+    }
+  });
+
+  // everything from the received request to the serialized response
+  size_t responseSize = 0;
+  state.Measure("method call", [&]() {
+    for (std::vector<std::string>::const_iterator request = requests.begin(); request != requests.end(); ++request)
+      responseSize += CJSONRPC::MethodCall(*request, &transport, &client).size();
+  });
+
+  // the same requests sent as batches like the ones of remote dashboards
+  std::vector<std::string> batches;
+  for (size_t i = 0; i < requests.size(); i += BATCH_SIZE)
+  {
+    std::string batch = "[";
+    for (size_t j = i; j < std::min(i + BATCH_SIZE, requests.size()); j++)
+    {
+      if (j > i)
+        batch += ",";
+      batch += requests[j];
+    }
+    batches.push_back(batch + "]");
+  }
+
+  state.Measure("batch call", [&]() {
+    for (std::vector<std::string>::const_iterator batch = batches.begin(); batch != batches.end(); ++batch)
+      responseSize += CJSONRPC::MethodCall(*batch, &transport, &client).size();
+  });
+
+  CJSONRPC::Cleanup();
+}
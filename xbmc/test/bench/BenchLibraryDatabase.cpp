@@ -0,0 +1,348 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Benchmark.h"
+#include "FileItem.h"
+#include "dbwrappers/Database.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "music/MusicDatabase.h"
+#include "music/MusicDbUrl.h"
+#include "settings/AdvancedSettings.h"
+#include "utils/SortUtils.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "video/VideoDatabase.h"
+#include "video/VideoDbUrl.h"
+
+#include <chrono>
+#include <stdint.h>
+
+namespace
+{
+const unsigned int NUM_GENRES = 24;
+const unsigned int EPISODES_PER_SEASON = 10;
+const unsigned int SEASONS_PER_SHOW = 5;
+const unsigned int SONGS_PER_ALBUM = 12;
+const unsigned int ALBUMS_PER_ARTIST = 8;
+
+const char *WORDS[] = {
+  "Night", "Return", "Dark", "River", "Last", "City", "Summer", "Ghost", "Iron",
+  "Silent", "Empire", "Storm", "Golden", "Road", "Winter", "Secret", "Fire",
+  "Lost", "Island", "Star", "Shadow", "Blue", "Kingdom", "Heart", "Wild", "Glass"
+};
+const unsigned int NUM_WORDS = sizeof(WORDS) / sizeof(WORDS[0]);
+
+// deterministic so every run measures the same library
+class CRandom
+{
+public:
+  explicit CRandom(uint32_t seed) : m_state(seed) {}
+  uint32_t Next(uint32_t max)
+  {
+    m_state = m_state * 1664525 + 1013904223;
+    return (m_state >> 8) % max;
+  }
+private:
+  uint32_t m_state;
+};
+
+std::string Title(CRandom &random, unsigned int id)
+{
+  // some titles with articles, so sorting has to strip them
+  std::string title = random.Next(5) == 0 ? "The " : "";
+  title += WORDS[random.Next(NUM_WORDS)];
+  title += " ";
+  title += WORDS[random.Next(NUM_WORDS)];
+  title += StringUtils::Format(" %u", id);
+  return title;
+}
+
+std::string Date(CRandom &random, unsigned int &year)
+{
+  year = 1950 + random.Next(70);
+  return StringUtils::Format("%u-%02u-%02u", year, 1 + random.Next(12), 1 + random.Next(28));
+}
+
+DatabaseSettings BenchmarkDatabaseSettings()
+{
+  DatabaseSettings settings;
+  settings.type = "sqlite3";
+  settings.host = CSpecialProtocol::TranslatePath("special://temp/");
+  return settings;
+}
+
+void DeleteDatabase(const DatabaseSettings &settings, const std::string &name)
+{
+  XFILE::CFile::Delete(URIUtils::AddFileToFolder(settings.host, name + ".db"));
+}
+
+double ElapsedMs(const std::chrono::steady_clock::time_point &start)
+{
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+void PopulateVideoLibrary(CVideoDatabase &db, unsigned int scale)
+{
+  CRandom random(scale);
+  db.BeginTransaction();
+
+  for (unsigned int genre = 1; genre <= NUM_GENRES; genre++)
+    db.ExecuteQuery(db.PrepareSQL("INSERT INTO genre (genre_id, name) VALUES (%u, 'Genre %u')", genre, genre));
+
+  // movies, 100 per folder
+  unsigned int idFile = 0;
+  for (unsigned int idMovie = 1; idMovie <= scale; idMovie++)
+  {
+    unsigned int idPath = (idMovie - 1) / 100 + 1;
+    if ((idMovie - 1) % 100 == 0)
+      db.ExecuteQuery(db.PrepareSQL("INSERT INTO path (idPath, strPath, strContent) VALUES (%u, '/media/movies/%u/', 'movies')", idPath, idPath));
+
+    unsigned int year;
+    std::string premiered = Date(random, year);
+    unsigned int genre1 = 1 + random.Next(NUM_GENRES);
+    unsigned int genre2 = 1 + (genre1 + random.Next(NUM_GENRES - 1)) % NUM_GENRES;
+    idFile++;
+    db.ExecuteQuery(db.PrepareSQL("INSERT INTO files (idFile, idPath, strFilename, playCount, dateAdded) VALUES (%u, %u, 'movie%u.mkv', %u, '%s 12:00:00')",
+                                  idFile, idPath, idMovie, random.Next(3), premiered.c_str()));
+    db.ExecuteQuery(db.PrepareSQL("INSERT INTO movie (idMovie, idFile, c00, c01, c11, c14, premiered, userrating) VALUES (%u, %u, '%s', 'Plot of movie %u', '%u', 'Genre %u / Genre %u', '%s', %u)",
+                                  idMovie, idFile, Title(random, idMovie).c_str(), idMovie, 60 * (80 + random.Next(80)),
+                                  genre1, genre2, premiered.c_str(), random.Next(11)));
+    db.ExecuteQuery(db.PrepareSQL("INSERT INTO genre_link (genre_id, media_id, media_type) VALUES (%u, %u, 'movie')", genre1, idMovie));
+    db.ExecuteQuery(db.PrepareSQL("INSERT INTO genre_link (genre_id, media_id, media_type) VALUES (%u, %u, 'movie')", genre2, idMovie));
+    db.ExecuteQuery(db.PrepareSQL("INSERT INTO rating (media_id, media_type, rating_type, rating, votes) VALUES (%u, 'movie', 'default', %f, %u)",
+                                  idMovie, random.Next(100) / 10.0, random.Next(100000)));
+  }
+
+  // as many episodes as movies, in shows of 5 seasons with 10 episodes
+  unsigned int idShow = 0;
+  unsigned int idSeason = 0;
+  unsigned int idPath = scale / 100 + 1;
+  for (unsigned int idEpisode = 1; idEpisode <= scale; idEpisode++)
+  {
+    unsigned int index = idEpisode - 1;
+    unsigned int episode = index % EPISODES_PER_SEASON + 1;
+    unsigned int season = (index / EPISODES_PER_SEASON) % SEASONS_PER_SHOW + 1;
+    if (episode == 1 && season == 1)
+    {
+      idShow++;
+      idPath++;
+      unsigned int year;
+      std::string premiered = Date(random, year);
+      db.ExecuteQuery(db.PrepareSQL("INSERT INTO path (idPath, strPath, strContent) VALUES (%u, '/media/tvshows/%u/', 'tvshows')", idPath, idShow));
+      db.ExecuteQuery(db.PrepareSQL("INSERT INTO tvshow (idShow, c00, c05, c08) VALUES (%u, '%s', '%s', 'Genre %u')",
+                                    idShow, Title(random, idShow).c_str(), premiered.c_str(), 1 + random.Next(NUM_GENRES)));
+      db.ExecuteQuery(db.PrepareSQL("INSERT INTO tvshowlinkpath (idShow, idPath) VALUES (%u, %u)", idShow, idPath));
+    }
+    if (episode == 1)
+    {
+      idSeason++;
+      db.ExecuteQuery(db.PrepareSQL("INSERT INTO seasons (idSeason, idShow, season) VALUES (%u, %u, %u)", idSeason, idShow, season));
+    }
+
+    unsigned int year;
+    std::string aired = Date(random, year);
+    idFile++;
+    db.ExecuteQuery(db.PrepareSQL("INSERT INTO files (idFile, idPath, strFilename, playCount, dateAdded) VALUES (%u, %u, 's%02ue%02u.mkv', %u, '%s 12:00:00')",
+                                  idFile, idPath, season, episode, random.Next(2), aired.c_str()));
+    db.ExecuteQuery(db.PrepareSQL("INSERT INTO episode (idEpisode, idFile, c00, c05, c12, c13, idShow, idSeason) VALUES (%u, %u, '%s', '%s', '%u', '%u', %u, %u)",
+                                  idEpisode, idFile, Title(random, idEpisode).c_str(), aired.c_str(), season, episode, idShow, idSeason));
+  }
+
+  db.CommitTransaction();
+}
+
+void PopulateMusicLibrary(CMusicDatabase &db, unsigned int scale)
+{
+  CRandom random(scale);
+  db.BeginTransaction();
+
+  for (unsigned int genre = 1; genre <= NUM_GENRES; genre++)
+    db.ExecuteQuery(db.PrepareSQL("INSERT INTO genre (idGenre, strGenre) VALUES (%u, 'Genre %u')", genre, genre));
+
+  unsigned int idAlbum = 0;
+  unsigned int idArtist = 1; // the blank artist is created with the tables
+  std::string artist;
+  std::string album;
+  unsigned int albumGenre = 1;
+  unsigned int albumYear = 0;
+  for (unsigned int idSong = 1; idSong <= scale; idSong++)
+  {
+    unsigned int track = (idSong - 1) % SONGS_PER_ALBUM + 1;
+    if (track == 1)
+    {
+      if (idAlbum % ALBUMS_PER_ARTIST == 0)
+      {
+        idArtist++;
+        artist = Title(random, idArtist);
+        db.ExecuteQuery(db.PrepareSQL("INSERT INTO artist (idArtist, strArtist) VALUES (%u, '%s')", idArtist, artist.c_str()));
+      }
+      idAlbum++;
+      album = Title(random, idAlbum);
+      albumGenre = 1 + random.Next(NUM_GENRES);
+      albumYear = 1950 + random.Next(70);
+      db.ExecuteQuery(db.PrepareSQL("INSERT INTO path (idPath, strPath) VALUES (%u, '/media/music/%u/')", idAlbum, idAlbum));
+      db.ExecuteQuery(db.PrepareSQL("INSERT INTO album (idAlbum, strAlbum, strArtists, strGenres, iYear) VALUES (%u, '%s', '%s', 'Genre %u', %u)",
+                                    idAlbum, album.c_str(), artist.c_str(), albumGenre, albumYear));
+      db.ExecuteQuery(db.PrepareSQL("INSERT INTO album_artist (idArtist, idAlbum, iOrder, strArtist) VALUES (%u, %u, 0, '%s')",
+                                    idArtist, idAlbum, artist.c_str()));
+      db.ExecuteQuery(db.PrepareSQL("INSERT INTO album_genre (idGenre, idAlbum, iOrder) VALUES (%u, %u, 0)", albumGenre, idAlbum));
+    }
+
+    db.ExecuteQuery(db.PrepareSQL("INSERT INTO song (idSong, idAlbum, idPath, strArtists, strGenres, strTitle, iTrack, iDuration, iYear, strFileName, iTimesPlayed, rating, userrating, dateAdded) "
+                                  "VALUES (%u, %u, %u, '%s', 'Genre %u', '%s', %u, %u, %u, 'track%02u.flac', %u, %f, %u, '%u-01-01 12:00:00')",
+                                  idSong, idAlbum, idAlbum, artist.c_str(), albumGenre, Title(random, idSong).c_str(), track,
+                                  120 + random.Next(300), albumYear, track, random.Next(20), random.Next(100) / 10.0, random.Next(11), albumYear));
+    db.ExecuteQuery(db.PrepareSQL("INSERT INTO song_artist (idArtist, idSong, idRole, iOrder, strArtist) VALUES (%u, %u, 1, 0, '%s')",
+                                  idArtist, idSong, artist.c_str()));
+    db.ExecuteQuery(db.PrepareSQL("INSERT INTO song_genre (idGenre, idSong, iOrder) VALUES (%u, %u, 0)", albumGenre, idSong));
+  }
+
+  db.CommitTransaction();
+}
+
+SortDescription Sorting(SortBy sortBy, SortOrder sortOrder = SortOrderAscending)
+{
+  SortDescription sorting;
+  sorting.sortBy = sortBy;
+  sorting.sortOrder = sortOrder;
+  sorting.sortAttributes = SortAttributeIgnoreArticle;
+  return sorting;
+}
+
+std::string PlaylistUrl(CDbUrl &url, const std::string &baseDir, const std::string &xsp)
+{
+  url.FromString(baseDir);
+  url.AddOption("xsp", xsp);
+  return url.ToString();
+}
+}
+
+KODI_BENCHMARK(VideoLibrary)
+{
+  DatabaseSettings settings = BenchmarkDatabaseSettings();
+  std::string name = StringUtils::Format("BenchVideos%u", state.Scale());
+  DeleteDatabase(settings, name);
+
+  CVideoDatabase db;
+  if (!db.Connect(name, settings, true))
+  {
+    fprintf(stderr, "%s: unable to create %s\n", state.Name().c_str(), name.c_str());
+    return;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  PopulateVideoLibrary(db, state.Scale());
+  std::vector<double> populate(1, ElapsedMs(start));
+  state.Report("populate", populate);
+
+  state.Measure("GetMoviesNav", [&db]() {
+    CFileItemList items;
+    db.GetMoviesNav("videodb://movies/titles/", items);
+  });
+  state.Measure("GetMoviesNav genre", [&db]() {
+    CFileItemList items;
+    db.GetMoviesNav("videodb://movies/titles/", items, 3);
+  });
+  state.Measure("GetMoviesNav sort title", [&db]() {
+    CFileItemList items;
+    db.GetMoviesNav("videodb://movies/titles/", items, -1, -1, -1, -1, -1, -1, -1, -1, Sorting(SortByTitle));
+  });
+  state.Measure("GetMoviesNav sort year page", [&db]() {
+    CFileItemList items;
+    SortDescription sorting = Sorting(SortByYear, SortOrderDescending);
+    sorting.limitEnd = 50;
+    db.GetMoviesNav("videodb://movies/titles/", items, -1, -1, -1, -1, -1, -1, -1, -1, sorting);
+  });
+  state.Measure("GetMoviesByWhere playlist", [&db]() {
+    CVideoDbUrl url;
+    CFileItemList items;
+    std::string xsp = "{\"type\":\"movies\",\"rules\":{\"and\":["
+                      "{\"field\":\"genre\",\"operator\":\"is\",\"value\":[\"Genre 5\",\"Genre 7\"]},"
+                      "{\"field\":\"year\",\"operator\":\"greaterthan\",\"value\":\"1980\"},"
+                      "{\"field\":\"playcount\",\"operator\":\"is\",\"value\":\"0\"}]}}";
+    db.GetMoviesByWhere(PlaylistUrl(url, "videodb://movies/titles/", xsp), CDatabase::Filter(), items, Sorting(SortByRating, SortOrderDescending));
+  });
+  state.Measure("GetEpisodesByWhere", [&db]() {
+    CFileItemList items;
+    db.GetEpisodesByWhere("videodb://tvshows/titles/-1/-1/", CDatabase::Filter(), items);
+  });
+  state.Measure("GetEpisodesByWhere sort", [&db]() {
+    CFileItemList items;
+    db.GetEpisodesByWhere("videodb://tvshows/titles/-1/-1/", CDatabase::Filter(), items, true, Sorting(SortByEpisodeNumber));
+  });
+  state.Measure("GetEpisodesByWhere playlist", [&db]() {
+    CVideoDbUrl url;
+    CFileItemList items;
+    std::string xsp = "{\"type\":\"episodes\",\"rules\":{\"and\":["
+                      "{\"field\":\"airdate\",\"operator\":\"after\",\"value\":\"2000-01-01\"},"
+                      "{\"field\":\"title\",\"operator\":\"contains\",\"value\":\"Night\"}]}}";
+    db.GetEpisodesByWhere(PlaylistUrl(url, "videodb://tvshows/titles/-1/-1/", xsp), CDatabase::Filter(), items, true, Sorting(SortByTitle));
+  });
+
+  db.Close();
+  DeleteDatabase(settings, name);
+}
+
+KODI_BENCHMARK(MusicLibrary)
+{
+  DatabaseSettings settings = BenchmarkDatabaseSettings();
+  std::string name = StringUtils::Format("BenchMusic%u", state.Scale());
+  DeleteDatabase(settings, name);
+
+  CMusicDatabase db;
+  if (!db.Connect(name, settings, true))
+  {
+    fprintf(stderr, "%s: unable to create %s\n", state.Name().c_str(), name.c_str());
+    return;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  PopulateMusicLibrary(db, state.Scale());
+  std::vector<double> populate(1, ElapsedMs(start));
+  state.Report("populate", populate);
+
+  state.Measure("GetSongsFullByWhere", [&db]() {
+    CFileItemList items;
+    db.GetSongsFullByWhere("musicdb://songs/", CDatabase::Filter(), items);
+  });
+  state.Measure("GetSongsFullByWhere artists", [&db]() {
+    CFileItemList items;
+    db.GetSongsFullByWhere("musicdb://songs/", CDatabase::Filter(), items, SortDescription(), true);
+  });
+  state.Measure("GetSongsFullByWhere sort artist", [&db]() {
+    CFileItemList items;
+    db.GetSongsFullByWhere("musicdb://songs/", CDatabase::Filter(), items, Sorting(SortByArtist));
+  });
+  state.Measure("GetSongsFullByWhere playlist", [&db]() {
+    CMusicDbUrl url;
+    CFileItemList items;
+    std::string xsp = "{\"type\":\"songs\",\"rules\":{\"and\":["
+                      "{\"field\":\"genre\",\"operator\":\"is\",\"value\":[\"Genre 2\",\"Genre 9\"]},"
+                      "{\"field\":\"year\",\"operator\":\"lessthan\",\"value\":\"2000\"},"
+                      "{\"field\":\"rating\",\"operator\":\"greaterthan\",\"value\":\"5\"}]}}";
+    db.GetSongsFullByWhere(PlaylistUrl(url, "musicdb://songs/", xsp), CDatabase::Filter(), items, Sorting(SortByTitle));
+  });
+
+  db.Close();
+  DeleteDatabase(settings, name);
+}
@@ -0,0 +1,137 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+#include "pictures/Picture.h"
+#include "pictures/PictureScaler.h"
+#include "utils/CPUInfo.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+// artwork as it is scraped, scaled to what the texture cache stores with the
+// default <fanartres> and <imageres>
+struct ArtworkSize
+{
+  const char *name;
+  unsigned int width;
+  unsigned int height;
+  unsigned int cachedWidth;
+  unsigned int cachedHeight;
+};
+
+const ArtworkSize ARTWORK_SIZES[] = {
+  { "fanart 4k",  3840, 2160, 1920, 1080 },
+  { "fanart",     1920, 1080, 1280,  720 },
+  { "poster",     1000, 1500,  480,  720 },
+  { "thumb",       758,  426,  256,  144 }
+};
+
+class CImage
+{
+public:
+  CImage(unsigned int width, unsigned int height)
+    : m_width(width),
+      m_height(height),
+      m_pixels(width * height * 4)
+  {
+    // a gradient with some noise, so nothing can be skipped
+    uint32_t state = width ^ height;
+    for (unsigned int y = 0; y < height; y++)
+    {
+      for (unsigned int x = 0; x < width; x++)
+      {
+        state = state * 1664525 + 1013904223;
+        uint8_t *pixel = &m_pixels[(y * width + x) * 4];
+        pixel[0] = (uint8_t)(x * 255 / width);
+        pixel[1] = (uint8_t)(y * 255 / height);
+        pixel[2] = (uint8_t)(state >> 24);
+        pixel[3] = 0xFF;
+      }
+    }
+  }
+
+  unsigned int m_width;
+  unsigned int m_height;
+  std::vector<uint8_t> m_pixels;
+};
+}
+
+// Scale() is the number of images scaled per run, like the artwork of a
+// poster wall being cached
+KODI_BENCHMARK(PictureScaler)
+{
+  for (const ArtworkSize &size : ARTWORK_SIZES)
+  {
+    CImage image(size.width, size.height);
+    std::vector<uint8_t> cached(size.cachedWidth * size.cachedHeight * 4);
+    const std::string name = size.name;
+
+    const struct
+    {
+      const char *label;
+      CPictureScalingAlgorithm::Algorithm algorithm;
+    } swscaleAlgorithms[] = {
+      { "swscale bicubic", CPictureScalingAlgorithm::Bicubic },
+      { "swscale area", CPictureScalingAlgorithm::AveragingArea },
+      { "swscale lanczos", CPictureScalingAlgorithm::Lanczos }
+    };
+    for (const auto &algorithm : swscaleAlgorithms)
+    {
+      state.Measure(name + " " + algorithm.label, [&]() {
+        for (unsigned int i = 0; i < state.Scale(); i++)
+          CPicture::ScaleImage(image.m_pixels.data(), image.m_width, image.m_height, image.m_width * 4,
+                               cached.data(), size.cachedWidth, size.cachedHeight, size.cachedWidth * 4,
+                               algorithm.algorithm);
+      });
+    }
+
+    const struct
+    {
+      const char *label;
+      unsigned int cpuFeatures;
+      unsigned int threads;
+    } implementations[] = {
+      { "scalar", 0, 1 },
+      { "sse2", CPU_FEATURE_SSE2, 1 },
+      { "avx2", CPU_FEATURE_SSE2 | CPU_FEATURE_AVX2, 1 },
+      { "parallel", ~0U, 0 }
+    };
+    for (unsigned int filter = CPictureScaler::AveragingArea; filter <= CPictureScaler::Lanczos; filter++)
+    {
+      for (const auto &implementation : implementations)
+      {
+        if (implementation.cpuFeatures != ~0U && (g_cpuInfo.GetCPUFeatures() & implementation.cpuFeatures) != implementation.cpuFeatures)
+          continue;
+
+        const std::string label = name + (filter == CPictureScaler::Lanczos ? " lanczos " : " area ") + implementation.label;
+        state.Measure(label, [&]() {
+          for (unsigned int i = 0; i < state.Scale(); i++)
+            CPictureScaler::Scale(image.m_pixels.data(), image.m_width, image.m_height, image.m_width * 4,
+                                  cached.data(), size.cachedWidth, size.cachedHeight, size.cachedWidth * 4,
+                                  (CPictureScaler::Filter)filter, implementation.threads, implementation.cpuFeatures);
+        });
+      }
+    }
+  }
+}
@@ -0,0 +1,207 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+#include "FileItem.h"
+#include "utils/SortUtils.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+#include "video/VideoInfoTag.h"
+
+#include <chrono>
+#include <stdint.h>
+
+namespace
+{
+const char *WORDS[] = {
+  "Night", "Return", "Dark", "River", "Last", "City", "Summer", "Ghost", "Iron",
+  "Silent", "Empire", "Storm", "Golden", "Road", "Winter", "Secret", "Fire",
+  "Lost", "Island", "Star", "Shadow", "Blue", "Kingdom", "Heart", "Wild", "Glass"
+};
+const unsigned int NUM_WORDS = sizeof(WORDS) / sizeof(WORDS[0]);
+
+// deterministic so every run sorts the same items
+class CRandom
+{
+public:
+  explicit CRandom(uint32_t seed) : m_state(seed) {}
+  uint32_t Next(uint32_t max)
+  {
+    m_state = m_state * 1664525 + 1013904223;
+    return (m_state >> 8) % max;
+  }
+private:
+  uint32_t m_state;
+};
+
+std::string Title(CRandom &random)
+{
+  // some titles with articles, so sorting has to strip them
+  std::string title = random.Next(5) == 0 ? "The " : "";
+  title += WORDS[random.Next(NUM_WORDS)];
+  title += " ";
+  title += WORDS[random.Next(NUM_WORDS)];
+  if (random.Next(3) == 0)
+    title += StringUtils::Format(" %u", 1 + random.Next(12));
+  return title;
+}
+
+DatabaseResults CreateResults(unsigned int scale)
+{
+  CRandom random(scale);
+  DatabaseResults results;
+  results.reserve(scale);
+  for (unsigned int i = 0; i < scale; i++)
+  {
+    SortItem item;
+    item[FieldId] = i + 1;
+    item[FieldRow] = i;
+    item[FieldTitle] = Title(random);
+    item[FieldLabel] = item[FieldTitle];
+    item[FieldYear] = 1950 + random.Next(70);
+    item[FieldRating] = random.Next(100) / 10.0f;
+    item[FieldPlaycount] = random.Next(4);
+    item[FieldDateAdded] = StringUtils::Format("2016-%02u-%02u %02u:%02u:00", 1 + random.Next(12), 1 + random.Next(28),
+                                               random.Next(24), random.Next(60));
+    results.push_back(item);
+  }
+  return results;
+}
+
+void CreateFileItems(unsigned int scale, CFileItemList &items)
+{
+  CRandom random(scale);
+  for (unsigned int i = 0; i < scale; i++)
+  {
+    CVideoInfoTag tag;
+    tag.m_iDbId = i + 1;
+    tag.m_type = MediaTypeMovie;
+    tag.m_strTitle = Title(random);
+    tag.SetYear(1950 + random.Next(70));
+    tag.SetRating(random.Next(100) / 10.0f);
+    tag.m_playCount = random.Next(4);
+
+    CFileItemPtr item(new CFileItem(tag));
+    item->SetLabel(tag.m_strTitle);
+    items.Add(item);
+  }
+}
+
+// the way CFileItemList::Sort worked before the typed sort keys
+void SortFileItemsByPreparator(CFileItemList &items, const SortDescription &sorting)
+{
+  const Fields fields = SortUtils::GetFieldsForSorting(sorting.sortBy);
+  SortItems sortItems((size_t)items.Size());
+  for (int index = 0; index < items.Size(); index++)
+  {
+    sortItems[index] = std::shared_ptr<SortItem>(new SortItem);
+    items[index]->ToSortable(*sortItems[index], fields);
+    (*sortItems[index])[FieldId] = index;
+  }
+
+  SortUtils::SortByPreparator(sorting.sortBy, sorting.sortOrder, sorting.sortAttributes, sortItems, sorting.limitEnd, sorting.limitStart);
+
+  VECFILEITEMS sortedFileItems;
+  sortedFileItems.reserve(sortItems.size());
+  for (SortItems::const_iterator it = sortItems.begin(); it != sortItems.end(); ++it)
+  {
+    CFileItemPtr item = items.Get((int)(*it)->at(FieldId).asInteger());
+    item->SetSortLabel((*it)->at(FieldSort).asWideString());
+    sortedFileItems.push_back(item);
+  }
+}
+
+SortDescription Sorting(SortBy sortBy, SortOrder sortOrder = SortOrderAscending)
+{
+  SortDescription sorting;
+  sorting.sortBy = sortBy;
+  sorting.sortOrder = sortOrder;
+  sorting.sortAttributes = SortAttributeIgnoreArticle;
+  return sorting;
+}
+
+// every sort needs unsorted input, so the copy is kept out of the timing
+template<typename Sort>
+void MeasureResults(CBenchmarkState &state, const std::string &label, const DatabaseResults &results, Sort sort)
+{
+  std::vector<double> samples;
+  for (unsigned int i = 0; i <= state.Iterations(); i++)
+  {
+    DatabaseResults items = results;
+    auto start = std::chrono::steady_clock::now();
+    sort(items);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    // the first run is the warm-up
+    if (i > 0)
+      samples.push_back(elapsed.count());
+  }
+  state.Report(label, samples);
+}
+
+template<typename Sort>
+void MeasureFileItems(CBenchmarkState &state, const std::string &label, Sort sort)
+{
+  std::vector<double> samples;
+  for (unsigned int i = 0; i <= state.Iterations(); i++)
+  {
+    CFileItemList items;
+    CreateFileItems(state.Scale(), items);
+    auto start = std::chrono::steady_clock::now();
+    sort(items);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    if (i > 0)
+      samples.push_back(elapsed.count());
+  }
+  state.Report(label, samples);
+}
+}
+
+KODI_BENCHMARK(SortUtils)
+{
+  const DatabaseResults results = CreateResults(state.Scale());
+
+  const SortBy sortMethods[] = { SortByTitle, SortByYear, SortByRating, SortByDateAdded };
+  for (const auto sortBy : sortMethods)
+  {
+    const SortDescription sorting = Sorting(sortBy);
+    const std::string method = SortUtils::SortMethodToString(sortBy);
+
+    MeasureResults(state, "results " + method + " preparator", results, [&sorting](DatabaseResults &items) {
+      SortUtils::SortByPreparator(sorting.sortBy, sorting.sortOrder, sorting.sortAttributes, items);
+    });
+    MeasureResults(state, "results " + method + " keys", results, [&sorting](DatabaseResults &items) {
+      SortUtils::Sort(sorting, items);
+    });
+  }
+
+  const SortBy fileItemSortMethods[] = { SortByTitle, SortByYear };
+  for (const auto sortBy : fileItemSortMethods)
+  {
+    const SortDescription sorting = Sorting(sortBy, SortOrderDescending);
+    const std::string method = SortUtils::SortMethodToString(sortBy);
+
+    MeasureFileItems(state, "fileitems " + method + " preparator", [&sorting](CFileItemList &items) {
+      SortFileItemsByPreparator(items, sorting);
+    });
+    MeasureFileItems(state, "fileitems " + method + " keys", [&sorting](CFileItemList &items) {
+      items.Sort(sorting);
+    });
+  }
+}
@@ -0,0 +1,85 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+namespace
+{
+// looks like the movies of a VideoLibrary.GetMovies response
+CVariant CreateMovies(unsigned int scale)
+{
+  CVariant movies(CVariant::VariantTypeArray);
+  for (unsigned int i = 0; i < scale; i++)
+  {
+    CVariant movie;
+    movie["movieid"] = i + 1;
+    movie["label"] = StringUtils::Format("Movie %u", i);
+    movie["title"] = StringUtils::Format("Movie %u", i);
+    movie["year"] = 1950 + i % 70;
+    movie["rating"] = (i % 100) / 10.0;
+    movie["playcount"] = i % 4;
+    movie["file"] = StringUtils::Format("smb://server/share/movies/Movie %u (%u)/Movie %u.mkv", i, 1950 + i % 70, i);
+    movie["genre"].push_back("Drama");
+    movie["genre"].push_back("Science Fiction");
+    movie["art"]["poster"] = StringUtils::Format("image://smb%%3a%%2f%%2fserver%%2fshare%%2fmovies%%2fMovie%%20%u%%2fposter.jpg/", i);
+    movie["art"]["fanart"] = StringUtils::Format("image://smb%%3a%%2f%%2fserver%%2fshare%%2fmovies%%2fMovie%%20%u%%2ffanart.jpg/", i);
+    movies.push_back(std::move(movie));
+  }
+  return movies;
+}
+}
+
+KODI_BENCHMARK(Variant)
+{
+  const CVariant movies = CreateMovies(state.Scale());
+
+  state.Measure("construct", [&state]() {
+    CVariant created = CreateMovies(state.Scale());
+  });
+
+  state.Measure("copy", [&movies]() {
+    CVariant copy = movies;
+  });
+
+  int64_t found = 0;
+  state.Measure("lookup", [&movies, &found]() {
+    for (CVariant::const_iterator_array movie = movies.begin_array(); movie != movies.end_array(); ++movie)
+    {
+      found += (*movie)["movieid"].asInteger();
+      found += (*movie)["year"].asInteger();
+      found += (*movie)["art"]["poster"].size();
+      if ((*movie).isMember("playcount") && !(*movie).isMember("resume"))
+        found++;
+    }
+  });
+
+  std::string json;
+  state.Measure("json write", [&movies, &json]() {
+    json = CJSONVariantWriter::Write(movies, true);
+  });
+
+  state.Measure("json parse", [&json]() {
+    CVariant parsed = CJSONVariantParser::Parse(json);
+  });
+}
@@ -0,0 +1,160 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+
+#ifdef HAS_WEB_SERVER
+
+#include "Benchmark.h"
+#include "URL.h"
+#include "filesystem/CurlFile.h"
+#include "filesystem/File.h"
+#include "network/WebServer.h"
+#include "network/httprequesthandler/HTTPVfsHandler.h"
+#include "settings/MediaSourceSettings.h"
+#include "test/TestUtils.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#include <chrono>
+#include <functional>
+#include <inttypes.h>
+#include <thread>
+#include <vector>
+
+using namespace XFILE;
+
+#define WEBSERVER_PORT 23457
+
+namespace
+{
+const unsigned int CLIENTS = 4;
+
+// reads the whole response without keeping it around
+uint64_t Download(const std::string &url, const std::string &range = "")
+{
+  CCurlFile curl;
+  if (!range.empty())
+    curl.SetRequestHeader("Range", "bytes=" + range);
+  if (!curl.Open(CURL(url)))
+    return 0;
+
+  std::vector<char> buffer(64 * 1024);
+  uint64_t size = 0;
+  ssize_t read;
+  while ((read = curl.Read(buffer.data(), buffer.size())) > 0)
+    size += read;
+  curl.Close();
+
+  return size;
+}
+
+// measures download() like Measure() does and also reports the throughput
+// of every timed run in MB/s
+void MeasureThroughput(CBenchmarkState &state, const std::string &label, const std::function<uint64_t()> &download)
+{
+  std::vector<double> throughput;
+  bool warmup = true;
+  state.Measure(label, [&]() {
+    auto start = std::chrono::steady_clock::now();
+    const uint64_t bytes = download();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    if (!warmup && elapsed.count() > 0.0)
+      throughput.push_back(bytes / (elapsed.count() * 1000.0));
+    warmup = false;
+  });
+  state.Report(label + " MB/s", throughput);
+}
+}
+
+// Scale() is the size of the served file in KB
+KODI_BENCHMARK(WebServer)
+{
+  CFile *file = XBMC_CREATETEMPFILE(".bin");
+  if (file == nullptr)
+  {
+    fprintf(stderr, "%s: unable to create a temporary file\n", state.Name().c_str());
+    return;
+  }
+
+  std::string block(1024, 'x');
+  for (unsigned int i = 0; i < state.Scale(); i++)
+    file->Write(block.c_str(), block.size());
+  file->Flush();
+  const std::string filePath = XBMC_TEMPFILEPATH(file);
+  const uint64_t fileSize = static_cast<uint64_t>(state.Scale()) * block.size();
+
+  // the VFS handler only serves files from a source
+  CMediaSource source;
+  source.strName = "WebServer Benchmark";
+  source.strPath = URIUtils::GetDirectory(filePath);
+  source.vecPaths.push_back(source.strPath);
+  source.m_allowSharing = true;
+  source.m_iDriveType = CMediaSource::SOURCE_TYPE_LOCAL;
+  source.m_iLockMode = LOCK_MODE_EVERYONE;
+  source.m_ignore = true;
+  CMediaSourceSettings::GetInstance().AddShare("videos", source);
+
+  CWebServer webserver;
+  CHTTPVfsHandler vfsHandler;
+  webserver.RegisterRequestHandler(&vfsHandler);
+  if (!webserver.Start(WEBSERVER_PORT, "", ""))
+  {
+    fprintf(stderr, "%s: unable to start the webserver\n", state.Name().c_str());
+    webserver.UnregisterRequestHandler(&vfsHandler);
+    CMediaSourceSettings::GetInstance().Clear();
+    XBMC_DELETETEMPFILE(file);
+    return;
+  }
+
+  const std::string url = StringUtils::Format("http://localhost:%d/vfs/%s", WEBSERVER_PORT, CURL::Encode(filePath).c_str());
+
+  MeasureThroughput(state, "full download", [&]() {
+    return Download(url);
+  });
+
+  // the second half of the file like a player seeking into a movie
+  const std::string range = StringUtils::Format("%" PRIu64 "-", fileSize / 2);
+  MeasureThroughput(state, "range download", [&]() {
+    return Download(url, range);
+  });
+
+  // several clients streaming at the same time
+  MeasureThroughput(state, "concurrent download", [&]() {
+    std::vector<std::thread> clients;
+    std::vector<uint64_t> sizes(CLIENTS, 0);
+    for (unsigned int i = 0; i < CLIENTS; i++)
+      clients.push_back(std::thread([&, i]() { sizes[i] = Download(url); }));
+    uint64_t downloaded = 0;
+    for (unsigned int i = 0; i < CLIENTS; i++)
+    {
+      clients[i].join();
+      downloaded += sizes[i];
+    }
+    return downloaded;
+  });
+
+  webserver.Stop();
+  webserver.UnregisterRequestHandler(&vfsHandler);
+  CMediaSourceSettings::GetInstance().Clear();
+  XBMC_DELETETEMPFILE(file);
+}
+
+#endif // HAS_WEB_SERVER
@@ -0,0 +1,211 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Benchmark.h"
+#include "utils/StringUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> s_allocations(0);
+
+void *operator new(size_t size)
+{
+  s_allocations.fetch_add(1, std::memory_order_relaxed);
+  void *memory = malloc(size > 0 ? size : 1);
+  if (memory == NULL)
+    throw std::bad_alloc();
+  return memory;
+}
+
+void *operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+  free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+  operator delete(memory);
+}
+
+// the sized forms are used by C++14 compilers for complete types and would
+// otherwise go to the library's operator delete
+void operator delete(void *memory, size_t) noexcept
+{
+  operator delete(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept
+{
+  operator delete(memory);
+}
+
+uint64_t CBenchmarkState::Allocations()
+{
+  return s_allocations.load(std::memory_order_relaxed);
+}
+
+CBenchmarkState::CBenchmarkState(const std::string &name, unsigned int scale, unsigned int iterations, std::vector<BenchmarkResult> &results)
+  : m_name(name),
+    m_scale(scale),
+    m_iterations(iterations),
+    m_results(results)
+{
+}
+
+static double Percentile(const std::vector<double> &sorted, double percent)
+{
+  // nearest rank
+  size_t rank = (size_t)std::ceil(percent / 100.0 * sorted.size());
+  if (rank > 0)
+    rank--;
+  return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+void CBenchmarkState::Report(const std::string &label, std::vector<double> &samples, double allocations /* = -1.0 */)
+{
+  if (samples.empty())
+    return;
+
+  std::sort(samples.begin(), samples.end());
+
+  double sum = 0.0;
+  for (double sample : samples)
+    sum += sample;
+
+  BenchmarkResult result;
+  result.name = m_name;
+  result.label = label;
+  result.scale = m_scale;
+  result.iterations = samples.size();
+  result.min = samples.front();
+  result.mean = sum / samples.size();
+  result.p50 = Percentile(samples, 50);
+  result.p90 = Percentile(samples, 90);
+  result.p99 = Percentile(samples, 99);
+  result.max = samples.back();
+  result.allocations = allocations;
+  m_results.push_back(result);
+
+  std::string allocationsText = allocations < 0 ? "-" : StringUtils::Format("%.0f", allocations);
+  printf("%-28s %-32s %8u %5u %10.3f %10.3f %10.3f %10.3f %10.3f %10s\n",
+         result.name.c_str(), result.label.c_str(), result.scale, result.iterations,
+         result.min, result.p50, result.p90, result.p99, result.max, allocationsText.c_str());
+  fflush(stdout);
+}
+
+CBenchmarkRegistry &CBenchmarkRegistry::GetInstance()
+{
+  static CBenchmarkRegistry s_registry;
+  return s_registry;
+}
+
+bool CBenchmarkRegistry::Register(const std::string &name, BenchmarkFunc func)
+{
+  Benchmark benchmark = { name, func };
+  m_benchmarks.push_back(benchmark);
+  return true;
+}
+
+void CBenchmarkRegistry::WriteCsv(FILE *out, const BenchmarkResult &result) const
+{
+  fprintf(out, "%s,%s,%u,%u,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.1f\n",
+          result.name.c_str(), result.label.c_str(), result.scale, result.iterations,
+          result.min, result.mean, result.p50, result.p90, result.p99, result.max, result.allocations);
+}
+
+int CBenchmarkRegistry::Run(int argc, char **argv)
+{
+  std::string filter;
+  std::string csvFile;
+  std::vector<unsigned int> scales;
+  unsigned int iterations = 10;
+  bool list = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (StringUtils::StartsWith(arg, "--bench-filter="))
+      filter = arg.substr(15);
+    else if (StringUtils::StartsWith(arg, "--bench-scale="))
+    {
+      for (const auto &scale : StringUtils::Split(arg.substr(14), ","))
+        scales.push_back(strtoul(scale.c_str(), NULL, 10));
+    }
+    else if (StringUtils::StartsWith(arg, "--bench-iterations="))
+      iterations = std::max(1UL, strtoul(arg.c_str() + 19, NULL, 10));
+    else if (StringUtils::StartsWith(arg, "--bench-csv="))
+      csvFile = arg.substr(12);
+    else if (arg == "--bench-list")
+      list = true;
+  }
+  if (scales.empty())
+    scales.push_back(10000);
+
+  std::sort(m_benchmarks.begin(), m_benchmarks.end(),
+            [](const Benchmark &a, const Benchmark &b) { return a.name < b.name; });
+
+  if (list)
+  {
+    for (const auto &benchmark : m_benchmarks)
+      printf("%s\n", benchmark.name.c_str());
+    return 0;
+  }
+
+  printf("%-28s %-32s %8s %5s %10s %10s %10s %10s %10s %10s\n",
+         "benchmark", "operation", "scale", "runs", "min ms", "p50 ms", "p90 ms", "p99 ms", "max ms", "allocs");
+
+  std::vector<BenchmarkResult> results;
+  for (const auto &benchmark : m_benchmarks)
+  {
+    if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+      continue;
+
+    for (unsigned int scale : scales)
+    {
+      CBenchmarkState state(benchmark.name, scale, iterations, results);
+      benchmark.func(state);
+    }
+  }
+
+  if (!csvFile.empty())
+  {
+    FILE *out = fopen(csvFile.c_str(), "w");
+    if (!out)
+    {
+      fprintf(stderr, "Unable to write benchmark results to %s\n", csvFile.c_str());
+      return 1;
+    }
+    fprintf(out, "benchmark,operation,scale,runs,min,mean,p50,p90,p99,max,allocations\n");
+    for (const auto &result : results)
+      WriteCsv(out, result);
+    fclose(out);
+  }
+
+  return 0;
+}
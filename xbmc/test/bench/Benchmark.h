@@ -0,0 +1,139 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/*!
+ \brief Latency statistics of one measured operation, in milliseconds, and
+ the number of heap allocations per run (negative if unknown).
+ */
+struct BenchmarkResult
+{
+  std::string name;
+  std::string label;
+  unsigned int scale;
+  unsigned int iterations;
+  double min;
+  double mean;
+  double p50;
+  double p90;
+  double p99;
+  double max;
+  double allocations;
+};
+
+/*!
+ \brief State handed to a benchmark body.
+
+ A benchmark sets up its data for Scale() items and then times one or more
+ operations with Measure(). Every measured operation runs Iterations() times
+ after an untimed warm-up run and is reported with its latency percentiles.
+ */
+class CBenchmarkState
+{
+public:
+  CBenchmarkState(const std::string &name, unsigned int scale, unsigned int iterations, std::vector<BenchmarkResult> &results);
+
+  const std::string &Name() const { return m_name; }
+  unsigned int Scale() const { return m_scale; }
+  unsigned int Iterations() const { return m_iterations; }
+
+  template<typename Func>
+  void Measure(const std::string &label, Func func)
+  {
+    func();
+
+    std::vector<double> samples;
+    samples.reserve(m_iterations);
+    uint64_t allocations = 0;
+    for (unsigned int i = 0; i < m_iterations; i++)
+    {
+      uint64_t allocationsBefore = Allocations();
+      auto start = std::chrono::steady_clock::now();
+      func();
+      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+      allocations += Allocations() - allocationsBefore;
+      samples.push_back(elapsed.count());
+    }
+    Report(label, samples, (double)allocations / m_iterations);
+  }
+
+  /*!
+   \brief Report samples that were timed by the benchmark itself.
+   \param allocations the mean number of heap allocations per sample, negative if unknown
+   */
+  void Report(const std::string &label, std::vector<double> &samples, double allocations = -1.0);
+
+  /*!
+   \brief The number of heap allocations made by the process so far.
+
+   Counted by the global operator new of the benchmark binary.
+   */
+  static uint64_t Allocations();
+
+private:
+  std::string m_name;
+  unsigned int m_scale;
+  unsigned int m_iterations;
+  std::vector<BenchmarkResult> &m_results;
+};
+
+typedef void (*BenchmarkFunc)(CBenchmarkState &state);
+
+/*!
+ \brief Collects the benchmarks registered with KODI_BENCHMARK and runs them.
+
+ Recognised arguments:
+  --bench-filter=<substring>    only run benchmarks whose name contains it
+  --bench-scale=<n>[,<n>...]    data sizes to run every benchmark with
+  --bench-iterations=<n>        timed runs per operation
+  --bench-csv=<file>            also write the results to a CSV file
+  --bench-list                  list the benchmarks and exit
+ Other arguments are ignored so they can be handled by the test utilities.
+ */
+class CBenchmarkRegistry
+{
+public:
+  static CBenchmarkRegistry &GetInstance();
+
+  bool Register(const std::string &name, BenchmarkFunc func);
+  int Run(int argc, char **argv);
+
+private:
+  CBenchmarkRegistry() = default;
+  void WriteCsv(FILE *out, const BenchmarkResult &result) const;
+
+  struct Benchmark
+  {
+    std::string name;
+    BenchmarkFunc func;
+  };
+  std::vector<Benchmark> m_benchmarks;
+};
+
+#define KODI_BENCHMARK(name) \
+  static void Benchmark_##name(CBenchmarkState &state); \
+  static bool Benchmark_##name##_registered = CBenchmarkRegistry::GetInstance().Register(#name, Benchmark_##name); \
+  static void Benchmark_##name(CBenchmarkState &state)
@@ -0,0 +1,37 @@
+/*
+ *      Copyright (C) 2005-2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Benchmark.h"
+#include "test/TestBasicEnvironment.h"
+#include "test/TestUtils.h"
+
+int main(int argc, char **argv)
+{
+  CXBMCTestUtils::Instance().ParseArgs(argc, argv);
+
+  // benchmarks run against the same environment as the unit tests
+  TestBasicEnvironment environment;
+  environment.SetUp();
+  int ret = CBenchmarkRegistry::GetInstance().Run(argc, argv);
+  environment.TearDown();
+
+  return ret;
+}
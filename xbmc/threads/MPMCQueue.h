@@ -0,0 +1,127 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threads/Helpers.h"
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Bounded lock-free queue for any number of producer and consumer threads.
+ *
+ * Every slot carries a sequence number that tells producers and consumers
+ * whether it is free or filled for the current lap of the ring, so Push() and
+ * Pop() only contend on a single compare-and-swap of the tail or head index.
+ * Nothing is allocated after construction. Items are popped in the order they
+ * were pushed; items pushed concurrently by different threads have no defined
+ * order among each other.
+ *
+ * Use CSPSCQueue if there is only one producer and one consumer thread.
+ */
+template<typename T>
+class CMPMCQueue : public XbmcThreads::NonCopyable
+{
+public:
+  /*!
+   \param capacity maximum number of queued items, rounded up to a power of two
+   */
+  explicit CMPMCQueue(size_t capacity)
+  {
+    size_t size = 1;
+    while (size < capacity)
+      size <<= 1;
+    m_cells.reset(new Cell[size]);
+    for (size_t i = 0; i < size; i++)
+      m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    m_mask = size - 1;
+  }
+
+  /*! \return false if the queue is full */
+  bool Push(const T &item)
+  {
+    Cell *cell;
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      cell = &m_cells[tail & m_mask];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t diff = (intptr_t)sequence - (intptr_t)tail;
+      if (diff == 0)
+      {
+        if (m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+        return false;
+      else
+        tail = m_tail.load(std::memory_order_relaxed);
+    }
+
+    cell->item = item;
+    cell->sequence.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /*! \return false if the queue is empty */
+  bool Pop(T &item)
+  {
+    Cell *cell;
+    size_t head = m_head.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      cell = &m_cells[head & m_mask];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t diff = (intptr_t)sequence - (intptr_t)(head + 1);
+      if (diff == 0)
+      {
+        if (m_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+        return false;
+      else
+        head = m_head.load(std::memory_order_relaxed);
+    }
+
+    item = cell->item;
+    cell->sequence.store(head + m_mask + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t Capacity() const { return m_mask + 1; }
+
+private:
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    T item;
+  };
+
+  std::unique_ptr<Cell[]> m_cells;
+  size_t m_mask;
+  char m_padding0[64];
+  std::atomic<size_t> m_head{0};
+  char m_padding1[64];
+  std::atomic<size_t> m_tail{0};
+  char m_padding2[64];
+};
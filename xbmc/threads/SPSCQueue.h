@@ -0,0 +1,104 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threads/Helpers.h"
+
+#include <atomic>
+#include <stddef.h>
+#include <vector>
+
+/**
+ * @brief Bounded lock-free queue for exactly one producer and one consumer thread.
+ *
+ * All items are allocated up front, Push() and Pop() neither lock nor
+ * allocate. Push() may only be called by the producer thread, Pop() only by
+ * the consumer thread. Size() and Empty() can be called from both, the result
+ * is a snapshot.
+ */
+template<typename T>
+class CSPSCQueue : public XbmcThreads::NonCopyable
+{
+public:
+  /*!
+   \param capacity maximum number of queued items, rounded up to a power of two
+   */
+  explicit CSPSCQueue(size_t capacity)
+  {
+    size_t size = 1;
+    while (size < capacity)
+      size <<= 1;
+    m_items.resize(size);
+    m_mask = size - 1;
+  }
+
+  /*! \return false if the queue is full */
+  bool Push(const T &item)
+  {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_cachedHead > m_mask)
+    {
+      m_cachedHead = m_head.load(std::memory_order_acquire);
+      if (tail - m_cachedHead > m_mask)
+        return false;
+    }
+
+    m_items[tail & m_mask] = item;
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /*! \return false if the queue is empty */
+  bool Pop(T &item)
+  {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_cachedTail)
+    {
+      m_cachedTail = m_tail.load(std::memory_order_acquire);
+      if (head == m_cachedTail)
+        return false;
+    }
+
+    item = m_items[head & m_mask];
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t Size() const
+  {
+    return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+  }
+
+  bool Empty() const { return Size() == 0; }
+  size_t Capacity() const { return m_items.size(); }
+
+private:
+  // head and tail are kept on separate cache lines, together with the copy
+  // of the other index their thread last saw
+  std::vector<T> m_items;
+  size_t m_mask;
+  char m_padding0[64];
+  std::atomic<size_t> m_head{0};
+  size_t m_cachedTail = 0;
+  char m_padding1[64];
+  std::atomic<size_t> m_tail{0};
+  size_t m_cachedHead = 0;
+  char m_padding2[64];
+};
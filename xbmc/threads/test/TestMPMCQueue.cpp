@@ -0,0 +1,151 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threads/MPMCQueue.h"
+
+#include "threads/test/TestHelpers.h"
+
+#include <atomic>
+#include <vector>
+
+#define NUMTHREADS 4
+#define NUMITEMS 250000
+
+class MPMCProducer : public IRunnable
+{
+  CMPMCQueue<unsigned int>& queue;
+  unsigned int id;
+public:
+  inline MPMCProducer(CMPMCQueue<unsigned int>& q, unsigned int i) : queue(q), id(i) {}
+
+  virtual void Run()
+  {
+    // the thread id in the upper bits lets the consumers check the order
+    for (unsigned int i = 0; i < NUMITEMS; i++)
+    {
+      while (!queue.Push(id << 24 | i))
+        XbmcThreads::ThreadSleep(0);
+    }
+  }
+};
+
+class MPMCConsumer : public IRunnable
+{
+  CMPMCQueue<unsigned int>& queue;
+  std::atomic<unsigned int>& consumed;
+public:
+  bool ordered;
+  uint64_t sum;
+
+  inline MPMCConsumer(CMPMCQueue<unsigned int>& q, std::atomic<unsigned int>& c) :
+    queue(q), consumed(c), ordered(true), sum(0) {}
+
+  virtual void Run()
+  {
+    std::vector<int> last(NUMTHREADS, -1);
+    while (consumed < NUMTHREADS * NUMITEMS)
+    {
+      unsigned int item;
+      if (!queue.Pop(item))
+      {
+        XbmcThreads::ThreadSleep(0);
+        continue;
+      }
+      consumed++;
+      const int producer = item >> 24;
+      const int value = item & 0xFFFFFF;
+      if (value <= last[producer])
+        ordered = false;
+      last[producer] = value;
+      sum += value;
+    }
+  }
+};
+
+TEST(TestMPMCQueue, Capacity)
+{
+  CMPMCQueue<int> queue(3);
+  EXPECT_EQ(4U, queue.Capacity());
+
+  for (int i = 0; i < 4; i++)
+    EXPECT_TRUE(queue.Push(i));
+  EXPECT_FALSE(queue.Push(4));
+
+  int item;
+  EXPECT_TRUE(queue.Pop(item));
+  EXPECT_EQ(0, item);
+  EXPECT_TRUE(queue.Push(4));
+  EXPECT_FALSE(queue.Push(5));
+}
+
+TEST(TestMPMCQueue, Order)
+{
+  CMPMCQueue<int> queue(4);
+  int item;
+  EXPECT_FALSE(queue.Pop(item));
+
+  // wrap around several times
+  for (int i = 0; i < 10; i++)
+  {
+    EXPECT_TRUE(queue.Push(i * 3));
+    EXPECT_TRUE(queue.Push(i * 3 + 1));
+    EXPECT_TRUE(queue.Push(i * 3 + 2));
+    for (int j = 0; j < 3; j++)
+    {
+      EXPECT_TRUE(queue.Pop(item));
+      EXPECT_EQ(i * 3 + j, item);
+    }
+  }
+  EXPECT_FALSE(queue.Pop(item));
+}
+
+TEST(TestMPMCQueue, Threads)
+{
+  CMPMCQueue<unsigned int> queue(64);
+  std::atomic<unsigned int> consumed(0);
+  std::vector<MPMCProducer> producers;
+  std::vector<MPMCConsumer> consumers;
+  for (unsigned int i = 0; i < NUMTHREADS; i++)
+  {
+    producers.push_back(MPMCProducer(queue, i));
+    consumers.push_back(MPMCConsumer(queue, consumed));
+  }
+
+  std::vector<thread*> threads;
+  for (unsigned int i = 0; i < NUMTHREADS; i++)
+  {
+    threads.push_back(new thread(producers[i]));
+    threads.push_back(new thread(consumers[i]));
+  }
+  for (thread *t : threads)
+  {
+    EXPECT_TRUE(t->timed_join(MILLIS(30000)));
+    delete t;
+  }
+
+  // every item arrives once and items of one producer stay in order
+  uint64_t sum = 0;
+  for (const MPMCConsumer &consumer : consumers)
+  {
+    EXPECT_TRUE(consumer.ordered);
+    sum += consumer.sum;
+  }
+  EXPECT_EQ((uint64_t)NUMTHREADS * NUMITEMS * (NUMITEMS - 1) / 2, sum);
+}
@@ -0,0 +1,102 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threads/SPSCQueue.h"
+
+#include "threads/test/TestHelpers.h"
+
+#define NUMITEMS 1000000
+
+class QueueProducer : public IRunnable
+{
+  CSPSCQueue<unsigned int>& queue;
+public:
+  inline QueueProducer(CSPSCQueue<unsigned int>& q) : queue(q) {}
+
+  virtual void Run()
+  {
+    for (unsigned int i = 0; i < NUMITEMS; i++)
+    {
+      while (!queue.Push(i))
+        XbmcThreads::ThreadSleep(0);
+    }
+  }
+};
+
+TEST(TestSPSCQueue, Capacity)
+{
+  CSPSCQueue<int> queue(5);
+  EXPECT_EQ(8U, queue.Capacity());
+  EXPECT_TRUE(queue.Empty());
+
+  for (int i = 0; i < 8; i++)
+    EXPECT_TRUE(queue.Push(i));
+  EXPECT_FALSE(queue.Push(8));
+  EXPECT_EQ(8U, queue.Size());
+
+  int item;
+  EXPECT_TRUE(queue.Pop(item));
+  EXPECT_EQ(0, item);
+  EXPECT_TRUE(queue.Push(8));
+  EXPECT_FALSE(queue.Push(9));
+}
+
+TEST(TestSPSCQueue, Order)
+{
+  CSPSCQueue<int> queue(4);
+  int item;
+  EXPECT_FALSE(queue.Pop(item));
+
+  // wrap around several times
+  for (int i = 0; i < 10; i++)
+  {
+    EXPECT_TRUE(queue.Push(i * 2));
+    EXPECT_TRUE(queue.Push(i * 2 + 1));
+    EXPECT_TRUE(queue.Pop(item));
+    EXPECT_EQ(i * 2, item);
+    EXPECT_TRUE(queue.Pop(item));
+    EXPECT_EQ(i * 2 + 1, item);
+  }
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_FALSE(queue.Pop(item));
+}
+
+TEST(TestSPSCQueue, Threads)
+{
+  CSPSCQueue<unsigned int> queue(64);
+  QueueProducer producer(queue);
+  thread producerThread(producer);
+
+  unsigned int expected = 0;
+  while (expected < NUMITEMS)
+  {
+    unsigned int item;
+    if (!queue.Pop(item))
+    {
+      XbmcThreads::ThreadSleep(0);
+      continue;
+    }
+    ASSERT_EQ(expected, item);
+    expected++;
+  }
+
+  EXPECT_TRUE(producerThread.timed_join(MILLIS(10000)));
+  EXPECT_TRUE(queue.Empty());
+}
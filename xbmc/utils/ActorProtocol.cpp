@@ -19,27 +19,45 @@
  */
 
 #include "ActorProtocol.h"
+#include "utils/log.h"
+#include "utils/TimeUtils.h"
+
+#include <algorithm>
+
+// number of free messages, payloads of each size class and sync events kept
+// for reuse, anything beyond is freed
+#define MSG_FREE_MESSAGES 128
+#define MSG_FREE_PAYLOADS 16
+#define MSG_FREE_EVENTS 8
 
 using namespace Actor;
 
+static inline int PayloadClassSize(int payloadClass)
+{
+  return MSG_INTERNAL_BUFFER_SIZE << (2 * (payloadClass + 1));
+}
+
 void Message::Release()
 {
-  bool skip;
-  origin->Lock();
-  skip = isSync ? !isSyncFini : false;
-  isSyncFini = true;
-  origin->Unlock();
+  bool skip = false;
+  if (isSync)
+  {
+    origin->Lock();
+    skip = !isSyncFini;
+    isSyncFini = true;
+    origin->Unlock();
+  }
 
   if (skip)
     return;
 
   // free data buffer
-  if (data != buffer)
-    delete [] data;
+  if (data && data != buffer)
+    origin->ReturnPayload(this);
 
-  // delete event in case of sync message
+  // keep the event of a sync message for the next one
   if (event)
-    delete event;
+    origin->ReturnSyncEvent(event);
 
   origin->ReturnMessage(this);
 }
@@ -63,13 +81,7 @@ bool Message::Reply(int sig, void *data /* = NULL*/, int size /* = 0 */)
     msg->isOut = !isOut;
     replyMessage = msg;
     if (data)
-    {
-      if (size > MSG_INTERNAL_BUFFER_SIZE)
-        msg->data = new uint8_t[size];
-      else
-        msg->data = msg->buffer;
-      memcpy(msg->data, data, size);
-    }
+      origin->CopyPayload(msg, data, size);
   }
 
   origin->Unlock();
@@ -80,31 +92,74 @@ bool Message::Reply(int sig, void *data /* = NULL*/, int size /* = 0 */)
   return true;
 }
 
+void Protocol::MessageQueue::Push(Message *msg)
+{
+  msg->next = NULL;
+  if (back)
+    back->next = msg;
+  else
+    front = msg;
+  back = msg;
+}
+
+Message *Protocol::MessageQueue::Pop()
+{
+  Message *msg = front;
+  if (msg)
+  {
+    front = msg->next;
+    if (!front)
+      back = NULL;
+  }
+  return msg;
+}
+
+Protocol::PayloadPool::PayloadPool() : blocks(MSG_FREE_PAYLOADS)
+{
+}
+
+Protocol::Protocol(std::string name, CEvent* inEvent, CEvent *outEvent)
+  : portName(name),
+    containerInEvent(inEvent),
+    containerOutEvent(outEvent),
+    outCount(0),
+    inCount(0),
+    freeMessages(MSG_FREE_MESSAGES),
+    freeEvents(MSG_FREE_EVENTS),
+    inDefered(false),
+    outDefered(false)
+{
+  ResetStats();
+}
+
 Protocol::~Protocol()
 {
   Message *msg;
   Purge();
-  while (!freeMessageQueue.empty())
-  {
-    msg = freeMessageQueue.front();
-    freeMessageQueue.pop();
+  while (freeMessages.Pop(msg))
     delete msg;
+
+  uint8_t *payload;
+  for (PayloadPool &pool : freePayloads)
+  {
+    while (pool.blocks.Pop(payload))
+      delete [] payload;
   }
+
+  CEvent *event;
+  while (freeEvents.Pop(event))
+    delete event;
 }
 
 Message *Protocol::GetMessage()
 {
   Message *msg;
 
-  CSingleLock lock(criticalSection);
-
-  if (!freeMessageQueue.empty())
+  if (!freeMessages.Pop(msg))
   {
-    msg = freeMessageQueue.front();
-    freeMessageQueue.pop();
-  }
-  else
     msg = new Message();
+    statsAllocations++;
+  }
 
   msg->isSync = false;
   msg->isSyncFini = false;
@@ -112,6 +167,7 @@ Message *Protocol::GetMessage()
   msg->event = NULL;
   msg->data = NULL;
   msg->payloadSize = 0;
+  msg->payloadClass = -1;
   msg->replyMessage = NULL;
   msg->origin = this;
 
@@ -120,9 +176,66 @@ Message *Protocol::GetMessage()
 
 void Protocol::ReturnMessage(Message *msg)
 {
-  CSingleLock lock(criticalSection);
+  if (!freeMessages.Push(msg))
+    delete msg;
+}
+
+void Protocol::CopyPayload(Message *msg, const void *data, int size)
+{
+  msg->payloadSize = size;
+  if (size <= MSG_INTERNAL_BUFFER_SIZE)
+    msg->data = msg->buffer;
+  else
+  {
+    int payloadClass = 0;
+    while (payloadClass < MSG_PAYLOAD_CLASSES && size > PayloadClassSize(payloadClass))
+      payloadClass++;
 
-  freeMessageQueue.push(msg);
+    if (payloadClass == MSG_PAYLOAD_CLASSES)
+    {
+      msg->payloadClass = -1;
+      msg->data = new uint8_t[size];
+      statsAllocations++;
+    }
+    else
+    {
+      msg->payloadClass = payloadClass;
+      if (!freePayloads[payloadClass].blocks.Pop(msg->data))
+      {
+        msg->data = new uint8_t[PayloadClassSize(payloadClass)];
+        statsAllocations++;
+      }
+    }
+  }
+  memcpy(msg->data, data, size);
+}
+
+void Protocol::ReturnPayload(Message *msg)
+{
+  if (msg->payloadClass < 0 || !freePayloads[msg->payloadClass].blocks.Push(msg->data))
+    delete [] msg->data;
+
+  msg->data = NULL;
+  msg->payloadClass = -1;
+}
+
+CEvent *Protocol::GetSyncEvent()
+{
+  CEvent *event;
+  if (!freeEvents.Pop(event))
+  {
+    event = new CEvent;
+    statsAllocations++;
+  }
+  return event;
+}
+
+void Protocol::ReturnSyncEvent(CEvent *event)
+{
+  // only called once both sides are done with the message, nobody
+  // can set the event anymore
+  if (!freeEvents.Push(event))
+    delete event;
 }
 
 bool Protocol::SendOutMessage(int signal, void *data /* = NULL */, int size /* = 0 */, Message *outMsg /* = NULL */)
@@ -137,17 +250,13 @@ bool Protocol::SendOutMessage(int signal, void *data /* = NULL */, int size /* =
   msg->isOut = true;
 
   if (data)
-  {
-    if (size > MSG_INTERNAL_BUFFER_SIZE)
-      msg->data = new uint8_t[size];
-    else
-      msg->data = msg->buffer;
-    memcpy(msg->data, data, size);
-  }
+    CopyPayload(msg, data, size);
 
-  { CSingleLock lock(criticalSection);
-    outMessages.push(msg);
+  { CSingleLock lock(outSection);
+    outMessages.Push(msg);
+    outCount++;
   }
+  statsOut++;
   containerOutEvent->Set();
 
   return true;
@@ -165,17 +274,13 @@ bool Protocol::SendInMessage(int signal, void *data /* = NULL */, int size /* =
   msg->isOut = false;
 
   if (data)
-  {
-    if (size > MSG_INTERNAL_BUFFER_SIZE)
-      msg->data = new uint8_t[size];
-    else
-      msg->data = msg->buffer;
-    memcpy(msg->data, data, size);
-  }
+    CopyPayload(msg, data, size);
 
-  { CSingleLock lock(criticalSection);
-    inMessages.push(msg);
+  { CSingleLock lock(inSection);
+    inMessages.Push(msg);
+    inCount++;
   }
+  statsIn++;
   containerInEvent->Set();
 
   return true;
@@ -187,8 +292,9 @@ bool Protocol::SendOutMessageSync(int signal, Message **retMsg, int timeout, voi
   Message *msg = GetMessage();
   msg->isOut = true;
   msg->isSync = true;
-  msg->event = new CEvent;
+  msg->event = GetSyncEvent();
   msg->event->Reset();
+  int64_t start = CurrentHostCounter();
   SendOutMessage(signal, data, size, msg);
 
   if (!msg->event->WaitMSec(timeout))
@@ -208,6 +314,15 @@ bool Protocol::SendOutMessageSync(int signal, Message **retMsg, int timeout, voi
 
   msg->Release();
 
+  int64_t waited = (CurrentHostCounter() - start) * 1000000 / CurrentHostFrequency();
+  int64_t waitMax = statsWaitMax.load();
+  while (waited > waitMax && !statsWaitMax.compare_exchange_weak(waitMax, waited))
+    ;
+  statsWaitTotal += waited;
+  statsSync++;
+  if (!*retMsg)
+    statsTimeouts++;
+
   if (*retMsg)
     return true;
   else
@@ -216,26 +331,34 @@ bool Protocol::SendOutMessageSync(int signal, Message **retMsg, int timeout, voi
 
 bool Protocol::ReceiveOutMessage(Message **msg)
 {
-  CSingleLock lock(criticalSection);
+  if (outCount == 0 || outDefered)
+    return false;
+
+  CSingleLock lock(outSection);
 
-  if (outMessages.empty() || outDefered)
+  Message *front = outMessages.Pop();
+  if (!front)
     return false;
 
-  *msg = outMessages.front();
-  outMessages.pop();
+  *msg = front;
+  outCount--;
 
   return true;
 }
 
 bool Protocol::ReceiveInMessage(Message **msg)
 {
-  CSingleLock lock(criticalSection);
+  if (inCount == 0 || inDefered)
+    return false;
+
+  CSingleLock lock(inSection);
 
-  if (inMessages.empty() || inDefered)
+  Message *front = inMessages.Pop();
+  if (!front)
     return false;
 
-  *msg = inMessages.front();
-  inMessages.pop();
+  *msg = front;
+  inCount--;
 
   return true;
 }
@@ -255,43 +378,94 @@ void Protocol::Purge()
 void Protocol::PurgeIn(int signal)
 {
   Message *msg;
-  std::queue<Message*> msgs;
+  MessageQueue msgs, purged;
 
-  CSingleLock lock(criticalSection);
+  { CSingleLock lock(inSection);
 
-  while (!inMessages.empty())
-  {
-    msg = inMessages.front();
-    inMessages.pop();
-    if (msg->signal != signal)
-      msgs.push(msg);
-  }
-  while (!msgs.empty())
-  {
-    msg = msgs.front();
-    msgs.pop();
-    inMessages.push(msg);
+    size_t count = 0;
+    while ((msg = inMessages.Pop()))
+    {
+      if (msg->signal != signal)
+      {
+        msgs.Push(msg);
+        count++;
+      }
+      else
+        purged.Push(msg);
+    }
+    inMessages = msgs;
+    inCount = count;
   }
+
+  while ((msg = purged.Pop()))
+    msg->Release();
 }
 
 void Protocol::PurgeOut(int signal)
 {
   Message *msg;
-  std::queue<Message*> msgs;
+  MessageQueue msgs, purged;
 
-  CSingleLock lock(criticalSection);
+  { CSingleLock lock(outSection);
 
-  while (!outMessages.empty())
-  {
-    msg = outMessages.front();
-    outMessages.pop();
-    if (msg->signal != signal)
-      msgs.push(msg);
-  }
-  while (!msgs.empty())
-  {
-    msg = msgs.front();
-    msgs.pop();
-    outMessages.push(msg);
+    size_t count = 0;
+    while ((msg = outMessages.Pop()))
+    {
+      if (msg->signal != signal)
+      {
+        msgs.Push(msg);
+        count++;
+      }
+      else
+        purged.Push(msg);
+    }
+    outMessages = msgs;
+    outCount = count;
   }
+
+  while ((msg = purged.Pop()))
+    msg->Release();
+}
+
+void Protocol::GetStats(ProtocolStats &stats) const
+{
+  stats.seconds = (double)(CurrentHostCounter() - statsStart) / CurrentHostFrequency();
+  stats.outMessages = statsOut;
+  stats.inMessages = statsIn;
+  stats.syncMessages = statsSync;
+  stats.syncTimeouts = statsTimeouts;
+  stats.syncWaitTotal = statsWaitTotal;
+  stats.syncWaitMax = statsWaitMax;
+  stats.allocations = statsAllocations;
+}
+
+void Protocol::ResetStats()
+{
+  statsStart = CurrentHostCounter();
+  statsOut = 0;
+  statsIn = 0;
+  statsSync = 0;
+  statsTimeouts = 0;
+  statsWaitTotal = 0;
+  statsWaitMax = 0;
+  statsAllocations = 0;
+}
+
+void Protocol::LogStats() const
+{
+  ProtocolStats stats;
+  GetStats(stats);
+  if (stats.outMessages + stats.inMessages == 0)
+    return;
+
+  CLog::Log(LOGDEBUG, "Protocol::%s - %s: %llu out, %llu in messages in %.1fs (%.1f/s), "
+            "%llu sync, wait avg %lldus max %lldus, %llu timeouts, %llu allocations",
+            __FUNCTION__, portName.c_str(),
+            (unsigned long long)stats.outMessages, (unsigned long long)stats.inMessages,
+            stats.seconds, (stats.outMessages + stats.inMessages) / std::max(stats.seconds, 0.001),
+            (unsigned long long)stats.syncMessages,
+            (long long)(stats.syncMessages ? stats.syncWaitTotal / (int64_t)stats.syncMessages : 0),
+            (long long)stats.syncWaitMax,
+            (unsigned long long)stats.syncTimeouts,
+            (unsigned long long)stats.allocations);
 }
@@ -20,17 +20,36 @@
 
 #pragma once
 
+#include "threads/MPMCQueue.h"
 #include "threads/Thread.h"
+#include <atomic>
 #include <queue>
 #include "memory.h"
 
 #define MSG_INTERNAL_BUFFER_SIZE 32
+// larger payloads are taken from pools of 128, 512, 2048 and 8192 bytes
+#define MSG_PAYLOAD_CLASSES 4
 
 namespace Actor
 {
 
 class Protocol;
 
+/*!
+ \brief Traffic of a protocol since it was created or ResetStats() was called
+ */
+struct ProtocolStats
+{
+  double seconds;
+  uint64_t outMessages;
+  uint64_t inMessages;
+  uint64_t syncMessages;
+  uint64_t syncTimeouts;
+  int64_t syncWaitTotal;  // microseconds
+  int64_t syncWaitMax;    // microseconds
+  uint64_t allocations;   // messages, payloads and events not taken from a pool
+};
+
 class Message
 {
   friend class Protocol;
@@ -51,14 +70,15 @@ public:
   bool Reply(int sig, void *data = NULL, int size = 0);
 
 private:
-  Message() {isSync = false; data = NULL; event = NULL; replyMessage = NULL;};
+  Message() {isSync = false; data = NULL; event = NULL; replyMessage = NULL; payloadClass = -1; next = NULL;};
+  int payloadClass;
+  Message *next;
 };
 
 class Protocol
 {
 public:
-  Protocol(std::string name, CEvent* inEvent, CEvent *outEvent)
-    : portName(name), inDefered(false), outDefered(false) {containerInEvent = inEvent; containerOutEvent = outEvent;};
+  Protocol(std::string name, CEvent* inEvent, CEvent *outEvent);
   virtual ~Protocol();
   Message *GetMessage();
   void ReturnMessage(Message *msg);
@@ -74,15 +94,45 @@ public:
   void DeferOut(bool value) {outDefered = value;};
   void Lock() {criticalSection.lock();};
   void Unlock() {criticalSection.unlock();};
+  void GetStats(ProtocolStats &stats) const;
+  void ResetStats();
+  void LogStats() const;
   std::string portName;
 
 protected:
+  friend class Message;
+  void CopyPayload(Message *msg, const void *data, int size);
+  void ReturnPayload(Message *msg);
+  CEvent *GetSyncEvent();
+  void ReturnSyncEvent(CEvent *event);
+
   CEvent *containerInEvent, *containerOutEvent;
   CCriticalSection criticalSection;
-  std::queue<Message*> outMessages;
-  std::queue<Message*> inMessages;
-  std::queue<Message*> freeMessageQueue;
+  // the queues of each direction have their own lock, their size is also
+  // kept outside of it so polling an empty queue does not need to take it
+  CCriticalSection outSection, inSection;
+  // fifo linked through the messages, queuing never allocates
+  struct MessageQueue
+  {
+    MessageQueue() : front(NULL), back(NULL) {}
+    void Push(Message *msg);
+    Message *Pop();
+    Message *front, *back;
+  } outMessages, inMessages;
+  std::atomic<size_t> outCount, inCount;
+  // messages, payloads and sync events are recycled through lock-free rings
+  CMPMCQueue<Message*> freeMessages;
+  struct PayloadPool
+  {
+    PayloadPool();
+    CMPMCQueue<uint8_t*> blocks;
+  } freePayloads[MSG_PAYLOAD_CLASSES];
+  CMPMCQueue<CEvent*> freeEvents;
   bool inDefered, outDefered;
+
+  std::atomic<int64_t> statsStart;
+  std::atomic<uint64_t> statsOut, statsIn, statsSync, statsTimeouts, statsAllocations;
+  std::atomic<int64_t> statsWaitTotal, statsWaitMax;
 };
 
 }
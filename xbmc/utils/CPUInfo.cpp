@@ -73,11 +73,16 @@
 #define CPUID_00000001_ECX_SSSE3 (1<<9)
 #define CPUID_00000001_ECX_SSE4  (1<<19)
 #define CPUID_00000001_ECX_SSE42 (1<<20)
+#define CPUID_00000001_ECX_OSXSAVE (1<<27)
+#define CPUID_00000001_ECX_AVX   (1<<28)
 
 #define CPUID_00000001_EDX_MMX   (1<<23)
 #define CPUID_00000001_EDX_SSE   (1<<25)
 #define CPUID_00000001_EDX_SSE2  (1<<26)
 
+// Bitmasks for the values returned by a call to cpuid with eax=0x00000007, ecx=0
+#define CPUID_00000007_EBX_AVX2  (1<<5)
+
 // Extended Features
 // Bitmasks for the values returned by a call to cpuid with eax=0x80000001
 #define CPUID_80000001_EDX_MMX2     (1<<22)
@@ -407,6 +412,10 @@ CCPUInfo::CCPUInfo(void)
               m_cpuFeatures |= CPU_FEATURE_SSE4;
             else if (0 == strcmp(tok, "sse4_2"))
               m_cpuFeatures |= CPU_FEATURE_SSE42;
+            else if (0 == strcmp(tok, "avx"))
+              m_cpuFeatures |= CPU_FEATURE_AVX;
+            else if (0 == strcmp(tok, "avx2"))
+              m_cpuFeatures |= CPU_FEATURE_AVX2;
             else if (0 == strcmp(tok, "3dnow"))
               m_cpuFeatures |= CPU_FEATURE_3DNOW;
             else if (0 == strcmp(tok, "3dnowext"))
@@ -884,6 +893,21 @@ void CCPUInfo::ReadCPUFeatures()
       m_cpuFeatures |= CPU_FEATURE_SSE4;
     if (CPUInfo[CPUINFO_ECX] & CPUID_00000001_ECX_SSE42)
       m_cpuFeatures |= CPU_FEATURE_SSE42;
+
+    // AVX also needs the OS to save the YMM registers on context switches
+    if ((CPUInfo[CPUINFO_ECX] & CPUID_00000001_ECX_OSXSAVE) &&
+        (CPUInfo[CPUINFO_ECX] & CPUID_00000001_ECX_AVX) &&
+        (_xgetbv(0) & 0x6) == 0x6)
+    {
+      m_cpuFeatures |= CPU_FEATURE_AVX;
+
+      if (MaxStdInfoType >= 7)
+      {
+        __cpuidex(CPUInfo, 7, 0);
+        if (CPUInfo[CPUINFO_EBX] & CPUID_00000007_EBX_AVX2)
+          m_cpuFeatures |= CPU_FEATURE_AVX2;
+      }
+    }
   }
 
   __cpuid(CPUInfo, 0x80000000);
@@ -934,9 +958,20 @@ void CCPUInfo::ReadCPUFeatures()
         m_cpuFeatures |= CPU_FEATURE_3DNOW;
       if (strstr(buffer,"3DNOWEXT "))
        m_cpuFeatures |= CPU_FEATURE_3DNOWEXT;
+      if (strstr(buffer,"AVX1.0 "))
+        m_cpuFeatures |= CPU_FEATURE_AVX;
     }
     else
       m_cpuFeatures |= CPU_FEATURE_MMX;
+
+    len = sizeof(buffer) - 1;
+    memset(buffer, 0, sizeof(buffer));
+    if (sysctlbyname("machdep.cpu.leaf7_features", &buffer, &len, NULL, 0) == 0)
+    {
+      strcat(buffer, " ");
+      if (strstr(buffer,"AVX2 "))
+        m_cpuFeatures |= CPU_FEATURE_AVX2;
+    }
   #endif
 #elif defined(LINUX)
 // empty on purpose, the implementation is in the constructor
@@ -21,110 +21,165 @@
 #include <locale>
 
 #include "JSONVariantWriter.h"
-#include "utils/Variant.h"
 
-std::string CJSONVariantWriter::Write(const CVariant &value, bool compact)
+namespace
 {
-  std::string output;
-
-  yajl_gen g = yajl_gen_alloc(NULL);
-  yajl_gen_config(g, yajl_gen_beautify, compact ? 0 : 1);
-  yajl_gen_config(g, yajl_gen_indent_string, "\t");
-
-  // Set locale to classic ("C") to ensure valid JSON numbers
-#ifndef TARGET_WINDOWS
-  const char *currentLocale = setlocale(LC_NUMERIC, NULL);
-  std::string backupLocale;
-  if (currentLocale != NULL && (currentLocale[0] != 'C' || currentLocale[1] != 0))
+// Set locale to classic ("C") to ensure valid JSON numbers
+class CClassicNumericLocale
+{
+public:
+  CClassicNumericLocale()
   {
-    backupLocale = currentLocale;
-    setlocale(LC_NUMERIC, "C");
-  }
+#ifndef TARGET_WINDOWS
+    const char *currentLocale = setlocale(LC_NUMERIC, NULL);
+    if (currentLocale != NULL && (currentLocale[0] != 'C' || currentLocale[1] != 0))
+    {
+      m_backupLocale = currentLocale;
+      setlocale(LC_NUMERIC, "C");
+    }
 #else  // TARGET_WINDOWS
-  const wchar_t* const currentLocale = _wsetlocale(LC_NUMERIC, NULL);
-  std::wstring backupLocale;
-  if (currentLocale != NULL && (currentLocale[0] != L'C' || currentLocale[1] != 0))
-  {
-    backupLocale = currentLocale;
-    _wsetlocale(LC_NUMERIC, L"C");
-  }
+    const wchar_t* const currentLocale = _wsetlocale(LC_NUMERIC, NULL);
+    if (currentLocale != NULL && (currentLocale[0] != L'C' || currentLocale[1] != 0))
+    {
+      m_backupLocale = currentLocale;
+      _wsetlocale(LC_NUMERIC, L"C");
+    }
 #endif // TARGET_WINDOWS
-
-  if (InternalWrite(g, value))
-  {
-    const unsigned char * buffer;
-
-    size_t length;
-    yajl_gen_get_buf(g, &buffer, &length);
-    output = std::string((const char *)buffer, length);
   }
 
-  // Re-set locale to what it was before using yajl
+  ~CClassicNumericLocale()
+  {
+    // Re-set locale to what it was before using yajl
 #ifndef TARGET_WINDOWS
-  if (!backupLocale.empty())
-    setlocale(LC_NUMERIC, backupLocale.c_str());
+    if (!m_backupLocale.empty())
+      setlocale(LC_NUMERIC, m_backupLocale.c_str());
 #else  // TARGET_WINDOWS
-  if (!backupLocale.empty())
-    _wsetlocale(LC_NUMERIC, backupLocale.c_str());
+    if (!m_backupLocale.empty())
+      _wsetlocale(LC_NUMERIC, m_backupLocale.c_str());
 #endif // TARGET_WINDOWS
+  }
+
+private:
+#ifndef TARGET_WINDOWS
+  std::string m_backupLocale;
+#else
+  std::wstring m_backupLocale;
+#endif
+};
+}
+
+std::string CJSONVariantWriter::Write(const CVariant &value, bool compact)
+{
+  std::string output;
 
-  yajl_gen_clear(g);
-  yajl_gen_free(g);
+  CJSONVariantStreamWriter writer(value, compact);
+  if (!writer.Write(output, std::string::npos))
+    return "";
 
   return output;
 }
 
-bool CJSONVariantWriter::InternalWrite(yajl_gen g, const CVariant &value)
+CJSONVariantStreamWriter::CJSONVariantStreamWriter(const CVariant &value, bool compact)
+  : m_generator(yajl_gen_alloc(NULL)),
+    m_next(&value),
+    m_failed(false)
 {
-  bool success = false;
+  yajl_gen_config(m_generator, yajl_gen_beautify, compact ? 0 : 1);
+  yajl_gen_config(m_generator, yajl_gen_indent_string, "\t");
+}
 
-  switch (value.type())
+CJSONVariantStreamWriter::~CJSONVariantStreamWriter()
+{
+  yajl_gen_free(m_generator);
+}
+
+bool CJSONVariantStreamWriter::Write(std::string &output, size_t minimum)
+{
+  if (m_failed)
+    return false;
+
+  CClassicNumericLocale locale;
+
+  const unsigned char *buffer;
+  size_t length = 0;
+  while (!IsDone() && length < minimum)
   {
-  case CVariant::VariantTypeInteger:
-    success = yajl_gen_status_ok == yajl_gen_integer(g, (long long int)value.asInteger());
-    break;
-  case CVariant::VariantTypeUnsignedInteger:
-    success = yajl_gen_status_ok == yajl_gen_integer(g, (long long int)value.asUnsignedInteger());
-    break;
-  case CVariant::VariantTypeDouble:
-    success = yajl_gen_status_ok == yajl_gen_double(g, value.asDouble());
-    break;
-  case CVariant::VariantTypeBoolean:
-    success = yajl_gen_status_ok == yajl_gen_bool(g, value.asBoolean() ? 1 : 0);
-    break;
-  case CVariant::VariantTypeString:
-    success = yajl_gen_status_ok == yajl_gen_string(g, (const unsigned char*)value.c_str(), (size_t)value.size());
-    break;
-  case CVariant::VariantTypeArray:
-    success = yajl_gen_status_ok == yajl_gen_array_open(g);
+    if (!WriteNext())
+    {
+      m_failed = true;
+      break;
+    }
+
+    yajl_gen_get_buf(m_generator, &buffer, &length);
+  }
+
+  if (!m_failed)
+  {
+    yajl_gen_get_buf(m_generator, &buffer, &length);
+    output.append((const char *)buffer, length);
+  }
 
-    for (CVariant::const_iterator_array itr = value.begin_array(); itr != value.end_array() && success; ++itr)
-      success &= InternalWrite(g, *itr);
+  // only clears the buffer, the generator keeps its state
+  yajl_gen_clear(m_generator);
 
-    if (success)
-      success = yajl_gen_status_ok == yajl_gen_array_close(g);
+  return !m_failed;
+}
 
-    break;
-  case CVariant::VariantTypeObject:
-    success = yajl_gen_status_ok == yajl_gen_map_open(g);
+bool CJSONVariantStreamWriter::WriteNext()
+{
+  if (m_next == NULL)
+  {
+    // continue with the innermost array or object
+    Container &container = m_containers.back();
+    if (container.value->isArray())
+    {
+      if (container.array == container.value->end_array())
+      {
+        m_containers.pop_back();
+        return yajl_gen_status_ok == yajl_gen_array_close(m_generator);
+      }
+
+      m_next = &*container.array;
+      ++container.array;
+      return true;
+    }
 
-    for (CVariant::const_iterator_map itr = value.begin_map(); itr != value.end_map() && success; ++itr)
+    if (container.map == container.value->end_map())
     {
-      success &= yajl_gen_status_ok == yajl_gen_string(g, (const unsigned char*)itr->first.c_str(), (size_t)itr->first.length());
-      if (success)
-        success &= InternalWrite(g, itr->second);
+      m_containers.pop_back();
+      return yajl_gen_status_ok == yajl_gen_map_close(m_generator);
     }
 
-    if (success)
-      success &= yajl_gen_status_ok == yajl_gen_map_close(g);
+    m_next = &container.map->second;
+    const std::string &key = container.map->first;
+    ++container.map;
+    return yajl_gen_status_ok == yajl_gen_string(m_generator, (const unsigned char*)key.c_str(), (size_t)key.length());
+  }
+
+  const CVariant &value = *m_next;
+  m_next = NULL;
 
-    break;
+  switch (value.type())
+  {
+  case CVariant::VariantTypeInteger:
+    return yajl_gen_status_ok == yajl_gen_integer(m_generator, (long long int)value.asInteger());
+  case CVariant::VariantTypeUnsignedInteger:
+    return yajl_gen_status_ok == yajl_gen_integer(m_generator, (long long int)value.asUnsignedInteger());
+  case CVariant::VariantTypeDouble:
+    return yajl_gen_status_ok == yajl_gen_double(m_generator, value.asDouble());
+  case CVariant::VariantTypeBoolean:
+    return yajl_gen_status_ok == yajl_gen_bool(m_generator, value.asBoolean() ? 1 : 0);
+  case CVariant::VariantTypeString:
+    return yajl_gen_status_ok == yajl_gen_string(m_generator, (const unsigned char*)value.c_str(), (size_t)value.size());
+  case CVariant::VariantTypeArray:
+    m_containers.push_back(Container(value));
+    return yajl_gen_status_ok == yajl_gen_array_open(m_generator);
+  case CVariant::VariantTypeObject:
+    m_containers.push_back(Container(value));
+    return yajl_gen_status_ok == yajl_gen_map_open(m_generator);
   case CVariant::VariantTypeConstNull:
   case CVariant::VariantTypeNull:
   default:
-    success = yajl_gen_status_ok == yajl_gen_null(g);
-    break;
+    return yajl_gen_status_ok == yajl_gen_null(m_generator);
   }
-
-  return success;
 }
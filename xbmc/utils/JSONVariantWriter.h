@@ -21,13 +21,65 @@
 
 #include <yajl/yajl_gen.h>
 #include <string>
+#include <vector>
 
-class CVariant;
+#include "utils/Variant.h"
 
 class CJSONVariantWriter
 {
 public:
   static std::string Write(const CVariant &value, bool compact);
+};
+
+/*!
+ \brief Serializes a CVariant to JSON piece by piece.
+
+ Allows sending a large value (e.g. a JSON-RPC response) while it is being
+ serialized instead of holding the whole serialized string in memory. The
+ output is identical to the one of CJSONVariantWriter::Write().
+
+ The value must not be changed or destroyed before the writer is done.
+ */
+class CJSONVariantStreamWriter
+{
+public:
+  CJSONVariantStreamWriter(const CVariant &value, bool compact);
+  ~CJSONVariantStreamWriter();
+
+  /*!
+   \brief Serialize the next part of the value and append it to the output.
+   \param output string to append the serialized JSON to
+   \param minimum number of bytes after which to stop serializing
+   \return false if the value couldn't be serialized
+   */
+  bool Write(std::string &output, size_t minimum);
+
+  /*!
+   \brief Whether the whole value has been serialized (or serializing failed).
+   */
+  bool IsDone() const { return m_failed || (m_next == NULL && m_containers.empty()); }
+
 private:
-  static bool InternalWrite(yajl_gen g, const CVariant &value);
+  CJSONVariantStreamWriter(const CJSONVariantStreamWriter&) = delete;
+  CJSONVariantStreamWriter& operator=(const CJSONVariantStreamWriter&) = delete;
+
+  struct Container
+  {
+    explicit Container(const CVariant &container)
+      : value(&container),
+        array(container.begin_array()),
+        map(container.begin_map())
+    { }
+
+    const CVariant *value;
+    CVariant::const_iterator_array array;
+    CVariant::const_iterator_map map;
+  };
+
+  bool WriteNext();
+
+  yajl_gen m_generator;
+  const CVariant *m_next;
+  std::vector<Container> m_containers;
+  bool m_failed;
 };
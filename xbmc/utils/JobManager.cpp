@@ -23,6 +23,8 @@
 #include <functional>
 #include <stdexcept>
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/CPUInfo.h"
 #include "utils/log.h"
 #ifdef TARGET_POSIX
 #include "linux/XTimeUtils.h"
@@ -37,9 +39,10 @@ bool CJob::ShouldCancel(unsigned int progress, unsigned int total) const
   return false;
 }
 
-CJobWorker::CJobWorker(CJobManager *manager) : CThread("JobWorker")
+CJobWorker::CJobWorker(CJobManager *manager, unsigned int queue) : CThread("JobWorker")
 {
   m_jobManager = manager;
+  m_queue = queue;
   Create(true); // start work immediately, and kill ourselves when we're done
 }
 
@@ -181,9 +184,12 @@ CJobManager &CJobManager::GetInstance()
 
 CJobManager::CJobManager()
 {
+  m_activeQueues = 1;
+  m_nextQueue = 0;
   m_jobCounter = 0;
   m_running = true;
   m_pauseJobs = false;
+  m_stats = Statistics();
 }
 
 void CJobManager::Restart()
@@ -197,19 +203,30 @@ void CJobManager::Restart()
 
 void CJobManager::CancelJobs()
 {
-  CSingleLock lock(m_section);
   m_running = false;
 
-  // clear any pending jobs
-  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+  // clear any pending jobs. AddJob() checks m_running while holding the queue
+  // lock, so nothing can be queued behind our back once we've been through a queue
+  for (unsigned int queue = 0; queue < MAX_QUEUES; ++queue)
   {
-    for_each(m_jobQueue[priority].begin(), m_jobQueue[priority].end(), std::mem_fun_ref(&CWorkItem::FreeJob));
-    m_jobQueue[priority].clear();
+    CSingleLock queueLock(m_queues[queue].m_section);
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+    {
+      JobQueue &jobs = m_queues[queue].m_jobs[priority];
+      for_each(jobs.begin(), jobs.end(), std::mem_fun_ref(&CWorkItem::FreeJob));
+      jobs.clear();
+    }
   }
 
+  CSingleLock lock(m_section);
+
   // cancel any callbacks on jobs still processing
   for_each(m_processing.begin(), m_processing.end(), std::mem_fun_ref(&CWorkItem::Cancel));
 
+  if (m_stats.jobs)
+    CLog::Log(LOGDEBUG, "CJobManager: %" PRIu64" jobs, average wait %" PRIu64" ms, max wait %u ms, %" PRIu64" steals",
+              m_stats.jobs, m_stats.totalWaitTime / m_stats.jobs, m_stats.maxWaitTime, m_stats.steals);
+
   // tell our workers to finish
   while (m_workers.size())
   {
@@ -226,19 +243,40 @@ CJobManager::~CJobManager()
 
 unsigned int CJobManager::AddJob(CJob *job, IJobCallback *callback, CJob::PRIORITY priority)
 {
-  CSingleLock lock(m_section);
-
-  if (!m_running)
-    return 0;
-
   // increment the job counter, ensuring 0 (invalid job) is never hit
-  m_jobCounter++;
-  if (m_jobCounter == 0)
-    m_jobCounter++;
+  unsigned int id = ++m_jobCounter;
+  if (id == 0)
+    id = ++m_jobCounter;
 
   // create a work item for this job
-  CWorkItem work(job, m_jobCounter, priority, callback);
-  m_jobQueue[priority].push_back(work);
+  CWorkItem work(job, id, priority, callback);
+  work.m_queuedAt = XbmcThreads::SystemClockMillis();
+
+  // jobs queued from within a job stay with the worker that spawned them,
+  // everything else is spread over the queues
+  unsigned int queue;
+  const CJobWorker *worker = dynamic_cast<const CJobWorker*>(CThread::GetCurrentThread());
+  if (worker && IsWorkStealing())
+    queue = worker->GetQueue();
+  else
+    queue = m_nextQueue++;
+
+  while (true)
+  {
+    const unsigned int queues = m_activeQueues;
+    CWorkQueue &target = m_queues[queue % queues];
+    CSingleLock lock(target.m_section);
+
+    if (!m_running)
+      return 0;
+
+    // the number of queues may have changed before we got the lock
+    if (queues != m_activeQueues)
+      continue;
+
+    target.m_jobs[priority].push_back(work);
+    break;
+  }
 
   StartWorkers(priority);
   return work.m_id;
@@ -246,29 +284,43 @@ unsigned int CJobManager::AddJob(CJob *job, IJobCallback *callback, CJob::PRIORI
 
 void CJobManager::CancelJob(unsigned int jobID)
 {
-  CSingleLock lock(m_section);
+  // hold all queues so the job can't be popped or moved while we look for it
+  LockQueues();
 
   // check whether we have this job in the queue
-  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+  for (unsigned int queue = 0; queue < m_activeQueues; ++queue)
   {
-    JobQueue::iterator i = find(m_jobQueue[priority].begin(), m_jobQueue[priority].end(), jobID);
-    if (i != m_jobQueue[priority].end())
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
     {
-      delete i->m_job;
-      m_jobQueue[priority].erase(i);
-      return;
+      JobQueue &jobs = m_queues[queue].m_jobs[priority];
+      JobQueue::iterator i = find(jobs.begin(), jobs.end(), jobID);
+      if (i != jobs.end())
+      {
+        delete i->m_job;
+        jobs.erase(i);
+        UnlockQueues();
+        return;
+      }
     }
   }
+
   // or if we're processing it
-  Processing::iterator it = find(m_processing.begin(), m_processing.end(), jobID);
-  if (it != m_processing.end())
-    it->m_callback = NULL; // job is in progress, so only thing to do is to remove callback
+  {
+    CSingleLock lock(m_section);
+    Processing::iterator it = find(m_processing.begin(), m_processing.end(), jobID);
+    if (it != m_processing.end())
+      it->m_callback = NULL; // job is in progress, so only thing to do is to remove callback
+  }
+  UnlockQueues();
 }
 
 void CJobManager::StartWorkers(CJob::PRIORITY priority)
 {
   CSingleLock lock(m_section);
 
+  if (!m_running)
+    return;
+
   // check how many free threads we have
   if (m_processing.size() >= GetMaxWorkers(priority))
     return;
@@ -281,23 +333,42 @@ void CJobManager::StartWorkers(CJob::PRIORITY priority)
   }
 
   // everyone is busy - we need more workers
-  m_workers.push_back(new CJobWorker(this));
+  m_workers.push_back(new CJobWorker(this, m_nextQueue++));
 }
 
-CJob *CJobManager::PopJob()
+CJob *CJobManager::PopJob(unsigned int queue)
 {
-  CSingleLock lock(m_section);
+  const unsigned int queues = m_activeQueues;
   for (int priority = CJob::PRIORITY_DEDICATED; priority >= CJob::PRIORITY_LOW_PAUSABLE; --priority)
   {
     // Check whether we're pausing pausable jobs
     if (priority == CJob::PRIORITY_LOW_PAUSABLE && m_pauseJobs)
       continue;
 
-    if (m_jobQueue[priority].size() && m_processing.size() < GetMaxWorkers(CJob::PRIORITY(priority)))
+    // our own queue first, then steal from the others
+    for (unsigned int i = 0; i < queues; ++i)
     {
+      CWorkQueue &source = m_queues[(queue + i) % queues];
+      CSingleLock queueLock(source.m_section);
+      JobQueue &jobs = source.m_jobs[priority];
+      if (jobs.empty())
+        continue;
+
+      CSingleLock lock(m_section);
+      // lower priorities are allowed even fewer workers
+      if (m_processing.size() >= GetMaxWorkers(CJob::PRIORITY(priority)))
+        return NULL;
+
       // pop the job off the queue
-      CWorkItem job = m_jobQueue[priority].front();
-      m_jobQueue[priority].pop_front();
+      CWorkItem job = jobs.front();
+      jobs.pop_front();
+
+      unsigned int wait = XbmcThreads::SystemClockMillis() - job.m_queuedAt;
+      m_stats.jobs++;
+      m_stats.totalWaitTime += wait;
+      m_stats.maxWaitTime = std::max(m_stats.maxWaitTime, wait);
+      if (i > 0)
+        m_stats.steals++;
 
       // add to the processing vector
       m_processing.push_back(job);
@@ -308,15 +379,102 @@ CJob *CJobManager::PopJob()
   return NULL;
 }
 
-void CJobManager::PauseJobs()
+bool CJobManager::HasQueuedJobs(CJob::PRIORITY &priority)
+{
+  const unsigned int queues = m_activeQueues;
+  for (int p = CJob::PRIORITY_DEDICATED; p >= CJob::PRIORITY_LOW_PAUSABLE; --p)
+  {
+    for (unsigned int queue = 0; queue < queues; ++queue)
+    {
+      CSingleLock queueLock(m_queues[queue].m_section);
+      if (!m_queues[queue].m_jobs[p].empty())
+      {
+        priority = CJob::PRIORITY(p);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void CJobManager::LockQueues()
+{
+  for (unsigned int queue = 0; queue < MAX_QUEUES; ++queue)
+    m_queues[queue].m_section.lock();
+}
+
+void CJobManager::UnlockQueues()
+{
+  for (unsigned int queue = MAX_QUEUES; queue > 0; --queue)
+    m_queues[queue - 1].m_section.unlock();
+}
+
+void CJobManager::SetWorkStealing(bool enable, unsigned int queues)
+{
+  if (!enable)
+    queues = 1;
+  else
+  {
+    if (queues == 0)
+      queues = g_cpuInfo.getCPUCount();
+    if (queues < 2)
+      queues = 2;
+    else if (queues > MAX_QUEUES)
+      queues = MAX_QUEUES;
+  }
+
+  LockQueues();
+  if (queues != m_activeQueues)
+  {
+    // gather everything that is queued, preserving the order within each queue
+    JobQueue pending[CJob::PRIORITY_DEDICATED + 1];
+    for (unsigned int queue = 0; queue < m_activeQueues; ++queue)
+    {
+      for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+      {
+        JobQueue &jobs = m_queues[queue].m_jobs[priority];
+        pending[priority].insert(pending[priority].end(), jobs.begin(), jobs.end());
+        jobs.clear();
+      }
+    }
+
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+    {
+      unsigned int queue = 0;
+      for (JobQueue::const_iterator it = pending[priority].begin(); it != pending[priority].end(); ++it)
+        m_queues[queue++ % queues].m_jobs[priority].push_back(*it);
+    }
+
+    m_activeQueues = queues;
+    CLog::Log(LOGDEBUG, "CJobManager: %s (%u queues)", enable ? "work-stealing enabled" : "work-stealing disabled", queues);
+  }
+  UnlockQueues();
+}
+
+bool CJobManager::IsWorkStealing() const
+{
+  return m_activeQueues > 1;
+}
+
+CJobManager::Statistics CJobManager::GetStatistics() const
 {
   CSingleLock lock(m_section);
+  return m_stats;
+}
+
+void CJobManager::ResetStatistics()
+{
+  CSingleLock lock(m_section);
+  m_stats = Statistics();
+}
+
+void CJobManager::PauseJobs()
+{
   m_pauseJobs = true;
 }
 
 void CJobManager::UnPauseJobs()
 {
-  CSingleLock lock(m_section);
   m_pauseJobs = false;
 }
 
@@ -353,30 +511,31 @@ int CJobManager::IsProcessing(const std::string &type) const
 
 CJob *CJobManager::GetNextJob(const CJobWorker *worker)
 {
-  CSingleLock lock(m_section);
   while (m_running)
   {
     // grab a job off the queue if we have one
-    CJob *job = PopJob();
+    CJob *job = PopJob(worker->GetQueue());
     if (job)
       return job;
     // no jobs are left - sleep for 30 seconds to allow new jobs to come in
-    lock.Leave();
-    bool newJob = m_jobEvent.WaitMSec(30000);
-    lock.Enter();
-    if (!newJob)
+    if (!m_jobEvent.WaitMSec(30000))
       break;
   }
   // ensure no jobs have come in during the period after
-  // timeout and before we held the lock
-  CJob *job = PopJob();
+  // timeout and before we leave
+  CJob *job = PopJob(worker->GetQueue());
   if (job)
     return job;
   // have no jobs
   RemoveWorker(worker);
+
+  // a job may have been queued after our last look while we were still counted
+  // as an idle worker, make sure someone picks it up
+  CJob::PRIORITY priority;
+  if (HasQueuedJobs(priority))
+    StartWorkers(priority);
   return NULL;
 }
-
 bool CJobManager::OnJobProgress(unsigned int progress, unsigned int total, const CJob *job) const
 {
   CSingleLock lock(m_section);
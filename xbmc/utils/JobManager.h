@@ -19,9 +19,11 @@
  *
  */
 
+#include <atomic>
 #include <queue>
 #include <vector>
 #include <string>
+#include <stdint.h>
 #include "threads/CriticalSection.h"
 #include "threads/Thread.h"
 #include "Job.h"
@@ -31,12 +33,19 @@ class CJobManager;
 class CJobWorker : public CThread
 {
 public:
-  CJobWorker(CJobManager *manager);
+  CJobWorker(CJobManager *manager, unsigned int queue);
   virtual ~CJobWorker();
 
   void Process();
+
+  /*!
+   \brief The work queue this worker prefers to pull jobs from.
+   Only meaningful in work-stealing mode, see CJobManager::SetWorkStealing()
+   */
+  unsigned int GetQueue() const { return m_queue; };
 private:
   CJobManager  *m_jobManager;
+  unsigned int  m_queue;
 };
 
 /*!
@@ -170,6 +179,12 @@ private:
  priority levels.  Lower priority jobs are executed only if there are sufficient
  spare worker threads free to allow for higher priority jobs that may arise.
 
+ Queued jobs are kept in one or more work queues, each holding one lane per priority
+ and guarded by its own lock.  By default a single queue is shared by all workers.
+ In work-stealing mode there are several queues: each worker prefers its own queue and
+ steals from the others when that runs dry, and jobs added from within a job go to the
+ queue of the worker running it.  Priority lanes are honoured across all queues.
+
  \sa CJob and IJobCallback
  */
 class CJobManager
@@ -183,6 +198,7 @@ class CJobManager
       m_id = id;
       m_callback = callback;
       m_priority = priority;
+      m_queuedAt = 0;
     }
     bool operator==(unsigned int jobID) const
     {
@@ -205,6 +221,16 @@ class CJobManager
     unsigned int  m_id;
     IJobCallback *m_callback;
     CJob::PRIORITY m_priority;
+    unsigned int  m_queuedAt;
+  };
+
+  typedef std::deque<CWorkItem> JobQueue;
+
+  class CWorkQueue
+  {
+  public:
+    CCriticalSection m_section;
+    JobQueue         m_jobs[CJob::PRIORITY_DEDICATED + 1];
   };
 
   template<typename F>
@@ -222,6 +248,17 @@ class CJobManager
   };
 
 public:
+  /*!
+   \brief Scheduling counters, see GetStatistics()
+   */
+  struct Statistics
+  {
+    uint64_t jobs;           //!< number of jobs taken off the queues for processing
+    uint64_t totalWaitTime;  //!< accumulated time jobs spent queued, in ms
+    unsigned int maxWaitTime; //!< longest time a job spent queued, in ms
+    uint64_t steals;         //!< number of jobs a worker took from another worker's queue
+  };
+
   /*!
    \brief The only way through which the global instance of the CJobManager should be accessed.
    \return the global instance.
@@ -297,6 +334,33 @@ public:
    */
   bool IsProcessing(const CJob::PRIORITY &priority) const;
 
+  /*!
+   \brief Switch between the shared queue and work-stealing scheduling
+   Jobs already queued are redistributed over the new set of queues.
+   \param enable true to give each worker its own queue and steal from the others when idle,
+   false to share a single queue between all workers.
+   \param queues number of queues to use in work-stealing mode, 0 picks one per CPU core.
+   \sa IsWorkStealing()
+   */
+  void SetWorkStealing(bool enable, unsigned int queues = 0);
+
+  /*!
+   \brief Checks whether work-stealing scheduling is enabled
+   \sa SetWorkStealing()
+   */
+  bool IsWorkStealing() const;
+
+  /*!
+   \brief Retrieve queue wait time and steal counters
+   \sa ResetStatistics()
+   */
+  Statistics GetStatistics() const;
+
+  /*!
+   \brief Reset the counters returned by GetStatistics()
+   */
+  void ResetStatistics();
+
 protected:
   friend class CJobWorker;
   friend class CJob;
@@ -335,27 +399,42 @@ private:
   CJobManager const& operator=(CJobManager const&);
   virtual ~CJobManager();
 
-  /*! \brief Pop a job off the job queue and add to the processing queue ready to process
+  /*! \brief Pop a job off the job queues and add to the processing queue ready to process
+   The given queue is tried first, the other active queues are stolen from afterwards.
+   \param queue the preferred queue of the calling worker
    \return the job to process, NULL if no jobs are available
    */
-  CJob *PopJob();
+  CJob *PopJob(unsigned int queue);
+
+  /*! \brief Check for queued jobs, returning the highest priority found
+   */
+  bool HasQueuedJobs(CJob::PRIORITY &priority);
+
+  /*! \brief Lock all work queues in order, preventing jobs moving between queues
+   */
+  void LockQueues();
+  void UnlockQueues();
 
   void StartWorkers(CJob::PRIORITY priority);
   void RemoveWorker(const CJobWorker *worker);
   static unsigned int GetMaxWorkers(CJob::PRIORITY priority);
 
-  unsigned int m_jobCounter;
+  static const unsigned int MAX_QUEUES = 16;
 
-  typedef std::deque<CWorkItem>    JobQueue;
   typedef std::vector<CWorkItem>   Processing;
   typedef std::vector<CJobWorker*> Workers;
 
-  JobQueue   m_jobQueue[CJob::PRIORITY_DEDICATED + 1];
-  bool       m_pauseJobs;
+  // lock order is: work queues (ascending) -> m_section
+  CWorkQueue        m_queues[MAX_QUEUES];
+  std::atomic<unsigned int> m_activeQueues;
+  std::atomic<unsigned int> m_nextQueue;
+  std::atomic<unsigned int> m_jobCounter;
+  std::atomic<bool> m_pauseJobs;
   Processing m_processing;
   Workers    m_workers;
+  Statistics m_stats;
 
   CCriticalSection m_section;
   CEvent           m_jobEvent;
-  bool             m_running;
+  std::atomic<bool> m_running;
 };
@@ -0,0 +1,144 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ParallelJobs.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/Event.h"
+#include "utils/CPUInfo.h"
+#include "utils/JobManager.h"
+
+#include <atomic>
+#include <memory>
+
+namespace
+{
+// shared between the caller and the jobs as a job may only start running
+// after the caller has already finished all tasks and returned
+class CParallelTaskState
+{
+public:
+  CParallelTaskState(size_t count, const std::function<void(size_t)> &task)
+    : m_count(count),
+      m_task(task),
+      m_next(0),
+      m_done(0),
+      m_finished(true)
+  { }
+
+  void Work()
+  {
+    size_t index;
+    while ((index = m_next++) < m_count)
+    {
+      m_task(index);
+      if (++m_done == m_count)
+        m_finished.Set();
+    }
+  }
+
+  void Wait()
+  {
+    m_finished.Wait();
+  }
+
+private:
+  const size_t m_count;
+  const std::function<void(size_t)> m_task;
+  std::atomic<size_t> m_next;
+  std::atomic<size_t> m_done;
+  CEvent m_finished;
+};
+
+class CParallelTaskJob : public CJob
+{
+public:
+  explicit CParallelTaskJob(const std::shared_ptr<CParallelTaskState> &state)
+    : m_state(state)
+  { }
+
+  bool DoWork() override
+  {
+    m_state->Work();
+    return true;
+  }
+
+  const char *GetType() const override { return "paralleltask"; }
+
+private:
+  std::shared_ptr<CParallelTaskState> m_state;
+};
+}
+
+unsigned int CParallelJobs::GetThreads(size_t items)
+{
+  if (items < g_advancedSettings.m_jobManagerParallelThreshold)
+    return 1;
+
+  unsigned int threads = g_advancedSettings.m_jobManagerParallelThreads;
+  if (threads == 0)
+    threads = std::min(std::max(g_cpuInfo.getCPUCount(), 1), 4);
+
+  return threads;
+}
+
+size_t CParallelJobs::GetRanges(size_t count, unsigned int threads)
+{
+  return std::max<size_t>(std::min<size_t>(threads, count), 1);
+}
+
+void CParallelJobs::ForEach(size_t count, unsigned int threads, const std::function<void(size_t range, size_t begin, size_t end)> &task)
+{
+  const size_t ranges = GetRanges(count, threads);
+  Run(ranges, threads, [&](size_t range)
+  {
+    task(range, count * range / ranges, count * (range + 1) / ranges);
+  });
+}
+
+void CParallelJobs::Run(size_t count, unsigned int threads, const std::function<void(size_t index)> &task)
+{
+  if (count == 0)
+    return;
+
+  if (threads <= 1 || count == 1)
+  {
+    for (size_t i = 0; i < count; i++)
+      task(i);
+    return;
+  }
+
+  std::shared_ptr<CParallelTaskState> state = std::make_shared<CParallelTaskState>(count, task);
+
+  // the calling thread is one of the threads
+  const size_t jobs = std::min<size_t>(threads - 1, count - 1);
+  for (size_t i = 0; i < jobs; i++)
+  {
+    CParallelTaskJob *job = new CParallelTaskJob(state);
+    if (CJobManager::GetInstance().AddJob(job, NULL, CJob::PRIORITY_HIGH) == 0)
+    {
+      // the job manager is shutting down, do the rest ourselves
+      delete job;
+      break;
+    }
+  }
+
+  state->Work();
+  state->Wait();
+}
@@ -0,0 +1,129 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <stddef.h>
+#include <vector>
+
+/*!
+ \ingroup jobs
+ \brief Splits work on large lists over the CJobManager workers.
+
+ The calling thread always takes part in the work and only returns once all of
+ it is done, so the helpers can be used from the GUI thread as well as from
+ within a job, even if all workers are busy. Results don't depend on the
+ number of threads used.
+
+ \sa CJobManager
+ */
+class CParallelJobs
+{
+public:
+  /*!
+   \brief Get the number of threads to use for a list of the given size.
+
+   Lists smaller than <jobmanager><parallelthreshold> are handled by the
+   calling thread alone, larger ones by at most <jobmanager><parallelthreads>
+   threads (including the calling one).
+   \param items the number of items in the list
+   \return the number of threads, 1 to handle the list serially
+   */
+  static unsigned int GetThreads(size_t items);
+
+  /*!
+   \brief Get the number of ranges ForEach() splits the items into.
+   */
+  static size_t GetRanges(size_t count, unsigned int threads);
+
+  /*!
+   \brief Call task(range, begin, end) for contiguous ranges covering [0, count).
+   \param count the number of items
+   \param threads the number of threads to use, see GetThreads()
+   \param task the function handling the items in [begin, end). It is called
+   from several threads at once, each time with a different range. The ranges
+   are numbered in order from 0 to GetRanges() - 1.
+   */
+  static void ForEach(size_t count, unsigned int threads, const std::function<void(size_t range, size_t begin, size_t end)> &task);
+
+  /*!
+   \brief Call task(i) for every i in [0, count) and wait until all calls returned.
+
+   Unlike ForEach() the items are handed out one by one to whichever thread
+   is free, which suits few items that take very different amounts of time.
+   \param count the number of items
+   \param threads the maximum number of threads to use (including the calling one)
+   \param task the function handling item i. It is called from several threads at once.
+   */
+  static void Run(size_t count, unsigned int threads, const std::function<void(size_t index)> &task);
+
+  /*!
+   \brief Sort the items like std::stable_sort() does.
+
+   With more than one thread the list is split into chunks which are sorted
+   in parallel and then merged pairwise. Merging keeps the order of equal
+   items so the result is identical to the one of std::stable_sort().
+   */
+  template<typename T, typename Compare>
+  static void StableSort(std::vector<T> &items, Compare comp, unsigned int threads)
+  {
+    const size_t chunks = std::min<size_t>(threads, items.size() / MinChunkSize);
+    if (chunks <= 1)
+    {
+      std::stable_sort(items.begin(), items.end(), comp);
+      return;
+    }
+
+    std::vector<size_t> bounds(chunks + 1);
+    for (size_t i = 0; i <= chunks; i++)
+      bounds[i] = items.size() * i / chunks;
+
+    Run(chunks, threads, [&](size_t chunk)
+    {
+      std::stable_sort(items.begin() + bounds[chunk], items.begin() + bounds[chunk + 1], comp);
+    });
+
+    std::vector<T> buffer(items.size());
+    std::vector<T> *source = &items;
+    std::vector<T> *target = &buffer;
+    for (size_t width = 1; width < chunks; width *= 2)
+    {
+      const size_t merges = (chunks + 2 * width - 1) / (2 * width);
+      Run(merges, threads, [&](size_t merge)
+      {
+        const size_t first = bounds[merge * 2 * width];
+        const size_t middle = bounds[std::min(merge * 2 * width + width, chunks)];
+        const size_t last = bounds[std::min(merge * 2 * width + 2 * width, chunks)];
+        std::merge(std::make_move_iterator(source->begin() + first), std::make_move_iterator(source->begin() + middle),
+                   std::make_move_iterator(source->begin() + middle), std::make_move_iterator(source->begin() + last),
+                   target->begin() + first, comp);
+      });
+      std::swap(source, target);
+    }
+
+    if (source != &items)
+      items.swap(buffer);
+  }
+
+private:
+  static const size_t MinChunkSize = 1024;
+};
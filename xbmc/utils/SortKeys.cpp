@@ -0,0 +1,540 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SortKeys.h"
+#include "LangInfo.h"
+#include "utils/CharsetConverter.h"
+#include "utils/ParallelJobs.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+static const CVariant& GetValue(const SortItem &item, Field field)
+{
+  SortItem::const_iterator it = item.find(field);
+  if (it == item.end())
+    return CVariant::ConstNullVariant;
+
+  return it->second;
+}
+
+// the preparators format integers with "%i" after casting them to int
+static bool GetInteger(const CVariant &variant, int64_t &value)
+{
+  value = (int)variant.asInteger();
+  return value >= 0;
+}
+
+static bool GetInteger64(const CVariant &variant, int64_t &value)
+{
+  value = variant.asInteger();
+  return value >= 0;
+}
+
+// the preparators format ratings with "%f" i.e. with six decimals
+static bool GetRating(const CVariant &variant, int64_t &value)
+{
+  double rating = variant.asFloat();
+  if (!(rating >= 0.0) || rating > (double)(std::numeric_limits<int64_t>::max() / 1000000))
+    return false;
+
+  value = llround(rating * 1000000.0);
+  return true;
+}
+
+static bool IsDigits(const std::string &str, size_t start, size_t count)
+{
+  for (size_t i = start; i < start + count; i++)
+  {
+    if (!StringUtils::isasciidigit(str[i]))
+      return false;
+  }
+  return true;
+}
+
+// packs "YYYY-MM-DD" and "YYYY-MM-DD hh:mm:ss" into YYYYMMDDhhmmss which
+// orders the same way as the digit groups compared by AlphaNumericCompare as
+// long as all dates of the list use the same format
+static bool GetDate(const CVariant &variant, size_t &format, int64_t &value)
+{
+  value = 0;
+  if (variant.isNull())
+    return true;
+
+  const std::string date = variant.asString();
+  if (date.empty())
+    return true;
+
+  if (date.size() != 10 && date.size() != 19)
+    return false;
+  if (format == 0)
+    format = date.size();
+  else if (format != date.size())
+    return false;
+  if (!IsDigits(date, 0, 4) || date[4] != '-' || !IsDigits(date, 5, 2) || date[7] != '-' || !IsDigits(date, 8, 2))
+    return false;
+
+  int64_t day = atoi(date.c_str()) * 10000 + atoi(date.c_str() + 5) * 100 + atoi(date.c_str() + 8);
+  int64_t time = 0;
+  if (date.size() == 19)
+  {
+    if (date[10] != ' ' || !IsDigits(date, 11, 2) || date[13] != ':' || !IsDigits(date, 14, 2) || date[16] != ':' || !IsDigits(date, 17, 2))
+      return false;
+    time = atoi(date.c_str() + 11) * 10000 + atoi(date.c_str() + 14) * 100 + atoi(date.c_str() + 17);
+  }
+
+  value = day * 1000000 + time;
+  return true;
+}
+
+CSortKeys::CSortKeys(SortBy sortBy, SortAttribute attributes)
+  : m_sortBy(sortBy),
+    m_attributes(attributes),
+    m_leading(LeadingNone),
+    m_valueCount(0),
+    m_dateFormat(0),
+    m_yearLayout(-1),
+    m_hasAirDate(false),
+    m_hasYearWithoutAirDate(false)
+{
+  switch (m_sortBy)
+  {
+    case SortByLabel:
+    case SortByTitle:
+    case SortBySortTitle:
+      break;
+
+    case SortByDateAdded:
+      m_leading = LeadingDate;
+      m_valueCount = 2;
+      break;
+
+    case SortByDate:
+    case SortByLastPlayed:
+      m_leading = LeadingDate;
+      m_valueCount = 1;
+      break;
+
+    case SortByRating:
+      m_leading = LeadingRating;
+      m_valueCount = 1;
+      break;
+
+    case SortByYear:
+      m_leading = LeadingDate;
+      m_valueCount = 3;
+      break;
+
+    default:
+      m_leading = LeadingInteger;
+      m_valueCount = 1;
+      break;
+  }
+
+  if (m_attributes & SortAttributeIgnoreArticle)
+    m_sortTokens = g_langInfo.GetSortTokens();
+}
+
+bool CSortKeys::IsSupported(SortBy sortBy)
+{
+  switch (sortBy)
+  {
+    case SortByLabel:
+    case SortByTitle:
+    case SortBySortTitle:
+    case SortByDate:
+    case SortByDateAdded:
+    case SortByLastPlayed:
+    case SortByPlaycount:
+    case SortByYear:
+    case SortByRating:
+    case SortByUserRating:
+    case SortByVotes:
+    case SortByTop250:
+    case SortBySize:
+    case SortByBitrate:
+    case SortByListeners:
+    case SortByDriveType:
+    case SortByTrackNumber:
+    case SortByProgramCount:
+    case SortByPlaylistOrder:
+    case SortByEpisodeNumber:
+    case SortBySeason:
+    case SortByNumberOfEpisodes:
+    case SortByNumberOfWatchedEpisodes:
+    case SortByVideoResolution:
+    case SortByAudioChannels:
+    case SortByChannelNumber:
+    case SortByRelevance:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+bool CSortKeys::Add(const SortItem &item)
+{
+  Key key;
+  key.values[0] = key.values[1] = key.values[2] = 0;
+  key.special = SortSpecialNone;
+  key.hasFolder = false;
+  key.folder = false;
+
+  SortItem::const_iterator it = item.find(FieldSortSpecial);
+  if (it != item.end() && it->second.asInteger() <= (int64_t)SortSpecialOnBottom)
+    key.special = (SortSpecial)it->second.asInteger();
+  it = item.find(FieldFolder);
+  if (it != item.end())
+  {
+    key.hasFolder = true;
+    key.folder = it->second.asBoolean();
+  }
+
+  bool valid = true;
+  switch (m_sortBy)
+  {
+    case SortByLabel:
+      valid = GetLabel(item, key.text);
+      break;
+
+    case SortByTitle:
+      valid = GetTitle(item, FieldTitle, key.text);
+      break;
+
+    case SortBySortTitle:
+      valid = GetTitle(item, FieldSortTitle, key.text);
+      break;
+
+    case SortByDate:
+      valid = GetDate(GetValue(item, FieldDate), m_dateFormat, key.values[0]) && GetLabel(item, key.text);
+      break;
+
+    case SortByDateAdded:
+      valid = GetDate(GetValue(item, FieldDateAdded), m_dateFormat, key.values[0]) && GetInteger(GetValue(item, FieldId), key.values[1]);
+      break;
+
+    case SortByLastPlayed:
+      valid = GetDate(GetValue(item, FieldLastPlayed), m_dateFormat, key.values[0]) && GetLabel(item, key.text);
+      break;
+
+    case SortByPlaycount:
+      valid = GetInteger(GetValue(item, FieldPlaycount), key.values[0]) && GetLabel(item, key.text);
+      break;
+
+    case SortByYear:
+    {
+      // the preparator builds "[airdate ]year[ album][ track] label". The
+      // optional parts only compare like separate keys if all items have the
+      // same layout and an item without an air date has no year either, which
+      // is the case for the video library. Albums are left to the preparator.
+      const CVariant &album = GetValue(item, FieldAlbum);
+      const CVariant &track = GetValue(item, FieldTrackNumber);
+      if (!album.isNull() && !album.asString().empty())
+        return false;
+
+      int layout = (album.isNull() ? 0 : 1) | (track.isNull() ? 0 : 2);
+      if (m_yearLayout < 0)
+        m_yearLayout = layout;
+      else if (m_yearLayout != layout)
+        return false;
+
+      valid = GetDate(GetValue(item, FieldAirDate), m_dateFormat, key.values[0]) &&
+              GetInteger(GetValue(item, FieldYear), key.values[1]) &&
+              GetInteger(track, key.values[2]) && GetLabel(item, key.text);
+      if (key.values[0] > 0)
+        m_hasAirDate = true;
+      else if (key.values[1] > 0)
+        m_hasYearWithoutAirDate = true;
+      if (m_hasAirDate && m_hasYearWithoutAirDate)
+        return false;
+      break;
+    }
+
+    case SortByRating:
+      valid = GetRating(GetValue(item, FieldRating), key.values[0]) && GetLabel(item, key.text);
+      break;
+
+    case SortByUserRating:
+      valid = GetInteger(GetValue(item, FieldUserRating), key.values[0]) && GetLabel(item, key.text);
+      break;
+
+    case SortByVotes:
+      valid = GetInteger(GetValue(item, FieldVotes), key.values[0]) && GetLabel(item, key.text);
+      break;
+
+    case SortByTop250:
+      valid = GetInteger(GetValue(item, FieldTop250), key.values[0]) && GetLabel(item, key.text);
+      break;
+
+    case SortBySize:
+      valid = GetInteger64(GetValue(item, FieldSize), key.values[0]);
+      break;
+
+    case SortByBitrate:
+      valid = GetInteger64(GetValue(item, FieldBitrate), key.values[0]);
+      break;
+
+    case SortByListeners:
+      valid = GetInteger64(GetValue(item, FieldListeners), key.values[0]);
+      break;
+
+    case SortByDriveType:
+      valid = GetInteger(GetValue(item, FieldDriveType), key.values[0]) && GetLabel(item, key.text);
+      break;
+
+    case SortByTrackNumber:
+      valid = GetInteger(GetValue(item, FieldTrackNumber), key.values[0]);
+      break;
+
+    case SortByProgramCount:
+    case SortByPlaylistOrder:
+      valid = GetInteger(GetValue(item, FieldProgramCount), key.values[0]);
+      break;
+
+    case SortByEpisodeNumber:
+    {
+      // same offset calculation as the ByEpisodeNumber preparator
+      uint64_t num;
+      const CVariant &episodeSpecial = GetValue(item, FieldEpisodeNumberSpecialSort);
+      const CVariant &seasonSpecial = GetValue(item, FieldSeasonSpecialSort);
+      if (!episodeSpecial.isNull() && !seasonSpecial.isNull() &&
+         (episodeSpecial.asInteger() > 0 || seasonSpecial.asInteger() > 0))
+        num = ((uint64_t)seasonSpecial.asInteger() << 32) + (episodeSpecial.asInteger() << 16) - ((2 << 15) - GetValue(item, FieldEpisodeNumber).asInteger());
+      else
+        num = ((uint64_t)GetValue(item, FieldSeason).asInteger() << 32) + (GetValue(item, FieldEpisodeNumber).asInteger() << 16);
+      if (num > (uint64_t)std::numeric_limits<int64_t>::max())
+        return false;
+      key.values[0] = (int64_t)num;
+
+      it = item.find(FieldMediaType);
+      if (it != item.end() && it->second.asString() == MediaTypeMovie)
+        valid = GetTitle(item, FieldSortTitle, key.text);
+      if (valid && key.text.empty())
+        valid = GetLabel(item, key.text);
+      break;
+    }
+
+    case SortBySeason:
+    {
+      const CVariant &specialSeason = GetValue(item, FieldSeasonSpecialSort);
+      valid = GetInteger(specialSeason.isNull() ? GetValue(item, FieldSeason) : specialSeason, key.values[0]) && GetLabel(item, key.text);
+      break;
+    }
+
+    case SortByNumberOfEpisodes:
+      valid = GetInteger(GetValue(item, FieldNumberOfEpisodes), key.values[0]) && GetLabel(item, key.text);
+      break;
+
+    case SortByNumberOfWatchedEpisodes:
+      valid = GetInteger(GetValue(item, FieldNumberOfWatchedEpisodes), key.values[0]) && GetLabel(item, key.text);
+      break;
+
+    case SortByVideoResolution:
+      valid = GetInteger(GetValue(item, FieldVideoResolution), key.values[0]) && GetLabel(item, key.text);
+      break;
+
+    case SortByAudioChannels:
+      valid = GetInteger(GetValue(item, FieldAudioChannels), key.values[0]) && GetLabel(item, key.text);
+      break;
+
+    case SortByChannelNumber:
+      valid = GetInteger(GetValue(item, FieldChannelNumber), key.values[0]);
+      break;
+
+    case SortByRelevance:
+      valid = GetInteger(GetValue(item, FieldRelevance), key.values[0]);
+      break;
+
+    default:
+      return false;
+  }
+
+  if (!valid)
+    return false;
+
+  m_keys.push_back(std::move(key));
+  return true;
+}
+
+bool CSortKeys::Append(CSortKeys &&keys)
+{
+  if (keys.m_dateFormat != 0)
+  {
+    if (m_dateFormat == 0)
+      m_dateFormat = keys.m_dateFormat;
+    else if (m_dateFormat != keys.m_dateFormat)
+      return false;
+  }
+
+  if (keys.m_yearLayout >= 0)
+  {
+    if (m_yearLayout < 0)
+      m_yearLayout = keys.m_yearLayout;
+    else if (m_yearLayout != keys.m_yearLayout)
+      return false;
+  }
+
+  m_hasAirDate |= keys.m_hasAirDate;
+  m_hasYearWithoutAirDate |= keys.m_hasYearWithoutAirDate;
+  if (m_hasAirDate && m_hasYearWithoutAirDate)
+    return false;
+
+  if (m_keys.empty())
+    m_keys.swap(keys.m_keys);
+  else
+    m_keys.insert(m_keys.end(), std::make_move_iterator(keys.m_keys.begin()), std::make_move_iterator(keys.m_keys.end()));
+  keys.m_keys.clear();
+
+  return true;
+}
+
+std::vector<size_t> CSortKeys::GetOrder(SortOrder sortOrder, int limitEnd /* = -1 */, int limitStart /* = 0 */) const
+{
+  std::vector<size_t> order(m_keys.size());
+  for (size_t i = 0; i < order.size(); i++)
+    order[i] = i;
+
+  const bool handleFolder = !(m_attributes & SortAttributeIgnoreFolders);
+  const bool descending = sortOrder == SortOrderDescending;
+  CParallelJobs::StableSort(order, [&](size_t leftIndex, size_t rightIndex)
+  {
+    const Key &left = m_keys[leftIndex];
+    const Key &right = m_keys[rightIndex];
+
+    // same special sorting and folder handling as the preparator sorters
+    if (left.special != right.special)
+      return left.special == SortSpecialOnTop || right.special == SortSpecialOnBottom;
+    if (left.special != SortSpecialNone)
+      return false;
+
+    if (handleFolder && left.hasFolder && right.hasFolder && left.folder != right.folder)
+      return left.folder;
+
+    int result = Compare(left, right);
+    return descending ? result > 0 : result < 0;
+  }, CParallelJobs::GetThreads(order.size()));
+
+  if (limitStart > 0 && (size_t)limitStart < order.size())
+  {
+    order.erase(order.begin(), order.begin() + limitStart);
+    limitEnd -= limitStart;
+  }
+  if (limitEnd > 0 && (size_t)limitEnd < order.size())
+    order.erase(order.begin() + limitEnd, order.end());
+
+  return order;
+}
+
+std::wstring CSortKeys::GetSortLabel(size_t index) const
+{
+  const Key &key = m_keys[index];
+
+  std::wstring label;
+  switch (m_leading)
+  {
+    case LeadingNone:
+      return key.text;
+
+    case LeadingInteger:
+      label = std::to_wstring(key.values[0]);
+      break;
+
+    case LeadingRating:
+      label = std::to_wstring(key.values[0] / 1000000.0);
+      break;
+
+    case LeadingDate:
+      // an empty date is formatted as an empty string by the preparators
+      if (key.values[0] > 0)
+        label = std::to_wstring(key.values[0]);
+      break;
+  }
+
+  for (unsigned int i = 1; i < m_valueCount; i++)
+  {
+    if (!label.empty())
+      label += L" ";
+    label += std::to_wstring(key.values[i]);
+  }
+  if (!key.text.empty())
+  {
+    if (!label.empty())
+      label += L" ";
+    label += key.text;
+  }
+
+  return label;
+}
+
+bool CSortKeys::GetText(const SortItem &item, Field field, std::wstring &text) const
+{
+  return g_charsetConverter.utf8ToW(GetValue(item, field).asString(), text, false);
+}
+
+bool CSortKeys::GetLabel(const SortItem &item, std::wstring &text) const
+{
+  if (!(m_attributes & SortAttributeIgnoreArticle))
+    return GetText(item, FieldLabel, text);
+
+  return g_charsetConverter.utf8ToW(RemoveArticles(GetValue(item, FieldLabel).asString()), text, false);
+}
+
+bool CSortKeys::GetTitle(const SortItem &item, Field field, std::wstring &text) const
+{
+  std::string title = GetValue(item, field).asString();
+  if (title.empty() && field == FieldSortTitle)
+    title = GetValue(item, FieldTitle).asString();
+
+  if (m_attributes & SortAttributeIgnoreArticle)
+    title = RemoveArticles(title);
+
+  return g_charsetConverter.utf8ToW(title, text, false);
+}
+
+std::string CSortKeys::RemoveArticles(const std::string &label) const
+{
+  for (std::set<std::string>::const_iterator token = m_sortTokens.begin(); token != m_sortTokens.end(); ++token)
+  {
+    if (token->size() < label.size() && StringUtils::StartsWithNoCase(label, *token))
+      return label.substr(token->size());
+  }
+
+  return label;
+}
+
+int CSortKeys::Compare(const Key &left, const Key &right) const
+{
+  for (unsigned int i = 0; i < m_valueCount; i++)
+  {
+    if (left.values[i] != right.values[i])
+      return left.values[i] < right.values[i] ? -1 : 1;
+  }
+
+  if (left.text.empty() || right.text.empty())
+    return left.text.empty() ? (right.text.empty() ? 0 : -1) : 1;
+
+  int64_t result = StringUtils::AlphaNumericCompare(left.text.c_str(), right.text.c_str());
+  return result < 0 ? -1 : (result > 0 ? 1 : 0);
+}
@@ -0,0 +1,125 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <set>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "SortUtils.h"
+
+/*!
+ \brief Sorts items by typed sort keys that are extracted once per item.
+
+ The string preparators of SortUtils format every sort method into a single
+ string which is then compared character by character on every comparison.
+ For the common sort methods CSortKeys instead extracts the numeric parts
+ (years, ratings, counts, dates) as integers and only the textual part
+ (article stripped) as a wide string, stores them in one contiguous array and
+ sorts a permutation of indices into it.
+
+ The resulting order is the same as the one of the string preparators. Items
+ which can't be represented exactly by a typed key (e.g. negative numbers or
+ dates in an unknown format) are reported by Add() so that the caller can fall
+ back to SortUtils::SortByPreparator().
+ */
+class CSortKeys
+{
+public:
+  CSortKeys(SortBy sortBy, SortAttribute attributes);
+
+  /*!
+   \brief Whether typed keys are available for the given sort method.
+   */
+  static bool IsSupported(SortBy sortBy);
+
+  void Reserve(size_t count) { m_keys.reserve(count); }
+  size_t Size() const { return m_keys.size(); }
+
+  /*!
+   \brief Extract the sort key of the given item and append it.
+   \return false if the item can't be sorted by a typed key
+   */
+  bool Add(const SortItem &item);
+
+  /*!
+   \brief Move the keys of another list of keys to the end of this one.
+
+   Used to combine keys that were extracted in parallel for consecutive ranges
+   of items.
+   \return false if the keys can't be sorted together by typed keys
+   */
+  bool Append(CSortKeys &&keys);
+
+  /*!
+   \brief Sort the keys added so far.
+
+   Large lists are sorted in parallel, see CParallelJobs.
+   \param sortOrder the order to sort in
+   \param limitEnd index after the last item to keep (as in SortDescription), -1 for all
+   \param limitStart index of the first item to keep
+   \return the indices of the added items in sorted order, limited to the requested range
+   */
+  std::vector<size_t> GetOrder(SortOrder sortOrder, int limitEnd = -1, int limitStart = 0) const;
+
+  /*!
+   \brief Get the label of the given item that is used for jumping by letter.
+
+   Starts with the same character as the string produced by the matching
+   string preparator.
+   */
+  std::wstring GetSortLabel(size_t index) const;
+
+private:
+  enum LeadingValue
+  {
+    LeadingNone,
+    LeadingInteger,
+    LeadingRating,
+    LeadingDate
+  };
+
+  struct Key
+  {
+    int64_t values[3];
+    std::wstring text;
+    SortSpecial special;
+    bool hasFolder;
+    bool folder;
+  };
+
+  bool GetText(const SortItem &item, Field field, std::wstring &text) const;
+  bool GetLabel(const SortItem &item, std::wstring &text) const;
+  bool GetTitle(const SortItem &item, Field field, std::wstring &text) const;
+  std::string RemoveArticles(const std::string &label) const;
+  int Compare(const Key &left, const Key &right) const;
+
+  SortBy m_sortBy;
+  SortAttribute m_attributes;
+  LeadingValue m_leading;
+  unsigned int m_valueCount;
+  size_t m_dateFormat;
+  int m_yearLayout;
+  bool m_hasAirDate;
+  bool m_hasYearWithoutAirDate;
+  std::set<std::string> m_sortTokens;
+  std::vector<Key> m_keys;
+};
@@ -19,11 +19,13 @@
  */
 
 #include "SortUtils.h"
+#include "SortKeys.h"
 #include "LangInfo.h"
 #include "URL.h"
 #include "Util.h"
 #include "XBDateTime.h"
 #include "utils/CharsetConverter.h"
+#include "utils/ParallelJobs.h"
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
 
@@ -689,7 +691,54 @@ std::map<SortBy, Fields> fillSortingFields()
 std::map<SortBy, SortUtils::SortPreparator> SortUtils::m_preparators = fillPreparators();
 std::map<SortBy, Fields> SortUtils::m_sortingFields = fillSortingFields();
 
+static const SortItem& GetSortItem(const SortItem &item)
+{
+  return item;
+}
+
+static const SortItem& GetSortItem(const SortItemPtr &item)
+{
+  return *item;
+}
+
+template<typename Items>
+static bool SortByKeys(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, Items& items, int limitEnd, int limitStart)
+{
+  if (!CSortKeys::IsSupported(sortBy))
+    return false;
+
+  CSortKeys keys(sortBy, attributes);
+  keys.Reserve(items.size());
+  for (typename Items::const_iterator item = items.begin(); item != items.end(); ++item)
+  {
+    if (!keys.Add(GetSortItem(*item)))
+      return false;
+  }
+
+  std::vector<size_t> order = keys.GetOrder(sortOrder, limitEnd, limitStart);
+
+  Items sortedItems;
+  sortedItems.reserve(order.size());
+  for (std::vector<size_t>::const_iterator index = order.begin(); index != order.end(); ++index)
+    sortedItems.push_back(std::move(items[*index]));
+  items.swap(sortedItems);
+
+  return true;
+}
+
 void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, DatabaseResults& items, int limitEnd /* = -1 */, int limitStart /* = 0 */)
+{
+  if (!SortByKeys(sortBy, sortOrder, attributes, items, limitEnd, limitStart))
+    SortByPreparator(sortBy, sortOrder, attributes, items, limitEnd, limitStart);
+}
+
+void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, SortItems& items, int limitEnd /* = -1 */, int limitStart /* = 0 */)
+{
+  if (!SortByKeys(sortBy, sortOrder, attributes, items, limitEnd, limitStart))
+    SortByPreparator(sortBy, sortOrder, attributes, items, limitEnd, limitStart);
+}
+
+void SortUtils::SortByPreparator(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, DatabaseResults& items, int limitEnd /* = -1 */, int limitStart /* = 0 */)
 {
   if (sortBy != SortByNone)
   {
@@ -699,23 +748,29 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
     {
       Fields sortingFields = GetFieldsForSorting(sortBy);
 
+      // the random preparator isn't safe to call from several threads
+      const unsigned int threads = sortBy == SortByRandom ? 1 : CParallelJobs::GetThreads(items.size());
+
       // Prepare the string used for sorting and store it under FieldSort
-      for (DatabaseResults::iterator item = items.begin(); item != items.end(); ++item)
+      CParallelJobs::ForEach(items.size(), threads, [&](size_t range, size_t begin, size_t end)
       {
-        // add all fields to the item that are required for sorting if they are currently missing
-        for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); ++field)
+        for (DatabaseResults::iterator item = items.begin() + begin; item != items.begin() + end; ++item)
         {
-          if (item->find(*field) == item->end())
-            item->insert(std::pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
+          // add all fields to the item that are required for sorting if they are currently missing
+          for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); ++field)
+          {
+            if (item->find(*field) == item->end())
+              item->insert(std::pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
+          }
+
+          std::wstring sortLabel;
+          g_charsetConverter.utf8ToW(preparator(attributes, *item), sortLabel, false);
+          item->insert(std::pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
         }
-
-        std::wstring sortLabel;
-        g_charsetConverter.utf8ToW(preparator(attributes, *item), sortLabel, false);
-        item->insert(std::pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
-      }
+      });
 
       // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorter(sortOrder, attributes));
+      CParallelJobs::StableSort(items, getSorter(sortOrder, attributes), threads);
     }
   }
 
@@ -728,7 +783,7 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
     items.erase(items.begin() + limitEnd, items.end());
 }
 
-void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, SortItems& items, int limitEnd /* = -1 */, int limitStart /* = 0 */)
+void SortUtils::SortByPreparator(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, SortItems& items, int limitEnd /* = -1 */, int limitStart /* = 0 */)
 {
   if (sortBy != SortByNone)
   {
@@ -738,23 +793,29 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
     {
       Fields sortingFields = GetFieldsForSorting(sortBy);
 
+      // the random preparator isn't safe to call from several threads
+      const unsigned int threads = sortBy == SortByRandom ? 1 : CParallelJobs::GetThreads(items.size());
+
       // Prepare the string used for sorting and store it under FieldSort
-      for (SortItems::iterator item = items.begin(); item != items.end(); ++item)
+      CParallelJobs::ForEach(items.size(), threads, [&](size_t range, size_t begin, size_t end)
       {
-        // add all fields to the item that are required for sorting if they are currently missing
-        for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); ++field)
+        for (SortItems::iterator item = items.begin() + begin; item != items.begin() + end; ++item)
         {
-          if ((*item)->find(*field) == (*item)->end())
-            (*item)->insert(std::pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
+          // add all fields to the item that are required for sorting if they are currently missing
+          for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); ++field)
+          {
+            if ((*item)->find(*field) == (*item)->end())
+              (*item)->insert(std::pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
+          }
+
+          std::wstring sortLabel;
+          g_charsetConverter.utf8ToW(preparator(attributes, **item), sortLabel, false);
+          (*item)->insert(std::pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
         }
-
-        std::wstring sortLabel;
-        g_charsetConverter.utf8ToW(preparator(attributes, **item), sortLabel, false);
-        (*item)->insert(std::pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
-      }
+      });
 
       // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorterIndirect(sortOrder, attributes));
+      CParallelJobs::StableSort(items, getSorterIndirect(sortOrder, attributes), threads);
     }
   }
 
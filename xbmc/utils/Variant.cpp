@@ -20,6 +20,9 @@
 
 #include "Variant.h"
 
+#include <algorithm>
+#include <atomic>
+#include <new>
 #include <stdlib.h>
 #include <string.h>
 #include <sstream>
@@ -129,6 +132,45 @@ double str2double(const std::wstring &str, double fallback /* = 0.0 */)
   return fallback;
 }
 
+// reference counted, immutable string data in a single allocation
+struct CVariant::SharedString
+{
+  std::atomic<unsigned int> references;
+  size_t length;
+
+  const char *Data() const { return reinterpret_cast<const char *>(this + 1); }
+
+  static SharedString *Create(const char *str, size_t length)
+  {
+    void *memory = malloc(sizeof(SharedString) + length + 1);
+    if (memory == NULL)
+      throw std::bad_alloc();
+
+    SharedString *string = new (memory) SharedString();
+    string->references = 1;
+    string->length = length;
+    char *data = reinterpret_cast<char *>(string + 1);
+    memcpy(data, str, length);
+    data[length] = '\0';
+    return string;
+  }
+
+  SharedString *Acquire()
+  {
+    references.fetch_add(1, std::memory_order_relaxed);
+    return this;
+  }
+
+  void Release()
+  {
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      this->~SharedString();
+      free(this);
+    }
+  }
+};
+
 CVariant::CVariant()
   : CVariant(VariantTypeNull)
 {
@@ -155,7 +197,7 @@ CVariant::CVariant(VariantType type)
       m_data.dvalue = 0.0;
       break;
     case VariantTypeString:
-      m_data.string = new std::string();
+      assignString("", 0);
       break;
     case VariantTypeWideString:
       m_data.wstring = new std::wstring();
@@ -216,26 +258,22 @@ CVariant::CVariant(bool boolean)
 
 CVariant::CVariant(const char *str)
 {
-  m_type = VariantTypeString;
-  m_data.string = new std::string(str);
+  assignString(str, strlen(str));
 }
 
 CVariant::CVariant(const char *str, unsigned int length)
 {
-  m_type = VariantTypeString;
-  m_data.string = new std::string(str, length);
+  assignString(str, length);
 }
 
 CVariant::CVariant(const std::string &str)
 {
-  m_type = VariantTypeString;
-  m_data.string = new std::string(str);
+  assignString(str.c_str(), str.size());
 }
 
 CVariant::CVariant(std::string &&str)
 {
-  m_type = VariantTypeString;
-  m_data.string = new std::string(std::move(str));
+  assignString(str.c_str(), str.size());
 }
 
 CVariant::CVariant(const wchar_t *str)
@@ -275,8 +313,10 @@ CVariant::CVariant(const std::map<std::string, std::string> &strMap)
 {
   m_type = VariantTypeObject;
   m_data.map = new VariantMap;
+  m_data.map->reserve(strMap.size());
+  // std::map is sorted by key just like VariantMap
   for (std::map<std::string, std::string>::const_iterator it = strMap.begin(); it != strMap.end(); ++it)
-    m_data.map->insert(make_pair(it->first, CVariant(it->second)));
+    m_data.map->push_back(std::make_pair(it->first, CVariant(it->second)));
 }
 
 CVariant::CVariant(const std::map<std::string, CVariant> &variantMap)
@@ -291,7 +331,7 @@ CVariant::CVariant(const CVariant &variant)
   *this = variant;
 }
 
-CVariant::CVariant(CVariant&& rhs)
+CVariant::CVariant(CVariant&& rhs) noexcept
 {
   //Set this so that operator= don't try and run cleanup
   //when we're not initialized.
@@ -310,8 +350,10 @@ void CVariant::cleanup()
   switch (m_type)
   {
   case VariantTypeString:
-    delete m_data.string;
+    if (!m_smallString)
+      m_data.string->Release();
     m_data.string = nullptr;
+    m_smallString = false;
     break;
 
   case VariantTypeWideString:
@@ -384,6 +426,52 @@ CVariant::VariantType CVariant::type() const
   return m_type;
 }
 
+void CVariant::assignString(const char *str, size_t length)
+{
+  m_type = VariantTypeString;
+  m_smallString = length <= SmallStringLength;
+  if (m_smallString)
+  {
+    memcpy(m_data.smallstring, str, length);
+    m_data.smallstring[length] = '\0';
+    m_data.smallstring[SmallStringLength] = static_cast<char>(SmallStringLength - length);
+  }
+  else
+    m_data.string = SharedString::Create(str, length);
+}
+
+const char *CVariant::stringData() const
+{
+  return m_smallString ? m_data.smallstring : m_data.string->Data();
+}
+
+size_t CVariant::stringLength() const
+{
+  if (m_smallString)
+    return SmallStringLength - static_cast<unsigned char>(m_data.smallstring[SmallStringLength]);
+  return m_data.string->length;
+}
+
+CVariant::VariantMap::iterator CVariant::findMember(const std::string &key)
+{
+  VariantMap::iterator it = std::lower_bound(m_data.map->begin(), m_data.map->end(), key,
+    [](const VariantMap::value_type &member, const std::string &name) { return member.first < name; });
+  if (it != m_data.map->end() && it->first == key)
+    return it;
+
+  return m_data.map->end();
+}
+
+CVariant::VariantMap::const_iterator CVariant::findMember(const std::string &key) const
+{
+  VariantMap::const_iterator it = std::lower_bound(m_data.map->cbegin(), m_data.map->cend(), key,
+    [](const VariantMap::value_type &member, const std::string &name) { return member.first < name; });
+  if (it != m_data.map->cend() && it->first == key)
+    return it;
+
+  return m_data.map->cend();
+}
+
 int64_t CVariant::asInteger(int64_t fallback) const
 {
   switch (m_type)
@@ -395,7 +483,7 @@ int64_t CVariant::asInteger(int64_t fallback) const
     case VariantTypeDouble:
       return (int64_t)m_data.dvalue;
     case VariantTypeString:
-      return str2int64(*m_data.string, fallback);
+      return str2int64(std::string(stringData(), stringLength()), fallback);
     case VariantTypeWideString:
       return str2int64(*m_data.wstring, fallback);
     default:
@@ -416,7 +504,7 @@ uint64_t CVariant::asUnsignedInteger(uint64_t fallback) const
     case VariantTypeDouble:
       return (uint64_t)m_data.dvalue;
     case VariantTypeString:
-      return str2uint64(*m_data.string, fallback);
+      return str2uint64(std::string(stringData(), stringLength()), fallback);
     case VariantTypeWideString:
       return str2uint64(*m_data.wstring, fallback);
     default:
@@ -437,7 +525,7 @@ double CVariant::asDouble(double fallback) const
     case VariantTypeUnsignedInteger:
       return (double)m_data.unsignedinteger;
     case VariantTypeString:
-      return str2double(*m_data.string, fallback);
+      return str2double(std::string(stringData(), stringLength()), fallback);
     case VariantTypeWideString:
       return str2double(*m_data.wstring, fallback);
     default:
@@ -458,7 +546,7 @@ float CVariant::asFloat(float fallback) const
     case VariantTypeUnsignedInteger:
       return (float)m_data.unsignedinteger;
     case VariantTypeString:
-      return (float)str2double(*m_data.string, fallback);
+      return (float)str2double(std::string(stringData(), stringLength()), fallback);
     case VariantTypeWideString:
       return (float)str2double(*m_data.wstring, fallback);
     default:
@@ -481,9 +569,13 @@ bool CVariant::asBoolean(bool fallback) const
     case VariantTypeDouble:
       return (m_data.dvalue != 0);
     case VariantTypeString:
-      if (m_data.string->empty() || m_data.string->compare("0") == 0 || m_data.string->compare("false") == 0)
+    {
+      const char *str = stringData();
+      size_t length = stringLength();
+      if (length == 0 || (length == 1 && str[0] == '0') || (length == 5 && memcmp(str, "false", 5) == 0))
         return false;
       return true;
+    }
     case VariantTypeWideString:
       if (m_data.wstring->empty() || m_data.wstring->compare(L"0") == 0 || m_data.wstring->compare(L"false") == 0)
         return false;
@@ -500,7 +592,7 @@ std::string CVariant::asString(const std::string &fallback /* = "" */) const
   switch (m_type)
   {
     case VariantTypeString:
-      return *m_data.string;
+      return std::string(stringData(), stringLength());
     case VariantTypeBoolean:
       return m_data.boolean ? "true" : "false";
     case VariantTypeInteger:
@@ -560,7 +652,14 @@ CVariant &CVariant::operator[](const std::string &key)
   }
 
   if (m_type == VariantTypeObject)
-    return (*m_data.map)[key];
+  {
+    VariantMap::iterator it = std::lower_bound(m_data.map->begin(), m_data.map->end(), key,
+      [](const VariantMap::value_type &member, const std::string &name) { return member.first < name; });
+    if (it == m_data.map->end() || it->first != key)
+      it = m_data.map->insert(it, VariantMap::value_type(key, CVariant()));
+
+    return it->second;
+  }
   else
     return ConstNullVariant;
 }
@@ -568,7 +667,7 @@ CVariant &CVariant::operator[](const std::string &key)
 const CVariant &CVariant::operator[](const std::string &key) const
 {
   VariantMap::const_iterator it;
-  if (m_type == VariantTypeObject && (it = m_data.map->find(key)) != m_data.map->end())
+  if (m_type == VariantTypeObject && (it = findMember(key)) != m_data.map->end())
     return it->second;
   else
     return ConstNullVariant;
@@ -614,7 +713,11 @@ CVariant &CVariant::operator=(const CVariant &rhs)
     m_data.dvalue = rhs.m_data.dvalue;
     break;
   case VariantTypeString:
-    m_data.string = new std::string(*rhs.m_data.string);
+    m_smallString = rhs.m_smallString;
+    if (m_smallString)
+      m_data = rhs.m_data;
+    else
+      m_data.string = rhs.m_data.string->Acquire();
     break;
   case VariantTypeWideString:
     m_data.wstring = new std::wstring(*rhs.m_data.wstring);
@@ -623,7 +726,7 @@ CVariant &CVariant::operator=(const CVariant &rhs)
     m_data.array = new VariantArray(rhs.m_data.array->begin(), rhs.m_data.array->end());
     break;
   case VariantTypeObject:
-    m_data.map = new VariantMap(rhs.m_data.map->begin(), rhs.m_data.map->end());
+    m_data.map = new VariantMap(*rhs.m_data.map);
     break;
   default:
     break;
@@ -632,7 +735,7 @@ CVariant &CVariant::operator=(const CVariant &rhs)
   return *this;
 }
 
-CVariant& CVariant::operator=(CVariant&& rhs)
+CVariant& CVariant::operator=(CVariant&& rhs) noexcept
 {
   if (m_type == VariantTypeConstNull || this == &rhs)
     return *this;
@@ -642,6 +745,7 @@ CVariant& CVariant::operator=(CVariant&& rhs)
     cleanup();
 
   m_type = rhs.m_type;
+  m_smallString = rhs.m_smallString;
   m_data = std::move(rhs.m_data);
 
   //Should be enough to just set m_type here
@@ -656,6 +760,7 @@ CVariant& CVariant::operator=(CVariant&& rhs)
     rhs.m_data.map = nullptr;
 
   rhs.m_type = VariantTypeNull;
+  rhs.m_smallString = false;
 
   return *this;
 }
@@ -675,7 +780,7 @@ bool CVariant::operator==(const CVariant &rhs) const
     case VariantTypeDouble:
       return m_data.dvalue == rhs.m_data.dvalue;
     case VariantTypeString:
-      return *m_data.string == *rhs.m_data.string;
+      return stringLength() == rhs.stringLength() && memcmp(stringData(), rhs.stringData(), stringLength()) == 0;
     case VariantTypeWideString:
       return *m_data.wstring == *rhs.m_data.wstring;
     case VariantTypeArray:
@@ -727,21 +832,16 @@ void CVariant::append(CVariant&& variant)
 const char *CVariant::c_str() const
 {
   if (m_type == VariantTypeString)
-    return m_data.string->c_str();
+    return stringData();
   else
     return NULL;
 }
 
 void CVariant::swap(CVariant &rhs)
 {
-  VariantType  temp_type = m_type;
-  VariantUnion temp_data = m_data;
-
-  m_type = rhs.m_type;
-  m_data = rhs.m_data;
-
-  rhs.m_type = temp_type;
-  rhs.m_data = temp_data;
+  std::swap(m_type, rhs.m_type);
+  std::swap(m_smallString, rhs.m_smallString);
+  std::swap(m_data, rhs.m_data);
 }
 
 CVariant::iterator_array CVariant::begin_array()
@@ -815,7 +915,7 @@ unsigned int CVariant::size() const
   else if (m_type == VariantTypeArray)
     return m_data.array->size();
   else if (m_type == VariantTypeString)
-    return m_data.string->size();
+    return stringLength();
   else if (m_type == VariantTypeWideString)
     return m_data.wstring->size();
   else
@@ -829,7 +929,7 @@ bool CVariant::empty() const
   else if (m_type == VariantTypeArray)
     return m_data.array->empty();
   else if (m_type == VariantTypeString)
-    return m_data.string->empty();
+    return stringLength() == 0;
   else if (m_type == VariantTypeWideString)
     return m_data.wstring->empty();
   else if (m_type == VariantTypeNull)
@@ -845,7 +945,10 @@ void CVariant::clear()
   else if (m_type == VariantTypeArray)
     m_data.array->clear();
   else if (m_type == VariantTypeString)
-    m_data.string->clear();
+  {
+    cleanup();
+    assignString("", 0);
+  }
   else if (m_type == VariantTypeWideString)
     m_data.wstring->clear();
 }
@@ -858,7 +961,15 @@ void CVariant::erase(const std::string &key)
     m_data.map = new VariantMap;
   }
   else if (m_type == VariantTypeObject)
-    m_data.map->erase(key);
+  {
+    VariantMap::iterator it = findMember(key);
+    if (it != m_data.map->end())
+    {
+      // a ConstNull member would ignore the members moved onto it
+      it->second.cleanup();
+      m_data.map->erase(it);
+    }
+  }
 }
 
 void CVariant::erase(unsigned int position)
@@ -870,13 +981,17 @@ void CVariant::erase(unsigned int position)
   }
 
   if (m_type == VariantTypeArray && position < size())
+  {
+    // a ConstNull item would ignore the items moved onto it
+    m_data.array->at(position).cleanup();
     m_data.array->erase(m_data.array->begin() + position);
+  }
 }
 
 bool CVariant::isMember(const std::string &key) const
 {
   if (m_type == VariantTypeObject)
-    return m_data.map->find(key) != m_data.map->end();
+    return findMember(key) != m_data.map->end();
 
   return false;
 }
@@ -69,7 +69,7 @@ public:
   CVariant(const std::map<std::string, std::string> &strMap);
   CVariant(const std::map<std::string, CVariant> &variantMap);
   CVariant(const CVariant &variant);
-  CVariant(CVariant &&rhs);
+  CVariant(CVariant &&rhs) noexcept;
   ~CVariant();
 
 
@@ -100,7 +100,7 @@ public:
   const CVariant &operator[](unsigned int position) const;
 
   CVariant &operator=(const CVariant &rhs);
-  CVariant &operator=(CVariant &&rhs);
+  CVariant &operator=(CVariant &&rhs) noexcept;
   bool operator==(const CVariant &rhs) const;
   bool operator!=(const CVariant &rhs) const { return !(*this == rhs); }
 
@@ -115,7 +115,12 @@ public:
 
 private:
   typedef std::vector<CVariant> VariantArray;
-  typedef std::map<std::string, CVariant> VariantMap;
+  /*
+   Objects are stored as a vector of members sorted by their key. Like with
+   arrays, adding or removing members invalidates references and iterators
+   to the other members of the same object.
+   */
+  typedef std::vector<std::pair<std::string, CVariant> > VariantMap;
 
 public:
   typedef VariantArray::iterator        iterator_array;
@@ -145,19 +150,36 @@ public:
   static CVariant ConstNullVariant;
 
 private:
+  /*
+   Strings of up to SmallStringLength characters are stored inline. Longer
+   ones are immutable and shared between copies by reference counting.
+   */
+  struct SharedString;
+  static const size_t SmallStringLength = 15;
+
   void cleanup();
+  void assignString(const char *str, size_t length);
+  const char *stringData() const;
+  size_t stringLength() const;
+  VariantMap::iterator findMember(const std::string &key);
+  VariantMap::const_iterator findMember(const std::string &key) const;
+
   union VariantUnion
   {
     int64_t integer;
     uint64_t unsignedinteger;
     bool boolean;
     double dvalue;
-    std::string *string;
+    // the last byte holds the number of unused characters so that it is
+    // also the terminating null character of a string of maximum length
+    char smallstring[SmallStringLength + 1];
+    SharedString *string;
     std::wstring *wstring;
     VariantArray *array;
     VariantMap *map;
   };
 
   VariantType m_type;
+  bool m_smallString = false;
   VariantUnion m_data;
 };
@@ -0,0 +1,215 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/ActorProtocol.h"
+#include "threads/test/TestHelpers.h"
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+#include <vector>
+
+using namespace Actor;
+
+namespace
+{
+enum Signals
+{
+  PING,
+  PONG,
+  DATA,
+};
+
+// answers every message on the out side of the port after a delay
+class Responder : public IRunnable
+{
+  Protocol &m_port;
+  CEvent &m_event;
+  unsigned int m_messages;
+  unsigned int m_delay;
+public:
+  Responder(Protocol &port, CEvent &event, unsigned int messages, unsigned int delay) :
+    m_port(port), m_event(event), m_messages(messages), m_delay(delay) {}
+
+  virtual void Run()
+  {
+    unsigned int answered = 0;
+    while (answered < m_messages)
+    {
+      Message *msg;
+      if (!m_port.ReceiveOutMessage(&msg))
+      {
+        m_event.WaitMSec(1000);
+        continue;
+      }
+      if (m_delay)
+        XbmcThreads::ThreadSleep(m_delay);
+      int value = *(int*)msg->data + 1;
+      msg->Reply(PONG, &value, sizeof(value));
+      msg->Release();
+      answered++;
+    }
+  }
+};
+}
+
+TEST(TestActorProtocol, SendReceive)
+{
+  CEvent inEvent, outEvent;
+  Protocol port("TestPort", &inEvent, &outEvent);
+
+  // one payload in the message, one from a pool and one too large for any
+  int small = 42;
+  uint8_t medium[300];
+  std::vector<uint8_t> large(10000);
+  memset(medium, 1, sizeof(medium));
+  memset(large.data(), 2, large.size());
+  port.SendOutMessage(PING, &small, sizeof(small));
+  port.SendOutMessage(DATA, medium, sizeof(medium));
+  port.SendOutMessage(DATA, large.data(), large.size());
+  port.SendInMessage(PONG);
+  EXPECT_TRUE(outEvent.WaitMSec(0));
+  EXPECT_TRUE(inEvent.WaitMSec(0));
+
+  Message *msg;
+  ASSERT_TRUE(port.ReceiveOutMessage(&msg));
+  EXPECT_EQ(PING, msg->signal);
+  EXPECT_EQ(42, *(int*)msg->data);
+  msg->Release();
+  ASSERT_TRUE(port.ReceiveOutMessage(&msg));
+  EXPECT_EQ(300, msg->payloadSize);
+  EXPECT_EQ(0, memcmp(medium, msg->data, sizeof(medium)));
+  msg->Release();
+  ASSERT_TRUE(port.ReceiveOutMessage(&msg));
+  EXPECT_EQ(0, memcmp(large.data(), msg->data, large.size()));
+  msg->Release();
+  EXPECT_FALSE(port.ReceiveOutMessage(&msg));
+
+  ASSERT_TRUE(port.ReceiveInMessage(&msg));
+  EXPECT_EQ(PONG, msg->signal);
+  EXPECT_EQ(NULL, msg->data);
+  msg->Release();
+  EXPECT_FALSE(port.ReceiveInMessage(&msg));
+
+  ProtocolStats stats;
+  port.GetStats(stats);
+  EXPECT_EQ(3U, stats.outMessages);
+  EXPECT_EQ(1U, stats.inMessages);
+}
+
+TEST(TestActorProtocol, Recycle)
+{
+  CEvent inEvent, outEvent;
+  Protocol port("TestPort", &inEvent, &outEvent);
+  uint8_t payload[1000] = {};
+
+  Message *msg;
+  for (int i = 0; i < 4; i++)
+    port.SendOutMessage(DATA, payload, sizeof(payload));
+  while (port.ReceiveOutMessage(&msg))
+    msg->Release();
+
+  // messages and payloads are reused once the pools are warm
+  port.ResetStats();
+  for (int i = 0; i < 100; i++)
+  {
+    port.SendOutMessage(DATA, payload, sizeof(payload));
+    port.SendOutMessage(DATA, payload, sizeof(payload));
+    while (port.ReceiveOutMessage(&msg))
+      msg->Release();
+  }
+
+  ProtocolStats stats;
+  port.GetStats(stats);
+  EXPECT_EQ(200U, stats.outMessages);
+  EXPECT_EQ(0U, stats.allocations);
+}
+
+TEST(TestActorProtocol, Purge)
+{
+  CEvent inEvent, outEvent;
+  Protocol port("TestPort", &inEvent, &outEvent);
+  for (int i = 0; i < 6; i++)
+    port.SendOutMessage(i % 2 ? PING : DATA, &i, sizeof(i));
+
+  port.PurgeOut(DATA);
+  Message *msg;
+  for (int i = 1; i < 6; i += 2)
+  {
+    ASSERT_TRUE(port.ReceiveOutMessage(&msg));
+    EXPECT_EQ(i, *(int*)msg->data);
+    msg->Release();
+  }
+  EXPECT_FALSE(port.ReceiveOutMessage(&msg));
+
+  port.SendOutMessage(PING);
+  port.DeferOut(true);
+  EXPECT_FALSE(port.ReceiveOutMessage(&msg));
+  port.DeferOut(false);
+  port.Purge();
+  EXPECT_FALSE(port.ReceiveOutMessage(&msg));
+}
+
+TEST(TestActorProtocol, Sync)
+{
+  CEvent inEvent, outEvent;
+  Protocol port("TestPort", &inEvent, &outEvent);
+  Responder responder(port, outEvent, 20, 0);
+  thread responderThread(responder);
+
+  for (int i = 0; i < 20; i++)
+  {
+    Message *reply;
+    ASSERT_TRUE(port.SendOutMessageSync(PING, &reply, 5000, &i, sizeof(i)));
+    EXPECT_EQ(PONG, reply->signal);
+    EXPECT_EQ(i + 1, *(int*)reply->data);
+    reply->Release();
+  }
+  EXPECT_TRUE(responderThread.timed_join(MILLIS(10000)));
+
+  ProtocolStats stats;
+  port.GetStats(stats);
+  EXPECT_EQ(20U, stats.syncMessages);
+  EXPECT_EQ(0U, stats.syncTimeouts);
+}
+
+TEST(TestActorProtocol, SyncTimeout)
+{
+  CEvent inEvent, outEvent;
+  Protocol port("TestPort", &inEvent, &outEvent);
+  Responder responder(port, outEvent, 2, 200);
+  thread responderThread(responder);
+
+  // the late reply to the first request must not complete the second one
+  Message *reply;
+  int value = 1;
+  EXPECT_FALSE(port.SendOutMessageSync(PING, &reply, 50, &value, sizeof(value)));
+  value = 10;
+  ASSERT_TRUE(port.SendOutMessageSync(PING, &reply, 5000, &value, sizeof(value)));
+  EXPECT_EQ(11, *(int*)reply->data);
+  reply->Release();
+  EXPECT_TRUE(responderThread.timed_join(MILLIS(10000)));
+
+  ProtocolStats stats;
+  port.GetStats(stats);
+  EXPECT_EQ(2U, stats.syncMessages);
+  EXPECT_EQ(1U, stats.syncTimeouts);
+  EXPECT_LE(stats.syncWaitMax, stats.syncWaitTotal);
+}
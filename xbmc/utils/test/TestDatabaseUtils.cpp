@@ -1347,6 +1347,43 @@ TEST(TestDatabaseUtils, GetFieldValue)
   EXPECT_TRUE(v_string.isString());
 }
 
+TEST(TestDatabaseUtils, GetFieldValueFromResultSet)
+{
+  dbiplus::result_set rs;
+  rs.record_header.resize(4);
+  rs.add_row();
+  rs.set_int64(0, 42);
+  rs.set_string(1, "test");
+  rs.set_double(2, 2.5);
+  rs.set_null(3);
+  rs.add_row();
+  rs.set_string(1, "17");
+
+  ASSERT_EQ(2u, rs.records.size());
+  const dbiplus::sql_record *row = rs.records.at(0);
+  EXPECT_EQ(4u, row->size());
+  EXPECT_EQ(42, row->at(0).get_asInt());
+  EXPECT_STREQ("42", row->at(0).get_asString().c_str());
+  EXPECT_STREQ("test", row->at(1).get_asString().c_str());
+  EXPECT_EQ(2.5, row->at(2).get_asDouble());
+  EXPECT_TRUE(row->at(3).get_isNull());
+  EXPECT_THROW(row->at(4), std::out_of_range);
+
+  // unset fields of a row are empty strings, numbers convert in place
+  row = rs.records.at(1);
+  EXPECT_FALSE(row->at(0).get_isNull());
+  EXPECT_STREQ("", row->at(0).get_asString().c_str());
+  EXPECT_EQ(17, row->at(1).get_asInt());
+  EXPECT_EQ(0, row->at(3).get_asInt());
+
+  CVariant v_int, v_null;
+  EXPECT_TRUE(DatabaseUtils::GetFieldValue(rs.records.at(0)->at(0), v_int));
+  EXPECT_TRUE(v_int.isInteger());
+  EXPECT_EQ(42, v_int.asInteger());
+  EXPECT_TRUE(DatabaseUtils::GetFieldValue(rs.records.at(0)->at(3), v_null));
+  EXPECT_TRUE(v_null.isNull());
+}
+
 //! @todo Need some way to test this function
 // TEST(TestDatabaseUtils, GetDatabaseResults)
 // {
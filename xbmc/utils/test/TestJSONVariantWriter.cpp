@@ -31,3 +31,57 @@ TEST(TestJSONVariantWriter, Write)
   str = CJSONVariantWriter::Write(variant, false);
   EXPECT_STREQ("null\n", str.c_str());
 }
+
+TEST(TestJSONVariantWriter, StreamWrite)
+{
+  CVariant variant(CVariant::VariantTypeObject);
+  variant["string"] = "text";
+  variant["double"] = 1.5;
+  variant["empty"] = CVariant(CVariant::VariantTypeArray);
+  for (int i = 0; i < 2; i++)
+  {
+    CVariant item;
+    item["id"] = i;
+    item["label"] = "item";
+    item["flag"] = i % 2 == 0;
+    variant["items"].push_back(item);
+  }
+
+  const char *expected[] = {
+    "{\n"
+    "\t\"double\": 1.5,\n"
+    "\t\"empty\": [\n"
+    "\n"
+    "\t],\n"
+    "\t\"items\": [\n"
+    "\t\t{\n"
+    "\t\t\t\"flag\": true,\n"
+    "\t\t\t\"id\": 0,\n"
+    "\t\t\t\"label\": \"item\"\n"
+    "\t\t},\n"
+    "\t\t{\n"
+    "\t\t\t\"flag\": false,\n"
+    "\t\t\t\"id\": 1,\n"
+    "\t\t\t\"label\": \"item\"\n"
+    "\t\t}\n"
+    "\t],\n"
+    "\t\"string\": \"text\"\n"
+    "}\n",
+    "{\"double\":1.5,\"empty\":[],\"items\":[{\"flag\":true,\"id\":0,\"label\":\"item\"},"
+    "{\"flag\":false,\"id\":1,\"label\":\"item\"}],\"string\":\"text\"}"
+  };
+
+  for (int compact = 0; compact <= 1; compact++)
+  {
+    std::string str;
+    CJSONVariantStreamWriter writer(variant, compact != 0);
+    while (!writer.IsDone())
+    {
+      size_t length = str.size();
+      EXPECT_TRUE(writer.Write(str, 16));
+      EXPECT_LT(length, str.size());
+    }
+    EXPECT_EQ(expected[compact], str);
+    EXPECT_EQ(expected[compact], CJSONVariantWriter::Write(variant, compact != 0));
+  }
+}
@@ -179,3 +179,51 @@ TEST_F(TestJobManager, IsProcessing)
 
   job->FinishAndStopBlocking();
 }
+
+namespace
+{
+class CountingJob : public CJob
+{
+public:
+  CountingJob(std::atomic<int> &count, CEvent &done, int total) :
+    m_count(count),
+    m_done(done),
+    m_total(total)
+  {
+  }
+
+  bool DoWork()
+  {
+    if (++m_count == m_total)
+      m_done.Set();
+    return true;
+  }
+
+private:
+  std::atomic<int> &m_count;
+  CEvent &m_done;
+  int m_total;
+};
+}
+
+TEST_F(TestJobManager, WorkStealing)
+{
+  const int total = 100;
+  std::atomic<int> count(0);
+  CEvent done;
+
+  CJobManager::GetInstance().SetWorkStealing(true, 4);
+  EXPECT_TRUE(CJobManager::GetInstance().IsWorkStealing());
+  CJobManager::GetInstance().ResetStatistics();
+
+  for (int i = 0; i < total; i++)
+    CJobManager::GetInstance().AddJob(new CountingJob(count, done, total), NULL,
+                                      i % 2 ? CJob::PRIORITY_NORMAL : CJob::PRIORITY_HIGH);
+
+  EXPECT_TRUE(done.WaitMSec(10000));
+  EXPECT_EQ(total, count);
+  EXPECT_EQ(static_cast<uint64_t>(total), CJobManager::GetInstance().GetStatistics().jobs);
+
+  CJobManager::GetInstance().SetWorkStealing(false);
+  EXPECT_FALSE(CJobManager::GetInstance().IsWorkStealing());
+}
@@ -0,0 +1,105 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/ParallelJobs.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// many duplicate keys so that stability matters
+std::vector<std::pair<int, int> > GetItems(int count)
+{
+  std::vector<std::pair<int, int> > items;
+  unsigned int state = 1;
+  for (int i = 0; i < count; i++)
+  {
+    state = state * 1664525 + 1013904223;
+    items.push_back(std::make_pair((int)((state >> 8) % 97), i));
+  }
+  return items;
+}
+
+bool CompareFirst(const std::pair<int, int> &left, const std::pair<int, int> &right)
+{
+  return left.first < right.first;
+}
+}
+
+TEST(TestParallelJobs, StableSort)
+{
+  const std::vector<std::pair<int, int> > items = GetItems(10000);
+  std::vector<std::pair<int, int> > expected = items;
+  std::stable_sort(expected.begin(), expected.end(), CompareFirst);
+
+  for (unsigned int threads = 1; threads <= 7; threads++)
+  {
+    std::vector<std::pair<int, int> > sorted = items;
+    CParallelJobs::StableSort(sorted, CompareFirst, threads);
+    EXPECT_EQ(expected, sorted) << "threads: " << threads;
+  }
+}
+
+TEST(TestParallelJobs, ForEach)
+{
+  const size_t counts[] = { 0, 1, 3, 1000 };
+  for (const auto count : counts)
+  {
+    std::vector<std::atomic<int> > calls(count);
+    for (auto &call : calls)
+      call = 0;
+
+    std::vector<size_t> begins(CParallelJobs::GetRanges(count, 4), count);
+    CParallelJobs::ForEach(count, 4, [&](size_t range, size_t begin, size_t end)
+    {
+      begins[range] = begin;
+      for (size_t i = begin; i < end; i++)
+        calls[i]++;
+    });
+
+    for (size_t i = 0; i < count; i++)
+      EXPECT_EQ(1, calls[i]) << "count: " << count << " index: " << i;
+    for (size_t range = 1; range < begins.size(); range++)
+      EXPECT_LE(begins[range - 1], begins[range]);
+  }
+}
+
+TEST(TestParallelJobs, Run)
+{
+  const size_t counts[] = { 0, 1, 3, 30 };
+  for (const auto count : counts)
+  {
+    std::vector<std::atomic<int> > calls(count);
+    for (auto &call : calls)
+      call = 0;
+
+    CParallelJobs::Run(count, 4, [&](size_t index)
+    {
+      calls[index]++;
+    });
+
+    for (size_t i = 0; i < count; i++)
+      EXPECT_EQ(1, calls[i]) << "count: " << count << " index: " << i;
+  }
+}
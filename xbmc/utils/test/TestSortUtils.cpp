@@ -18,7 +18,9 @@
  *
  */
 
+#include "utils/SortKeys.h"
 #include "utils/SortUtils.h"
+#include "utils/StringUtils.h"
 #include "utils/Variant.h"
 
 #include "gtest/gtest.h"
@@ -131,3 +133,83 @@ TEST(TestSortUtils, GetFieldsForSorting)
   EXPECT_EQ(FieldTrackNumber, *it);
   EXPECT_EQ((unsigned int)4, fields.size());
 }
+
+static DatabaseResults GetSortKeyItems()
+{
+  static const char *labels[] = { "The Matrix", "Alien", "the Thing", "A Beautiful Mind", "alpha 10",
+                                  "alpha 2", "Up", "10 Things", "2012", "Babel" };
+  DatabaseResults items;
+  for (int i = 0; i < 40; i++)
+  {
+    SortItem item;
+    item[FieldRow] = i;
+    item[FieldId] = 40 - i;
+    item[FieldLabel] = labels[(i * 7) % 10];
+    item[FieldTitle] = labels[(i * 3) % 10];
+    item[FieldYear] = i % 8 == 0 ? 0 : 1990 + (i * 13) % 5;
+    if (item[FieldYear].asInteger() > 0)
+      item[FieldAirDate] = StringUtils::Format("%d-0%d-01", (int)item[FieldYear].asInteger(), 1 + i % 4);
+    item[FieldAlbum] = "";
+    item[FieldTrackNumber] = i % 6;
+    item[FieldRating] = (float)((i * 17) % 100) / 10.0f;
+    item[FieldPlaycount] = i % 3;
+    item[FieldSeason] = (i * 11) % 4;
+    item[FieldEpisodeNumber] = (i * 5) % 12;
+    item[FieldDateAdded] = StringUtils::Format("2017-0%d-1%d 10:0%d:00", 1 + i % 3, (i * 7) % 10, i % 10);
+    item[FieldFolder] = i % 9 == 0;
+    item[FieldSortSpecial] = i == 5 ? SortSpecialOnTop : (i == 6 ? SortSpecialOnBottom : SortSpecialNone);
+    items.push_back(item);
+  }
+  return items;
+}
+
+TEST(TestSortUtils, Sort_TypedKeysMatchPreparators)
+{
+  const SortBy sortMethods[] = { SortByLabel, SortByTitle, SortByYear, SortByRating, SortByPlaycount,
+                                 SortByEpisodeNumber, SortBySeason, SortByDateAdded };
+  const SortAttribute attributes[] = { SortAttributeNone, SortAttributeIgnoreArticle, SortAttributeIgnoreFolders };
+
+  for (const auto sortBy : sortMethods)
+  {
+    EXPECT_TRUE(CSortKeys::IsSupported(sortBy));
+    for (const auto attribute : attributes)
+    {
+      for (const auto sortOrder : { SortOrderAscending, SortOrderDescending })
+      {
+        // make sure the typed keys are used and not the preparator fallback
+        CSortKeys keys(sortBy, attribute);
+        for (const auto &item : GetSortKeyItems())
+          EXPECT_TRUE(keys.Add(item)) << "sort method " << sortBy;
+
+        DatabaseResults expected = GetSortKeyItems();
+        SortUtils::SortByPreparator(sortBy, sortOrder, attribute, expected, 30, 5);
+        DatabaseResults items = GetSortKeyItems();
+        SortUtils::Sort(sortBy, sortOrder, attribute, items, 30, 5);
+
+        ASSERT_EQ(expected.size(), items.size());
+        for (size_t i = 0; i < items.size(); i++)
+          EXPECT_EQ(expected[i][FieldRow].asInteger(), items[i][FieldRow].asInteger()) << "sort method " << sortBy << " at " << i;
+      }
+    }
+  }
+}
+
+TEST(TestSortUtils, SortKeys_Fallback)
+{
+  SortItem item;
+  item[FieldLabel] = "Label";
+  item[FieldYear] = 2000;
+  item[FieldTrackNumber] = 3;
+  item[FieldAlbum] = "Album";
+
+  // the album is part of the year's sort string
+  CSortKeys keys(SortByYear, SortAttributeNone);
+  EXPECT_FALSE(keys.Add(item));
+
+  item.erase(FieldAlbum);
+  EXPECT_TRUE(keys.Add(item));
+  EXPECT_EQ(L"2000 3 Label", keys.GetSortLabel(0));
+
+  EXPECT_FALSE(CSortKeys::IsSupported(SortByRandom));
+  EXPECT_FALSE(CSortKeys::IsSupported(SortByArtist));
+}
@@ -348,3 +348,59 @@ TEST(TestVariant, isMember)
   EXPECT_TRUE(a.isMember("key1"));
   EXPECT_FALSE(a.isMember("key2"));
 }
+
+TEST(TestVariant, strings)
+{
+  const std::string shortString("fifteen chars!!");
+  const std::string longString("a string which is too long to be stored inline");
+
+  CVariant a(shortString), b(longString), c(std::string("embedded\0null", 13));
+  EXPECT_EQ(shortString, a.asString());
+  EXPECT_EQ(15u, a.size());
+  EXPECT_EQ(longString, b.asString());
+  EXPECT_EQ(longString.size(), b.size());
+  EXPECT_EQ(13u, c.size());
+
+  // copies of long strings share their data but stay independent
+  CVariant d = b;
+  EXPECT_EQ(b.c_str(), d.c_str());
+  d.clear();
+  EXPECT_TRUE(d.empty());
+  EXPECT_EQ(longString, b.asString());
+
+  EXPECT_TRUE(CVariant("").empty());
+  EXPECT_FALSE(CVariant("false").asBoolean());
+  EXPECT_TRUE(CVariant("true").asBoolean());
+  EXPECT_EQ(42, CVariant("42").asInteger());
+  EXPECT_TRUE(CVariant(longString) == b);
+  EXPECT_FALSE(CVariant(shortString) == b);
+}
+
+TEST(TestVariant, objectMembers)
+{
+  CVariant a;
+  a["key3"] = 3;
+  a["key1"] = 1;
+  a["key2"] = CVariant::ConstNullVariant;
+  a["key4"] = 4;
+
+  // members are iterated in the order of their keys
+  int index = 0;
+  const char *keys[] = { "key1", "key2", "key3", "key4" };
+  for (CVariant::const_iterator_map it = a.begin_map(); it != a.end_map(); ++it)
+    EXPECT_EQ(keys[index++], it->first);
+  EXPECT_EQ(4, index);
+
+  a.erase("key2");
+  EXPECT_EQ(3u, a.size());
+  EXPECT_EQ(3, a["key3"].asInteger());
+  EXPECT_EQ(4, a["key4"].asInteger());
+
+  std::map<std::string, CVariant> map;
+  map["b"] = "b";
+  map["a"] = "a";
+  CVariant b(map);
+  EXPECT_STREQ("a", b["a"].c_str());
+  EXPECT_STREQ("b", b["b"].c_str());
+  EXPECT_FALSE(b.isMember("c"));
+}
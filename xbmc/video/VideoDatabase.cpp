@@ -531,8 +531,8 @@ int CVideoDatabase::GetPathId(const std::string& strPath)
 
     URIUtils::AddSlashAtEnd(strPath1);
 
-    strSQL=PrepareSQL("select idPath from path where strPath='%s'",strPath1.c_str());
-    m_pDS->query(strSQL);
+    strSQL = "select idPath from path where strPath=?";
+    m_pDS->query(strSQL, { strPath1 });
     if (!m_pDS->eof())
       idPath = m_pDS->fv("path.idPath").get_asInt();
 
@@ -556,10 +556,10 @@ bool CVideoDatabase::GetPaths(std::set<std::string> &paths)
     paths.clear();
 
     // grab all paths with movie content set
-    if (!m_pDS->query("select strPath,noUpdate from path"
-                      " where (strContent = 'movies' or strContent = 'musicvideos')"
-                      " and strPath NOT like 'multipath://%%'"
-                      " order by strPath"))
+    if (!m_pDS->query_forward("select strPath,noUpdate from path"
+                              " where (strContent = 'movies' or strContent = 'musicvideos')"
+                              " and strPath NOT like 'multipath://%%'"
+                              " order by strPath"))
       return false;
 
     while (!m_pDS->eof())
@@ -571,11 +571,11 @@ bool CVideoDatabase::GetPaths(std::set<std::string> &paths)
     m_pDS->close();
 
     // then grab all tvshow paths
-    if (!m_pDS->query("select strPath,noUpdate from path"
-                      " where ( strContent = 'tvshows'"
-                      "       or idPath in (select idPath from tvshowlinkpath))"
-                      " and strPath NOT like 'multipath://%%'"
-                      " order by strPath"))
+    if (!m_pDS->query_forward("select strPath,noUpdate from path"
+                              " where ( strContent = 'tvshows'"
+                              "       or idPath in (select idPath from tvshowlinkpath))"
+                              " and strPath NOT like 'multipath://%%'"
+                              " order by strPath"))
       return false;
 
     while (!m_pDS->eof())
@@ -590,14 +590,14 @@ bool CVideoDatabase::GetPaths(std::set<std::string> &paths)
     // - this isnt perfect but it should do fine in most situations.
     // reason we need it to hold a movie is stacks from different directories (cdx folders for instance)
     // not making mistakes must take priority
-    if (!m_pDS->query("select strPath,noUpdate from path"
-                       " where idPath in (select idPath from files join movie on movie.idFile=files.idFile)"
-                       " and idPath NOT in (select idPath from tvshowlinkpath)"
-                       " and idPath NOT in (select idPath from files where strFileName like 'video_ts.ifo')" // dvd folders get stacked to a single item in parent folder
-                       " and idPath NOT in (select idPath from files where strFileName like 'index.bdmv')" // bluray folders get stacked to a single item in parent folder
-                       " and strPath NOT like 'multipath://%%'"
-                       " and strContent NOT in ('movies', 'tvshows', 'None')" // these have been added above
-                       " order by strPath"))
+    if (!m_pDS->query_forward("select strPath,noUpdate from path"
+                               " where idPath in (select idPath from files join movie on movie.idFile=files.idFile)"
+                               " and idPath NOT in (select idPath from tvshowlinkpath)"
+                               " and idPath NOT in (select idPath from files where strFileName like 'video_ts.ifo')" // dvd folders get stacked to a single item in parent folder
+                               " and idPath NOT in (select idPath from files where strFileName like 'index.bdmv')" // bluray folders get stacked to a single item in parent folder
+                               " and strPath NOT like 'multipath://%%'"
+                               " and strContent NOT in ('movies', 'tvshows', 'None')" // these have been added above
+                               " order by strPath"))
 
       return false;
     while (!m_pDS->eof())
@@ -880,9 +880,9 @@ int CVideoDatabase::AddFile(const std::string& strFileNameAndPath)
     if (idPath < 0)
       return -1;
 
-    std::string strSQL=PrepareSQL("select idFile from files where strFileName='%s' and idPath=%i", strFileName.c_str(),idPath);
+    std::string strSQL = "select idFile from files where strFileName=? and idPath=?";
 
-    m_pDS->query(strSQL);
+    m_pDS->query(strSQL, { strFileName, idPath });
     if (m_pDS->num_rows() > 0)
     {
       idFile = m_pDS->fv("idFile").get_asInt() ;
@@ -891,8 +891,8 @@ int CVideoDatabase::AddFile(const std::string& strFileNameAndPath)
     }
     m_pDS->close();
 
-    strSQL=PrepareSQL("insert into files (idFile, idPath, strFileName) values(NULL, %i, '%s')", idPath, strFileName.c_str());
-    m_pDS->exec(strSQL);
+    strSQL = "insert into files (idFile, idPath, strFileName) values(NULL, ?, ?)";
+    m_pDS->exec(strSQL, { idPath, strFileName });
     idFile = (int)m_pDS->lastinsertid();
     return idFile;
   }
@@ -1063,9 +1063,7 @@ int CVideoDatabase::GetFileId(const std::string& strFilenameAndPath)
     int idPath = GetPathId(strPath);
     if (idPath >= 0)
     {
-      std::string strSQL;
-      strSQL=PrepareSQL("select idFile from files where strFileName='%s' and idPath=%i", strFileName.c_str(),idPath);
-      m_pDS->query(strSQL);
+      m_pDS->query("select idFile from files where strFileName=? and idPath=?", { strFileName, idPath });
       if (m_pDS->num_rows() > 0)
       {
         int idFile = m_pDS->fv("files.idFile").get_asInt();
@@ -1122,12 +1120,12 @@ int CVideoDatabase::GetMovieId(const std::string& strFilenameAndPath)
 
     std::string strSQL;
     if (idFile == -1)
-      strSQL=PrepareSQL("select idMovie from movie join files on files.idFile=movie.idFile where files.idPath=%i",idPath);
+      strSQL = "select idMovie from movie join files on files.idFile=movie.idFile where files.idPath=?";
     else
-      strSQL=PrepareSQL("select idMovie from movie where idFile=%i", idFile);
+      strSQL = "select idMovie from movie where idFile=?";
 
     CLog::Log(LOGDEBUG, "%s (%s), query = %s", __FUNCTION__, CURL::GetRedacted(strFilenameAndPath).c_str(), strSQL.c_str());
-    m_pDS->query(strSQL);
+    m_pDS->query(strSQL, { idFile == -1 ? idPath : idFile });
     if (m_pDS->num_rows() > 0)
       idMovie = m_pDS->fv("idMovie").get_asInt();
     m_pDS->close();
@@ -1154,20 +1152,17 @@ int CVideoDatabase::GetTvShowId(const std::string& strPath)
     if (idPath < 0)
       return -1;
 
-    std::string strSQL;
     std::string strPath1=strPath;
     std::string strParent;
     int iFound=0;
 
-    strSQL=PrepareSQL("select idShow from tvshowlinkpath where tvshowlinkpath.idPath=%i",idPath);
-    m_pDS->query(strSQL);
+    m_pDS->query("select idShow from tvshowlinkpath where tvshowlinkpath.idPath=?", { idPath });
     if (!m_pDS->eof())
       iFound = 1;
 
     while (iFound == 0 && URIUtils::GetParentPath(strPath1, strParent))
     {
-      strSQL=PrepareSQL("SELECT idShow FROM path INNER JOIN tvshowlinkpath ON tvshowlinkpath.idPath=path.idPath WHERE strPath='%s'",strParent.c_str());
-      m_pDS->query(strSQL);
+      m_pDS->query("SELECT idShow FROM path INNER JOIN tvshowlinkpath ON tvshowlinkpath.idPath=path.idPath WHERE strPath=?", { strParent });
       if (!m_pDS->eof())
       {
         int idShow = m_pDS->fv("idShow").get_asInt();
@@ -1206,10 +1201,10 @@ int CVideoDatabase::GetEpisodeId(const std::string& strFilenameAndPath, int idEp
     if (idFile < 0)
       return -1;
 
-    std::string strSQL=PrepareSQL("select idEpisode from episode where idFile=%i", idFile);
+    std::string strSQL = "select idEpisode from episode where idFile=?";
 
-    CLog::Log(LOGDEBUG, "%s (%s), query = %s", __FUNCTION__, CURL::GetRedacted(strFilenameAndPath).c_str(), strSQL.c_str());
-    pDS->query(strSQL);
+    CLog::Log(LOGDEBUG, "%s (%s), query = %s (%i)", __FUNCTION__, CURL::GetRedacted(strFilenameAndPath).c_str(), strSQL.c_str(), idFile);
+    pDS->query(strSQL, { idFile });
     if (pDS->num_rows() > 0)
     {
       if (idEpisode == -1)
@@ -1257,10 +1252,10 @@ int CVideoDatabase::GetMusicVideoId(const std::string& strFilenameAndPath)
     if (idFile < 0)
       return -1;
 
-    std::string strSQL=PrepareSQL("select idMVideo from musicvideo where idFile=%i", idFile);
+    std::string strSQL = "select idMVideo from musicvideo where idFile=?";
 
-    CLog::Log(LOGDEBUG, "%s (%s), query = %s", __FUNCTION__, CURL::GetRedacted(strFilenameAndPath).c_str(), strSQL.c_str());
-    m_pDS->query(strSQL);
+    CLog::Log(LOGDEBUG, "%s (%s), query = %s (%i)", __FUNCTION__, CURL::GetRedacted(strFilenameAndPath).c_str(), strSQL.c_str(), idFile);
+    m_pDS->query(strSQL, { idFile });
     int idMVideo=-1;
     if (m_pDS->num_rows() > 0)
       idMVideo = m_pDS->fv("idMVideo").get_asInt();
@@ -1410,14 +1405,15 @@ int CVideoDatabase::AddToTable(const std::string& table, const std::string& firs
     if (NULL == m_pDB.get()) return -1;
     if (NULL == m_pDS.get()) return -1;
 
-    std::string strSQL = PrepareSQL("select %s from %s where %s like '%s'", firstField.c_str(), table.c_str(), secondField.c_str(), value.substr(0, 255).c_str());
-    m_pDS->query(strSQL);
+    const std::string strValue = value.substr(0, 255);
+    std::string strSQL = PrepareSQL("select %s from %s where %s like ?", firstField.c_str(), table.c_str(), secondField.c_str());
+    m_pDS->query(strSQL, { strValue });
     if (m_pDS->num_rows() == 0)
     {
       m_pDS->close();
       // doesnt exists, add it
-      strSQL = PrepareSQL("insert into %s (%s, %s) values(NULL, '%s')", table.c_str(), firstField.c_str(), secondField.c_str(), value.substr(0, 255).c_str());
-      m_pDS->exec(strSQL);
+      strSQL = PrepareSQL("insert into %s (%s, %s) values(NULL, ?)", table.c_str(), firstField.c_str(), secondField.c_str());
+      m_pDS->exec(strSQL, { strValue });
       int id = (int)m_pDS->lastinsertid();
       return id;
     }
@@ -39,8 +39,7 @@ class CGUIDialogProgressBarHandle;
 
 namespace dbiplus
 {
-  class field_value;
-  typedef std::vector<field_value> sql_record;
+  class sql_record;
 }
 
 #ifndef my_offsetof
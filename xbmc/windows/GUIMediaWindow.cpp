@@ -64,6 +64,7 @@
 #include "threads/SystemClock.h"
 #include "utils/FileUtils.h"
 #include "utils/LabelFormatter.h"
+#include "utils/ParallelJobs.h"
 #include "utils/log.h"
 #include "utils/SortUtils.h"
 #include "utils/StringUtils.h"
@@ -1860,33 +1861,45 @@ bool CGUIMediaWindow::GetFilteredItems(const std::string &filter, CFileItemList
 
   CFileItemList filteredItems(items.GetPath()); // use the original path - it'll likely be relied on for other things later.
   bool numericMatch = StringUtils::IsNaturalNumber(trimmedFilter);
-  for (int i = 0; i < items.Size(); i++)
+
+  // match large lists in parallel but keep the matching items in their order
+  std::vector<char> matches(items.Size(), 0);
+  CParallelJobs::ForEach(matches.size(), CParallelJobs::GetThreads(matches.size()), [&](size_t range, size_t begin, size_t end)
   {
-    CFileItemPtr item = items.Get(i);
-    if (item->IsParentFolder())
+    for (size_t i = begin; i < end; i++)
     {
-      filteredItems.Add(item);
-      continue;
+      CFileItemPtr item = items.Get(i);
+      if (item->IsParentFolder())
+      {
+        matches[i] = 1;
+        continue;
+      }
+      //! @todo Need to update this to get all labels, ideally out of the displayed info (ie from m_layout and m_focusedLayout)
+      //! though that isn't practical.  Perhaps a better idea would be to just grab the info that we should filter on based on
+      //! where we are in the library tree.
+      //! Another idea is tying the filter string to the current level of the tree, so that going deeper disables the filter,
+      //! but it's re-enabled on the way back out.
+      std::string match;
+      /*    if (item->GetFocusedLayout())
+       match = item->GetFocusedLayout()->GetAllText();
+       else if (item->GetLayout())
+       match = item->GetLayout()->GetAllText();
+       else*/
+      match = item->GetLabel(); // Filter label only for now
+
+      if (numericMatch)
+        StringUtils::WordToDigits(match);
+
+      size_t pos = StringUtils::FindWords(match.c_str(), trimmedFilter.c_str());
+      if (pos != std::string::npos)
+        matches[i] = 1;
     }
-    //! @todo Need to update this to get all labels, ideally out of the displayed info (ie from m_layout and m_focusedLayout)
-    //! though that isn't practical.  Perhaps a better idea would be to just grab the info that we should filter on based on
-    //! where we are in the library tree.
-    //! Another idea is tying the filter string to the current level of the tree, so that going deeper disables the filter,
-    //! but it's re-enabled on the way back out.
-    std::string match;
-    /*    if (item->GetFocusedLayout())
-     match = item->GetFocusedLayout()->GetAllText();
-     else if (item->GetLayout())
-     match = item->GetLayout()->GetAllText();
-     else*/
-    match = item->GetLabel(); // Filter label only for now
-    
-    if (numericMatch)
-      StringUtils::WordToDigits(match);
-    
-    size_t pos = StringUtils::FindWords(match.c_str(), trimmedFilter.c_str());
-    if (pos != std::string::npos)
-      filteredItems.Add(item);
+  });
+
+  for (int i = 0; i < items.Size(); i++)
+  {
+    if (matches[i])
+      filteredItems.Add(items.Get(i));
   }
 
   items.ClearItems();
@@ -1907,15 +1920,28 @@ bool CGUIMediaWindow::GetAdvanceFilteredItems(CFileItemList &items)
   CFileItemList resultItems;
   XFILE::CSmartPlaylistDirectory::GetDirectory(m_filter, resultItems, m_strFilterPath, true);
 
+  // compare the paths ignoring any special options because they differ
+  // from filter to filter. Parsing them is done in parallel for large lists
+  std::vector<std::string> resultPaths(resultItems.Size());
+  std::vector<std::string> paths(items.Size());
+  auto getPaths = [](const CFileItemList &list, std::vector<std::string> &listPaths)
+  {
+    CParallelJobs::ForEach(listPaths.size(), CParallelJobs::GetThreads(listPaths.size()), [&](size_t range, size_t begin, size_t end)
+    {
+      for (size_t i = begin; i < end; i++)
+      {
+        listPaths[i] = CURL(list.Get(i)->GetPath()).GetWithoutOptions();
+        StringUtils::ToLower(listPaths[i]);
+      }
+    });
+  };
+  getPaths(resultItems, resultPaths);
+  getPaths(items, paths);
+
   // put together a lookup map for faster path comparison
   std::map<std::string, CFileItemPtr> lookup;
   for (int j = 0; j < resultItems.Size(); j++)
-  {
-    std::string itemPath = CURL(resultItems[j]->GetPath()).GetWithoutOptions();
-    StringUtils::ToLower(itemPath);
-
-    lookup[itemPath] = resultItems[j];
-  }
+    lookup[resultPaths[j]] = resultItems[j];
 
   // loop through all the original items and find
   // those which are still part of the filter
@@ -1930,25 +1956,27 @@ bool CGUIMediaWindow::GetAdvanceFilteredItems(CFileItemList &items)
     }
 
     // check if the item is part of the resultItems list
-    // by comparing their paths (but ignoring any special
-    // options because they differ from filter to filter)
-    std::string path = CURL(item->GetPath()).GetWithoutOptions();
-    StringUtils::ToLower(path);
-
-    std::map<std::string, CFileItemPtr>::iterator itItem = lookup.find(path);
+    std::map<std::string, CFileItemPtr>::iterator itItem = lookup.find(paths[i]);
     if (itItem != lookup.end())
     {
       // add the item to the list of filtered items
       filteredItems.Add(item);
 
-      // remove the item from the lists
-      resultItems.Remove(itItem->second.get());
+      // remove the item from the lookup
       lookup.erase(itItem);
     }
   }
 
-  if (resultItems.Size() > 0)
-    CLog::Log(LOGWARNING, "CGUIMediaWindow::GetAdvanceFilteredItems(): %d unknown items", resultItems.Size());
+  // the result items still in the lookup weren't part of the original items
+  int unknownItems = 0;
+  for (int j = 0; j < resultItems.Size(); j++)
+  {
+    if (lookup.find(resultPaths[j]) != lookup.end())
+      unknownItems++;
+  }
+
+  if (unknownItems > 0)
+    CLog::Log(LOGWARNING, "CGUIMediaWindow::GetAdvanceFilteredItems(): %d unknown items", unknownItems);
 
   items.ClearItems();
   items.Append(filteredItems);